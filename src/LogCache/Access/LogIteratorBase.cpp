@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2009, 2011-2016 - TortoiseSVN
+// Copyright (C) 2007-2009, 2011-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -296,6 +296,39 @@ void CLogIteratorBase::AdvanceOneStep()
     }
 }
 
+void CLogIteratorBase::AdvanceToCandidate (revision_t last)
+{
+    // perform at least one step
+
+    ToNextRevision();
+
+    while (revision != NO_REVISION)
+    {
+        // skip all revisions that the index knows to be irrelevant
+        // (revisions not covered by it will not be skipped)
+
+        if (revision > last)
+        {
+            revision_t candidate = historyCursor.GetPrevious (path, revision);
+            revision = (candidate == NO_REVISION) || (candidate < last)
+                     ? last
+                     : candidate;
+        }
+
+        // skip ranges of missing data, if we know
+        // that they don't affect our path
+
+        if (!InternalDataIsMissing())
+            break;
+
+        revision_t nextRevision = SkipNARevisions();
+        if (nextRevision == NO_REVISION)
+            break;
+
+        revision = nextRevision;
+    }
+}
+
 void CLogIteratorBase::InternalAdvance (revision_t last)
 {
     // find next entry that mentions the path
@@ -304,7 +337,7 @@ void CLogIteratorBase::InternalAdvance (revision_t last)
 
     do
     {
-        AdvanceOneStep();
+        AdvanceToCandidate (last);
     }
     while ((revision > last) && !InternalDataIsMissing() && !PathInRevision());
 }
@@ -318,6 +351,7 @@ CLogIteratorBase::CLogIteratorBase ( const CCachedLogInfo* cachedLog
     : revisionInfo (cachedLog->GetLogInfo())
     , revisionIndices (cachedLog->GetRevisions())
     , skipRevisionInfo (cachedLog->GetSkippedRevisions())
+    , historyCursor (&cachedLog->GetPathHistoryIndex())
     , revision (startRevision)
     , addRevision ((revision_t)NO_REVISION)
     , copyfromrevision((revision_t)NO_REVISION)
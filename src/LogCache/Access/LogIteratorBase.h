@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2008, 2011-2012, 2015-2016 - TortoiseSVN
+// Copyright (C) 2007-2008, 2011-2012, 2015-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -48,6 +48,10 @@ protected:
     const CRevisionIndex& revisionIndices;
     const CSkipRevisionInfo& skipRevisionInfo;
 
+    // jump directly to revisions that may affect our path
+
+    CPathHistoryIndex::CCursor historyCursor;
+
     // just enough to describe our position
     // and what we are looking for
 
@@ -111,6 +115,7 @@ protected:
     // log scanning
 
     void AdvanceOneStep();
+    void AdvanceToCandidate (revision_t last);
     void InternalAdvance (revision_t last);
 
 public:
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2010, 2012, 2014-2016 - TortoiseSVN
+// Copyright (C) 2007-2010, 2012, 2014-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -291,6 +291,9 @@ CCachedLogInfo::CCachedLogInfo()
     , revisions()
     , logInfo()
     , skippedRevisions (logInfo.GetPaths(), revisions, logInfo)
+    , searchIndexEnabled (false)
+    , pathHistoryEnabled (false)
+    , pathHistoryPending ((revision_t)NO_REVISION)
     , modified (false)
     , revisionAdded (false)
 {
@@ -301,6 +304,9 @@ CCachedLogInfo::CCachedLogInfo (const TFileName& aFileName)
     , revisions()
     , logInfo()
     , skippedRevisions (logInfo.GetPaths(), revisions, logInfo)
+    , searchIndexEnabled (false)
+    , pathHistoryEnabled (false)
+    , pathHistoryPending ((revision_t)NO_REVISION)
     , modified (false)
     , revisionAdded (false)
 {
@@ -363,7 +369,50 @@ void CCachedLogInfo::Load (int maxFailures)
                     }
                 }
             }
+
+            // the search index is optional and may have been dropped
+            // by older clients -> rebuild it in that case
+
+            if (searchIndexEnabled && stream.HasSubStream (SEARCH_INDEX_STREAM_ID))
+            {
+                try
+                {
+                    IHierarchicalInStream* searchIndexStream
+                        = stream.GetSubStream (SEARCH_INDEX_STREAM_ID);
+                    *searchIndexStream >> searchIndex;
+
+                    if (searchIndex.size() > logInfo.size())
+                        throw CContainerException("invalid reference in search index");
+                }
+                catch (...)
+                {
+                    searchIndex.Clear();
+                }
+            }
+
+            // same for the path history index
+
+            if (pathHistoryEnabled && stream.HasSubStream (PATH_HISTORY_STREAM_ID))
+            {
+                try
+                {
+                    IHierarchicalInStream* pathHistoryStream
+                        = stream.GetSubStream (PATH_HISTORY_STREAM_ID);
+                    *pathHistoryStream >> pathHistory;
+
+                    if (pathHistory.GetCoveredEnd() > revisions.GetLastRevision())
+                        throw CContainerException("invalid revision in path history");
+                }
+                catch (...)
+                {
+                    pathHistory.Clear();
+                }
+            }
         }
+
+        UpdateSearchIndex();
+        if (pathHistoryEnabled && (pathHistory.size() == 0))
+            RebuildPathHistory();
     }
     catch (...)
     {
@@ -372,6 +421,8 @@ void CCachedLogInfo::Load (int maxFailures)
         revisions.Clear();
         logInfo.Clear();
         skippedRevisions.Clear();
+        searchIndex.Clear();
+        pathHistory.Clear();
     }
 }
 
@@ -390,6 +441,10 @@ void CCachedLogInfo::Save (const TFileName& newFileName)
         fileManager.AutoAcquire (newFileName, 0);
     }
 
+    // the last revision is complete now
+
+    FlushPathHistory();
+
     // write the data file, if we were the first to open it
 
     if (fileManager.OwnsFile())
@@ -407,6 +462,20 @@ void CCachedLogInfo::Save (const TFileName& newFileName)
         IHierarchicalOutStream* skipRevisionsStream
             = stream.OpenSubStream<CCompositeOutStream> (SKIP_REVISIONS_STREAM_ID);
         *skipRevisionsStream << skippedRevisions;
+
+        if (searchIndexEnabled)
+        {
+            IHierarchicalOutStream* searchIndexStream
+                = stream.OpenSubStream<CCompositeOutStream> (SEARCH_INDEX_STREAM_ID);
+            *searchIndexStream << searchIndex;
+        }
+
+        if (pathHistoryEnabled)
+        {
+            IHierarchicalOutStream* pathHistoryStream
+                = stream.OpenSubStream<CCompositeOutStream> (PATH_HISTORY_STREAM_ID);
+            *pathHistoryStream << pathHistory;
+        }
     }
 
     // all fine -> connect to the new file name
@@ -442,6 +511,161 @@ revision_t CCachedLogInfo::FindRevisionByDate (__time64_t maxTimeStamp) const
     return result;
 }
 
+// full-text search
+
+void CCachedLogInfo::EnableSearchIndex (bool enable)
+{
+    searchIndexEnabled = enable;
+    if (enable)
+        UpdateSearchIndex();
+    else
+        searchIndex.Clear();
+}
+
+void CCachedLogInfo::UpdateSearchIndex()
+{
+    if (!searchIndexEnabled)
+        return;
+
+    std::string comment;
+    for (index_t i = searchIndex.size(), count = logInfo.size(); i < count; ++i)
+    {
+        logInfo.GetComment (i, comment);
+        searchIndex.Add (i, logInfo.GetAuthor (i), comment);
+
+        // the file shall contain the index next time
+
+        modified = true;
+    }
+}
+
+// path history index
+
+void CCachedLogInfo::EnablePathHistoryIndex (bool enable)
+{
+    pathHistoryEnabled = enable;
+    if (enable)
+    {
+        RebuildPathHistory();
+    }
+    else
+    {
+        pathHistory.Clear();
+        pathHistoryPending = (revision_t)NO_REVISION;
+    }
+}
+
+void CCachedLogInfo::AddToPathHistory (revision_t revision)
+{
+    // revisions without changed path info must not be covered
+
+    index_t index = revisions[revision];
+    if (   (index != NO_INDEX)
+        && (logInfo.GetPresenceFlags (index) & CRevisionInfoContainer::HAS_CHANGEDPATHS))
+    {
+        pathHistory.Add (revision, logInfo, index);
+    }
+    else
+    {
+        pathHistory.Uncover (revision);
+    }
+}
+
+void CCachedLogInfo::FlushPathHistory()
+{
+    if (pathHistoryPending != NO_REVISION)
+    {
+        AddToPathHistory (pathHistoryPending);
+        pathHistoryPending = (revision_t)NO_REVISION;
+    }
+}
+
+void CCachedLogInfo::RebuildPathHistory()
+{
+    pathHistory.Clear();
+    pathHistoryPending = (revision_t)NO_REVISION;
+
+    if (!pathHistoryEnabled)
+        return;
+
+    for ( revision_t revision = revisions.GetFirstRevision()
+        , last = revisions.GetLastRevision()
+        ; revision < last
+        ; ++revision)
+    {
+        AddToPathHistory (revision);
+    }
+
+    // the file shall contain the index next time
+
+    if (pathHistory.size() > 0)
+        modified = true;
+}
+
+void CCachedLogInfo::FindRevisions ( const std::string& text
+                                   , int fields
+                                   , std::vector<revision_t>& result) const
+{
+    result.clear();
+
+    // use the index to find the entries that need closer inspection
+
+    std::vector<index_t> candidates;
+    bool indexed = searchIndexEnabled
+                && searchIndex.GetCandidates (text, candidates);
+
+    // never trust indices that don't refer to existing entries.
+    // Treat the search index as missing in that case.
+
+    index_t size = logInfo.size();
+    if (indexed && std::any_of ( candidates.begin()
+                               , candidates.end()
+                               , [size](index_t index) { return index >= size; }))
+    {
+        indexed = false;
+    }
+
+    if (!indexed)
+    {
+        candidates.resize (logInfo.size());
+        for (index_t i = 0, count = logInfo.size(); i < count; ++i)
+            candidates[i] = i;
+    }
+
+    // verify them
+
+    std::string pattern = CLogSearchIndex::FoldCase (text);
+    std::string comment;
+
+    std::vector<bool> matches (logInfo.size(), false);
+    for (size_t i = 0, count = candidates.size(); i < count; ++i)
+    {
+        index_t index = candidates[i];
+        if (   (fields & SEARCH_AUTHORS)
+            && CLogSearchIndex::Contains (logInfo.GetAuthor (index), pattern))
+        {
+            matches[index] = true;
+        }
+        else if (fields & SEARCH_COMMENTS)
+        {
+            logInfo.GetComment (index, comment);
+            matches[index] = CLogSearchIndex::Contains (comment, pattern);
+        }
+    }
+
+    // translate to revisions
+
+    for ( revision_t revision = revisions.GetFirstRevision()
+        , last = revisions.GetLastRevision()
+        ; revision < last
+        ; ++revision)
+    {
+        index_t index = revisions[revision];
+        if ((index != NO_INDEX) && matches[index])
+            result.push_back (revision);
+    }
+}
+
 // data modification (mirrors CRevisionInfoContainer)
 
 void CCachedLogInfo::Insert ( revision_t revision
@@ -459,6 +683,16 @@ void CCachedLogInfo::Insert ( revision_t revision
     index_t index = logInfo.Insert (author, comment, timeStamp, flags);
     revisions.SetRevisionIndex (revision, index);
 
+    if (searchIndexEnabled)
+        searchIndex.Add (index, author, comment);
+
+    // changes of the previous revision are complete now
+    // and this one will be indexed as soon as its changes are
+
+    FlushPathHistory();
+    if (pathHistoryEnabled)
+        pathHistoryPending = revision;
+
     // you may call AddChange() now
 
     revisionAdded = true;
@@ -481,6 +715,9 @@ void CCachedLogInfo::Clear()
     revisions.Clear();
     logInfo.Clear();
     skippedRevisions.Clear();
+    searchIndex.Clear();
+    pathHistory.Clear();
+    pathHistoryPending = (revision_t)NO_REVISION;
 }
 
 // return false if concurrent read accesses
@@ -510,6 +747,10 @@ void CCachedLogInfo::Update ( const CCachedLogInfo& newData
     if (newData.IsEmpty() && keepOldDataForMissingNew)
         return;
 
+    // changes of the last inserted revision are complete
+
+    FlushPathHistory();
+
     // build revision index map
 
     index_mapping_t indexMap;
@@ -534,6 +775,28 @@ void CCachedLogInfo::Update ( const CCachedLogInfo& newData
         }
     }
 
+    // remember the searchable texts of existing entries
+    // (re-indexing them is expensive and they rarely change)
+
+    std::vector<std::pair<index_t, std::string> > oldTexts;
+    if (searchIndexEnabled)
+    {
+        std::string comment;
+        for (index_mapping_t::const_iterator iter = indexMap.begin()
+            , end = indexMap.end()
+            ; iter != end
+            ; ++iter)
+        {
+            if (iter->key < searchIndex.size())
+            {
+                logInfo.GetComment (iter->key, comment);
+                oldTexts.push_back (std::make_pair ( iter->key
+                                                   , logInfo.GetAuthor (iter->key)
+                                                     + ('\n' + comment)));
+            }
+        }
+    }
+
     // update our log info
 
     logInfo.Update ( newData.logInfo
@@ -541,6 +804,40 @@ void CCachedLogInfo::Update ( const CCachedLogInfo& newData
                    , flags
                    , keepOldDataForMissingNew);
 
+    // update the search index
+
+    if (searchIndexEnabled)
+    {
+        std::string comment;
+        for (size_t i = 0, count = oldTexts.size(); i < count; ++i)
+        {
+            index_t index = oldTexts[i].first;
+            std::string author = logInfo.GetAuthor (index);
+            logInfo.GetComment (index, comment);
+
+            if (oldTexts[i].second != author + ('\n' + comment))
+                searchIndex.Add (index, author, comment);
+        }
+
+        UpdateSearchIndex();
+    }
+
+    // update the path history index.
+    // Entries of replaced changes may remain in the lists. They only
+    // make the log iterators check a few more revisions.
+
+    if (pathHistoryEnabled && (flags & CRevisionInfoContainer::HAS_CHANGEDPATHS))
+    {
+        for ( revision_t i = newData.revisions.GetFirstRevision()
+            , last = newData.revisions.GetLastRevision()
+            ; i < last
+            ; ++i)
+        {
+            if (newData.revisions[i] != NO_INDEX)
+                AddToPathHistory (i);
+        }
+    }
+
     // our skip ranges should still be valid
     // but we check them anyway
 
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2010, 2015 - TortoiseSVN
+// Copyright (C) 2007-2010, 2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -26,6 +26,8 @@
 #include "RevisionIndex.h"
 #include "RevisionInfoContainer.h"
 #include "SkipRevisionInfo.h"
+#include "LogSearchIndex.h"
+#include "PathHistoryIndex.h"
 
 ///////////////////////////////////////////////////////////////
 // begin namespace LogCache
@@ -151,6 +153,21 @@ private:
     CRevisionInfoContainer logInfo;
     CSkipRevisionInfo skippedRevisions;
 
+    /// optional full-text index over authors and comments
+
+    CLogSearchIndex searchIndex;
+    bool searchIndexEnabled;
+
+    /// optional reverse index from paths to revisions
+
+    CPathHistoryIndex pathHistory;
+    bool pathHistoryEnabled;
+
+    /// last inserted revision. Its changes will be added
+    /// to the path history index upon the next modification.
+
+    revision_t pathHistoryPending;
+
     /// revision has been added or Clear() has been called
 
     bool modified;
@@ -165,15 +182,35 @@ private:
     {
         REVISIONS_STREAM_ID = 1,
         LOG_INFO_STREAM_ID = 2,
-        SKIP_REVISIONS_STREAM_ID = 3
+        SKIP_REVISIONS_STREAM_ID = 3,
+        SEARCH_INDEX_STREAM_ID = 4,
+        PATH_HISTORY_STREAM_ID = 5
     };
 
+    /// add all log info entries not yet covered by the search index
+
+    void UpdateSearchIndex();
+
+    /// path history index maintenance
+
+    void AddToPathHistory (revision_t revision);
+    void FlushPathHistory();
+    void RebuildPathHistory();
+
 public:
 
     /// for convenience
 
     typedef CRevisionInfoContainer::TChangeAction TChangeAction;
 
+    /// fields to search in FindRevisions()
+
+    enum
+    {
+        SEARCH_AUTHORS = 1,
+        SEARCH_COMMENTS = 2
+    };
+
     /// construction / destruction (nothing to do)
 
     CCachedLogInfo();
@@ -194,11 +231,33 @@ public:
     const CRevisionIndex& GetRevisions() const;
     const CRevisionInfoContainer& GetLogInfo() const;
     const CSkipRevisionInfo& GetSkippedRevisions() const;
+    const CLogSearchIndex& GetSearchIndex() const;
+    const CPathHistoryIndex& GetPathHistoryIndex() const;
+
+    /// maintain the search index (disabled by default).
+    /// Call this before Load() to prevent the index from being read.
+
+    void EnableSearchIndex (bool enable);
+    bool IsSearchIndexEnabled() const;
+
+    /// maintain the path history index (disabled by default).
+    /// Call this before Load() to prevent the index from being read.
+
+    void EnablePathHistoryIndex (bool enable);
+    bool IsPathHistoryIndexEnabled() const;
 
     /// find the highest revision not exceeding the given timestamp
 
     revision_t FindRevisionByDate (__time64_t maxTimeStamp) const;
 
+    /// find all revisions whose author and / or comment (see \a fields)
+    /// contains \a text. The comparison is ASCII case-insensitive.
+    /// Result will be in ascending order.
+
+    void FindRevisions ( const std::string& text
+                       , int fields
+                       , std::vector<revision_t>& result) const;
+
     /// data modification
     /// (mirrors CRevisionInfoContainer and CSkipRevisionInfo)
 
@@ -296,6 +355,26 @@ inline const CSkipRevisionInfo& CCachedLogInfo::GetSkippedRevisions() const
     return skippedRevisions;
 }
 
+inline const CLogSearchIndex& CCachedLogInfo::GetSearchIndex() const
+{
+    return searchIndex;
+}
+
+inline bool CCachedLogInfo::IsSearchIndexEnabled() const
+{
+    return searchIndexEnabled;
+}
+
+inline const CPathHistoryIndex& CCachedLogInfo::GetPathHistoryIndex() const
+{
+    return pathHistory;
+}
+
+inline bool CCachedLogInfo::IsPathHistoryIndexEnabled() const
+{
+    return pathHistoryEnabled;
+}
+
 ///////////////////////////////////////////////////////////////
 // data modification (mirrors CRevisionInfoContainer)
 ///////////////////////////////////////////////////////////////
@@ -0,0 +1,434 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "LogSearchIndex.h"
+#include "ContainerException.h"
+
+#include "../Streams/BLOBInStream.h"
+#include "../Streams/BLOBOutStream.h"
+#include "../Streams/PackedDWORDInStream.h"
+#include "../Streams/PackedDWORDOutStream.h"
+
+///////////////////////////////////////////////////////////////
+// begin namespace LogCache
+///////////////////////////////////////////////////////////////
+
+namespace LogCache
+{
+
+// utilities
+
+namespace
+{
+    inline char FoldChar (char c)
+    {
+        return (c >= 'A') && (c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+}
+
+// damaged data may contain overlong 7/8 codes
+
+static const int MAX_SHIFT = 8 * sizeof (index_t);
+
+void CLogSearchIndex::GetTrigrams ( const std::string& text
+                                  , std::vector<DWORD>& trigrams)
+{
+    if (text.size() < 3)
+        return;
+
+    const unsigned char* source
+        = reinterpret_cast<const unsigned char*>(text.c_str());
+
+    DWORD trigram = (source[0] << 8) + source[1];
+    for (size_t i = 2, count = text.size(); i < count; ++i)
+    {
+        trigram = ((trigram << 8) + source[i]) & 0xffffff;
+        trigrams.push_back (trigram);
+    }
+}
+
+void CLogSearchIndex::Decode ( const SPostings& postings
+                             , std::vector<index_t>& indices)
+{
+    indices.clear();
+
+    index_t next = 0;
+    index_t delta = 0;
+    int shift = 0;
+
+    for ( const unsigned char* iter = postings.data.data()
+        , *end = iter + postings.data.size()
+        ; iter != end
+        ; ++iter)
+    {
+        if (shift < MAX_SHIFT)
+            delta += (index_t)(*iter & 0x7f) << shift;
+        if (*iter < 0x80)
+        {
+            indices.push_back (next + delta);
+            next += delta + 1;
+            delta = 0;
+            shift = 0;
+        }
+        else
+        {
+            shift += 7;
+        }
+    }
+}
+
+void CLogSearchIndex::Encode ( const std::vector<index_t>& indices
+                             , SPostings& postings)
+{
+    postings.data.clear();
+    postings.next = 0;
+
+    for (size_t i = 0, count = indices.size(); i < count; ++i)
+        Append (postings, indices[i]);
+}
+
+void CLogSearchIndex::Append (SPostings& postings, index_t index)
+{
+    // usually, we get new revisions only
+
+    if (index >= postings.next)
+    {
+        index_t delta = index - postings.next;
+        while (delta >= 0x80)
+        {
+            postings.data.push_back ((unsigned char)(delta & 0x7f) + 0x80);
+            delta >>= 7;
+        }
+
+        postings.data.push_back ((unsigned char)delta);
+        postings.next = index + 1;
+
+        return;
+    }
+
+    // insert into the list, unless it is already there
+
+    std::vector<index_t> indices;
+    Decode (postings, indices);
+
+    std::vector<index_t>::iterator iter
+        = std::lower_bound (indices.begin(), indices.end(), index);
+    if ((iter == indices.end()) || (*iter != index))
+    {
+        indices.insert (iter, index);
+        Encode (indices, postings);
+    }
+}
+
+void CLogSearchIndex::Intersect ( const SPostings& postings
+                                , std::vector<index_t>& indices)
+{
+    // decode on-the-fly and keep all indices that we find in the list
+
+    size_t source = 0;
+    size_t target = 0;
+    size_t count = indices.size();
+
+    index_t next = 0;
+    index_t delta = 0;
+    int shift = 0;
+
+    for ( const unsigned char* iter = postings.data.data()
+        , *end = iter + postings.data.size()
+        ; (iter != end) && (source < count)
+        ; ++iter)
+    {
+        if (shift < MAX_SHIFT)
+            delta += (index_t)(*iter & 0x7f) << shift;
+        if (*iter >= 0x80)
+        {
+            shift += 7;
+            continue;
+        }
+
+        index_t index = next + delta;
+        next += delta + 1;
+        delta = 0;
+        shift = 0;
+
+        while ((source < count) && (indices[source] < index))
+            ++source;
+
+        if ((source < count) && (indices[source] == index))
+            indices[target++] = indices[source++];
+    }
+
+    indices.resize (target);
+}
+
+// construction / destruction
+
+CLogSearchIndex::CLogSearchIndex(void)
+    : count (0)
+{
+}
+
+CLogSearchIndex::~CLogSearchIndex(void)
+{
+}
+
+// index modification
+
+void CLogSearchIndex::Add ( index_t index
+                          , const std::string& author
+                          , const std::string& comment)
+{
+    std::vector<DWORD> trigrams;
+    GetTrigrams (FoldCase (author), trigrams);
+    GetTrigrams (FoldCase (comment), trigrams);
+
+    std::sort (trigrams.begin(), trigrams.end());
+    trigrams.erase ( std::unique (trigrams.begin(), trigrams.end())
+                   , trigrams.end());
+
+    for (size_t i = 0, size = trigrams.size(); i < size; ++i)
+        Append (postings[trigrams[i]], index);
+
+    if (index >= count)
+        count = index + 1;
+}
+
+// index lookup
+
+bool CLogSearchIndex::GetCandidates ( const std::string& text
+                                    , std::vector<index_t>& candidates) const
+{
+    candidates.clear();
+
+    std::vector<DWORD> trigrams;
+    GetTrigrams (FoldCase (text), trigrams);
+    if (trigrams.empty())
+        return false;
+
+    // any unknown trigram means: no match
+
+    std::vector<const SPostings*> lists;
+    lists.reserve (trigrams.size());
+
+    for (size_t i = 0, size = trigrams.size(); i < size; ++i)
+    {
+        TPostings::const_iterator iter = postings.find (trigrams[i]);
+        if (iter == postings.end())
+            return true;
+
+        lists.push_back (&iter->second);
+    }
+
+    // start with the shortest list to minimize decoding effort
+
+    std::sort ( lists.begin()
+              , lists.end()
+              , [](const SPostings* lhs, const SPostings* rhs)
+                {
+                    return lhs->data.size() < rhs->data.size();
+                });
+    lists.erase (std::unique (lists.begin(), lists.end()), lists.end());
+
+    Decode (*lists.front(), candidates);
+    for ( size_t i = 1, size = lists.size()
+        ; (i < size) && !candidates.empty()
+        ; ++i)
+    {
+        Intersect (*lists[i], candidates);
+    }
+
+    // damaged lists may refer to entries not covered by the index.
+    // Don't use the index at all in that case.
+
+    if (std::any_of ( candidates.begin()
+                    , candidates.end()
+                    , [this](index_t index) { return index >= count; }))
+    {
+        candidates.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void CLogSearchIndex::Clear()
+{
+    postings.clear();
+    count = 0;
+}
+
+void CLogSearchIndex::Swap (CLogSearchIndex& rhs)
+{
+    postings.swap (rhs.postings);
+    std::swap (count, rhs.count);
+}
+
+// ASCII case-insensitive text comparison
+
+std::string CLogSearchIndex::FoldCase (const std::string& text)
+{
+    std::string result (text);
+    std::transform (result.begin(), result.end(), result.begin(), FoldChar);
+
+    return result;
+}
+
+bool CLogSearchIndex::Contains ( const std::string& text
+                               , const std::string& foldedPattern)
+{
+    return std::search ( text.begin()
+                       , text.end()
+                       , foldedPattern.begin()
+                       , foldedPattern.end()
+                       , [](char lhs, char rhs)
+                         {
+                             return FoldChar (lhs) == rhs;
+                         })
+        != text.end();
+}
+
+// stream I/O
+
+IHierarchicalInStream& operator>> ( IHierarchicalInStream& stream
+                                  , CLogSearchIndex& index)
+{
+    index.Clear();
+
+    // read the list headers
+
+    std::vector<DWORD> trigrams;
+    *stream.GetSubStream<CDiffDWORDInStream>
+        (CLogSearchIndex::TRIGRAMS_STREAM_ID) >> trigrams;
+
+    std::vector<DWORD> sizes;
+    *stream.GetSubStream<CPackedDWORDInStream>
+        (CLogSearchIndex::SIZES_STREAM_ID) >> sizes;
+
+    // the number of covered entries precedes the list of next indices
+
+    CPackedDWORDInStream* nextIndicesStream
+        = stream.GetSubStream<CPackedDWORDInStream>
+            (CLogSearchIndex::NEXT_INDICES_STREAM_ID);
+
+    index_t count = (index_t)nextIndicesStream->GetSizeValue();
+
+    std::vector<DWORD> nextIndices;
+    *nextIndicesStream >> nextIndices;
+
+    // the posting lists themselves
+
+    CBLOBInStream* postingsStream
+        = stream.GetSubStream<CBLOBInStream>
+            (CLogSearchIndex::POSTINGS_STREAM_ID);
+
+    const unsigned char* data = postingsStream->GetData();
+    size_t dataSize = postingsStream->GetSize();
+
+    // validate the data before using it
+
+    size_t listCount = trigrams.size();
+    if ((sizes.size() != listCount) || (nextIndices.size() != listCount))
+        throw CContainerException ("search index list count mismatch");
+
+    size_t totalSize = 0;
+    for (size_t i = 0; i < listCount; ++i)
+    {
+        if (nextIndices[i] > count)
+            throw CContainerException ("invalid index in search index");
+
+        totalSize += sizes[i];
+    }
+
+    if (totalSize != dataSize)
+        throw CContainerException ("search index data size mismatch");
+
+    // fill the index
+
+    CLogSearchIndex::TPostings::iterator hint = index.postings.end();
+    for (size_t i = 0; i < listCount; ++i)
+    {
+        hint = index.postings.emplace_hint
+            (hint, trigrams[i], CLogSearchIndex::SPostings());
+
+        hint->second.data.assign (data, data + sizes[i]);
+        hint->second.next = nextIndices[i];
+
+        data += sizes[i];
+    }
+
+    index.count = count;
+
+    // ready
+
+    return stream;
+}
+
+IHierarchicalOutStream& operator<< ( IHierarchicalOutStream& stream
+                                   , const CLogSearchIndex& index)
+{
+    size_t listCount = index.postings.size();
+
+    std::vector<DWORD> trigrams;
+    std::vector<DWORD> sizes;
+    std::vector<DWORD> nextIndices;
+    std::vector<unsigned char> data;
+
+    trigrams.reserve (listCount);
+    sizes.reserve (listCount);
+    nextIndices.reserve (listCount);
+
+    for ( CLogSearchIndex::TPostings::const_iterator iter = index.postings.begin()
+        , end = index.postings.end()
+        ; iter != end
+        ; ++iter)
+    {
+        trigrams.push_back (iter->first);
+        sizes.push_back ((DWORD)iter->second.data.size());
+        nextIndices.push_back ((DWORD)iter->second.next);
+        data.insert (data.end(), iter->second.data.begin(), iter->second.data.end());
+    }
+
+    // write list headers
+
+    *stream.OpenSubStream<CDiffDWORDOutStream>
+        (CLogSearchIndex::TRIGRAMS_STREAM_ID) << trigrams;
+    *stream.OpenSubStream<CPackedDWORDOutStream>
+        (CLogSearchIndex::SIZES_STREAM_ID) << sizes;
+
+    CPackedDWORDOutStream* nextIndicesStream
+        = stream.OpenSubStream<CPackedDWORDOutStream>
+            (CLogSearchIndex::NEXT_INDICES_STREAM_ID);
+    nextIndicesStream->AddSizeValue (index.count);
+    *nextIndicesStream << nextIndices;
+
+    // write posting lists
+
+    stream.OpenSubStream<CBLOBOutStream>
+        (CLogSearchIndex::POSTINGS_STREAM_ID)->Add (data.data(), data.size());
+
+    // ready
+
+    return stream;
+}
+
+///////////////////////////////////////////////////////////////
+// end namespace LogCache
+///////////////////////////////////////////////////////////////
+
+}
@@ -0,0 +1,176 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+///////////////////////////////////////////////////////////////
+// necessary includes
+///////////////////////////////////////////////////////////////
+
+#include "LogCacheGlobals.h"
+
+///////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////
+
+class IHierarchicalInStream;
+class IHierarchicalOutStream;
+
+///////////////////////////////////////////////////////////////
+// begin namespace LogCache
+///////////////////////////////////////////////////////////////
+
+namespace LogCache
+{
+
+/**
+ * Trigram index over the authors and comments of a CRevisionInfoContainer.
+ *
+ * For every sequence of 3 bytes (trigram) found in the case-folded texts,
+ * we store the list of revision info indices whose author or comment
+ * contains it (posting list). Any text to search for with at least 3 bytes
+ * will only be found in revisions that are listed in the posting lists of
+ * all its trigrams. Hence, intersecting those lists yields a small superset
+ * of the actual matches that must then be verified against the texts.
+ *
+ * Case folding is limited to ASCII characters because that is all we can
+ * do without decoding UTF-8.
+ *
+ * Posting lists are stored as ascending sequences of differences in 7/8
+ * code (see CPackedDWORDOutStreamBase) to keep the index small. Adding
+ * new revisions appends to these lists in O(1). Adding text to existing
+ * revisions (e.g. when a log message got edited) requires the respective
+ * lists to be re-encoded. Since posting lists are supersets anyway, old
+ * entries never need to be removed.
+ *
+ * All indices below size() have been added.
+ */
+class CLogSearchIndex
+{
+private:
+
+    /// sub-stream IDs
+
+    enum
+    {
+        TRIGRAMS_STREAM_ID = 1,
+        SIZES_STREAM_ID = 2,
+        NEXT_INDICES_STREAM_ID = 3,
+        POSTINGS_STREAM_ID = 4
+    };
+
+    /**
+     * Revision info indices containing a specific trigram.
+     */
+
+    struct SPostings
+    {
+        /// differences between consecutive indices, 7/8 coded
+
+        std::vector<unsigned char> data;
+
+        /// one more than the last index in data
+
+        index_t next;
+
+        SPostings() : next (0) {}
+    };
+
+    typedef std::map<DWORD, SPostings> TPostings;
+
+    /// the index data
+
+    TPostings postings;
+
+    /// number of revision info entries covered by the index
+
+    index_t count;
+
+    /// utilities
+
+    static void GetTrigrams (const std::string& text, std::vector<DWORD>& trigrams);
+    static void Decode (const SPostings& postings, std::vector<index_t>& indices);
+    static void Encode (const std::vector<index_t>& indices, SPostings& postings);
+    static void Append (SPostings& postings, index_t index);
+    static void Intersect ( const SPostings& postings
+                          , std::vector<index_t>& indices);
+
+public:
+
+    /// construction / destruction
+
+    CLogSearchIndex(void);
+    virtual ~CLogSearchIndex(void);
+
+    /// number of revision info entries covered
+
+    index_t size() const
+    {
+        return count;
+    }
+
+    /// number of different trigrams
+
+    size_t GetTrigramCount() const
+    {
+        return postings.size();
+    }
+
+    /// add the author and comment of entry \a index.
+    /// May be called more than once per index.
+
+    void Add ( index_t index
+             , const std::string& author
+             , const std::string& comment);
+
+    /// Fills \a candidates with the ascending list of all indices that
+    /// may contain \a text. Returns false, if \a text is too short to
+    /// limit the search or the posting lists are damaged, i.e. if all
+    /// entries are candidates.
+
+    bool GetCandidates ( const std::string& text
+                       , std::vector<index_t>& candidates) const;
+
+    void Clear();
+    void Swap (CLogSearchIndex& rhs);
+
+    /// ASCII case-insensitive text comparison
+
+    static std::string FoldCase (const std::string& text);
+    static bool Contains (const std::string& text, const std::string& foldedPattern);
+
+    /// stream I/O
+
+    friend IHierarchicalInStream& operator>> ( IHierarchicalInStream& stream
+                                             , CLogSearchIndex& index);
+    friend IHierarchicalOutStream& operator<< ( IHierarchicalOutStream& stream
+                                              , const CLogSearchIndex& index);
+};
+
+/// stream I/O
+
+IHierarchicalInStream& operator>> ( IHierarchicalInStream& stream
+                                  , CLogSearchIndex& index);
+IHierarchicalOutStream& operator<< ( IHierarchicalOutStream& stream
+                                   , const CLogSearchIndex& index);
+
+///////////////////////////////////////////////////////////////
+// end namespace LogCache
+///////////////////////////////////////////////////////////////
+
+}
@@ -0,0 +1,578 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "PathHistoryIndex.h"
+#include "RevisionInfoContainer.h"
+#include "DictionaryBasedTempPath.h"
+#include "ContainerException.h"
+
+#include "../Streams/BLOBInStream.h"
+#include "../Streams/BLOBOutStream.h"
+#include "../Streams/PackedDWORDInStream.h"
+#include "../Streams/PackedDWORDOutStream.h"
+
+///////////////////////////////////////////////////////////////
+// begin namespace LogCache
+///////////////////////////////////////////////////////////////
+
+namespace LogCache
+{
+
+///////////////////////////////////////////////////////////////
+// CPathHistoryIndex::CCursor
+///////////////////////////////////////////////////////////////
+
+// construction
+
+CPathHistoryIndex::CCursor::CCursor (const CPathHistoryIndex* index)
+    : index (index)
+    , pathID ((index_t)NO_INDEX)
+    , fullyCached (false)
+    , updateCount (0)
+{
+}
+
+// find the next revision to look at
+
+revision_t CPathHistoryIndex::CCursor::GetPrevious
+    ( const CDictionaryBasedTempPath& path
+    , revision_t revision)
+{
+    // every revision is relevant to the root
+
+    if (path.IsRoot())
+        return revision;
+
+    // we know nothing about revisions not covered
+
+    revision_t uncovered = index->GetPreviousUncovered (revision);
+    if (uncovered == revision)
+        return revision;
+
+    // (re-)fetch the candidates for that path
+
+    if (   (pathID != path.GetBasePath().GetIndex())
+        || (fullyCached != path.IsFullyCachedPath())
+        || (updateCount != index->updateCount))
+    {
+        pathID = path.GetBasePath().GetIndex();
+        fullyCached = path.IsFullyCachedPath();
+        updateCount = index->updateCount;
+
+        index->GetCandidates (path, candidates);
+    }
+
+    // the closest of both
+
+    std::vector<revision_t>::const_iterator iter
+        = std::upper_bound (candidates.begin(), candidates.end(), revision);
+    if (iter == candidates.begin())
+        return uncovered;
+
+    revision_t candidate = *(iter-1);
+    return (uncovered == NO_REVISION) || (candidate > uncovered)
+        ? candidate
+        : uncovered;
+}
+
+///////////////////////////////////////////////////////////////
+// CPathHistoryIndex
+///////////////////////////////////////////////////////////////
+
+// utilities
+
+void CPathHistoryIndex::Decode ( const SPostings& postings
+                               , std::vector<revision_t>& revisions)
+{
+    revisions.clear();
+
+    revision_t next = 0;
+    revision_t delta = 0;
+    int shift = 0;
+
+    for ( const unsigned char* iter = postings.data.data()
+        , *end = iter + postings.data.size()
+        ; iter != end
+        ; ++iter)
+    {
+        delta += (revision_t)(*iter & 0x7f) << shift;
+        if (*iter < 0x80)
+        {
+            revisions.push_back (next + delta);
+            next += delta + 1;
+            delta = 0;
+            shift = 0;
+        }
+        else
+        {
+            shift += 7;
+        }
+    }
+
+    // merge revisions that could not be appended
+
+    if (!postings.pending.empty())
+    {
+        revisions.insert ( revisions.end()
+                         , postings.pending.begin()
+                         , postings.pending.end());
+
+        std::sort (revisions.begin(), revisions.end());
+        revisions.erase ( std::unique (revisions.begin(), revisions.end())
+                        , revisions.end());
+    }
+}
+
+void CPathHistoryIndex::Encode ( const std::vector<revision_t>& revisions
+                               , SPostings& postings)
+{
+    postings.data.clear();
+    postings.pending.clear();
+    postings.next = 0;
+
+    for (size_t i = 0, count = revisions.size(); i < count; ++i)
+        Append (postings, revisions[i]);
+}
+
+void CPathHistoryIndex::Append (SPostings& postings, revision_t revision)
+{
+    if (revision >= postings.next)
+    {
+        revision_t delta = revision - postings.next;
+        while (delta >= 0x80)
+        {
+            postings.data.push_back ((unsigned char)(delta & 0x7f) + 0x80);
+            delta >>= 7;
+        }
+
+        postings.data.push_back ((unsigned char)delta);
+        postings.next = revision + 1;
+    }
+    else if (revision + 1 != postings.next)
+    {
+        // re-encode the list once the pending revisions
+        // become a significant part of it
+
+        postings.pending.push_back (revision);
+        if (   (postings.pending.size() >= 16)
+            && (postings.pending.size() * 4 >= postings.data.size()))
+        {
+            std::vector<revision_t> revisions;
+            Decode (postings, revisions);
+            Encode (revisions, postings);
+        }
+    }
+}
+
+void CPathHistoryIndex::AddCovered (revision_t revision)
+{
+    // extend the range just before revision or merge with it
+
+    TRanges::iterator next = covered.upper_bound (revision);
+    if (next != covered.begin())
+    {
+        TRanges::iterator previous = next;
+        --previous;
+
+        if (revision < previous->second)
+            return;
+
+        if (previous->second == revision)
+        {
+            previous->second = revision + 1;
+            if ((next != covered.end()) && (next->first == previous->second))
+            {
+                previous->second = next->second;
+                covered.erase (next);
+            }
+
+            return;
+        }
+    }
+
+    // extend the range just after revision
+
+    if ((next != covered.end()) && (next->first == revision + 1))
+    {
+        revision_t end = next->second;
+        covered.erase (next);
+        covered.insert (std::make_pair (revision, end));
+    }
+    else
+    {
+        covered.insert (std::make_pair (revision, revision + 1));
+    }
+}
+
+// construction / destruction
+
+CPathHistoryIndex::CPathHistoryIndex(void)
+    : updateCount (0)
+{
+}
+
+CPathHistoryIndex::~CPathHistoryIndex(void)
+{
+}
+
+// index modification
+
+void CPathHistoryIndex::Add ( revision_t revision
+                            , const CRevisionInfoContainer& logInfo
+                            , index_t index)
+{
+    const CPathDictionary& paths = logInfo.GetPaths();
+
+    // collect all changed paths and their parents
+
+    std::vector<index_t> changedPaths;
+    std::vector<index_t> structuralChanges;
+
+    for ( CRevisionInfoContainer::CChangesIterator iter = logInfo.GetChangesBegin (index)
+        , end = logInfo.GetChangesEnd (index)
+        ; iter != end
+        ; ++iter)
+    {
+        index_t pathID = iter.GetPathID();
+        if (iter.GetAction() != CRevisionInfoContainer::ACTION_CHANGED)
+            structuralChanges.push_back (pathID);
+
+        for (; (pathID != 0) && (pathID != NO_INDEX); pathID = paths.GetParent (pathID))
+            changedPaths.push_back (pathID);
+    }
+
+    std::sort (changedPaths.begin(), changedPaths.end());
+    changedPaths.erase ( std::unique (changedPaths.begin(), changedPaths.end())
+                       , changedPaths.end());
+
+    std::sort (structuralChanges.begin(), structuralChanges.end());
+    structuralChanges.erase ( std::unique (structuralChanges.begin(), structuralChanges.end())
+                            , structuralChanges.end());
+
+    // add them to the index
+
+    for (size_t i = 0, count = changedPaths.size(); i < count; ++i)
+        Append (subtree[changedPaths[i]], revision);
+
+    for (size_t i = 0, count = structuralChanges.size(); i < count; ++i)
+        Append (structural[structuralChanges[i]], revision);
+
+    AddCovered (revision);
+    ++updateCount;
+}
+
+void CPathHistoryIndex::Uncover (revision_t revision)
+{
+    TRanges::iterator iter = covered.upper_bound (revision);
+    if (iter == covered.begin())
+        return;
+
+    --iter;
+    revision_t end = iter->second;
+    if (revision >= end)
+        return;
+
+    // split the range around revision
+
+    if (iter->first == revision)
+        covered.erase (iter);
+    else
+        iter->second = revision;
+
+    if (revision + 1 < end)
+        covered.insert (std::make_pair (revision + 1, end));
+
+    ++updateCount;
+}
+
+// index lookup
+
+bool CPathHistoryIndex::IsCovered (revision_t revision) const
+{
+    return GetPreviousUncovered (revision) != revision;
+}
+
+revision_t CPathHistoryIndex::GetPreviousUncovered (revision_t revision) const
+{
+    TRanges::const_iterator iter = covered.upper_bound (revision);
+    if (iter == covered.begin())
+        return revision;
+
+    --iter;
+    if (revision >= iter->second)
+        return revision;
+
+    return iter->first == 0
+        ? (revision_t)NO_REVISION
+        : iter->first - 1;
+}
+
+revision_t CPathHistoryIndex::GetCoveredEnd() const
+{
+    return covered.empty() ? 0 : covered.rbegin()->second;
+}
+
+void CPathHistoryIndex::GetCandidates ( const CDictionaryBasedTempPath& path
+                                      , std::vector<revision_t>& revisions) const
+{
+    revisions.clear();
+
+    const CDictionaryBasedPath& basePath = path.GetBasePath();
+    if (!basePath.IsValid())
+        return;
+
+    std::vector<revision_t> list;
+
+    // changes to the path itself or any of its sub-paths
+    // (a path not in the cache cannot have sub-paths in it)
+
+    if (path.IsFullyCachedPath())
+    {
+        TPostings::const_iterator iter = subtree.find (basePath.GetIndex());
+        if (iter != subtree.end())
+            Decode (iter->second, revisions);
+    }
+
+    // add / delete / replace of the path or any of its parents
+
+    const CPathDictionary* paths = basePath.GetDictionary();
+    for (index_t pathID = basePath.GetIndex(); ; pathID = paths->GetParent (pathID))
+    {
+        TPostings::const_iterator iter = structural.find (pathID);
+        if (iter != structural.end())
+        {
+            Decode (iter->second, list);
+            revisions.insert (revisions.end(), list.begin(), list.end());
+        }
+
+        if (pathID == 0)
+            break;
+    }
+
+    std::sort (revisions.begin(), revisions.end());
+    revisions.erase ( std::unique (revisions.begin(), revisions.end())
+                    , revisions.end());
+}
+
+void CPathHistoryIndex::Clear()
+{
+    subtree.clear();
+    structural.clear();
+    covered.clear();
+
+    ++updateCount;
+}
+
+void CPathHistoryIndex::Swap (CPathHistoryIndex& rhs)
+{
+    subtree.swap (rhs.subtree);
+    structural.swap (rhs.structural);
+    covered.swap (rhs.covered);
+
+    ++updateCount;
+    ++rhs.updateCount;
+}
+
+// stream I/O
+
+void CPathHistoryIndex::Read ( IHierarchicalInStream& stream
+                             , TPostings& postings)
+{
+    postings.clear();
+
+    // read the list headers
+
+    std::vector<DWORD> paths;
+    *stream.GetSubStream<CDiffDWORDInStream> (PATHS_STREAM_ID) >> paths;
+
+    std::vector<DWORD> sizes;
+    *stream.GetSubStream<CPackedDWORDInStream> (SIZES_STREAM_ID) >> sizes;
+
+    std::vector<DWORD> nextRevisions;
+    *stream.GetSubStream<CPackedDWORDInStream> (NEXT_REVISIONS_STREAM_ID)
+        >> nextRevisions;
+
+    // the posting lists themselves
+
+    CBLOBInStream* postingsStream
+        = stream.GetSubStream<CBLOBInStream> (POSTINGS_STREAM_ID);
+
+    const unsigned char* data = postingsStream->GetData();
+    size_t dataSize = postingsStream->GetSize();
+
+    // validate the data before using it
+
+    size_t listCount = paths.size();
+    if ((sizes.size() != listCount) || (nextRevisions.size() != listCount))
+        throw CContainerException ("path history list count mismatch");
+
+    size_t totalSize = 0;
+    for (size_t i = 0; i < listCount; ++i)
+        totalSize += sizes[i];
+
+    if (totalSize != dataSize)
+        throw CContainerException ("path history data size mismatch");
+
+    // fill the index
+
+    TPostings::iterator hint = postings.end();
+    for (size_t i = 0; i < listCount; ++i)
+    {
+        hint = postings.emplace_hint (hint, paths[i], SPostings());
+
+        hint->second.data.assign (data, data + sizes[i]);
+        hint->second.next = nextRevisions[i];
+
+        data += sizes[i];
+    }
+}
+
+void CPathHistoryIndex::Write ( IHierarchicalOutStream& stream
+                              , const TPostings& postings)
+{
+    size_t listCount = postings.size();
+
+    std::vector<DWORD> paths;
+    std::vector<DWORD> sizes;
+    std::vector<DWORD> nextRevisions;
+    std::vector<unsigned char> data;
+
+    paths.reserve (listCount);
+    sizes.reserve (listCount);
+    nextRevisions.reserve (listCount);
+
+    std::vector<revision_t> revisions;
+    SPostings merged;
+
+    for ( TPostings::const_iterator iter = postings.begin(), end = postings.end()
+        ; iter != end
+        ; ++iter)
+    {
+        // store pending revisions as well
+
+        const SPostings* source = &iter->second;
+        if (!source->pending.empty())
+        {
+            Decode (*source, revisions);
+            Encode (revisions, merged);
+            source = &merged;
+        }
+
+        paths.push_back ((DWORD)iter->first);
+        sizes.push_back ((DWORD)source->data.size());
+        nextRevisions.push_back ((DWORD)source->next);
+        data.insert (data.end(), source->data.begin(), source->data.end());
+    }
+
+    // write list headers
+
+    *stream.OpenSubStream<CDiffDWORDOutStream> (PATHS_STREAM_ID) << paths;
+    *stream.OpenSubStream<CPackedDWORDOutStream> (SIZES_STREAM_ID) << sizes;
+    *stream.OpenSubStream<CPackedDWORDOutStream> (NEXT_REVISIONS_STREAM_ID)
+        << nextRevisions;
+
+    // write posting lists
+
+    stream.OpenSubStream<CBLOBOutStream> (POSTINGS_STREAM_ID)
+        ->Add (data.data(), data.size());
+}
+
+IHierarchicalInStream& operator>> ( IHierarchicalInStream& stream
+                                  , CPathHistoryIndex& index)
+{
+    index.Clear();
+
+    // read posting lists
+
+    CPathHistoryIndex::Read
+        ( *stream.GetSubStream (CPathHistoryIndex::SUBTREE_STREAM_ID)
+        , index.subtree);
+    CPathHistoryIndex::Read
+        ( *stream.GetSubStream (CPathHistoryIndex::STRUCTURAL_STREAM_ID)
+        , index.structural);
+
+    // read covered revision ranges
+
+    std::vector<DWORD> starts;
+    *stream.GetSubStream<CDiffDWORDInStream>
+        (CPathHistoryIndex::RANGE_STARTS_STREAM_ID) >> starts;
+
+    std::vector<DWORD> lengths;
+    *stream.GetSubStream<CPackedDWORDInStream>
+        (CPathHistoryIndex::RANGE_LENGTHS_STREAM_ID) >> lengths;
+
+    if (starts.size() != lengths.size())
+        throw CContainerException ("path history range count mismatch");
+
+    revision_t end = 0;
+    for (size_t i = 0, count = starts.size(); i < count; ++i)
+    {
+        if ((starts[i] < end) || (lengths[i] == 0) || (starts[i] + lengths[i] < starts[i]))
+            throw CContainerException ("invalid path history range");
+
+        end = starts[i] + lengths[i];
+        index.covered.insert (index.covered.end(), std::make_pair (starts[i], end));
+    }
+
+    // ready
+
+    return stream;
+}
+
+IHierarchicalOutStream& operator<< ( IHierarchicalOutStream& stream
+                                   , const CPathHistoryIndex& index)
+{
+    // write posting lists
+
+    CPathHistoryIndex::Write
+        ( *stream.OpenSubStream<CCompositeOutStream> (CPathHistoryIndex::SUBTREE_STREAM_ID)
+        , index.subtree);
+    CPathHistoryIndex::Write
+        ( *stream.OpenSubStream<CCompositeOutStream> (CPathHistoryIndex::STRUCTURAL_STREAM_ID)
+        , index.structural);
+
+    // write covered revision ranges
+
+    std::vector<DWORD> starts;
+    std::vector<DWORD> lengths;
+
+    for ( CPathHistoryIndex::TRanges::const_iterator iter = index.covered.begin()
+        , end = index.covered.end()
+        ; iter != end
+        ; ++iter)
+    {
+        starts.push_back ((DWORD)iter->first);
+        lengths.push_back ((DWORD)(iter->second - iter->first));
+    }
+
+    *stream.OpenSubStream<CDiffDWORDOutStream>
+        (CPathHistoryIndex::RANGE_STARTS_STREAM_ID) << starts;
+    *stream.OpenSubStream<CPackedDWORDOutStream>
+        (CPathHistoryIndex::RANGE_LENGTHS_STREAM_ID) << lengths;
+
+    // ready
+
+    return stream;
+}
+
+///////////////////////////////////////////////////////////////
+// end namespace LogCache
+///////////////////////////////////////////////////////////////
+
+}
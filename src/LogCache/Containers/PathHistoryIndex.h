@@ -0,0 +1,248 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+///////////////////////////////////////////////////////////////
+// necessary includes
+///////////////////////////////////////////////////////////////
+
+#include "LogCacheGlobals.h"
+
+///////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////
+
+class IHierarchicalInStream;
+class IHierarchicalOutStream;
+
+///////////////////////////////////////////////////////////////
+// begin namespace LogCache
+///////////////////////////////////////////////////////////////
+
+namespace LogCache
+{
+
+///////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////
+
+class CRevisionInfoContainer;
+class CDictionaryBasedTempPath;
+
+/**
+ * Reverse index from paths to the revisions that changed them.
+ *
+ * For every path ID, there are two lists of revisions:
+ *
+ *  - "subtree": the path itself or any of its sub-paths got changed
+ *  - "structural": the path itself has been added, deleted or replaced
+ *
+ * A revision may only be relevant for the log of a given path if it is
+ * in the subtree list of that path or in the structural list of the path
+ * or any of its parents (see CLogIteratorBase::PathInRevision()).
+ *
+ * The subtree list of the root path is not being stored as every revision
+ * is relevant to the root.
+ *
+ * Revisions may be added in any order, e.g. descending while the log is
+ * being received. The lists are stored as ascending sequences of
+ * differences in 7/8 code (see CPackedDWORDOutStreamBase). Revisions
+ * that cannot be appended are kept in an unsorted list until there are
+ * enough of them to re-encode the respective list.
+ *
+ * The index also keeps track of the revisions it covers, i.e. for which
+ * all changes have been added. Revisions not covered may always be
+ * relevant.
+ */
+class CPathHistoryIndex
+{
+private:
+
+    /// sub-stream IDs
+
+    enum
+    {
+        SUBTREE_STREAM_ID = 1,
+        STRUCTURAL_STREAM_ID = 2,
+        RANGE_STARTS_STREAM_ID = 3,
+        RANGE_LENGTHS_STREAM_ID = 4
+    };
+
+    /// sub-stream IDs of the posting list containers
+
+    enum
+    {
+        PATHS_STREAM_ID = 1,
+        SIZES_STREAM_ID = 2,
+        NEXT_REVISIONS_STREAM_ID = 3,
+        POSTINGS_STREAM_ID = 4
+    };
+
+    /**
+     * Revisions associated with a specific path.
+     */
+
+    struct SPostings
+    {
+        /// differences between consecutive revisions, 7/8 coded
+
+        std::vector<unsigned char> data;
+
+        /// one more than the last revision in data
+
+        revision_t next;
+
+        /// revisions not yet stored in data (in no particular order)
+
+        std::vector<revision_t> pending;
+
+        SPostings() : next (0) {}
+    };
+
+    typedef std::map<index_t, SPostings> TPostings;
+
+    /// the index data
+
+    TPostings subtree;
+    TPostings structural;
+
+    /// covered revision ranges (start -> end, exclusive)
+
+    typedef std::map<revision_t, revision_t> TRanges;
+    TRanges covered;
+
+    /// incremented upon every modification
+
+    DWORD updateCount;
+
+    /// utilities
+
+    static void Decode (const SPostings& postings, std::vector<revision_t>& revisions);
+    static void Encode (const std::vector<revision_t>& revisions, SPostings& postings);
+    static void Append (SPostings& postings, revision_t revision);
+
+    void AddCovered (revision_t revision);
+
+    static void Read (IHierarchicalInStream& stream, TPostings& postings);
+    static void Write (IHierarchicalOutStream& stream, const TPostings& postings);
+
+public:
+
+    /**
+     * Walks the history of a single path backwards using the index.
+     * Caches the path's candidate revisions until the path or the
+     * index changes.
+     */
+
+    class CCursor
+    {
+    private:
+
+        const CPathHistoryIndex* index;
+
+        /// for which path and index state is the cache valid?
+
+        index_t pathID;
+        bool fullyCached;
+        DWORD updateCount;
+
+        /// ascending list of revisions that may be relevant to the path
+
+        std::vector<revision_t> candidates;
+
+    public:
+
+        /// construction
+
+        CCursor (const CPathHistoryIndex* index);
+
+        /// Return the highest revision not exceeding \a revision that
+        /// may be relevant to \a path (i.e. is not covered or is a
+        /// candidate). Returns NO_REVISION, if there is none.
+
+        revision_t GetPrevious ( const CDictionaryBasedTempPath& path
+                               , revision_t revision);
+    };
+
+    /// construction / destruction
+
+    CPathHistoryIndex(void);
+    virtual ~CPathHistoryIndex(void);
+
+    /// number of indexed paths
+
+    size_t size() const
+    {
+        return subtree.size();
+    }
+
+    /// add all changes of \a revision, i.e. those at \a index
+    /// in \a logInfo. May be called more than once per revision.
+
+    void Add ( revision_t revision
+             , const CRevisionInfoContainer& logInfo
+             , index_t index);
+
+    /// the changes of \a revision are no longer known.
+    /// Its entries in the lists may remain.
+
+    void Uncover (revision_t revision);
+
+    /// all changes of \a revision have been added
+
+    bool IsCovered (revision_t revision) const;
+
+    /// highest revision not exceeding \a revision that is not covered.
+    /// Returns NO_REVISION, if there is none.
+
+    revision_t GetPreviousUncovered (revision_t revision) const;
+
+    /// one more than the highest covered revision
+
+    revision_t GetCoveredEnd() const;
+
+    /// Fills \a revisions with the ascending list of all revisions
+    /// that may be relevant to \a path.
+
+    void GetCandidates ( const CDictionaryBasedTempPath& path
+                       , std::vector<revision_t>& revisions) const;
+
+    void Clear();
+    void Swap (CPathHistoryIndex& rhs);
+
+    /// stream I/O
+
+    friend IHierarchicalInStream& operator>> ( IHierarchicalInStream& stream
+                                             , CPathHistoryIndex& index);
+    friend IHierarchicalOutStream& operator<< ( IHierarchicalOutStream& stream
+                                              , const CPathHistoryIndex& index);
+};
+
+/// stream I/O
+
+IHierarchicalInStream& operator>> ( IHierarchicalInStream& stream
+                                  , CPathHistoryIndex& index);
+IHierarchicalOutStream& operator<< ( IHierarchicalOutStream& stream
+                                   , const CPathHistoryIndex& index);
+
+///////////////////////////////////////////////////////////////
+// end namespace LogCache
+///////////////////////////////////////////////////////////////
+
+}
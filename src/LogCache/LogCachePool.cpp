@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2012, 2014-2015 - TortoiseSVN
+// Copyright (C) 2007-2012, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -216,6 +216,8 @@ CCachedLogInfo* CLogCachePool::GetCache (const CString& uuid, const CString& roo
     std::wstring fileName = (LPCTSTR)(cacheFolderPath + info->fileName);
     std::unique_ptr<CCachedLogInfo> cache (new CCachedLogInfo (fileName));
 
+    cache->EnableSearchIndex (CSettings::GetEnableSearchIndex());
+    cache->EnablePathHistoryIndex (CSettings::GetEnablePathIndex());
     cache->Load (CSettings::GetMaxFailuresUntilDrop());
 
     caches[info->fileName] = cache.get();
@@ -282,6 +284,19 @@ void CLogCachePool::DropCache (const CString& uuid, const CString& root)
     if (FileExists (fileName + L".lock"))
         DeleteFile ((fileName + L".lock").c_str());
 
+    // revision graphs stored next to the cache (see CFullGraphCache)
+
+    WIN32_FIND_DATA dirEntry;
+    CAutoFindFile handle = FindFirstFile ((fileName + L".*.graph").c_str(), &dirEntry);
+    if (handle)
+    {
+        do
+        {
+            DeleteFile (cacheFolderPath + dirEntry.cFileName);
+        }
+        while (FindNextFile (handle, &dirEntry));
+    }
+
     // remove from cache info list
 
     repositoryInfo->DropEntry (uuid, root);
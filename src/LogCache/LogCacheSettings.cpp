@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2007, 2009, 2014 - TortoiseSVN
+// Copyright (C) 2007-2007, 2009, 2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -40,6 +40,8 @@ CSettings::CSettings()
     , cacheDropAge (REGKEY ("CacheDropAge"), 10)
     , cacheDropMaxSize (REGKEY ("CacheDropMaxSize"), 200)
     , maxFailuresUntilDrop (REGKEY ("MaxCacheFailures"), 0)
+    , enableSearchIndex (REGKEY ("SearchIndex"), FALSE)
+    , enablePathIndex (REGKEY ("PathIndex"), FALSE)
 {
     // auto-migration
 
@@ -193,6 +195,30 @@ void CSettings::SetMaxFailuresUntilDrop (int limit)
     Store (limit, GetInstance().maxFailuresUntilDrop);
 }
 
+/// full-text search support
+
+bool CSettings::GetEnableSearchIndex()
+{
+    return (DWORD)GetInstance().enableSearchIndex != FALSE;
+}
+
+void CSettings::SetEnableSearchIndex (bool enabled)
+{
+    Store (enabled ? TRUE : FALSE, GetInstance().enableSearchIndex);
+}
+
+/// per-path history lookup
+
+bool CSettings::GetEnablePathIndex()
+{
+    return (DWORD)GetInstance().enablePathIndex != FALSE;
+}
+
+void CSettings::SetEnablePathIndex (bool enabled)
+{
+    Store (enabled ? TRUE : FALSE, GetInstance().enablePathIndex);
+}
+
 // end namespace LogCache
 
 }
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2010, 2012, 2014-2015 - TortoiseSVN
+// Copyright (C) 2007-2010, 2012, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -64,6 +64,9 @@ private:
 
     CRegDWORD maxFailuresUntilDrop;
 
+    CRegDWORD enableSearchIndex;
+    CRegDWORD enablePathIndex;
+
     /// singleton construction
 
     CSettings();
@@ -131,6 +134,16 @@ public:
 
     static int GetMaxFailuresUntilDrop();
     static void SetMaxFailuresUntilDrop (int limit);
+
+    /// maintain a full-text index over authors and comments
+
+    static bool GetEnableSearchIndex();
+    static void SetEnableSearchIndex (bool enabled);
+
+    /// maintain a reverse index from paths to revisions
+
+    static bool GetEnablePathIndex();
+    static void SetEnablePathIndex (bool enabled);
 };
 
 ///////////////////////////////////////////////////////////////
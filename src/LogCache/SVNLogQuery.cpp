@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2011, 2013-2015 - TortoiseSVN
+// Copyright (C) 2007-2011, 2013-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -31,6 +31,7 @@
 #include "SVN.h"
 #include "SVNError.h"
 #include "SVNHelpers.h"
+#include "SVNRASessionPool.h"
 #include "TSVNPath.h"
 #include "SVNTrace.h"
 #include "Hooks.h"
@@ -271,6 +272,7 @@ svn_error_t* CSVNLogQuery::LogReceiver ( void *baton
 
     // now, report the change
 
+    receiverBaton->received = true;
     try
     {
         MergeInfo mergeInfo = { log_entry->has_children != FALSE
@@ -301,6 +303,60 @@ svn_error_t* CSVNLogQuery::LogReceiver ( void *baton
     return NULL;
 }
 
+// use a session from the SVNRASessionPool
+
+bool CSVNLogQuery::LogWithPooledSession ( const char* url
+                                        , const SVNRev& start
+                                        , const SVNRev& end
+                                        , int limit
+                                        , bool strictNodeHistory
+                                        , bool includeChanges
+                                        , bool includeMerges
+                                        , const apr_array_header_t* revprops
+                                        , SBaton& baton
+                                        , apr_pool_t* pool)
+{
+    SVNRASessionPool::Session session
+        = SVNRASessionPool::Instance().Checkout ( url
+                                                , context->cancel_func
+                                                , context->cancel_baton);
+    if (!session)
+        return false;
+
+    apr_array_header_t* paths = apr_array_make (pool, 1, sizeof (const char*));
+    APR_ARRAY_PUSH (paths, const char*) = "";
+
+    SVNTRACE (
+        svn_error_t *result = svn_ra_get_log2 ( session.Get()
+                                              , paths
+                                              , (LONG)start
+                                              , (LONG)end
+                                              , limit
+                                              , includeChanges
+                                              , strictNodeHistory
+                                              , includeMerges
+                                              , revprops
+                                              , LogReceiver
+                                              , (void *)&baton
+                                              , pool),
+        NULL
+    );
+
+    if (result == NULL)
+        return true;
+
+    session.Discard();
+
+    // let svn_client_log5() retry and report the error,
+    // unless the receiver already got some of the data
+
+    if (baton.received)
+        throw SVNError (result);
+
+    svn_error_clear (result);
+    return false;
+}
+
 CSVNLogQuery::CSVNLogQuery (svn_client_ctx_t *context, apr_pool_t *pool)
     : context (context)
     , pool (pool)
@@ -333,7 +389,8 @@ void CSVNLogQuery::Log ( const CTSVNPathList& targets
     SBaton baton = { receiver
                    , includeChanges
                    , includeStandardRevProps
-                   , includeUserRevProps};
+                   , includeUserRevProps
+                   , false };
 
     // list of revision ranges to fetch
     // (as of now, there is only one such range)
@@ -395,6 +452,28 @@ void CSVNLogQuery::Log ( const CTSVNPathList& targets
     }
 
     CHooks::Instance().PreConnect(targets);
+
+    // a single URL at its peg revision doesn't need any path resolution
+
+    if (   (targets.GetCount() == 1)
+        && targets[0].IsUrl()
+        && peg_revision.IsNumber()
+        && start.IsNumber()
+        && end.IsNumber()
+        && ((LONG)peg_revision == (LONG)start)
+        && ((LONG)start >= (LONG)end)
+        && LogWithPooledSession ( targets[0].GetSVNApiPath (localpool)
+                                , start
+                                , end
+                                , limit
+                                , strictNodeHistory
+                                , includeChanges
+                                , includeMerges
+                                , revprops
+                                , baton
+                                , localpool))
+        return;
+
     SVNTRACE (
         svn_error_t *result = svn_client_log5 ( targets.MakePathArray (localpool)
                                               , peg_revision
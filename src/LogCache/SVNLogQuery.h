@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007-2009, 2011-2012 - TortoiseSVN
+// Copyright (C) 2007-2009, 2011-2012, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -51,6 +51,9 @@ private:
         bool includeChanges;
         bool includeStandardRevProps;
         bool includeUserRevProps;
+
+        /// set once the first entry has been passed to the receiver
+        bool received;
     };
 
     /// SVN API utility
@@ -63,6 +66,21 @@ private:
 
     const TRevPropNames& GetStandardRevProps();
 
+    /// svn_client_log5() replacement for a single URL without
+    /// peg revision resolution, using an already open RA session.
+    /// Returns false, if Log() has to call svn_client_log5().
+
+    bool LogWithPooledSession ( const char* url
+                              , const SVNRev& start
+                              , const SVNRev& end
+                              , int limit
+                              , bool strictNodeHistory
+                              , bool includeChanges
+                              , bool includeMerges
+                              , const apr_array_header_t* revprops
+                              , SBaton& baton
+                              , apr_pool_t* pool);
+
     /// SVN callback. Route data to receiver
 
     static svn_error_t* LogReceiver ( void *baton
@@ -0,0 +1,300 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "../../TortoiseIDiff/ImageCompare.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    TEST_CLASS(ImageCompareTests)
+    {
+    private:
+        unsigned int seed;
+
+        uint32_t Random()
+        {
+            seed = seed * 1103515245 + 12345;
+            uint32_t high = seed >> 16;
+            seed = seed * 1103515245 + 12345;
+            return (high << 16) | (seed >> 16);
+        }
+
+        /// two images which differ in about every fourth pixel,
+        /// by small and large amounts
+        void MakeImages(int width, int height, ptrdiff_t stride,
+                        std::vector<uint32_t>& pixels1, std::vector<uint32_t>& pixels2)
+        {
+            pixels1.assign((size_t)stride * height, 0);
+            pixels2.assign((size_t)stride * height, 0);
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    uint32_t pixel = Random();
+                    pixels1[y * stride + x] = pixel;
+                    switch (Random() % 8)
+                    {
+                    case 0:
+                        pixel ^= 0x01 << ((Random() % 4) * 8);
+                        break;
+                    case 1:
+                        pixel ^= Random();
+                        break;
+                    default:
+                        break;
+                    }
+                    pixels2[y * stride + x] = pixel;
+                }
+                // the padding must not be compared
+                for (ptrdiff_t x = width; x < stride; ++x)
+                {
+                    pixels1[y * stride + x] = 0;
+                    pixels2[y * stride + x] = 0xFFFFFFFF;
+                }
+            }
+        }
+
+        static int PixelDifference(uint32_t a, uint32_t b)
+        {
+            int maxDiff = 0;
+            for (int shift = 0; shift < 32; shift += 8)
+                maxDiff = (std::max)(maxDiff, abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)));
+            return maxDiff;
+        }
+
+        static void AssertSameResult(const CImageCompare& expected, const CImageCompare& actual)
+        {
+            Assert::AreEqual(expected.GetWidth(), actual.GetWidth());
+            Assert::AreEqual(expected.GetHeight(), actual.GetHeight());
+            Assert::IsTrue(expected.GetMask() == actual.GetMask());
+
+            const CImageCompare::Statistics& stats1 = expected.GetStatistics();
+            const CImageCompare::Statistics& stats2 = actual.GetStatistics();
+            Assert::AreEqual(stats1.comparedPixels, stats2.comparedPixels);
+            Assert::AreEqual(stats1.changedPixels, stats2.changedPixels);
+            Assert::AreEqual(stats1.maxDifference, stats2.maxDifference);
+            Assert::AreEqual(stats1.meanDifference, stats2.meanDifference);
+
+            const auto& regions1 = expected.GetRegions();
+            const auto& regions2 = actual.GetRegions();
+            Assert::AreEqual(regions1.size(), regions2.size());
+            for (size_t i = 0; i < regions1.size(); ++i)
+            {
+                Assert::AreEqual(regions1[i].left, regions2[i].left);
+                Assert::AreEqual(regions1[i].top, regions2[i].top);
+                Assert::AreEqual(regions1[i].right, regions2[i].right);
+                Assert::AreEqual(regions1[i].bottom, regions2[i].bottom);
+            }
+        }
+
+        /// compares the images with every kernel the CPU supports and checks
+        /// that the vector kernels give the same results as the scalar one
+        void CompareKernels(int width, int height, int threshold)
+        {
+            ptrdiff_t stride = width + 3;
+            std::vector<uint32_t> pixels1;
+            std::vector<uint32_t> pixels2;
+            MakeImages(width, height, stride, pixels1, pixels2);
+            CImageCompare::Image image1 = { pixels1.data(), width, height, stride };
+            CImageCompare::Image image2 = { pixels2.data(), width, height, stride };
+
+            CImageCompare scalar;
+            scalar.SetKernel(CImageCompare::KERNEL_SCALAR);
+            Assert::IsTrue(scalar.GetKernel() == CImageCompare::KERNEL_SCALAR);
+            scalar.Compare(image1, image2, threshold);
+
+            // the scalar kernel against a plain loop
+            uint64_t changed = 0;
+            uint64_t sum = 0;
+            int maxDiff = 0;
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    int diff = PixelDifference(pixels1[y * stride + x], pixels2[y * stride + x]);
+                    Assert::AreEqual(diff, (int)scalar.GetMask()[(size_t)y * width + x]);
+                    sum += diff;
+                    maxDiff = (std::max)(maxDiff, diff);
+                    if (diff > threshold)
+                        ++changed;
+                }
+            }
+            Assert::AreEqual(changed, scalar.GetStatistics().changedPixels);
+            Assert::AreEqual(maxDiff, scalar.GetStatistics().maxDifference);
+            Assert::AreEqual((double)sum / ((uint64_t)width * height), scalar.GetStatistics().meanDifference);
+
+            const CImageCompare::Kernel kernels[] = { CImageCompare::KERNEL_SSE2, CImageCompare::KERNEL_AVX2 };
+            for (auto kernel : kernels)
+            {
+                CImageCompare vector;
+                vector.SetKernel(kernel);
+                if (vector.GetKernel() != kernel)
+                {
+                    Logger::WriteMessage(kernel == CImageCompare::KERNEL_AVX2 ? L"AVX2 is not supported\n" : L"SSE2 is not supported\n");
+                    continue;
+                }
+                vector.Compare(image1, image2, threshold);
+                AssertSameResult(scalar, vector);
+            }
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            seed = 4711;
+        }
+
+        TEST_METHOD(KernelsTest)
+        {
+            // around the SSE2 (16) and AVX2 (32) block sizes and the tile size (64)
+            const int widths[] = { 1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 97, 130 };
+            for (int width : widths)
+            {
+                CompareKernels(width, 5, 0);
+                CompareKernels(width, 67, 10);
+            }
+        }
+
+        TEST_METHOD(ThreadsTest)
+        {
+            // big enough for several threads, with a partial last tile in both directions
+            CompareKernels(1025, 777, 0);
+            CompareKernels(1025, 777, 128);
+        }
+
+        TEST_METHOD(ThresholdTest)
+        {
+            // the channel differences are exactly the threshold and one more
+            const int width = 37;
+            std::vector<uint32_t> pixels1(width, 0x40404040);
+            std::vector<uint32_t> pixels2(width, 0x40404040);
+            for (int x = 0; x < width; x += 2)
+                pixels2[x] = (x % 4) ? 0x40404045 : 0x46404040;
+            CImageCompare::Image image1 = { pixels1.data(), width, 1, width };
+            CImageCompare::Image image2 = { pixels2.data(), width, 1, width };
+
+            const CImageCompare::Kernel kernels[] = { CImageCompare::KERNEL_SCALAR, CImageCompare::KERNEL_SSE2, CImageCompare::KERNEL_AVX2 };
+            for (auto kernel : kernels)
+            {
+                CImageCompare compare;
+                compare.SetKernel(kernel);
+                compare.Compare(image1, image2, 5);
+                // only the pixels which differ by 6
+                Assert::AreEqual((uint64_t)10, compare.GetStatistics().changedPixels);
+                Assert::AreEqual(6, compare.GetStatistics().maxDifference);
+            }
+        }
+
+        TEST_METHOD(StripsTest)
+        {
+            const int width = 70;
+            const int height = 150;
+            std::vector<uint32_t> pixels1;
+            std::vector<uint32_t> pixels2;
+            MakeImages(width, height, width, pixels1, pixels2);
+
+            CImageCompare whole;
+            CImageCompare::Image image1 = { pixels1.data(), width, height, width };
+            CImageCompare::Image image2 = { pixels2.data(), width, height, width };
+            whole.Compare(image1, image2, 3);
+
+            // strips which don't end at tile boundaries
+            CImageCompare strips;
+            strips.Begin(width, height, 3);
+            for (int row = 0; row < height; row += 41)
+            {
+                int rows = (std::min)(41, height - row);
+                CImageCompare::Image strip1 = { pixels1.data() + row * width, width, rows, width };
+                CImageCompare::Image strip2 = { pixels2.data() + row * width, width, rows, width };
+                strips.CompareRows(strip1, strip2, row);
+            }
+            strips.End();
+            AssertSameResult(whole, strips);
+        }
+
+        TEST_METHOD(RegionsTest)
+        {
+            const int width = 300;
+            const int height = 200;
+            std::vector<uint32_t> pixels1(width * height, 0xFF808080);
+            std::vector<uint32_t> pixels2(pixels1);
+            // one change in the first tile, one spanning two tiles far away
+            pixels2[10 * width + 5] = 0xFF808081;
+            pixels2[150 * width + 250] = 0xFF000000;
+            pixels2[140 * width + 190] = 0xFF000000;
+
+            CImageCompare compare;
+            CImageCompare::Image image1 = { pixels1.data(), width, height, width };
+            CImageCompare::Image image2 = { pixels2.data(), width, height, width };
+            compare.Compare(image1, image2);
+
+            const auto& regions = compare.GetRegions();
+            Assert::AreEqual((size_t)2, regions.size());
+            Assert::AreEqual(5, regions[0].left);
+            Assert::AreEqual(10, regions[0].top);
+            Assert::AreEqual(6, regions[0].right);
+            Assert::AreEqual(11, regions[0].bottom);
+            Assert::AreEqual(190, regions[1].left);
+            Assert::AreEqual(140, regions[1].top);
+            Assert::AreEqual(251, regions[1].right);
+            Assert::AreEqual(151, regions[1].bottom);
+            Assert::AreEqual((uint64_t)3, compare.GetStatistics().changedPixels);
+        }
+
+        TEST_METHOD(PixelOperationsTest)
+        {
+            const size_t counts[] = { 1, 3, 4, 5, 17 };
+            for (size_t count : counts)
+            {
+                std::vector<uint32_t> pixels1(count);
+                std::vector<uint32_t> pixels2(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    pixels1[i] = Random();
+                    pixels2[i] = Random();
+                }
+
+                std::vector<uint32_t> dest(count);
+                CImageCompare::XorPixels(pixels1.data(), pixels2.data(), dest.data(), count);
+                for (size_t i = 0; i < count; ++i)
+                    Assert::AreEqual(~(pixels1[i] ^ pixels2[i]), dest[i]);
+
+                // both ends of the alpha range give one of the images
+                CImageCompare::BlendPixels(pixels1.data(), pixels2.data(), dest.data(), count, 0);
+                Assert::IsTrue(dest == pixels1);
+                CImageCompare::BlendPixels(pixels1.data(), pixels2.data(), dest.data(), count, 255);
+                Assert::IsTrue(dest == pixels2);
+
+                CImageCompare::BlendPixels(pixels1.data(), pixels2.data(), dest.data(), count, 128);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    for (int shift = 0; shift < 32; shift += 8)
+                    {
+                        int a = (pixels1[i] >> shift) & 0xFF;
+                        int b = (pixels2[i] >> shift) & 0xFF;
+                        Assert::AreEqual((a * 127 + b * 129) >> 8, (int)((dest[i] >> shift) & 0xFF));
+                    }
+                }
+            }
+        }
+    };
+}
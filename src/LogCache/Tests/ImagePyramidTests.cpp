@@ -0,0 +1,239 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "../../TortoiseIDiff/ImagePyramid.h"
+#include <future>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    TEST_CLASS(ImagePyramidTests)
+    {
+    private:
+        /// an opaque pixel which tells where it came from
+        static uint32_t TestPixel(int x, int y)
+        {
+            return 0xFF000000 | ((y & 0xFFF) << 12) | (x & 0xFFF);
+        }
+
+        /// records the requested parts and fills them with TestPixel()
+        struct TestSource
+        {
+            struct Request
+            {
+                int left;
+                int top;
+                int width;
+                int height;
+            };
+
+            std::vector<Request>    requests;
+            size_t                  failAt;
+
+            TestSource() : failAt((size_t)-1) {}
+
+            bool operator()(int left, int top, int width, int height, uint32_t * pixels, ptrdiff_t stride)
+            {
+                if (requests.size() == failAt)
+                    return false;
+                Request request = { left, top, width, height };
+                requests.push_back(request);
+                for (int y = 0; y < height; ++y)
+                    for (int x = 0; x < width; ++x)
+                        pixels[y * stride + x] = TestPixel(left + x, top + y);
+                return true;
+            }
+        };
+
+    public:
+        TEST_METHOD(LevelSizesTest)
+        {
+            CImagePyramid pyramid;
+            Assert::IsFalse(pyramid.Create(0, 5));
+            Assert::IsFalse(pyramid.Create(5, -1));
+            Assert::AreEqual(0, pyramid.GetLevelCount());
+            Assert::IsFalse(pyramid.IsValid());
+
+            // a single tile is enough
+            Assert::IsTrue(pyramid.Create(1, 1));
+            Assert::AreEqual(1, pyramid.GetLevelCount());
+            Assert::IsTrue(pyramid.Create(256, 256));
+            Assert::AreEqual(1, pyramid.GetLevelCount());
+
+            // odd sizes are rounded up, down to a level which fits into a tile
+            Assert::IsTrue(pyramid.Create(1000, 301));
+            Assert::AreEqual(3, pyramid.GetLevelCount());
+            const int widths[] = { 1000, 500, 250 };
+            const int heights[] = { 301, 151, 76 };
+            for (int level = 0; level < 3; ++level)
+            {
+                Assert::AreEqual(widths[level], pyramid.GetLevelWidth(level));
+                Assert::AreEqual(heights[level], pyramid.GetLevelHeight(level));
+            }
+
+            Assert::IsTrue(pyramid.Create(257, 1));
+            Assert::AreEqual(2, pyramid.GetLevelCount());
+            Assert::AreEqual(129, pyramid.GetLevelWidth(1));
+            Assert::AreEqual(1, pyramid.GetLevelHeight(1));
+
+            // nothing is ready before the full size level has been filled
+            Assert::IsFalse(pyramid.IsValid());
+            Assert::IsFalse(pyramid.IsLoading());
+        }
+
+        TEST_METHOD(TileEdgesTest)
+        {
+            const int width = 300;
+            const int height = 520;
+            CImagePyramid pyramid;
+            Assert::IsTrue(pyramid.Create(width, height));
+
+            TestSource source;
+            Assert::IsTrue(pyramid.LoadTiles(std::ref(source)));
+
+            // every tile is read once, the last column and row are partial
+            const int tileWidths[] = { 256, 44 };
+            const int tileHeights[] = { 256, 256, 8 };
+            Assert::AreEqual((size_t)6, source.requests.size());
+            for (size_t i = 0; i < source.requests.size(); ++i)
+            {
+                const auto& request = source.requests[i];
+                Assert::AreEqual((int)(i % 2) * 256, request.left);
+                Assert::AreEqual((int)(i / 2) * 256, request.top);
+                Assert::AreEqual(tileWidths[i % 2], request.width);
+                Assert::AreEqual(tileHeights[i / 2], request.height);
+            }
+
+            pyramid.BuildLevels();
+            Assert::AreEqual(pyramid.GetLevelCount(), pyramid.GetReadyLevels());
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    Assert::AreEqual(TestPixel(x, y), pyramid.GetPixel(0, x, y));
+
+            // filling by rows gives the same tiles
+            std::vector<uint32_t> rows((size_t)width * 100);
+            CImagePyramid byRows;
+            Assert::IsTrue(byRows.Create(width, height));
+            for (int row = 0; row < height; row += 100)
+            {
+                int count = (std::min)(100, height - row);
+                for (int y = 0; y < count; ++y)
+                    for (int x = 0; x < width; ++x)
+                        rows[y * width + x] = TestPixel(x, row + y);
+                byRows.SetRows(rows.data(), width, row, count);
+            }
+            byRows.BuildLevels();
+            for (int level = 0; level < pyramid.GetLevelCount(); ++level)
+                for (int y = 0; y < pyramid.GetLevelHeight(level); ++y)
+                    for (int x = 0; x < pyramid.GetLevelWidth(level); ++x)
+                        Assert::AreEqual(pyramid.GetPixel(level, x, y), byRows.GetPixel(level, x, y));
+        }
+
+        TEST_METHOD(OddDimensionsTest)
+        {
+            // the last column and row of an odd sized level have no partner,
+            // they must not be mixed with pixels outside the image
+            const int width = 513;
+            const int height = 257;
+            const uint32_t inner = 0xFF204060;
+            const uint32_t edge = 0xFFC0A080;
+            std::vector<uint32_t> pixels((size_t)width * height, inner);
+            for (int y = 0; y < height; ++y)
+                pixels[y * width + width - 1] = edge;
+            for (int x = 0; x < width; ++x)
+                pixels[(height - 1) * width + x] = edge;
+
+            CImagePyramid pyramid;
+            Assert::IsTrue(pyramid.Create(width, height));
+            pyramid.SetRows(pixels.data(), width, 0, height);
+            pyramid.BuildLevels();
+
+            Assert::AreEqual(3, pyramid.GetLevelCount());
+            Assert::AreEqual(257, pyramid.GetLevelWidth(1));
+            Assert::AreEqual(129, pyramid.GetLevelHeight(1));
+            Assert::AreEqual(129, pyramid.GetLevelWidth(2));
+            Assert::AreEqual(65, pyramid.GetLevelHeight(2));
+            for (int level = 1; level < pyramid.GetLevelCount(); ++level)
+            {
+                int lastX = pyramid.GetLevelWidth(level) - 1;
+                int lastY = pyramid.GetLevelHeight(level) - 1;
+                Assert::AreEqual(inner, pyramid.GetPixel(level, 0, 0));
+                Assert::AreEqual(inner, pyramid.GetPixel(level, lastX - 1, lastY - 1));
+                Assert::AreEqual(edge, pyramid.GetPixel(level, lastX, 0));
+                Assert::AreEqual(edge, pyramid.GetPixel(level, 0, lastY));
+                Assert::AreEqual(edge, pyramid.GetPixel(level, lastX, lastY));
+            }
+
+            // drawing the full size gives the opaque pixels without the alpha channel
+            std::vector<uint32_t> dest((size_t)width * height);
+            Assert::IsTrue(pyramid.Sample(width, height, 0, 0, width, height, dest.data(), width, 0));
+            for (size_t i = 0; i < dest.size(); ++i)
+                Assert::AreEqual(pixels[i] & 0xFFFFFF, dest[i]);
+        }
+
+        TEST_METHOD(AsyncTest)
+        {
+            CImagePyramid pyramid;
+            Assert::IsTrue(pyramid.Create(700, 600));
+            int levelCount = pyramid.GetLevelCount();
+
+            TestSource source;
+            std::vector<int> levels;
+            std::promise<void> done;
+            pyramid.BuildAsync(std::ref(source), [&](int level)
+            {
+                levels.push_back(level);
+                if ((level < 0) || (level + 1 == levelCount))
+                    done.set_value();
+            });
+            done.get_future().wait();
+            pyramid.Clear();
+
+            // the full size level first, then every smaller one
+            Assert::AreEqual((size_t)levelCount, levels.size());
+            for (int level = 0; level < levelCount; ++level)
+                Assert::AreEqual(level, levels[level]);
+            Assert::AreEqual((size_t)9, source.requests.size());
+        }
+
+        TEST_METHOD(AsyncFailureTest)
+        {
+            CImagePyramid pyramid;
+            Assert::IsTrue(pyramid.Create(700, 600));
+
+            TestSource source;
+            source.failAt = 4;
+            std::promise<int> done;
+            pyramid.BuildAsync(std::ref(source), [&](int level)
+            {
+                done.set_value(level);
+            });
+            Assert::AreEqual(-1, done.get_future().get());
+
+            // no level can be used, and the source isn't called anymore
+            Assert::IsFalse(pyramid.IsValid());
+            Assert::IsFalse(pyramid.IsLoading());
+            Assert::AreEqual((size_t)4, source.requests.size());
+            pyramid.Clear();
+        }
+    };
+}
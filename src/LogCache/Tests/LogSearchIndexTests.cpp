@@ -0,0 +1,305 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "TestTempFile.h"
+#include "LogSearchIndex.h"
+#include "CachedLogInfo.h"
+#include "RootOutStream.h"
+#include "RootInStream.h"
+#include "BLOBOutStream.h"
+#include "PackedDWORDOutStream.h"
+#include "DiffIntegerOutStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    TEST_CLASS(LogSearchIndexTests)
+    {
+    public:
+        TEST_METHOD(EmptyTest)
+        {
+            CTestTempFile tmpFile;
+            {
+                CRootOutStream strm(tmpFile.GetFileName());
+                LogCache::CLogSearchIndex index;
+
+                Assert::AreEqual((LogCache::index_t)0, index.size());
+
+                // Save data to stream.
+                strm << index;
+            }
+
+            {
+                CRootInStream strm(tmpFile.GetFileName());
+                LogCache::CLogSearchIndex index;
+
+                // Load data to stream.
+                strm >> index;
+
+                Assert::AreEqual((LogCache::index_t)0, index.size());
+                Assert::AreEqual((size_t)0, index.GetTrigramCount());
+
+                std::vector<LogCache::index_t> candidates;
+                Assert::IsTrue(index.GetCandidates("log", candidates));
+                Assert::IsTrue(candidates.empty());
+            }
+        }
+
+        TEST_METHOD(CandidatesTest)
+        {
+            LogCache::CLogSearchIndex index;
+            AddTestData(index);
+
+            Assert::AreEqual((LogCache::index_t)300, index.size());
+
+            std::vector<LogCache::index_t> candidates;
+
+            // case-insensitive lookup in authors and comments
+            Assert::IsTrue(index.GetCandidates("LOG", candidates));
+            Assert::AreEqual((size_t)2, candidates.size());
+            Assert::AreEqual((LogCache::index_t)0, candidates[0]);
+            Assert::AreEqual((LogCache::index_t)1, candidates[1]);
+
+            Assert::IsTrue(index.GetCandidates("carol", candidates));
+            Assert::AreEqual((size_t)1, candidates.size());
+            Assert::AreEqual((LogCache::index_t)299, candidates[0]);
+
+            // all trigrams must be present
+            Assert::IsTrue(index.GetCandidates("cache index", candidates));
+            Assert::AreEqual((size_t)1, candidates.size());
+            Assert::AreEqual((LogCache::index_t)1, candidates[0]);
+
+            Assert::IsTrue(index.GetCandidates("xyz", candidates));
+            Assert::IsTrue(candidates.empty());
+
+            // too short to use the index
+            Assert::IsFalse(index.GetCandidates("lo", candidates));
+        }
+
+        TEST_METHOD(ReAddTest)
+        {
+            LogCache::CLogSearchIndex index;
+            AddTestData(index);
+
+            // edited comment of an older entry
+            index.Add(150, "bob", "Log message edited");
+
+            std::vector<LogCache::index_t> candidates;
+            Assert::IsTrue(index.GetCandidates("log", candidates));
+            Assert::AreEqual((size_t)3, candidates.size());
+            Assert::AreEqual((LogCache::index_t)0, candidates[0]);
+            Assert::AreEqual((LogCache::index_t)1, candidates[1]);
+            Assert::AreEqual((LogCache::index_t)150, candidates[2]);
+
+            // adding the same text again does not change anything
+            index.Add(150, "bob", "Log message edited");
+
+            Assert::IsTrue(index.GetCandidates("log", candidates));
+            Assert::AreEqual((size_t)3, candidates.size());
+            Assert::AreEqual((LogCache::index_t)300, index.size());
+        }
+
+        TEST_METHOD(SimpleTest)
+        {
+            CTestTempFile tmpFile;
+            {
+                CRootOutStream strm(tmpFile.GetFileName());
+                LogCache::CLogSearchIndex index;
+                AddTestData(index);
+
+                // Save data to stream.
+                strm << index;
+            }
+
+            {
+                CRootInStream strm(tmpFile.GetFileName());
+                LogCache::CLogSearchIndex index;
+
+                // Load data to stream.
+                strm >> index;
+
+                Assert::AreEqual((LogCache::index_t)300, index.size());
+
+                std::vector<LogCache::index_t> candidates;
+                Assert::IsTrue(index.GetCandidates("revision 2", candidates));
+                Assert::AreEqual((size_t)111, candidates.size());
+                Assert::AreEqual((LogCache::index_t)2, candidates[0]);
+
+                // appending still works after loading
+                index.Add(300, "dave", "More log data");
+
+                Assert::IsTrue(index.GetCandidates("log", candidates));
+                Assert::AreEqual((size_t)3, candidates.size());
+                Assert::AreEqual((LogCache::index_t)300, candidates[2]);
+            }
+        }
+
+        TEST_METHOD(DamagedPostingsTest)
+        {
+            CTestTempFile tmpFile;
+            {
+                // same layout as written by CLogSearchIndex: a single
+                // list for "log" that covers 2 entries but refers to
+                // entry 100 and an overlong code
+                CRootOutStream strm(tmpFile.GetFileName());
+
+                std::vector<DWORD> trigrams(1, ('l' << 16) + ('o' << 8) + 'g');
+                std::vector<DWORD> sizes(1, 9);
+                std::vector<DWORD> nextIndices(1, 2);
+                const unsigned char data[] = { 100, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 };
+
+                *strm.OpenSubStream<CDiffDWORDOutStream>(1) << trigrams;
+                *strm.OpenSubStream<CPackedDWORDOutStream>(2) << sizes;
+                CPackedDWORDOutStream* nextIndicesStream = strm.OpenSubStream<CPackedDWORDOutStream>(3);
+                nextIndicesStream->AddSizeValue(2);
+                *nextIndicesStream << nextIndices;
+                strm.OpenSubStream<CBLOBOutStream>(4)->Add(data, sizeof(data));
+            }
+
+            {
+                CRootInStream strm(tmpFile.GetFileName());
+                LogCache::CLogSearchIndex index;
+                strm >> index;
+
+                Assert::AreEqual((LogCache::index_t)2, index.size());
+
+                // the damaged list must not be used
+                std::vector<LogCache::index_t> candidates;
+                Assert::IsFalse(index.GetCandidates("log", candidates));
+                Assert::IsTrue(candidates.empty());
+
+                // unknown trigrams still mean "no match"
+                Assert::IsTrue(index.GetCandidates("xyz", candidates));
+                Assert::IsTrue(candidates.empty());
+            }
+        }
+
+        TEST_METHOD(ContainsTest)
+        {
+            std::string pattern = LogCache::CLogSearchIndex::FoldCase("Cache");
+            Assert::AreEqual("cache", pattern.c_str());
+
+            Assert::IsTrue(LogCache::CLogSearchIndex::Contains("Log CACHE", pattern));
+            Assert::IsFalse(LogCache::CLogSearchIndex::Contains("Log CACH", pattern));
+            Assert::IsTrue(LogCache::CLogSearchIndex::Contains("anything", std::string()));
+        }
+
+        TEST_METHOD(FindRevisionsTest)
+        {
+            CTestTempFile tmpFile;
+            {
+                // no search index in the file
+                LogCache::CCachedLogInfo logInfo;
+                AddTestData(logInfo);
+
+                std::vector<LogCache::revision_t> revisions;
+                logInfo.FindRevisions("log", LogCache::CCachedLogInfo::SEARCH_COMMENTS, revisions);
+                Assert::AreEqual((size_t)2, revisions.size());
+                Assert::AreEqual((LogCache::revision_t)1, revisions[0]);
+                Assert::AreEqual((LogCache::revision_t)2, revisions[1]);
+
+                logInfo.Save(tmpFile.GetFileName());
+            }
+
+            {
+                // index gets built while loading the file
+                LogCache::CCachedLogInfo logInfo(tmpFile.GetFileName());
+                logInfo.EnableSearchIndex(true);
+                logInfo.Load(0);
+
+                Assert::IsTrue(logInfo.IsModified());
+                Assert::AreEqual((LogCache::index_t)300, logInfo.GetSearchIndex().size());
+
+                CheckFindRevisions(logInfo);
+
+                logInfo.Insert(301, "dave", "More log data", 4444);
+                logInfo.Save();
+            }
+
+            {
+                LogCache::CCachedLogInfo logInfo(tmpFile.GetFileName());
+                logInfo.EnableSearchIndex(true);
+                logInfo.Load(0);
+
+                Assert::IsFalse(logInfo.IsModified());
+                Assert::AreEqual((LogCache::index_t)301, logInfo.GetSearchIndex().size());
+
+                std::vector<LogCache::revision_t> revisions;
+                logInfo.FindRevisions("log", LogCache::CCachedLogInfo::SEARCH_COMMENTS, revisions);
+                Assert::AreEqual((size_t)3, revisions.size());
+                Assert::AreEqual((LogCache::revision_t)301, revisions[2]);
+            }
+        }
+
+    private:
+        template<class T>
+        static void AddTestData(T& target)
+        {
+            for (int i = 0; i < 300; ++i)
+            {
+                std::string author = i == 299 ? "Carol" : (i % 2 ? "alice" : "bob");
+                std::string comment = "Revision " + std::to_string(i);
+                if (i == 0)
+                    comment = "Fix crash in Log dialog";
+                else if (i == 1)
+                    comment = "Add log cache index";
+
+                Add(target, (LogCache::index_t)i, author, comment);
+            }
+        }
+
+        static void Add(LogCache::CLogSearchIndex& index, LogCache::index_t i, const std::string& author, const std::string& comment)
+        {
+            index.Add(i, author, comment);
+        }
+
+        static void Add(LogCache::CCachedLogInfo& logInfo, LogCache::index_t i, const std::string& author, const std::string& comment)
+        {
+            logInfo.Insert(i + 1, author, comment, 1111 + i);
+        }
+
+        static void CheckFindRevisions(const LogCache::CCachedLogInfo& logInfo)
+        {
+            std::vector<LogCache::revision_t> revisions;
+
+            logInfo.FindRevisions("LOG", LogCache::CCachedLogInfo::SEARCH_COMMENTS, revisions);
+            Assert::AreEqual((size_t)2, revisions.size());
+            Assert::AreEqual((LogCache::revision_t)1, revisions[0]);
+            Assert::AreEqual((LogCache::revision_t)2, revisions[1]);
+
+            logInfo.FindRevisions("carol", LogCache::CCachedLogInfo::SEARCH_COMMENTS, revisions);
+            Assert::IsTrue(revisions.empty());
+
+            logInfo.FindRevisions("carol", LogCache::CCachedLogInfo::SEARCH_AUTHORS, revisions);
+            Assert::AreEqual((size_t)1, revisions.size());
+            Assert::AreEqual((LogCache::revision_t)300, revisions[0]);
+
+            // short texts do not use the index
+            logInfo.FindRevisions("bo", LogCache::CCachedLogInfo::SEARCH_AUTHORS | LogCache::CCachedLogInfo::SEARCH_COMMENTS, revisions);
+            Assert::AreEqual((size_t)150, revisions.size());
+
+            // candidates found through the authors do not match any comment
+            logInfo.FindRevisions("alice", LogCache::CCachedLogInfo::SEARCH_COMMENTS, revisions);
+            Assert::IsTrue(revisions.empty());
+        }
+    };
+}
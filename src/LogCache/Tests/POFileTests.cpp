@@ -0,0 +1,184 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "TestTempFile.h"
+#include "../../ResText/POFile.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    TEST_CLASS(POFileTests)
+    {
+    private:
+        static void WriteTestFile(const std::wstring& path, const std::string& content)
+        {
+            std::ofstream file(path, std::ios_base::binary | std::ios_base::trunc);
+            file.write(content.data(), content.size());
+            file.close();
+            Assert::IsFalse(file.fail());
+        }
+
+        /// a po-file with a BOM, CRLF and LF line ends, continuation lines,
+        /// a regex pair in the header and no empty line at the end
+        static std::string GetTestPOFile()
+        {
+            return "\xEF\xBB\xBF"
+                   "# regexsearch=colou?r\n"
+                   "# regexreplace=hue\n"
+                   "# regexsearch=(\n"
+                   "# regexreplace=invalid\n"
+                   "msgid \"\"\n"
+                   "msgstr \"\"\n"
+                   "\"Content-Type: text/plain; charset=UTF-8\\n\"\n"
+                   "\n"
+                   "#. Resource IDs: (1)\r\n"
+                   "msgid \"Open\"\r\n"
+                   "msgstr \"\xC3\x96" "ffnen\"\r\n"
+                   "\r\n"
+                   "msgid \"\"\n"
+                   "\"Multi \"\n"
+                   "\"line\"\n"
+                   "msgstr \"\"\n"
+                   "\"Mehr\"\n"
+                   "\"zeilig\"\n"
+                   "\n"
+                   "\n"
+                   "#, c-format\n"
+                   "msgid \"%d files\"\n"
+                   "msgstr \"\"";
+        }
+
+    public:
+        TEST_METHOD(ReadUtf8FileTest)
+        {
+            CTestTempFile tmpFile;
+            std::wstring content;
+
+            WriteTestFile(tmpFile.GetFileName(), "\xEF\xBB\xBF" "a\r\n\xC3\xA4\xE2\x82\xAC");
+            Assert::IsTrue(CPOFile::ReadUtf8File(tmpFile.GetFileName().c_str(), content));
+            Assert::AreEqual(std::wstring(L"a\r\n\u00E4\u20AC"), content);
+
+            WriteTestFile(tmpFile.GetFileName(), "no BOM\n");
+            Assert::IsTrue(CPOFile::ReadUtf8File(tmpFile.GetFileName().c_str(), content));
+            Assert::AreEqual(std::wstring(L"no BOM\n"), content);
+
+            // empty files and files with only a BOM are fine
+            WriteTestFile(tmpFile.GetFileName(), "\xEF\xBB\xBF");
+            Assert::IsTrue(CPOFile::ReadUtf8File(tmpFile.GetFileName().c_str(), content));
+            Assert::IsTrue(content.empty());
+            WriteTestFile(tmpFile.GetFileName(), "");
+            content = L"old";
+            Assert::IsTrue(CPOFile::ReadUtf8File(tmpFile.GetFileName().c_str(), content));
+            Assert::IsTrue(content.empty());
+
+            std::wstring missing = tmpFile.GetFileName() + L".missing";
+            Assert::IsFalse(CPOFile::ReadUtf8File(missing.c_str(), content));
+        }
+
+        TEST_METHOD(CatalogTest)
+        {
+            CTestTempFile tmpFile;
+            WriteTestFile(tmpFile.GetFileName(), GetTestPOFile());
+
+            CPOFile catalog;
+            catalog.SetQuiet();
+            Assert::IsTrue(catalog.ParseFile(tmpFile.GetFileName().c_str(), FALSE, false) != FALSE);
+
+            // the header is always replaced by an empty entry
+            Assert::AreEqual((size_t)4, catalog.size());
+            Assert::IsTrue(catalog.count(L"") == 1);
+            Assert::IsTrue(catalog.GetEntry(L"").msgstr.empty());
+
+            // the generated comments and flags of the file are not kept,
+            // they come from the resources
+            const RESOURCEENTRY& open = catalog.GetEntry(L"Open");
+            Assert::AreEqual(std::wstring(L"\u00D6ffnen"), open.msgstr);
+            Assert::IsTrue(open.automaticcomments.empty());
+
+            Assert::AreEqual(std::wstring(L"Mehrzeilig"), catalog.GetEntry(L"Multi line").msgstr);
+
+            // the last entry ends at the end of the file
+            Assert::IsTrue(catalog.count(L"%d files") == 1);
+            const RESOURCEENTRY& files = catalog.GetEntry(L"%d files");
+            Assert::IsTrue(files.flag.empty());
+            Assert::IsTrue(files.msgstr.empty());
+
+            // unknown strings don't add entries
+            Assert::IsTrue(catalog.GetEntry(L"Close").msgstr.empty());
+            Assert::IsTrue(catalog.GetEntry(L"open").msgstr.empty());
+            Assert::AreEqual((size_t)4, catalog.size());
+        }
+
+        TEST_METHOD(UpdateExistingTest)
+        {
+            CTestTempFile tmpFile;
+            WriteTestFile(tmpFile.GetFileName(), GetTestPOFile());
+
+            // the entries found in the resources
+            CPOFile catalog;
+            catalog.SetQuiet();
+            catalog[L"Open"].automaticcomments.push_back(L"#. Resource IDs: (2)");
+            catalog[L"Save"].flag = L"#, c-format";
+
+            Assert::IsTrue(catalog.ParseFile(tmpFile.GetFileName().c_str(), TRUE, false) != FALSE);
+
+            // entries which aren't used anymore are dropped, the generated
+            // comments of the catalog win over the ones of the file
+            Assert::AreEqual((size_t)3, catalog.size());
+            Assert::IsTrue(catalog.count(L"Multi line") == 0);
+            const RESOURCEENTRY& open = catalog.GetEntry(L"Open");
+            Assert::AreEqual(std::wstring(L"\u00D6ffnen"), open.msgstr);
+            Assert::AreEqual((size_t)1, open.automaticcomments.size());
+            Assert::AreEqual(std::wstring(L"#. Resource IDs: (2)"), open.automaticcomments[0]);
+            Assert::AreEqual(std::wstring(L"#, c-format"), catalog.GetEntry(L"Save").flag);
+        }
+
+        TEST_METHOD(RegexTest)
+        {
+            CTestTempFile tmpFile;
+            WriteTestFile(tmpFile.GetFileName(), GetTestPOFile());
+
+            CPOFile catalog;
+            catalog.SetQuiet();
+            Assert::IsTrue(catalog.ParseFile(tmpFile.GetFileName().c_str(), FALSE, false) != FALSE);
+
+            // the invalid expression is skipped, the search ignores the case
+            Assert::AreEqual((size_t)1, catalog.m_regexes.size());
+            std::wstring text = L"Color and COLOUR, not colr";
+            catalog.ApplyRegexes(text);
+            Assert::AreEqual(std::wstring(L"hue and hue, not colr"), text);
+
+            // the pairs are applied in order, each to the result of the previous one
+            catalog.m_regexes.push_back(std::make_tuple(std::wregex(L"hue"), std::wstring(L"tint")));
+            catalog.m_regexes.push_back(std::make_tuple(std::wregex(L"(\\w+) and (\\w+)"), std::wstring(L"$2 or $1")));
+            text = L"colour and grey";
+            catalog.ApplyRegexes(text);
+            Assert::AreEqual(std::wstring(L"grey or tint"), text);
+
+            // no pairs, no changes
+            CPOFile empty;
+            text = L"colour";
+            empty.ApplyRegexes(text);
+            Assert::AreEqual(std::wstring(L"colour"), text);
+        }
+    };
+}
@@ -0,0 +1,349 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "TestTempFile.h"
+#include "PathHistoryIndex.h"
+#include "CachedLogInfo.h"
+#include "RootOutStream.h"
+#include "RootInStream.h"
+#include "Access/StrictLogIterator.h"
+#include "Access/CopyFollowingLogIterator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    TEST_CLASS(PathHistoryIndexTests)
+    {
+    public:
+        TEST_METHOD(EmptyTest)
+        {
+            CTestTempFile tmpFile;
+            {
+                CRootOutStream strm(tmpFile.GetFileName());
+                LogCache::CPathHistoryIndex index;
+
+                Assert::AreEqual((size_t)0, index.size());
+
+                // Save data to stream.
+                strm << index;
+            }
+
+            {
+                CRootInStream strm(tmpFile.GetFileName());
+                LogCache::CPathHistoryIndex index;
+
+                // Load data to stream.
+                strm >> index;
+
+                Assert::AreEqual((size_t)0, index.size());
+                Assert::AreEqual((LogCache::revision_t)0, index.GetCoveredEnd());
+                Assert::IsFalse(index.IsCovered(0));
+                Assert::AreEqual((LogCache::revision_t)10, index.GetPreviousUncovered(10));
+            }
+        }
+
+        TEST_METHOD(CandidatesTest)
+        {
+            // the log is being received in descending order
+            LogCache::CCachedLogInfo logInfo;
+            logInfo.EnablePathHistoryIndex(true);
+            for (LogCache::revision_t i = LAST_REVISION + 1; i > 0; --i)
+                AddRevision(logInfo, i - 1);
+
+            CheckCandidates(logInfo);
+
+            // changes of the last revision may still be incomplete
+            Assert::IsFalse(logInfo.GetPathHistoryIndex().IsCovered(0));
+        }
+
+        TEST_METHOD(CoverageTest)
+        {
+            CTestTempFile tmpFile;
+            LogCache::CCachedLogInfo logInfo;
+            logInfo.EnablePathHistoryIndex(true);
+
+            for (LogCache::revision_t i = 10; i <= 20; ++i)
+                AddRevision(logInfo, i);
+            for (LogCache::revision_t i = 40; i >= 30; --i)
+                AddRevision(logInfo, i);
+
+            // changes of the last revision may still be incomplete
+            const LogCache::CPathHistoryIndex& index = logInfo.GetPathHistoryIndex();
+            Assert::IsTrue(index.IsCovered(31));
+            Assert::IsFalse(index.IsCovered(30));
+
+            // revisions without changed paths are never covered
+            logInfo.Insert(41, "author", "no changes", 1111, LogCache::CRevisionInfoContainer::HAS_STANDARD_REVPROPS);
+
+            logInfo.Save(tmpFile.GetFileName());
+
+            Assert::IsTrue(index.IsCovered(10));
+            Assert::IsTrue(index.IsCovered(20));
+            Assert::IsFalse(index.IsCovered(21));
+            Assert::IsTrue(index.IsCovered(30));
+            Assert::IsFalse(index.IsCovered(41));
+            Assert::AreEqual((LogCache::revision_t)41, index.GetCoveredEnd());
+
+            Assert::AreEqual((LogCache::revision_t)5, index.GetPreviousUncovered(5));
+            Assert::AreEqual((LogCache::revision_t)9, index.GetPreviousUncovered(15));
+            Assert::AreEqual((LogCache::revision_t)29, index.GetPreviousUncovered(40));
+            Assert::AreEqual((LogCache::revision_t)41, index.GetPreviousUncovered(41));
+        }
+
+        TEST_METHOD(SimpleTest)
+        {
+            CTestTempFile tmpFile;
+            {
+                LogCache::CCachedLogInfo logInfo;
+                logInfo.EnablePathHistoryIndex(true);
+                for (LogCache::revision_t i = LAST_REVISION + 1; i > 0; --i)
+                    AddRevision(logInfo, i - 1);
+
+                logInfo.Save(tmpFile.GetFileName());
+            }
+
+            {
+                LogCache::CCachedLogInfo logInfo(tmpFile.GetFileName());
+                logInfo.EnablePathHistoryIndex(true);
+                logInfo.Load(0);
+
+                Assert::IsFalse(logInfo.IsModified());
+                Assert::IsTrue(logInfo.GetPathHistoryIndex().IsCovered(0));
+                CheckCandidates(logInfo);
+            }
+
+            {
+                // index is not being used
+                LogCache::CCachedLogInfo logInfo(tmpFile.GetFileName());
+                logInfo.Load(0);
+
+                Assert::AreEqual((size_t)0, logInfo.GetPathHistoryIndex().size());
+                logInfo.Save();
+            }
+
+            {
+                // index gets built while loading the file
+                LogCache::CCachedLogInfo logInfo(tmpFile.GetFileName());
+                logInfo.EnablePathHistoryIndex(true);
+                logInfo.Load(0);
+
+                Assert::IsTrue(logInfo.IsModified());
+                CheckCandidates(logInfo);
+            }
+        }
+
+        TEST_METHOD(IteratorTest)
+        {
+            LogCache::CCachedLogInfo plain;
+            LogCache::CCachedLogInfo indexed;
+            indexed.EnablePathHistoryIndex(true);
+
+            for (LogCache::revision_t i = LAST_REVISION + 1; i > 0; --i)
+            {
+                // leave a gap in the cached data
+                if ((i <= 210) && (i > 200))
+                    continue;
+
+                AddRevision(plain, i - 1);
+                AddRevision(indexed, i - 1);
+            }
+
+            // gap is not covered -> must be reported as missing data
+            CheckIterators(plain, indexed, LAST_REVISION);
+
+            // fill the gap through an update
+            LogCache::CCachedLogInfo newData;
+            for (LogCache::revision_t i = 200; i < 210; ++i)
+                AddRevision(newData, i);
+
+            plain.Update(newData);
+            indexed.Update(newData);
+
+            CheckIterators(plain, indexed, LAST_REVISION);
+            CheckIterators(plain, indexed, 150);
+        }
+
+        TEST_METHOD(ReplaceTest)
+        {
+            LogCache::CCachedLogInfo plain;
+            LogCache::CCachedLogInfo indexed;
+            indexed.EnablePathHistoryIndex(true);
+
+            for (LogCache::revision_t i = LAST_REVISION + 1; i > 0; --i)
+            {
+                AddRevision(plain, i - 1);
+                AddRevision(indexed, i - 1);
+            }
+
+            // replace the changes of some revisions and drop those of one
+            LogCache::CCachedLogInfo newData;
+            for (LogCache::revision_t i = 300; i < 310; ++i)
+            {
+                if (i == 305)
+                {
+                    newData.Insert(i, "author", "no changes", 1111 + i, LogCache::CRevisionInfoContainer::HAS_STANDARD_REVPROPS);
+                }
+                else
+                {
+                    newData.Insert(i, "author", "comment", 1111 + i);
+                    AddChange(newData, LogCache::CRevisionInfoContainer::ACTION_CHANGED, "/trunk/doc/readme");
+                }
+            }
+
+            plain.Update(newData, LogCache::CRevisionInfoContainer::HAS_ALL, false);
+            indexed.Update(newData, LogCache::CRevisionInfoContainer::HAS_ALL, false);
+
+            // no changes -> must be reported as missing data
+            const LogCache::CPathHistoryIndex& index = indexed.GetPathHistoryIndex();
+            Assert::IsTrue(index.IsCovered(304));
+            Assert::IsFalse(index.IsCovered(305));
+            Assert::IsTrue(index.IsCovered(306));
+
+            CheckIterators(plain, indexed, LAST_REVISION);
+            CheckIterators(plain, indexed, 304);
+        }
+
+    private:
+        enum { LAST_REVISION = 400 };
+
+        static void AddRevision(LogCache::CCachedLogInfo& logInfo, LogCache::revision_t revision)
+        {
+            logInfo.Insert(revision, "author", "comment", 1111 + revision);
+
+            std::string file = "/trunk/src/file" + std::to_string(revision % 4);
+            switch (revision)
+            {
+            case 0:
+                break;
+
+            case 1:
+                AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_ADDED, "/trunk");
+                AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_ADDED, "/branches");
+                break;
+
+            case 2:
+                AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_ADDED, "/trunk/src");
+                break;
+
+            default:
+                if (revision % 50 == 0)
+                {
+                    // create a branch
+                    logInfo.AddChange(LogCache::CRevisionInfoContainer::ACTION_ADDED,
+                                      LogCache::node_dir, "/branches/b" + std::to_string(revision),
+                                      "/trunk", revision - 1, FALSE, FALSE);
+                }
+                else if (revision % 3 == 0)
+                {
+                    AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_CHANGED, file);
+                }
+                else if (revision % 3 == 1)
+                {
+                    AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_CHANGED, "/trunk/doc/readme");
+                }
+                else
+                {
+                    AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_CHANGED,
+                              "/branches/b" + std::to_string(revision / 50 * 50) + "/src/file0");
+                }
+
+                if (revision % 13 == 0)
+                    AddChange(logInfo, LogCache::CRevisionInfoContainer::ACTION_REPLACED, file);
+            }
+        }
+
+        static void AddChange(LogCache::CCachedLogInfo& logInfo, LogCache::CCachedLogInfo::TChangeAction action, const std::string& path)
+        {
+            logInfo.AddChange(action, LogCache::node_file, path, "", LogCache::NO_REVISION, FALSE, FALSE);
+        }
+
+        static void CheckCandidates(const LogCache::CCachedLogInfo& logInfo)
+        {
+            const LogCache::CPathHistoryIndex& index = logInfo.GetPathHistoryIndex();
+            Assert::AreEqual((LogCache::revision_t)LAST_REVISION + 1, index.GetCoveredEnd());
+
+            // /trunk/doc itself never got added
+            std::vector<LogCache::revision_t> expected;
+            expected.push_back(1);
+            for (LogCache::revision_t i = 3; i <= LAST_REVISION; ++i)
+                if ((i % 50 != 0) && (i % 3 == 1))
+                    expected.push_back(i);
+
+            std::vector<LogCache::revision_t> candidates;
+            index.GetCandidates(GetPath(logInfo, "/trunk/doc"), candidates);
+            Assert::IsTrue(expected == candidates);
+
+            // add / replace of a file
+            expected.clear();
+            for (LogCache::revision_t i = 1; i <= LAST_REVISION; ++i)
+                if ((i <= 2) || ((i % 50 != 0) && (i % 12 == 9)) || ((i % 13 == 0) && (i % 4 == 1)))
+                    expected.push_back(i);
+
+            index.GetCandidates(GetPath(logInfo, "/trunk/src/file1"), candidates);
+            Assert::IsTrue(expected == candidates);
+
+            // paths not in the cache depend on their cached parent only
+            index.GetCandidates(GetPath(logInfo, "/branches/b100/unknown/path"), candidates);
+            Assert::AreEqual((size_t)2, candidates.size());
+            Assert::AreEqual((LogCache::revision_t)1, candidates[0]);
+            Assert::AreEqual((LogCache::revision_t)100, candidates[1]);
+        }
+
+        static void CheckIterators(const LogCache::CCachedLogInfo& plain, const LogCache::CCachedLogInfo& indexed, LogCache::revision_t start)
+        {
+            const char* paths[] = { "/", "/trunk", "/trunk/doc", "/trunk/doc/readme",
+                                    "/trunk/src/file1", "/branches", "/branches/b250/src/file0",
+                                    "/branches/b250/src/file2", "/trunk/unknown" };
+
+            for (size_t i = 0; i < _countof(paths); ++i)
+            {
+                Assert::IsTrue(GetHistory<LogCache::CStrictLogIterator>(plain, start, paths[i])
+                               == GetHistory<LogCache::CStrictLogIterator>(indexed, start, paths[i]));
+                Assert::IsTrue(GetHistory<LogCache::CCopyFollowingLogIterator>(plain, start, paths[i])
+                               == GetHistory<LogCache::CCopyFollowingLogIterator>(indexed, start, paths[i]));
+            }
+        }
+
+        template<class T>
+        static std::vector<LogCache::revision_t> GetHistory(const LogCache::CCachedLogInfo& logInfo, LogCache::revision_t start, const std::string& path)
+        {
+            T iterator(&logInfo, start, GetPath(logInfo, path));
+
+            // collect all revisions and the position where the iteration stopped
+            std::vector<LogCache::revision_t> result;
+            iterator.Retry();
+            while (!iterator.EndOfPath() && !iterator.DataIsMissing())
+            {
+                result.push_back(iterator.GetRevision());
+                iterator.Advance();
+            }
+
+            result.push_back(iterator.GetRevision());
+            return result;
+        }
+
+        static LogCache::CDictionaryBasedTempPath GetPath(const LogCache::CCachedLogInfo& logInfo, const std::string& path)
+        {
+            return LogCache::CDictionaryBasedTempPath(&logInfo.GetLogInfo().GetPaths(), path);
+        }
+    };
+}
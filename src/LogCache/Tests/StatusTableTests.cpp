@@ -0,0 +1,249 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "../../TSVNCache/StatusTable.h"
+#include <thread>
+#include <climits>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    TEST_CLASS(StatusTableTests)
+    {
+    public:
+        struct Value
+        {
+            uint32_t path;
+            uint32_t words[7];
+        };
+
+        typedef CSharedStatusTable<Value> Table;
+
+        TEST_METHOD(KeyTest)
+        {
+            Table::Key key = Table::GetKey(L"C:\\WC\\File.txt", 4);
+            Table::Key sameKey = Table::GetKey(L"c:\\wc\\file.TXT", 4);
+            Table::Key otherFlags = Table::GetKey(L"C:\\WC\\File.txt", 0);
+            Table::Key otherPath = Table::GetKey(L"C:\\WC\\File.tx", 4);
+
+            Assert::IsTrue((key.hash == sameKey.hash) && (key.check == sameKey.check));
+            Assert::IsTrue(key.hash != 0);
+            Assert::IsTrue((key.hash != otherFlags.hash) && (key.check != otherFlags.check));
+            Assert::IsTrue((key.hash != otherPath.hash) && (key.check != otherPath.check));
+        }
+
+        TEST_METHOD(PublishTest)
+        {
+            std::vector<uint32_t> memory(Table::GetMemorySize() / sizeof(uint32_t) + 1, 0);
+            Table writer;
+            Table reader;
+            Value value = {};
+
+            // nothing to attach to before the writer created the table
+            Assert::IsFalse(reader.Attach(memory.data()));
+            Assert::IsTrue(writer.Create(memory.data()));
+            Assert::IsTrue(reader.Attach(memory.data()));
+
+            const Table::Key key = Table::GetKey(L"C:\\WC\\a", 0);
+            writer.Publish(key, MakeValue(1, 10), writer.GetGeneration(), 100);
+
+            // not active yet
+            Assert::IsFalse(reader.Lookup(key, 0, value));
+
+            writer.SetActive(true);
+            Assert::IsTrue(reader.Lookup(key, 0, value));
+            Assert::AreEqual((uint32_t)1, value.path);
+            Assert::AreEqual((uint32_t)10, value.words[6]);
+
+            // expired
+            Assert::IsFalse(reader.Lookup(key, 100, value));
+
+            // same slot, but a different check hash
+            const Table::Key foreign = { key.hash, key.check ^ 1 };
+            Assert::IsFalse(reader.Lookup(foreign, 0, value));
+
+            writer.SetActive(false);
+            Assert::IsFalse(reader.Lookup(key, 0, value));
+        }
+
+        TEST_METHOD(RemoveTest)
+        {
+            std::vector<uint32_t> memory(Table::GetMemorySize() / sizeof(uint32_t) + 1, 0);
+            Table writer;
+            Table reader;
+            Value value = {};
+            Assert::IsTrue(writer.Create(memory.data()));
+            Assert::IsTrue(reader.Attach(memory.data()));
+            writer.SetActive(true);
+
+            Table::Key keys[2];
+            FindKeysInDifferentSlots(keys);
+            writer.Publish(keys[0], MakeValue(0, 1), writer.GetGeneration(), 100);
+            writer.Publish(keys[1], MakeValue(1, 1), writer.GetGeneration(), 100);
+
+            // only the removed entry is gone
+            writer.Remove(keys[0]);
+            Assert::IsFalse(reader.Lookup(keys[0], 0, value));
+            Assert::IsTrue(reader.Lookup(keys[1], 0, value));
+
+            // data determined before the removal must not get published
+            uint32_t generation = writer.GetGeneration();
+            writer.Remove(keys[0]);
+            writer.Publish(keys[0], MakeValue(0, 2), generation, 100);
+            Assert::IsFalse(reader.Lookup(keys[0], 0, value));
+
+            writer.Publish(keys[0], MakeValue(0, 3), writer.GetGeneration(), 100);
+            Assert::IsTrue(reader.Lookup(keys[0], 0, value));
+            Assert::AreEqual((uint32_t)3, value.words[0]);
+
+            // Invalidate() removes everything
+            generation = writer.GetGeneration();
+            writer.Invalidate();
+            Assert::IsFalse(reader.Lookup(keys[0], 0, value));
+            Assert::IsFalse(reader.Lookup(keys[1], 0, value));
+            writer.Publish(keys[1], MakeValue(1, 4), generation, 100);
+            Assert::IsFalse(reader.Lookup(keys[1], 0, value));
+        }
+
+        TEST_METHOD(RecreateTest)
+        {
+            std::vector<uint32_t> memory(Table::GetMemorySize() / sizeof(uint32_t) + 1, 0);
+            Table writer;
+            Table reader;
+            Value value = {};
+            Assert::IsTrue(writer.Create(memory.data()));
+            Assert::IsTrue(reader.Attach(memory.data()));
+            writer.SetActive(true);
+
+            const Table::Key key = Table::GetKey(L"C:\\WC\\a", 0);
+            writer.Publish(key, MakeValue(1, 1), writer.GetGeneration(), 100);
+
+            // a new writer must not serve entries of its predecessor
+            Table newWriter;
+            Assert::IsTrue(newWriter.Create(memory.data()));
+            Assert::IsFalse(reader.Lookup(key, 0, value));
+
+            // a block with a different layout is rejected
+            memory[1] ^= 1;
+            Assert::IsFalse(newWriter.Create(memory.data()));
+            Assert::IsFalse(reader.Attach(memory.data()));
+        }
+
+        TEST_METHOD(StressTest)
+        {
+            // Writers publish and remove entries for a few paths that share
+            // slots, readers check that they never see a torn value or the
+            // value of another path.
+            enum { PATH_COUNT = 64, WRITER_COUNT = 3, READER_COUNT = 4, RUN_TIME = 2000 };
+
+            std::vector<uint32_t> memory(Table::GetMemorySize() / sizeof(uint32_t) + 1, 0);
+            Table writer;
+            Assert::IsTrue(writer.Create(memory.data()));
+            writer.SetActive(true);
+
+            std::vector<Table::Key> keys;
+            for (int i = 0; i < PATH_COUNT; ++i)
+            {
+                wchar_t path[MAX_PATH];
+                swprintf_s(path, L"C:\\WC\\folder%d\\file", i);
+                keys.push_back(Table::GetKey(path, 0));
+                // force collisions
+                keys.back().hash = keys.back().hash % 8 + 1;
+            }
+
+            std::atomic<bool> stop(false);
+            std::atomic<unsigned> hits(0);
+            std::atomic<unsigned> errors(0);
+            std::vector<std::thread> threads;
+            for (int w = 0; w < WRITER_COUNT; ++w)
+            {
+                threads.emplace_back([&, w]()
+                {
+                    for (uint32_t round = 1; !stop; ++round)
+                    {
+                        const uint32_t path = (round * 7 + w) % PATH_COUNT;
+                        if (round % 5 == 0)
+                            writer.Remove(keys[path]);
+                        else
+                            writer.Publish(keys[path], MakeValue(path, round), writer.GetGeneration(), ULLONG_MAX);
+                    }
+                });
+            }
+            for (int r = 0; r < READER_COUNT; ++r)
+            {
+                threads.emplace_back([&, r]()
+                {
+                    Table reader;
+                    if (!reader.Attach(memory.data()))
+                    {
+                        ++errors;
+                        return;
+                    }
+                    for (uint32_t round = 0; !stop; ++round)
+                    {
+                        const uint32_t path = (round + r) % PATH_COUNT;
+                        Value value;
+                        if (!reader.Lookup(keys[path], 0, value))
+                            continue;
+                        ++hits;
+                        if (value.path != path)
+                            ++errors;
+                        for (int i = 1; i < _countof(value.words); ++i)
+                            if (value.words[i] != value.words[0])
+                                ++errors;
+                    }
+                });
+            }
+
+            Sleep(RUN_TIME);
+            stop = true;
+            for (auto& thread : threads)
+                thread.join();
+
+            Assert::AreEqual(0u, errors.load());
+            Assert::IsTrue(hits.load() > 0);
+        }
+
+    private:
+        static Value MakeValue(uint32_t path, uint32_t word)
+        {
+            Value value;
+            value.path = path;
+            for (int i = 0; i < _countof(value.words); ++i)
+                value.words[i] = word;
+            return value;
+        }
+
+        static void FindKeysInDifferentSlots(Table::Key keys[2])
+        {
+            keys[0] = Table::GetKey(L"C:\\WC\\a", 0);
+            for (wchar_t c = L'b'; ; ++c)
+            {
+                wchar_t path[] = L"C:\\WC\\?";
+                path[6] = c;
+                keys[1] = Table::GetKey(path, 0);
+                if (keys[0].hash % Table::ENTRY_COUNT != keys[1].hash % Table::ENTRY_COUNT)
+                    return;
+            }
+        }
+    };
+}
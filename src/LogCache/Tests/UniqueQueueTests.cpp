@@ -0,0 +1,242 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include "stdafx.h"
+
+#include "UniqueQueue.h"
+#include <deque>
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LogCacheTests
+{
+    struct NoCaseHash
+    {
+        size_t operator()(const std::wstring& s) const
+        {
+            std::wstring lower(s);
+            std::transform(lower.begin(), lower.end(), lower.begin(), towlower);
+            return std::hash<std::wstring>()(lower);
+        }
+    };
+
+    struct NoCaseEqual
+    {
+        bool operator()(const std::wstring& lhs, const std::wstring& rhs) const
+        {
+            return _wcsicmp(lhs.c_str(), rhs.c_str()) == 0;
+        }
+    };
+
+    TEST_CLASS(UniqueQueueTests)
+    {
+    public:
+        TEST_METHOD(OrderTest)
+        {
+            UniqueQueue<std::wstring> queue;
+
+            Assert::AreEqual((size_t)1, queue.Push(L"one"));
+            Assert::AreEqual((size_t)2, queue.Push(L"two"));
+            Assert::AreEqual((size_t)3, queue.Push(L"three"));
+
+            Assert::IsTrue(queue.contains(L"two"));
+            Assert::AreEqual(std::wstring(L"one"), queue.Pop());
+            Assert::AreEqual(std::wstring(L"two"), queue.Pop());
+            Assert::AreEqual(std::wstring(L"three"), queue.Pop());
+            Assert::AreEqual((size_t)0, queue.size());
+            Assert::IsFalse(queue.contains(L"two"));
+        }
+
+        TEST_METHOD(RePushTest)
+        {
+            UniqueQueue<std::wstring> queue;
+
+            queue.Push(L"one");
+            queue.Push(L"two");
+            queue.Push(L"three");
+
+            // moving the first, the middle and the last entry
+            Assert::AreEqual((size_t)3, queue.Push(L"one"));
+            Assert::AreEqual((size_t)3, queue.Push(L"three"));
+            Assert::AreEqual((size_t)3, queue.Push(L"three"));
+            Assert::AreEqual((size_t)3, queue.Push(L"two"));
+
+            Assert::AreEqual(std::wstring(L"one"), queue.Pop());
+            Assert::AreEqual(std::wstring(L"three"), queue.Pop());
+            Assert::AreEqual(std::wstring(L"two"), queue.Pop());
+            Assert::AreEqual((size_t)0, queue.size());
+        }
+
+        TEST_METHOD(EraseTest)
+        {
+            UniqueQueue<std::wstring> queue;
+
+            queue.Push(L"one");
+            queue.Push(L"two");
+            queue.Push(L"three");
+            queue.Push(L"four");
+
+            Assert::AreEqual((size_t)3, queue.erase(L"two"));
+            Assert::AreEqual((size_t)2, queue.erase(L"one"));
+            Assert::AreEqual((size_t)1, queue.erase(L"four"));
+
+            // the links must still be intact
+            queue.Push(L"five");
+            queue.Push(L"three");
+            Assert::AreEqual(std::wstring(L"five"), queue.Pop());
+            Assert::AreEqual(std::wstring(L"three"), queue.Pop());
+
+            // erasing the only entry leaves an empty queue
+            queue.Push(L"six");
+            Assert::AreEqual((size_t)0, queue.erase(L"six"));
+            queue.Push(L"seven");
+            Assert::AreEqual(std::wstring(L"seven"), queue.Pop());
+        }
+
+        TEST_METHOD(InvalidOperationsTest)
+        {
+            UniqueQueue<std::wstring> queue;
+
+            // popping and erasing on an empty queue are no-ops
+            Assert::AreEqual(std::wstring(), queue.Pop());
+            Assert::AreEqual((size_t)0, queue.erase(L"one"));
+            Assert::AreEqual((size_t)0, queue.size());
+
+            // erasing unknown entries must not change the queue
+            queue.Push(L"one");
+            queue.Push(L"two");
+            Assert::AreEqual((size_t)2, queue.erase(L"three"));
+            Assert::AreEqual((size_t)2, queue.erase(L"ONE"));
+
+            queue.Pop();
+            queue.Pop();
+            Assert::AreEqual(std::wstring(), queue.Pop());
+            Assert::AreEqual((size_t)0, queue.size());
+
+            // the queue is still usable afterwards
+            queue.Push(L"four");
+            Assert::AreEqual(std::wstring(L"four"), queue.Pop());
+        }
+
+        TEST_METHOD(CustomKeyTest)
+        {
+            UniqueQueue<std::wstring, NoCaseHash, NoCaseEqual> queue;
+
+            queue.Push(L"C:\\Dir\\File");
+            queue.Push(L"C:\\Other");
+            Assert::AreEqual((size_t)2, queue.Push(L"c:\\dir\\file"));
+
+            // the first spelling is kept
+            Assert::AreEqual(std::wstring(L"C:\\Other"), queue.Pop());
+            Assert::AreEqual(std::wstring(L"C:\\Dir\\File"), queue.Pop());
+        }
+
+        TEST_METHOD(ChurnTest)
+        {
+            // replay the folder crawler's pattern: bursts of change
+            // notifications for a working set of paths, erases for
+            // paths that got handled elsewhere and the occasional pop,
+            // and compare against a plain deque
+            UniqueQueue<int> queue;
+            std::deque<int> reference;
+
+            unsigned int seed = 4711;
+            auto random = [&seed](int range) -> int
+            {
+                seed = seed * 1103515245 + 12345;
+                return (int)((seed >> 16) % range);
+            };
+
+            for (int step = 0; step < 20000; ++step)
+            {
+                int value = random(500);
+                switch (random(8))
+                {
+                case 0:
+                    {
+                        auto it = std::find(reference.begin(), reference.end(), value);
+                        if (it != reference.end())
+                            reference.erase(it);
+                        Assert::AreEqual(reference.size(), queue.erase(value));
+                    }
+                    break;
+                case 1:
+                    if (reference.empty())
+                    {
+                        Assert::AreEqual(0, queue.Pop());
+                    }
+                    else
+                    {
+                        Assert::AreEqual(reference.front(), queue.Pop());
+                        reference.pop_front();
+                    }
+                    break;
+                default:
+                    {
+                        auto it = std::find(reference.begin(), reference.end(), value);
+                        if (it != reference.end())
+                            reference.erase(it);
+                        reference.push_back(value);
+                        Assert::AreEqual(reference.size(), queue.Push(value));
+                    }
+                    break;
+                }
+            }
+
+            while (!reference.empty())
+            {
+                Assert::AreEqual(reference.front(), queue.Pop());
+                reference.pop_front();
+            }
+            Assert::AreEqual((size_t)0, queue.size());
+        }
+
+        TEST_METHOD(LargeQueueTest)
+        {
+            // tens of thousands of entries, as seen during large builds:
+            // every re-push and erase would be a linear scan with the
+            // old implementation
+            const int count = 50000;
+            UniqueQueue<int> queue;
+
+            ULONGLONG start = GetTickCount64();
+            for (int round = 0; round < 4; ++round)
+                for (int i = 0; i < count; ++i)
+                    queue.Push((i * 7919) % count);
+            for (int i = 0; i < count; i += 2)
+                queue.erase(i);
+            ULONGLONG elapsed = GetTickCount64() - start;
+
+            Assert::AreEqual((size_t)count / 2, queue.size());
+            wchar_t message[100] = { 0 };
+            swprintf_s(message, L"UniqueQueue churn: %llu ms\n", elapsed);
+            Logger::WriteMessage(message);
+
+            int previous = -1;
+            while (queue.size())
+            {
+                int value = queue.Pop();
+                Assert::IsTrue((value & 1) != 0);
+                Assert::AreNotEqual(previous, value);
+                previous = value;
+            }
+        }
+    };
+}
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2016 - TortoiseSVN
+// Copyright (C) 2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -49,6 +49,7 @@
 // include commonly used headers
 
 #include <windows.h>
+#include <tchar.h>
 #include <WinSock2.h>
 #include <Ws2tcpip.h>
 #include <Wspiapi.h>
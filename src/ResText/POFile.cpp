@@ -1,7 +1,7 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
 // Copyright (C) 2012-2013, 2018 - TortoiseGit
-// Copyright (C) 2003-2008, 2011-2016 - TortoiseSVN
+// Copyright (C) 2003-2008, 2011-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -21,11 +21,13 @@
 #include <fstream>
 #include "codecvt.h"
 #include "Utils.h"
+#include "SmartHandle.h"
 #include "ResModule.h"
 #include "POFile.h"
 
 #include <algorithm>
 #include <cctype>
+#include <climits>
 #include <memory>
 #include <functional>
 
@@ -46,6 +48,65 @@ static bool StartsWith(const wchar_t* heystacl, const wchar_t* needle)
     return wcsncmp(heystacl, needle, wcslen(needle)) == 0;
 }
 
+bool CPOFile::ReadUtf8File(LPCTSTR szPath, std::wstring& content)
+{
+    content.clear();
+    CAutoFile hFile = CreateFile(szPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (!hFile)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || (fileSize.QuadPart >= INT_MAX))
+        return false;
+    if (fileSize.QuadPart == 0)
+        return true;
+
+    CAutoGeneralHandle hMapping = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping)
+        return false;
+    CAutoViewOfFile pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!pView)
+        return false;
+
+    auto data = static_cast<const char*>((PVOID)pView);
+    int length = (int)fileSize.QuadPart;
+    // skip the BOM
+    if ((length >= 3) && (memcmp(data, "\xEF\xBB\xBF", 3) == 0))
+    {
+        data += 3;
+        length -= 3;
+    }
+    if (length == 0)
+        return true;
+    int wideLength = MultiByteToWideChar(CP_UTF8, 0, data, length, nullptr, 0);
+    if (wideLength <= 0)
+        return false;
+    content.resize(wideLength);
+    MultiByteToWideChar(CP_UTF8, 0, data, length, &content[0], wideLength);
+    return true;
+}
+
+const RESOURCEENTRY& CPOFile::GetEntry(const std::wstring& msgid) const
+{
+    static const RESOURCEENTRY emptyEntry = { 0 };
+    auto it = find(msgid);
+    return it == end() ? emptyEntry : it->second;
+}
+
+void CPOFile::ApplyRegexes(std::wstring& str) const
+{
+    for (const auto& t : m_regexes)
+    {
+        try
+        {
+            str = std::regex_replace(str, std::get<0>(t), std::get<1>(t));
+        }
+        catch (std::exception&)
+        {
+            // a failed replacement leaves the string as it was
+        }
+    }
+}
+
 BOOL CPOFile::ParseFile(LPCTSTR szPath, BOOL bUpdateExisting, bool bAdjustEOLs)
 {
     if (!PathFileExists(szPath))
@@ -59,25 +120,33 @@ BOOL CPOFile::ParseFile(LPCTSTR szPath, BOOL bUpdateExisting, bool bAdjustEOLs)
     int nEntries = 0;
     int nDeleted = 0;
     int nTranslated = 0;
-    //since stream classes still expect the filepath in char and not wchar_t
-    //we need to convert the filepath to multibyte
-    char filepath[MAX_PATH + 1] = { 0 };
-    WideCharToMultiByte(CP_ACP, 0, szPath, -1, filepath, _countof(filepath) - 1, nullptr, nullptr);
-
-    std::wifstream File;
-    File.imbue(std::locale(std::locale(), new utf8_conversion()));
-    File.open(filepath);
-    if (!File.good())
+    std::wstring content;
+    if (!ReadUtf8File(szPath, content))
     {
         _ftprintf(stderr, L"can't open input file %s\n", szPath);
         return FALSE;
     }
-    auto line = std::make_unique<TCHAR[]>(2 * MAX_STRING_LENGTH);
+    std::wstring line;
     std::vector<std::wstring> entry;
+    size_t lineStart = 0;
+    bool bEndOfFile = false;
     do
     {
-        File.getline(line.get(), 2*MAX_STRING_LENGTH);
-        if (line.get()[0]==0)
+        bEndOfFile = lineStart >= content.size();
+        if (bEndOfFile)
+            line.clear();       // the end of the file also ends the last entry
+        else
+        {
+            size_t lineEnd = content.find(L'\n', lineStart);
+            if (lineEnd == std::wstring::npos)
+                lineEnd = content.size();
+            size_t lineLength = lineEnd - lineStart;
+            if (lineLength && (content[lineEnd - 1] == L'\r'))
+                --lineLength;
+            line.assign(content, lineStart, lineLength);
+            lineStart = lineEnd + 1;
+        }
+        if (line.empty())
         {
             //empty line means end of entry!
             RESOURCEENTRY resEntry = {0};
@@ -97,7 +166,14 @@ BOOL CPOFile::ParseFile(LPCTSTR szPath, BOOL bUpdateExisting, bool bAdjustEOLs)
                         resEntry.translatorcomments.push_back(I->c_str());
                     if (!regexsearch.empty() && !regexreplace.empty())
                     {
-                        m_regexes.push_back(std::make_tuple(regexsearch, regexreplace));
+                        try
+                        {
+                            m_regexes.push_back(std::make_tuple(std::wregex(regexsearch, std::regex_constants::icase), regexreplace));
+                        }
+                        catch (std::exception&)
+                        {
+                            // ignore invalid expressions
+                        }
                         regexsearch.clear();
                         regexreplace.clear();
                     }
@@ -155,7 +231,8 @@ BOOL CPOFile::ParseFile(LPCTSTR szPath, BOOL bUpdateExisting, bool bAdjustEOLs)
                 }
             }
             entry.clear();
-            if ((bUpdateExisting)&&(this->count(msgid) == 0))
+            auto found = this->find(msgid);
+            if ((bUpdateExisting)&&(found == this->end()))
                 nDeleted++;
             else
             {
@@ -163,23 +240,23 @@ BOOL CPOFile::ParseFile(LPCTSTR szPath, BOOL bUpdateExisting, bool bAdjustEOLs)
                 {
                     AdjustEOLs(resEntry.msgstr);
                 }
+                if (found == this->end())
+                    found = this->emplace(std::move(msgid), RESOURCEENTRY()).first;
                 // always use the new data for generated comments/flags
-                auto newEntry = (*this)[msgid];
-                resEntry.automaticcomments = newEntry.automaticcomments;
-                resEntry.flag = newEntry.flag;
-                resEntry.resourceIDs = newEntry.resourceIDs;
+                RESOURCEENTRY& newEntry = found->second;
+                resEntry.automaticcomments = std::move(newEntry.automaticcomments);
+                resEntry.flag = std::move(newEntry.flag);
+                resEntry.resourceIDs = std::move(newEntry.resourceIDs);
 
-                (*this)[msgid] = resEntry;
+                newEntry = std::move(resEntry);
             }
             msgid.clear();
         }
         else
         {
-            entry.push_back(line.get());
+            entry.push_back(line);
         }
-    } while (File.gcount() > 0);
-    printf("%s", File.getloc().name().c_str());
-    File.close();
+    } while (!bEndOfFile);
     RESOURCEENTRY emptyentry = {0};
     (*this)[std::wstring(L"")] = emptyentry;
     if (!m_bQuiet)
@@ -249,14 +326,22 @@ BOOL CPOFile::SaveFile(LPCTSTR szPath, LPCTSTR lpszHeaderFile)
     File << L"# If you do not want to change an Accelerator Key, copy msgid to msgstr\n";
     File << L"\n";
 
-    for (auto I = this->cbegin(); I != this->cend(); ++I)
+    // the catalog is unordered, but the file is written sorted by msgid
+    // so that it doesn't change more than necessary
+    std::vector<const value_type*> sortedEntries;
+    sortedEntries.reserve(this->size());
+    for (const auto& e : *this)
+        sortedEntries.push_back(&e);
+    std::sort(sortedEntries.begin(), sortedEntries.end(), [](const value_type* a, const value_type* b) { return a->first < b->first; });
+
+    for (const value_type* I : sortedEntries)
     {
         std::wstring s = I->first;
         s.erase(s.cbegin(), std::find_if(s.cbegin(), s.cend(), [](const auto& c) { return !iswspace(c); }));
         if (s.empty())
             continue;
 
-        RESOURCEENTRY entry = I->second;
+        const RESOURCEENTRY& entry = I->second;
         for (auto II = entry.automaticcomments.cbegin(); II != entry.automaticcomments.cend(); ++II)
         {
             File << II->c_str() << L"\n";
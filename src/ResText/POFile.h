@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2007, 2011, 2015-2016 - TortoiseSVN
+// Copyright (C) 2003-2007, 2011, 2015-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -17,10 +17,11 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 #pragma once
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <set>
 #include <vector>
 #include <tuple>
+#include <regex>
 
 typedef struct tagResourceEntry
 {
@@ -35,13 +36,15 @@ typedef struct tagResourceEntry
 
 /**
  * \ingroup ResText
- * Class to handle po-files. Inherits from an std::map which assigns
+ * Class to handle po-files. Inherits from an std::unordered_map which assigns
  * string IDs to additional information, including the translated strings.
+ * Every string ID is stored only once, as the key of its entry. SaveFile()
+ * writes the entries sorted by their string IDs.
  *
  * Provides methods to load and save a po-file with the translation information
  * we need for ResText.
  */
-class CPOFile : public std::map<std::wstring, RESOURCEENTRY>
+class CPOFile : public std::unordered_map<std::wstring, RESOURCEENTRY>
 {
 public:
     CPOFile();
@@ -51,7 +54,19 @@ public:
     BOOL SaveFile(LPCTSTR szPath, LPCTSTR lpszHeaderFile);
     void SetQuiet(BOOL bQuiet = TRUE) {m_bQuiet = bQuiet;}
 
-    std::vector<std::tuple<std::wstring, std::wstring>> m_regexes;
+    /// returns the entry for \a msgid or an empty entry if there is none.
+    /// Doesn't modify the catalog, so several threads can use it at once.
+    const RESOURCEENTRY& GetEntry(const std::wstring& msgid) const;
+    /// applies the regexsearch/regexreplace pairs to \a str, in the order
+    /// of the po-file. Like GetEntry(), this can be used by several threads.
+    void ApplyRegexes(std::wstring& str) const;
+
+    /// reads a whole UTF-8 file, with or without BOM, as UTF-16
+    static bool ReadUtf8File(LPCTSTR szPath, std::wstring& content);
+
+    /// the regexsearch/regexreplace pairs of the po-file, the search
+    /// expressions are compiled when the file is parsed
+    std::vector<std::tuple<std::wregex, std::wstring>> m_regexes;
 private:
     void AdjustEOLs(std::wstring& str);
     BOOL m_bQuiet;
@@ -1,7 +1,7 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
 // Copyright (C) 2015-2019 - TortoiseGit
-// Copyright (C) 2003-2008, 2010-2017, 2019 - TortoiseSVN
+// Copyright (C) 2003-2008, 2010-2017, 2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -28,6 +28,9 @@
 #include <functional>
 #include <locale>
 #include <codecvt>
+#include <thread>
+#include <atomic>
+#include <system_error>
 
 #pragma warning(push)
 #pragma warning(disable: 4091) // 'typedef ': ignored on left of '' when no variable is declared
@@ -253,31 +256,31 @@ BOOL CResModule::CreateTranslatedResources(LPCTSTR lpszSrcLangDllPath, LPCTSTR l
 
     if (!m_bQuiet)
         _ftprintf(stdout, L"Translating StringTable...");
-    bRes = EnumResourceNames(m_hResDll, RT_STRING, EnumResNameWriteCallback, (LONG_PTR)this);
+    bRes = TranslateResources(RT_STRING, m_bTranslatedStrings, m_bDefaultStrings);
     if (!m_bQuiet)
         _ftprintf(stdout, L"%4d translated, %4d not translated\n", m_bTranslatedStrings, m_bDefaultStrings);
 
     if (!m_bQuiet)
         _ftprintf(stdout, L"Translating Dialogs.......");
-    bRes = EnumResourceNames(m_hResDll, RT_DIALOG, EnumResNameWriteCallback, (LONG_PTR)this);
+    bRes = TranslateResources(RT_DIALOG, m_bTranslatedDialogStrings, m_bDefaultDialogStrings);
     if (!m_bQuiet)
         _ftprintf(stdout, L"%4d translated, %4d not translated\n", m_bTranslatedDialogStrings, m_bDefaultDialogStrings);
 
     if (!m_bQuiet)
         _ftprintf(stdout, L"Translating Menus.........");
-    bRes = EnumResourceNames(m_hResDll, RT_MENU, EnumResNameWriteCallback, (LONG_PTR)this);
+    bRes = TranslateResources(RT_MENU, m_bTranslatedMenuStrings, m_bDefaultMenuStrings);
     if (!m_bQuiet)
         _ftprintf(stdout, L"%4d translated, %4d not translated\n", m_bTranslatedMenuStrings, m_bDefaultMenuStrings);
 
     if (!m_bQuiet)
         _ftprintf(stdout, L"Translating Accelerators..");
-    bRes = EnumResourceNames(m_hResDll, RT_ACCELERATOR, EnumResNameWriteCallback, (LONG_PTR)this);
+    bRes = TranslateResources(RT_ACCELERATOR, m_bTranslatedAcceleratorStrings, m_bDefaultAcceleratorStrings);
     if (!m_bQuiet)
         _ftprintf(stdout, L"%4d translated, %4d not translated\n", m_bTranslatedAcceleratorStrings, m_bDefaultAcceleratorStrings);
 
     if (!m_bQuiet)
         _ftprintf(stdout, L"Translating Ribbons.......");
-    bRes = EnumResourceNames(m_hResDll, RT_RIBBON, EnumResNameWriteCallback, (LONG_PTR)this);
+    bRes = TranslateResources(RT_RIBBON, m_bTranslatedRibbonTexts, m_bDefaultRibbonTexts);
     if (!m_bQuiet)
         _ftprintf(stdout, L"%4d translated, %4d not translated\n", m_bTranslatedRibbonTexts, m_bDefaultRibbonTexts);
     bRes = TRUE;
@@ -348,11 +351,10 @@ BOOL CResModule::ExtractString(LPCTSTR lpszType)
         if (buf[0])
         {
             std::wstring str = std::wstring(buf);
-            RESOURCEENTRY entry = m_StringEntries[str];
+            RESOURCEENTRY& entry = m_StringEntries[str];
             InsertResourceIDs(RT_STRING, 0, entry, ((INT_PTR)lpszType - 1) * 16 + i, L"");
             if (wcschr(str.c_str(), '%'))
                 entry.flag = L"#, c-format";
-            m_StringEntries[str] = entry;
         }
         pp += len;
     }
@@ -365,113 +367,59 @@ DONE_ERROR:
     MYERROR;
 }
 
-BOOL CResModule::ReplaceString(LPCTSTR lpszType, WORD wLanguage)
+BOOL CResModule::ReplaceString(RESOURCEJOB& job) const
 {
-    HRSRC       hrsrc = FindResourceEx(m_hResDll, RT_STRING, lpszType, wLanguage);
-    HGLOBAL     hglStringTable;
-    LPWSTR      p;
-
-    if (!hrsrc)
-        MYERROR;
-    hglStringTable = LoadResource(m_hResDll, hrsrc);
-
-    if (!hglStringTable)
-        goto DONE_ERROR;
-    p = (LPWSTR)LockResource(hglStringTable);
-
-    if (!p)
-        goto DONE_ERROR;
 /*  [Block of 16 strings.  The strings are Pascal style with a WORD
     length preceding the string.  16 strings are always written, even
     if not all slots are full.  Any slots in the block with no string
     have a zero WORD for the length.]
 */
+    const WORD * p = (const WORD *)job.data;
+    std::wstring strings[16];
 
-    //first check how much memory we need
+    //first translate the strings to know how much memory we need
     size_t nMem = 0;
-    LPWSTR pp = p;
     for (int i=0; i<16; ++i)
     {
-        nMem++;
-        size_t len = GET_WORD(pp);
-        pp++;
-        std::wstring msgid = std::wstring(pp, len);
-        wchar_t buf[MAX_STRING_LENGTH * 2] = { 0 };
-        wcscpy_s(buf, msgid.c_str());
-        CUtils::StringExtend(buf);
-        msgid = std::wstring(buf);
-
-        RESOURCEENTRY resEntry;
-        resEntry = m_StringEntries[msgid];
-        wcscpy_s(buf, resEntry.msgstr.empty() ? msgid.c_str() : resEntry.msgstr.c_str());
-        ReplaceWithRegex(buf);
-        CUtils::StringCollapse(buf);
-        size_t newlen = wcslen(buf);
-        if (newlen)
-            nMem += newlen;
-        else
-            nMem += len;
-        pp += len;
-    }
-
-    WORD * newTable = new WORD[nMem + (nMem % 2)];
-    SecureZeroMemory(newTable, (nMem + (nMem % 2))*2);
-
-    size_t index = 0;
-    for (int i=0; i<16; ++i)
-    {
-        int len = GET_WORD(p);
+        size_t len = GET_WORD(p);
         p++;
-        std::wstring msgid = std::wstring(p, len);
+        std::wstring msgid = std::wstring((LPCWSTR)p, len);
         wchar_t buf[MAX_STRING_LENGTH * 2] = { 0 };
         wcscpy_s(buf, msgid.c_str());
         CUtils::StringExtend(buf);
         msgid = std::wstring(buf);
 
-        RESOURCEENTRY resEntry;
-        resEntry = m_StringEntries[msgid];
+        const RESOURCEENTRY& resEntry = m_StringEntries.GetEntry(msgid);
         wcscpy_s(buf, resEntry.msgstr.empty() ? msgid.c_str() : resEntry.msgstr.c_str());
         ReplaceWithRegex(buf);
         CUtils::StringCollapse(buf);
-        size_t newlen = wcslen(buf);
-        if (newlen)
+        if (buf[0])
         {
-            newTable[index++] = (WORD)newlen;
-            wcsncpy((wchar_t *)&newTable[index], buf, newlen);
-            index += newlen;
-            m_bTranslatedStrings++;
+            strings[i] = buf;
+            job.translatedCount++;
         }
         else
         {
-            newTable[index++] = (WORD)len;
+            strings[i] = std::wstring((LPCWSTR)p, len);
             if (len)
-                wcsncpy((wchar_t *)&newTable[index], p, len);
-            index += len;
-            if (len)
-                m_bDefaultStrings++;
+                job.defaultCount++;
         }
+        nMem += strings[i].size() + 1;
         p += len;
     }
 
-    if (!UpdateResource(m_hUpdateRes, RT_STRING, lpszType, (m_wTargetLang ? m_wTargetLang : wLanguage), newTable, (DWORD)(nMem + (nMem % 2))*2))
-    {
-        delete [] newTable;
-        goto DONE_ERROR;
-    }
+    job.translated.assign((nMem + (nMem % 2)) * sizeof(WORD), 0);
+    WORD * newTable = (WORD *)job.translated.data();
 
-    if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, RT_STRING, lpszType, wLanguage, nullptr, 0)))
+    size_t index = 0;
+    for (const auto& str : strings)
     {
-        delete [] newTable;
-        goto DONE_ERROR;
+        newTable[index++] = (WORD)str.size();
+        if (!str.empty())
+            wcsncpy((wchar_t *)&newTable[index], str.c_str(), str.size());
+        index += str.size();
     }
-    delete [] newTable;
-    UnlockResource(hglStringTable);
-    FreeResource(hglStringTable);
     return TRUE;
-DONE_ERROR:
-    UnlockResource(hglStringTable);
-    FreeResource(hglStringTable);
-    MYERROR;
 }
 
 BOOL CResModule::ExtractMenu(LPCTSTR lpszType)
@@ -545,26 +493,11 @@ DONE_ERROR:
     MYERROR;
 }
 
-BOOL CResModule::ReplaceMenu(LPCTSTR lpszType, WORD wLanguage)
+BOOL CResModule::ReplaceMenu(RESOURCEJOB& job) const
 {
-    HRSRC       hrsrc = FindResourceEx(m_hResDll, RT_MENU, lpszType, wLanguage);
-    HGLOBAL     hglMenuTemplate;
     WORD        version, offset;
-    LPWSTR      p;
-    WORD *p0;
-
-    if (!hrsrc)
-        MYERROR;    //just the language wasn't found
-
-    hglMenuTemplate = LoadResource(m_hResDll, hrsrc);
-
-    if (!hglMenuTemplate)
-        MYERROR;
-
-    p = (LPWSTR)LockResource(hglMenuTemplate);
-
-    if (!p)
-        MYERROR;
+    const WORD* p = (const WORD *)job.data;
+    const WORD* p0 = p;
 
     //struct MenuHeader {
     //  WORD   wVersion;           // Currently zero
@@ -577,7 +510,6 @@ BOOL CResModule::ReplaceMenu(LPCTSTR lpszType, WORD wLanguage)
     //    WORD wOffset;
     //    DWORD dwHelpId;
     //};
-    p0 = (WORD *)p;
     version = GET_WORD(p);
 
     p++;
@@ -590,29 +522,12 @@ BOOL CResModule::ReplaceMenu(LPCTSTR lpszType, WORD wLanguage)
             p += offset;
             p++;
             size_t nMem = 0;
-            if (!CountMemReplaceMenuResource((WORD*)p, &nMem, nullptr))
-                goto DONE_ERROR;
-            WORD * newMenu = new WORD[nMem + (nMem % 2)+2];
-            SecureZeroMemory(newMenu, (nMem + (nMem % 2)+2)*2);
+            if (!CountMemReplaceMenuResource(p, &nMem, nullptr, &job.translatedCount, &job.defaultCount))
+                return FALSE;
+            job.translated.assign((nMem + (nMem % 2) + 2) * sizeof(WORD), 0);
             size_t index = 2;       // MenuHeader has 2 WORDs zero
-            if (!CountMemReplaceMenuResource((WORD *)p, &index, newMenu))
-            {
-                delete [] newMenu;
-                goto DONE_ERROR;
-            }
-
-            if (!UpdateResource(m_hUpdateRes, RT_MENU, lpszType, (m_wTargetLang ? m_wTargetLang : wLanguage), newMenu, (DWORD)(nMem + (nMem % 2)+2)*2))
-            {
-                delete [] newMenu;
-                goto DONE_ERROR;
-            }
-
-            if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, RT_MENU, lpszType, wLanguage, nullptr, 0)))
-            {
-                delete [] newMenu;
-                goto DONE_ERROR;
-            }
-            delete [] newMenu;
+            if (!CountMemReplaceMenuResource(p, &index, (WORD *)job.translated.data(), &job.translatedCount, &job.defaultCount))
+                return FALSE;
         }
         break;
     case 1:
@@ -621,44 +536,20 @@ BOOL CResModule::ReplaceMenu(LPCTSTR lpszType, WORD wLanguage)
             p++;
             //dwHelpId = GET_DWORD(p);
             size_t nMem = 0;
-            if (!CountMemReplaceMenuExResource((WORD*)(p0 + offset), &nMem, nullptr))
-                goto DONE_ERROR;
-            WORD * newMenu = new WORD[nMem + (nMem % 2) + 4];
-            SecureZeroMemory(newMenu, (nMem + (nMem % 2) + 4) * 2);
+            if (!CountMemReplaceMenuExResource(p0 + offset, &nMem, nullptr, &job.translatedCount, &job.defaultCount))
+                return FALSE;
+            job.translated.assign((nMem + (nMem % 2) + 4) * sizeof(WORD), 0);
+            WORD * newMenu = (WORD *)job.translated.data();
             CopyMemory(newMenu, p0, 2 * sizeof(WORD) + sizeof(DWORD));
             size_t index = 4;       // MenuExHeader has 2 x WORD + 1 x DWORD
-            if (!CountMemReplaceMenuExResource((WORD *)(p0 + offset), &index, newMenu))
-            {
-                delete [] newMenu;
-                goto DONE_ERROR;
-            }
-
-            if (!UpdateResource(m_hUpdateRes, RT_MENU, lpszType, (m_wTargetLang ? m_wTargetLang : wLanguage), newMenu, (DWORD)(nMem + (nMem % 2) + 4) * 2))
-            {
-                delete [] newMenu;
-                goto DONE_ERROR;
-            }
-
-            if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, RT_MENU, lpszType, wLanguage, nullptr, 0)))
-            {
-                delete [] newMenu;
-                goto DONE_ERROR;
-            }
-            delete [] newMenu;
+            if (!CountMemReplaceMenuExResource(p0 + offset, &index, newMenu, &job.translatedCount, &job.defaultCount))
+                return FALSE;
         }
         break;
     default:
-        goto DONE_ERROR;
+        return FALSE;
     }
-
-    UnlockResource(hglMenuTemplate);
-    FreeResource(hglMenuTemplate);
     return TRUE;
-
-DONE_ERROR:
-    UnlockResource(hglMenuTemplate);
-    FreeResource(hglMenuTemplate);
-    MYERROR;
 }
 
 const WORD* CResModule::ParseMenuResource(const WORD * res)
@@ -699,12 +590,10 @@ const WORD* CResModule::ParseMenuResource(const WORD * res)
             CUtils::StringExtend(buf);
 
             std::wstring wstr = std::wstring(buf);
-            RESOURCEENTRY entry = m_StringEntries[wstr];
+            RESOURCEENTRY& entry = m_StringEntries[wstr];
             if (id)
                 InsertResourceIDs(RT_MENU, 0, entry, id, L" - PopupMenu");
 
-            m_StringEntries[wstr] = entry;
-
             if ((res = ParseMenuResource(res))==0)
                 return nullptr;
         }
@@ -715,7 +604,7 @@ const WORD* CResModule::ParseMenuResource(const WORD * res)
             CUtils::StringExtend(buf);
 
             std::wstring wstr = std::wstring(buf);
-            RESOURCEENTRY entry = m_StringEntries[wstr];
+            RESOURCEENTRY& entry = m_StringEntries[wstr];
             InsertResourceIDs(RT_MENU, 0, entry, id, L" - Menu");
 
             TCHAR szTempBuf[1024] = { 0 };
@@ -724,15 +613,13 @@ const WORD* CResModule::ParseMenuResource(const WORD * res)
             menu_entry.wID = id;
             menu_entry.reference = szTempBuf;
             menu_entry.msgstr = wstr;
-
-            m_StringEntries[wstr] = entry;
             m_MenuEntries[id] = menu_entry;
         }
     } while (!(flags & MF_END));
     return res;
 }
 
-const WORD* CResModule::CountMemReplaceMenuResource(const WORD * res, size_t * wordcount, WORD * newMenu)
+const WORD* CResModule::CountMemReplaceMenuResource(const WORD * res, size_t * wordcount, WORD * newMenu, int * translated, int * def) const
 {
     WORD        flags;
     WORD        id = 0;
@@ -769,15 +656,15 @@ const WORD* CResModule::CountMemReplaceMenuResource(const WORD * res, size_t * w
 
         if (flags & MF_POPUP)
         {
-            ReplaceStr((LPCWSTR)res, newMenu, wordcount, &m_bTranslatedMenuStrings, &m_bDefaultMenuStrings);
+            ReplaceStr((LPCWSTR)res, newMenu, wordcount, translated, def);
             res += wcslen((LPCWSTR)res) + 1;
 
-            if ((res = CountMemReplaceMenuResource(res, wordcount, newMenu))==0)
+            if ((res = CountMemReplaceMenuResource(res, wordcount, newMenu, translated, def))==0)
                 return nullptr;
         }
         else if (id != 0)
         {
-            ReplaceStr((LPCWSTR)res, newMenu, wordcount, &m_bTranslatedMenuStrings, &m_bDefaultMenuStrings);
+            ReplaceStr((LPCWSTR)res, newMenu, wordcount, translated, def);
             res += wcslen((LPCWSTR)res) + 1;
         }
         else
@@ -834,7 +721,7 @@ const WORD* CResModule::ParseMenuExResource(const WORD * res)
             CUtils::StringExtend(buf);
 
             std::wstring wstr = std::wstring(buf);
-            RESOURCEENTRY entry = m_StringEntries[wstr];
+            RESOURCEENTRY& entry = m_StringEntries[wstr];
             // Popup has a DWORD help entry on a DWORD boundary - skip over it
             res += 2;
 
@@ -845,7 +732,6 @@ const WORD* CResModule::ParseMenuExResource(const WORD * res)
             menu_entry.wID = (WORD)menuId;
             menu_entry.reference = szTempBuf;
             menu_entry.msgstr = wstr;
-            m_StringEntries[wstr] = entry;
             m_MenuEntries[(WORD)menuId] = menu_entry;
 
             if ((res = ParseMenuExResource(res)) == 0)
@@ -857,7 +743,7 @@ const WORD* CResModule::ParseMenuExResource(const WORD * res)
             CUtils::StringExtend(buf);
 
             std::wstring wstr = std::wstring(buf);
-            RESOURCEENTRY entry = m_StringEntries[wstr];
+            RESOURCEENTRY& entry = m_StringEntries[wstr];
             InsertResourceIDs(RT_MENU, 0, entry, menuId, L" - MenuEx");
 
             TCHAR szTempBuf[1024] = { 0 };
@@ -866,14 +752,13 @@ const WORD* CResModule::ParseMenuExResource(const WORD * res)
             menu_entry.wID = (WORD)menuId;
             menu_entry.reference = szTempBuf;
             menu_entry.msgstr = wstr;
-            m_StringEntries[wstr] = entry;
             m_MenuEntries[(WORD)menuId] = menu_entry;
         }
     } while (!(bResInfo & 0x80));
     return res;
 }
 
-const WORD* CResModule::CountMemReplaceMenuExResource(const WORD * res, size_t * wordcount, WORD * newMenu)
+const WORD* CResModule::CountMemReplaceMenuExResource(const WORD * res, size_t * wordcount, WORD * newMenu, int * translated, int * def) const
 {
     WORD bResInfo;
 
@@ -912,7 +797,7 @@ const WORD* CResModule::CountMemReplaceMenuExResource(const WORD * res, size_t *
 
         if (bResInfo & 0x01)
         {
-            ReplaceStr((LPCWSTR)res, newMenu, wordcount, &m_bTranslatedMenuStrings, &m_bDefaultMenuStrings);
+            ReplaceStr((LPCWSTR)res, newMenu, wordcount, translated, def);
             res += wcslen((LPCWSTR)res) + 1;
             // Align to DWORD
             res = AlignWORD(res);
@@ -925,12 +810,12 @@ const WORD* CResModule::CountMemReplaceMenuExResource(const WORD * res, size_t *
             res += 2;
             (*wordcount) += 2;
 
-            if ((res = CountMemReplaceMenuExResource(res, wordcount, newMenu)) == 0)
+            if ((res = CountMemReplaceMenuExResource(res, wordcount, newMenu, translated, def)) == 0)
                 return nullptr;
         }
         else if (menuId != 0)
         {
-            ReplaceStr((LPCWSTR)res, newMenu, wordcount, &m_bTranslatedMenuStrings, &m_bDefaultMenuStrings);
+            ReplaceStr((LPCWSTR)res, newMenu, wordcount, translated, def);
             res += wcslen((LPCWSTR)res) + 1;
         }
         else
@@ -1046,7 +931,7 @@ BOOL CResModule::ExtractAccelerator(LPCTSTR lpszType)
         swprintf_s(buf2, L"%s+%c", buf, wAnsi);
 
         std::wstring wstr = std::wstring(buf2);
-        RESOURCEENTRY AKey_entry = m_StringEntries[wstr];
+        RESOURCEENTRY& AKey_entry = m_StringEntries[wstr];
 
         TCHAR szTempBuf[1024] = { 0 };
         std::wstring wmenu;
@@ -1057,8 +942,6 @@ BOOL CResModule::ExtractAccelerator(LPCTSTR lpszType)
         }
         swprintf_s(szTempBuf, L"#. Accelerator Entry for Menu ID:%u; '%s'", wID, wmenu.c_str());
         AKey_entry.automaticcomments.push_back(std::wstring(szTempBuf));
-
-        m_StringEntries[wstr] = AKey_entry;
     } while (!bEnd);
 
     UnlockResource(hglAccTable);
@@ -1071,16 +954,15 @@ DONE_ERROR:
     MYERROR;
 }
 
-BOOL CResModule::ReplaceAccelerator(LPCTSTR lpszType, WORD wLanguage)
+BOOL CResModule::ReplaceAccelerator(RESOURCEJOB& job) const
 {
     LPACCEL     lpaccelNew;         // pointer to new accelerator table
     HACCEL      haccelOld;          // handle to old accelerator table
     int         cAccelerators;      // number of accelerators in table
-    HGLOBAL     hglAccTableNew;
-    const WORD* p;
+    WORD*       p;
     int         i;
 
-    haccelOld = LoadAccelerators(m_hResDll, lpszType);
+    haccelOld = LoadAccelerators(m_hResDll, job.GetName());
 
     if (!haccelOld)
         MYERROR;
@@ -1136,10 +1018,10 @@ BOOL CResModule::ReplaceAccelerator(LPCTSTR lpszType, WORD wLanguage)
         swprintf_s(buf2, L"%s+%c", buf, lpaccelNew[i].key);
 
         // Is it there?
-        std::map<std::wstring, RESOURCEENTRY>::iterator pAK_iter = m_StringEntries.find(buf2);
+        auto pAK_iter = m_StringEntries.find(buf2);
         if (pAK_iter != m_StringEntries.end())
         {
-            m_bTranslatedAcceleratorStrings++;
+            job.translatedCount++;
             xfVirt = 0;
             xkey = 0;
             std::wstring wtemp = pAK_iter->second.msgstr;
@@ -1170,15 +1052,13 @@ BOOL CResModule::ReplaceAccelerator(LPCTSTR lpszType, WORD wLanguage)
             }
         }
         else
-            m_bDefaultAcceleratorStrings++;
+            job.defaultCount++;
     }
 
 
     // Create the new accelerator table
-    hglAccTableNew = LocalAlloc(LPTR, cAccelerators * 4 * sizeof(WORD));
-    if (!hglAccTableNew)
-        goto DONE_ERROR;
-    p = (WORD *)hglAccTableNew;
+    job.translated.assign(cAccelerators * 4 * sizeof(WORD), 0);
+    p = (WORD *)job.translated.data();
     lpaccelNew[cAccelerators-1].fVirt |= 0x80;
     for (i = 0; i < cAccelerators; i++)
     {
@@ -1191,25 +1071,8 @@ BOOL CResModule::ReplaceAccelerator(LPCTSTR lpszType, WORD wLanguage)
         p++;
     }
 
-    if (!UpdateResource(m_hUpdateRes, RT_ACCELERATOR, lpszType,
-        (m_wTargetLang ? m_wTargetLang : wLanguage), hglAccTableNew /* haccelNew*/, cAccelerators * 4 * sizeof(WORD)))
-    {
-        goto DONE_ERROR;
-    }
-
-    if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, RT_ACCELERATOR, lpszType, wLanguage, nullptr, 0)))
-    {
-        goto DONE_ERROR;
-    }
-
-    LocalFree(hglAccTableNew);
     LocalFree(lpaccelNew);
     return TRUE;
-
-DONE_ERROR:
-    LocalFree(hglAccTableNew);
-    LocalFree(lpaccelNew);
-    MYERROR;
 }
 
 BOOL CResModule::ExtractDialog(LPCTSTR lpszType)
@@ -1246,10 +1109,8 @@ BOOL CResModule::ExtractDialog(LPCTSTR lpszType)
         CUtils::StringExtend(buf);
 
         std::wstring wstr = std::wstring(buf);
-        RESOURCEENTRY entry = m_StringEntries[wstr];
+        RESOURCEENTRY& entry = m_StringEntries[wstr];
         InsertResourceIDs(RT_DIALOG, (INT_PTR)lpszType, entry, (INT_PTR)lpszType, L"");
-
-        m_StringEntries[wstr] = entry;
     }
 
     while (bNumControls-- != 0)
@@ -1267,10 +1128,8 @@ BOOL CResModule::ExtractDialog(LPCTSTR lpszType)
             CUtils::StringExtend(szTitle);
 
             std::wstring wstr = std::wstring(szTitle);
-            RESOURCEENTRY entry = m_StringEntries[wstr];
+            RESOURCEENTRY& entry = m_StringEntries[wstr];
             InsertResourceIDs(RT_DIALOG, (INT_PTR)lpszType, entry, dlgItem.id, L"");
-
-            m_StringEntries[wstr] = entry;
         }
     }
 
@@ -1279,62 +1138,19 @@ BOOL CResModule::ExtractDialog(LPCTSTR lpszType)
     return (TRUE);
 }
 
-BOOL CResModule::ReplaceDialog(LPCTSTR lpszType, WORD wLanguage)
+BOOL CResModule::ReplaceDialog(RESOURCEJOB& job) const
 {
-    const WORD* lpDlg;
-    HRSRC       hrsrc;
-    HGLOBAL     hGlblDlgTemplate;
-
-    hrsrc = FindResourceEx(m_hResDll, RT_DIALOG, lpszType, wLanguage);
-
-    if (!hrsrc)
-        MYERROR;
-
-    hGlblDlgTemplate = LoadResource(m_hResDll, hrsrc);
-
-    if (!hGlblDlgTemplate)
-        MYERROR;
-
-    lpDlg = (WORD *) LockResource(hGlblDlgTemplate);
-
-    if (!lpDlg)
-        MYERROR;
+    const WORD* lpDlg = (const WORD *)job.data;
 
     size_t nMem = 0;
-    const WORD * p = lpDlg;
-    if (!CountMemReplaceDialogResource(p, &nMem, nullptr))
-        goto DONE_ERROR;
-    WORD * newDialog = new WORD[nMem + (nMem % 2)];
-    SecureZeroMemory(newDialog, (nMem + (nMem % 2))*2);
+    if (!CountMemReplaceDialogResource(lpDlg, &nMem, nullptr, &job.translatedCount, &job.defaultCount))
+        return FALSE;
+    job.translated.assign((nMem + (nMem % 2)) * sizeof(WORD), 0);
 
     size_t index = 0;
-    if (!CountMemReplaceDialogResource(lpDlg, &index, newDialog))
-    {
-        delete [] newDialog;
-        goto DONE_ERROR;
-    }
-
-    if (!UpdateResource(m_hUpdateRes, RT_DIALOG, lpszType, (m_wTargetLang ? m_wTargetLang : wLanguage), newDialog, (DWORD)(nMem + (nMem % 2))*2))
-    {
-        delete [] newDialog;
-        goto DONE_ERROR;
-    }
-
-    if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, RT_DIALOG, lpszType, wLanguage, nullptr, 0)))
-    {
-        delete [] newDialog;
-        goto DONE_ERROR;
-    }
-
-    delete [] newDialog;
-    UnlockResource(hGlblDlgTemplate);
-    FreeResource(hGlblDlgTemplate);
+    if (!CountMemReplaceDialogResource(lpDlg, &index, (WORD *)job.translated.data(), &job.translatedCount, &job.defaultCount))
+        return FALSE;
     return TRUE;
-
-DONE_ERROR:
-    UnlockResource(hGlblDlgTemplate);
-    FreeResource(hGlblDlgTemplate);
-    MYERROR;
 }
 
 const WORD* CResModule::GetDialogInfo(const WORD * pTemplate, LPDIALOGINFO lpDlgInfo) const
@@ -1530,7 +1346,7 @@ const WORD* CResModule::GetControlInfo(const WORD* p, LPDLGITEMINFO lpDlgItemInf
     return p;
 }
 
-const WORD * CResModule::CountMemReplaceDialogResource(const WORD * res, size_t * wordcount, WORD * newDialog)
+const WORD * CResModule::CountMemReplaceDialogResource(const WORD * res, size_t * wordcount, WORD * newDialog, int * translated, int * def) const
 {
     BOOL bEx = FALSE;
     DWORD style = GET_DWORD(res);
@@ -1676,7 +1492,7 @@ const WORD * CResModule::CountMemReplaceDialogResource(const WORD * res, size_t
 
     // Get the window caption
 
-    ReplaceStr((LPCWSTR)res, newDialog, wordcount, &m_bTranslatedDialogStrings, &m_bDefaultDialogStrings);
+    ReplaceStr((LPCWSTR)res, newDialog, wordcount, translated, def);
     res += wcslen((LPCWSTR)res) + 1;
 
     // Get the font name
@@ -1715,12 +1531,12 @@ const WORD * CResModule::CountMemReplaceDialogResource(const WORD * res, size_t
 
     while (nbItems--)
     {
-        res = ReplaceControlInfo(res, wordcount, newDialog, bEx);
+        res = ReplaceControlInfo(res, wordcount, newDialog, bEx, translated, def);
     }
     return res;
 }
 
-const WORD* CResModule::ReplaceControlInfo(const WORD * res, size_t * wordcount, WORD * newDialog, BOOL bEx)
+const WORD* CResModule::ReplaceControlInfo(const WORD * res, size_t * wordcount, WORD * newDialog, BOOL bEx, int * translated, int * def) const
 {
     if (bEx)
     {
@@ -1838,7 +1654,7 @@ const WORD* CResModule::ReplaceControlInfo(const WORD * res, size_t * wordcount,
     }
     else
     {
-        ReplaceStr((LPCWSTR)res, newDialog, wordcount, &m_bTranslatedDialogStrings, &m_bDefaultDialogStrings);
+        ReplaceStr((LPCWSTR)res, newDialog, wordcount, translated, def);
         res += wcslen((LPCWSTR)res) + 1;
     }
 
@@ -1909,11 +1725,10 @@ BOOL CResModule::ExtractRibbon(LPCTSTR lpszType)
         MultiByteToWideChar(CP_UTF8, 0, str3.c_str(), -1, bufw3.get(), (int)len * 4);
         std::wstring str = bufw3.get();
 
-        RESOURCEENTRY entry = m_StringEntries[str];
+        RESOURCEENTRY& entry = m_StringEntries[str];
         InsertResourceIDs(RT_RIBBON, 0, entry, std::stoi(strIdVal), strIdNameVal.c_str());
         if (wcschr(str.c_str(), '%'))
             entry.flag = L"#, c-format";
-        m_StringEntries[str] = entry;
         m_bDefaultRibbonTexts++;
     }
 
@@ -1928,11 +1743,10 @@ BOOL CResModule::ExtractRibbon(LPCTSTR lpszType)
         SecureZeroMemory(bufw.get(), (len*4 + 1)*sizeof(wchar_t));
         MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, bufw.get(), (int)len*4);
         std::wstring ret = bufw.get();
-        RESOURCEENTRY entry = m_StringEntries[ret];
+        RESOURCEENTRY& entry = m_StringEntries[ret];
         InsertResourceIDs(RT_RIBBON, 0, entry, (INT_PTR)lpszType, L" - Ribbon element");
         if (wcschr(ret.c_str(), '%'))
             entry.flag = L"#, c-format";
-        m_StringEntries[ret] = entry;
         m_bDefaultRibbonTexts++;
     }
 
@@ -1941,28 +1755,9 @@ BOOL CResModule::ExtractRibbon(LPCTSTR lpszType)
     return TRUE;
 }
 
-BOOL CResModule::ReplaceRibbon(LPCTSTR lpszType, WORD wLanguage)
+BOOL CResModule::ReplaceRibbon(RESOURCEJOB& job) const
 {
-    HRSRC       hrsrc = FindResource(m_hResDll, lpszType, RT_RIBBON);
-    HGLOBAL     hglRibbonTemplate;
-    const BYTE *p;
-
-    if (!hrsrc)
-        MYERROR;
-
-    hglRibbonTemplate = LoadResource(m_hResDll, hrsrc);
-
-    DWORD sizeres = SizeofResource(m_hResDll, hrsrc);
-
-    if (!hglRibbonTemplate)
-        MYERROR;
-
-    p = (const BYTE*)LockResource(hglRibbonTemplate);
-
-    if (!p)
-        MYERROR;
-
-    std::string ss = std::string((const char*)p, sizeres);
+    std::string ss = std::string((const char*)job.data, job.size);
     size_t len = ss.size();
     auto bufw = std::make_unique<wchar_t[]>(len * 4 + 1);
     SecureZeroMemory(bufw.get(), (len*4 + 1)*sizeof(wchar_t));
@@ -1981,7 +1776,7 @@ BOOL CResModule::ReplaceRibbon(LPCTSTR lpszType, WORD wLanguage)
         MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, bufw2.get(), (int)slen*4);
         std::wstring ret = bufw2.get();
 
-        RESOURCEENTRY entry = m_StringEntries[ret];
+        const RESOURCEENTRY& entry = m_StringEntries.GetEntry(ret);
         ret = L"<TEXT>" + ret + L"</TEXT>";
 
         if (entry.msgstr.size())
@@ -1995,10 +1790,10 @@ BOOL CResModule::ReplaceRibbon(LPCTSTR lpszType, WORD wLanguage)
             sreplace += sbuf.get();
             sreplace += L"</TEXT>";
             CUtils::SearchReplace(ssw, ret, sreplace);
-            m_bTranslatedRibbonTexts++;
+            job.translatedCount++;
         }
         else
-            m_bDefaultRibbonTexts++;
+            job.defaultCount++;
     }
 
     const std::regex regRevMatchName("</ELEMENT_NAME><NAME>([^<]+)</NAME>");
@@ -2011,7 +1806,7 @@ BOOL CResModule::ReplaceRibbon(LPCTSTR lpszType, WORD wLanguage)
         MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, bufw2.get(), (int)slen*4);
         std::wstring ret = bufw2.get();
 
-        RESOURCEENTRY entry = m_StringEntries[ret];
+        const RESOURCEENTRY& entry = m_StringEntries.GetEntry(ret);
         ret = L"</ELEMENT_NAME><NAME>" + ret + L"</NAME>";
 
         if (entry.msgstr.size())
@@ -2025,70 +1820,34 @@ BOOL CResModule::ReplaceRibbon(LPCTSTR lpszType, WORD wLanguage)
             sreplace += sbuf.get();
             sreplace += L"</NAME>";
             CUtils::SearchReplace(ssw, ret, sreplace);
-            m_bTranslatedRibbonTexts++;
+            job.translatedCount++;
         }
         else
-            m_bDefaultRibbonTexts++;
+            job.defaultCount++;
     }
 
     auto buf = std::make_unique<char[]>(ssw.size() * 4 + 1);
     int lengthIncTerminator = WideCharToMultiByte(CP_UTF8, 0, ssw.c_str(), -1, buf.get(), (int)len * 4, nullptr, nullptr);
+    if (lengthIncTerminator <= 0)
+        return FALSE;
 
-
-    if (!UpdateResource(m_hUpdateRes, RT_RIBBON, lpszType, (m_wTargetLang ? m_wTargetLang : wLanguage), buf.get(), lengthIncTerminator-1))
-    {
-        goto DONE_ERROR;
-    }
-
-    if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, RT_RIBBON, lpszType, wLanguage, nullptr, 0)))
-    {
-        goto DONE_ERROR;
-    }
-
-
-    UnlockResource(hglRibbonTemplate);
-    FreeResource(hglRibbonTemplate);
+    job.translated.assign(buf.get(), buf.get() + lengthIncTerminator - 1);
     return TRUE;
-
-DONE_ERROR:
-    UnlockResource(hglRibbonTemplate);
-    FreeResource(hglRibbonTemplate);
-    MYERROR;
 }
 
-std::wstring CResModule::ReplaceWithRegex(WCHAR* pBuf, size_t bufferSize)
+std::wstring CResModule::ReplaceWithRegex(WCHAR* pBuf, size_t bufferSize) const
 {
-    for (const auto& t : m_StringEntries.m_regexes)
-    {
-        try
-        {
-            std::wregex e(std::get<0>(t), std::regex_constants::icase);
-            auto replaced = std::regex_replace(pBuf, e, std::get<1>(t));
-            wcscpy_s(pBuf, bufferSize, replaced.c_str());
-        }
-        catch (std::exception&)
-        {
-
-        }
-    }
-    return pBuf;
+    if (m_StringEntries.m_regexes.empty())
+        return pBuf;
+    std::wstring s = pBuf;
+    m_StringEntries.ApplyRegexes(s);
+    wcscpy_s(pBuf, bufferSize, s.c_str());
+    return s;
 }
 
-std::wstring CResModule::ReplaceWithRegex(std::wstring& s)
+std::wstring CResModule::ReplaceWithRegex(std::wstring& s) const
 {
-    for (const auto& t : m_StringEntries.m_regexes)
-    {
-        try
-        {
-            std::wregex e(std::get<0>(t), std::regex_constants::icase);
-            auto replaced = std::regex_replace(s, e, std::get<1>(t));
-            s = replaced;
-        }
-        catch (std::exception&)
-        {
-
-        }
-    }
+    m_StringEntries.ApplyRegexes(s);
     return s;
 }
 
@@ -2142,41 +1901,100 @@ BOOL CALLBACK CResModule::EnumResNameCallback(HMODULE /*hModule*/, LPCTSTR lpszT
 
 BOOL CALLBACK CResModule::EnumResNameWriteCallback(HMODULE hModule, LPCTSTR lpszType, LPTSTR lpszName, LONG_PTR lParam)
 {
-    auto lpResModule = reinterpret_cast<CResModule*>(lParam);
-    return EnumResourceLanguages(hModule, lpszType, lpszName, (ENUMRESLANGPROC)&lpResModule->EnumResWriteLangCallback, lParam);
+    return EnumResourceLanguages(hModule, lpszType, lpszName, (ENUMRESLANGPROC)&CResModule::EnumResWriteLangCallback, lParam);
 }
 
-BOOL CALLBACK CResModule::EnumResWriteLangCallback(HMODULE /*hModule*/, LPCTSTR lpszType, LPTSTR lpszName, WORD wLanguage, LONG_PTR lParam)
+BOOL CALLBACK CResModule::EnumResWriteLangCallback(HMODULE hModule, LPCTSTR lpszType, LPTSTR lpszName, WORD wLanguage, LONG_PTR lParam)
 {
-    BOOL bRes = FALSE;
-    auto lpResModule = reinterpret_cast<CResModule*>(lParam);
+    auto jobs = reinterpret_cast<std::vector<RESOURCEJOB>*>(lParam);
 
-    if (lpszType == RT_STRING)
-    {
-        bRes = lpResModule->ReplaceString(lpszName, wLanguage);
-    }
-    else if (lpszType == RT_MENU)
+    HRSRC hrsrc = FindResourceEx(hModule, lpszType, lpszName, wLanguage);
+    if (!hrsrc)
+        MYERROR;
+    HGLOBAL hglResource = LoadResource(hModule, hrsrc);
+    if (!hglResource)
+        MYERROR;
+
+    RESOURCEJOB job;
+    job.lpszType = lpszType;
+    job.nameId = IS_INTRESOURCE(lpszName) ? (INT_PTR)lpszName : 0;
+    if (!IS_INTRESOURCE(lpszName))
+        job.name = lpszName;
+    job.wLanguage = wLanguage;
+    job.data = LockResource(hglResource);
+    job.size = SizeofResource(hModule, hrsrc);
+    job.bResult = FALSE;
+    job.translatedCount = 0;
+    job.defaultCount = 0;
+    if (!job.data)
+        MYERROR;
+
+    jobs->push_back(std::move(job));
+    return TRUE;
+}
+
+BOOL CResModule::TranslateResources(LPCTSTR lpszType, int& translated, int& def)
+{
+    // the resource data stays valid as long as the module is loaded
+    std::vector<RESOURCEJOB> jobs;
+    BOOL bRes = EnumResourceNames(m_hResDll, lpszType, EnumResNameWriteCallback, (LONG_PTR)&jobs);
+
+    // translating only reads the po-file entries, so the resources
+    // can be translated in parallel
+    std::atomic<size_t> nextJob(0);
+    auto translateJobs = [&]()
     {
-        bRes = lpResModule->ReplaceMenu(lpszName, wLanguage);
-    }
-    else if (lpszType == RT_DIALOG)
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+            jobs[i].bResult = TranslateResource(jobs[i]);
+    };
+    size_t threadCount = (std::min)((size_t)std::thread::hardware_concurrency(), jobs.size());
+    std::vector<std::thread> threads;
+    try
     {
-        bRes = lpResModule->ReplaceDialog(lpszName, wLanguage);
+        while (threads.size() + 1 < threadCount)
+            threads.push_back(std::thread(translateJobs));
     }
-    else if (lpszType == RT_ACCELERATOR)
+    catch (const std::system_error&)
     {
-        bRes = lpResModule->ReplaceAccelerator(lpszName, wLanguage);
+        // the remaining jobs are translated by this thread
     }
-    else if (lpszType == RT_RIBBON)
+    translateJobs();
+    for (auto& t : threads)
+        t.join();
+
+    // but the updates have to be done one after the other
+    for (const auto& job : jobs)
     {
-        bRes = lpResModule->ReplaceRibbon(lpszName, wLanguage);
-    }
+        if (!job.bResult)
+            return FALSE;
+        translated += job.translatedCount;
+        def += job.defaultCount;
 
+        if (!UpdateResource(m_hUpdateRes, lpszType, job.GetName(), (m_wTargetLang ? m_wTargetLang : job.wLanguage), (LPVOID)job.translated.data(), (DWORD)job.translated.size()))
+            MYERROR;
+
+        if (m_wTargetLang && (!UpdateResource(m_hUpdateRes, lpszType, job.GetName(), job.wLanguage, nullptr, 0)))
+            MYERROR;
+    }
     return bRes;
+}
 
+BOOL CResModule::TranslateResource(RESOURCEJOB& job) const
+{
+    if (job.lpszType == RT_STRING)
+        return ReplaceString(job);
+    else if (job.lpszType == RT_MENU)
+        return ReplaceMenu(job);
+    else if (job.lpszType == RT_DIALOG)
+        return ReplaceDialog(job);
+    else if (job.lpszType == RT_ACCELERATOR)
+        return ReplaceAccelerator(job);
+    else if (job.lpszType == RT_RIBBON)
+        return ReplaceRibbon(job);
+    return FALSE;
 }
 
-void CResModule::ReplaceStr(LPCWSTR src, WORD * dest, size_t * count, int * translated, int * def)
+void CResModule::ReplaceStr(LPCWSTR src, WORD * dest, size_t * count, int * translated, int * def) const
 {
     wchar_t buf[MAX_STRING_LENGTH] = { 0 };
     wcscpy_s(buf, src);
@@ -2184,7 +2002,7 @@ void CResModule::ReplaceStr(LPCWSTR src, WORD * dest, size_t * count, int * tran
 
     std::wstring wstr = std::wstring(buf);
     ReplaceWithRegex(buf);
-    RESOURCEENTRY entry = m_StringEntries[wstr];
+    const RESOURCEENTRY& entry = m_StringEntries.GetEntry(wstr);
     if (!entry.msgstr.empty())
     {
         wcscpy_s(buf, entry.msgstr.c_str());
@@ -1,7 +1,7 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
 // Copyright (C) 2019 - TortoiseGit
-// Copyright (C) 2003-2007, 2011-2012, 2014-2017 - TortoiseSVN
+// Copyright (C) 2003-2007, 2011-2012, 2014-2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -71,12 +71,38 @@ typedef struct tagMenuEntry
     std::wstring    reference;
     std::wstring    msgstr;
 } MENUENTRY, * LPMENUENTRY;
+// a resource of the source module and its translated data
+typedef struct tagResourceJob
+{
+    LPCTSTR             lpszType;
+    INT_PTR             nameId;         // zero if the resource has a name
+    std::wstring        name;
+    WORD                wLanguage;
+    const void *        data;
+    DWORD               size;
+    std::vector<BYTE>   translated;
+    BOOL                bResult;
+    int                 translatedCount;
+    int                 defaultCount;
+
+    LPCTSTR GetName() const { return nameId ? MAKEINTRESOURCE(nameId) : name.c_str(); }
+} RESOURCEJOB, * LPRESOURCEJOB;
 
 /**
  * \ingroup ResText
  * Class to handle a resource module (*.exe or *.dll file).
  *
  * Provides methods to extract and apply resource strings.
+ *
+ * To apply the translations, the resources of one type are collected first.
+ * Their data is then translated by several threads, which only read the
+ * po-file entries. Finally the translated data is written to the destination
+ * module, one resource after the other.
+ *
+ * The parts which don't need the Windows resource functions, the catalog
+ * lookups and the regex replacements, are done by CPOFile. Extracting the
+ * strings stays serial: it merges everything into one catalog and runs only
+ * once per template, not once per language.
  */
 class CResModule
 {
@@ -100,31 +126,34 @@ private:
     BOOL    ExtractDialog(LPCTSTR lpszType);
     BOOL    ExtractMenu(LPCTSTR lpszType);
     BOOL    ExtractRibbon(LPCTSTR lpszType);
-    BOOL    ReplaceString(LPCTSTR lpszType, WORD wLanguage);
-    BOOL    ReplaceDialog(LPCTSTR lpszType, WORD wLanguage);
-    BOOL    ReplaceMenu(LPCTSTR lpszType, WORD wLanguage);
     BOOL    ExtractAccelerator(LPCTSTR lpszType);
-    BOOL    ReplaceAccelerator(LPCTSTR lpszType, WORD wLanguage);
-    BOOL    ReplaceRibbon(LPCTSTR lpszType, WORD wLanguage);
+
+    BOOL    TranslateResources(LPCTSTR lpszType, int& translated, int& def);
+    BOOL    TranslateResource(RESOURCEJOB& job) const;
+    BOOL    ReplaceString(RESOURCEJOB& job) const;
+    BOOL    ReplaceDialog(RESOURCEJOB& job) const;
+    BOOL    ReplaceMenu(RESOURCEJOB& job) const;
+    BOOL    ReplaceAccelerator(RESOURCEJOB& job) const;
+    BOOL    ReplaceRibbon(RESOURCEJOB& job) const;
 
     template <size_t _Size>
-    inline std::wstring ReplaceWithRegex(WCHAR (&pBuf)[_Size])
+    inline std::wstring ReplaceWithRegex(WCHAR (&pBuf)[_Size]) const
     {
         return ReplaceWithRegex(pBuf, _Size);
     }
-    std::wstring ReplaceWithRegex(WCHAR* pBuf, size_t bufferSize);
-    std::wstring ReplaceWithRegex(std::wstring& s);
+    std::wstring ReplaceWithRegex(WCHAR* pBuf, size_t bufferSize) const;
+    std::wstring ReplaceWithRegex(std::wstring& s) const;
 
     const WORD* ParseMenuResource(const WORD * res);
-    const WORD* CountMemReplaceMenuResource(const WORD * res, size_t * wordcount, WORD * newMenu);
+    const WORD* CountMemReplaceMenuResource(const WORD * res, size_t * wordcount, WORD * newMenu, int * translated, int * def) const;
     const WORD* ParseMenuExResource(const WORD * res);
-    const WORD* CountMemReplaceMenuExResource(const WORD * res, size_t * wordcount, WORD * newMenu);
+    const WORD* CountMemReplaceMenuExResource(const WORD * res, size_t * wordcount, WORD * newMenu, int * translated, int * def) const;
     const WORD* GetControlInfo(const WORD* p, LPDLGITEMINFO lpDlgItemInfo, BOOL dialogEx, LPBOOL bIsID) const;
     const WORD* GetDialogInfo(const WORD * pTemplate, LPDIALOGINFO lpDlgInfo) const;
-    const WORD* CountMemReplaceDialogResource(const WORD * res, size_t * wordcount, WORD * newMenu);
-    const WORD* ReplaceControlInfo(const WORD * res, size_t * wordcount, WORD * newDialog, BOOL bEx);
+    const WORD* CountMemReplaceDialogResource(const WORD * res, size_t * wordcount, WORD * newMenu, int * translated, int * def) const;
+    const WORD* ReplaceControlInfo(const WORD * res, size_t * wordcount, WORD * newDialog, BOOL bEx, int * translated, int * def) const;
 
-    void    ReplaceStr(LPCWSTR src, WORD * dest, size_t * count, int * translated, int * def);
+    void    ReplaceStr(LPCWSTR src, WORD * dest, size_t * count, int * translated, int * def) const;
 
     size_t  ScanHeaderFile(const std::wstring& filepath);
     void    InsertResourceIDs(LPCWSTR lpType, INT_PTR mainId, RESOURCEENTRY& entry, INT_PTR id, LPCWSTR infotext);
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2019 - TortoiseSVN
+// Copyright (C) 2003-2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -21,9 +21,12 @@
 #include "SVN.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
+#include "svn_hash.h"
 #include "client.h"
 #include "svn_compat.h"
 #include "private/svn_client_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_fspath.h"
 #pragma warning(pop)
 
 #include "TortoiseProc.h"
@@ -43,6 +46,7 @@
 #include "SVNAdminDir.h"
 #include "SVNConfig.h"
 #include "SVNError.h"
+#include "SVNRASessionPool.h"
 #include "SVNLogQuery.h"
 #include "SVNDiffOptions.h"
 #include "CacheLogQuery.h"
@@ -2301,6 +2305,9 @@ bool SVN::List(const CTSVNPath& url, const SVNRev& revision, const SVNRev& pegre
     const char* svnPath = url.GetSVNApiPath(subpool);
     CHooks::Instance().PreConnect(CTSVNPathList(url));
 
+    if (!includeExternals && url.IsUrl() && ListWithPooledSession(svnPath, revision, pegrev, depth, fetchlocks, dirents, subpool))
+        return (Err == NULL);
+
     SVNTRACE(
         Err = svn_client_list4(svnPath,
                                pegrev,
@@ -2319,6 +2326,88 @@ bool SVN::List(const CTSVNPath& url, const SVNRev& revision, const SVNRev& pegre
     return (Err == NULL);
 }
 
+bool SVN::ListWithPooledSession(const char* url, const SVNRev& revision, const SVNRev& pegrev, svn_depth_t depth, bool fetchlocks, apr_uint32_t dirents, apr_pool_t* pool)
+{
+    // no history tracing and no recursion. An unspecified peg revision
+    // of a URL means HEAD, i.e. it only matches a HEAD revision.
+    const bool pegIsHead = !pegrev.IsValid() || pegrev.IsHead();
+    const bool sameRevision = (pegIsHead && revision.IsHead())
+                           || (pegrev.IsNumber() && revision.IsNumber() && ((LONG)pegrev == (LONG)revision));
+    if (!sameRevision)
+        return false;
+    if ((depth != svn_depth_empty) && (depth != svn_depth_files) && (depth != svn_depth_immediates))
+        return false;
+
+    SVNRASessionPool::Session session = SVNRASessionPool::Instance().Checkout(url, m_pctx->cancel_func, m_pctx->cancel_baton);
+    if (!session)
+        return false;
+
+    // fetch everything before reporting anything,
+    // so we can still fall back to svn_client_list4()
+
+    svn_revnum_t  rev      = revision.IsNumber() ? (LONG)revision : SVN_INVALID_REVNUM;
+    svn_dirent_t* dirent   = nullptr;
+    apr_hash_t*   entries  = nullptr;
+    apr_hash_t*   locks    = nullptr;
+    const char*   relPath  = nullptr;
+    svn_error_t*  err      = SVN_NO_ERROR;
+
+    if (!SVN_IS_VALID_REVNUM(rev))
+        err = svn_ra_get_latest_revnum(session.Get(), &rev, pool);
+    if (err == nullptr)
+        err = svn_ra_stat(session.Get(), "", rev, &dirent, pool);
+    if ((err == nullptr) && dirent && (dirent->kind == svn_node_dir))
+    {
+        err = svn_ra_get_path_relative_to_root(session.Get(), &relPath, url, pool);
+        if ((err == nullptr) && (depth != svn_depth_empty))
+            err = svn_ra_get_dir2(session.Get(), &entries, nullptr, nullptr, "", rev, dirents, pool);
+        if ((err == nullptr) && fetchlocks)
+        {
+            err = svn_ra_get_locks2(session.Get(), &locks, "", depth, pool);
+            if (err && (err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED))
+            {
+                svn_error_clear(err);
+                err   = nullptr;
+                locks = nullptr;
+            }
+        }
+    }
+
+    if (err)
+    {
+        svn_error_clear(err);
+        session.Discard();
+        return false;
+    }
+
+    // let svn_client_list4() handle files and report missing paths
+    if ((dirent == nullptr) || (dirent->kind != svn_node_dir))
+        return false;
+
+    // report in the same way as svn_client_list4()
+
+    const char* fsPath = svn_fspath__canonicalize(relPath, pool);
+    svn_lock_t* lock   = locks ? (svn_lock_t*)svn_hash_gets(locks, fsPath) : nullptr;
+    Err                = listReceiver(this, "", dirent, lock, fsPath, nullptr, nullptr, pool);
+    if (Err || (entries == nullptr))
+        return true;
+
+    apr_array_header_t* sorted = svn_sort__hash(entries, svn_sort_compare_items_lexically, pool);
+    for (int i = 0; (i < sorted->nelts) && (Err == nullptr); ++i)
+    {
+        const svn_sort__item_t& item  = APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+        const char*             name  = (const char*)item.key;
+        const svn_dirent_t*     entry = (const svn_dirent_t*)item.value;
+        if ((depth == svn_depth_files) && (entry->kind != svn_node_file))
+            continue;
+
+        lock = locks ? (svn_lock_t*)svn_hash_gets(locks, svn_fspath__join(fsPath, name, pool)) : nullptr;
+        Err  = listReceiver(this, name, entry, lock, fsPath, nullptr, nullptr, pool);
+    }
+
+    return true;
+}
+
 bool SVN::Relocate(const CTSVNPath& path, const CTSVNPath& from, const CTSVNPath& to, bool includeexternals)
 {
     Prepare();
@@ -2454,6 +2543,19 @@ svn_revnum_t SVN::GetHEADRevision(const CTSVNPath& path, bool cacheAllowed)
         // non-cached access
 
         CHooks::Instance().PreConnect(CTSVNPathList(path));
+
+        // try an already open session first
+        SVNRASessionPool::Session pooledSession = SVNRASessionPool::Instance().Checkout(urla, m_pctx->cancel_func, m_pctx->cancel_baton);
+        if (pooledSession)
+        {
+            svn_error_t* pooledErr = svn_ra_get_latest_revnum(pooledSession.Get(), &rev, localpool);
+            if (pooledErr == nullptr)
+                return rev;
+
+            svn_error_clear(pooledErr);
+            pooledSession.Discard();
+        }
+
         /* use subpool to create a temporary RA session */
         SVNTRACE(
             Err = svn_client_open_ra_session2(&ra_session, urla, path.IsUrl() ? NULL : svnPath, m_pctx, localpool, localpool),
@@ -2569,31 +2671,48 @@ bool SVN::GetRootAndHead(const CTSVNPath& path, CTSVNPath& url, svn_revnum_t& re
     return true;
 }
 
-bool SVN::GetLocks(const CTSVNPath& url, std::map<CString, SVNLock>* locks)
+bool SVN::GetLocks(const CTSVNPath& url, std::map<CString, SVNLock>* locks, svn_depth_t depth)
 {
     svn_ra_session_t* ra_session;
 
     SVNPool localpool(m_pool);
     Prepare();
 
-    apr_hash_t* hash = apr_hash_make(localpool);
+    apr_hash_t* hash = nullptr;
 
-    /* use subpool to create a temporary RA session */
     const char* svnPath = url.GetSVNApiPath(localpool);
     CHooks::Instance().PreConnect(CTSVNPathList(url));
-    SVNTRACE(
-        Err = svn_client_open_ra_session2(&ra_session, svnPath, NULL, m_pctx, localpool, localpool),
-        svnPath);
-    ClearCAPIAuthCacheOnError();
-    if (Err != NULL)
-        return false;
 
-    SVNTRACE(
-        Err = svn_ra_get_locks2(ra_session, &hash, "", svn_depth_infinity, localpool),
-        svnPath)
-    ClearCAPIAuthCacheOnError();
-    if (Err != NULL)
-        return false;
+    // try an already open session first
+    SVNRASessionPool::Session pooledSession = SVNRASessionPool::Instance().Checkout(svnPath, m_pctx->cancel_func, m_pctx->cancel_baton);
+    if (pooledSession)
+    {
+        svn_error_t* pooledErr = svn_ra_get_locks2(pooledSession.Get(), &hash, "", depth, localpool);
+        if (pooledErr)
+        {
+            svn_error_clear(pooledErr);
+            pooledSession.Discard();
+            hash = nullptr;
+        }
+    }
+
+    if (hash == nullptr)
+    {
+        /* use subpool to create a temporary RA session */
+        SVNTRACE(
+            Err = svn_client_open_ra_session2(&ra_session, svnPath, NULL, m_pctx, localpool, localpool),
+            svnPath);
+        ClearCAPIAuthCacheOnError();
+        if (Err != NULL)
+            return false;
+
+        SVNTRACE(
+            Err = svn_ra_get_locks2(ra_session, &hash, "", depth, localpool),
+            svnPath)
+        ClearCAPIAuthCacheOnError();
+        if (Err != NULL)
+            return false;
+    }
     apr_hash_index_t* hi;
     svn_lock_t*       val;
     const char*       key;
@@ -2722,6 +2841,36 @@ CString SVN::RevPropertyGet(const CString& sName, const CTSVNPath& URL, const SV
     return CUnicodeUtils::GetUnicode(propval->data);
 }
 
+bool SVN::PropertyGetRecursive(const std::string& name, const CTSVNPath& path, const SVNRev& pegrev, const SVNRev& revision, svn_depth_t depth, std::map<CTSVNPath, std::string>& values)
+{
+    values.clear();
+    Prepare();
+
+    SVNPool     subpool(m_pool);
+    apr_hash_t* props   = NULL;
+    const char* svnPath = path.GetSVNApiPath(subpool);
+    if (path.IsUrl())
+        CHooks::Instance().PreConnect(CTSVNPathList(path));
+    SVNTRACE(
+        Err = svn_client_propget5(&props, NULL, name.c_str(), svnPath, pegrev, revision, NULL, depth, NULL, m_pctx, subpool, subpool),
+        svnPath);
+    ClearCAPIAuthCacheOnError();
+    if (Err)
+        return false;
+
+    for (apr_hash_index_t* hi = apr_hash_first(subpool, props); hi; hi = apr_hash_next(hi))
+    {
+        const char*         key   = (const char*)apr_hash_this_key(hi);
+        const svn_string_t* value = (const svn_string_t*)apr_hash_this_val(hi);
+
+        CTSVNPath itemPath;
+        itemPath.SetFromSVN(key);
+        values[itemPath] = std::string(value->data, value->len);
+    }
+
+    return true;
+}
+
 CTSVNPath SVN::GetPristinePath(const CTSVNPath& wcPath)
 {
     svn_error_t* err;
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2019 - TortoiseSVN
+// Copyright (C) 2003-2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -818,12 +818,20 @@ public:
     CString RevPropertyGet(const CString& sName, const CTSVNPath& URL, const SVNRev& rev);
 
     /**
-     * Fetches all locks for \a url and the paths below.
+     * Reads the property \a name of \a path and of all items below it
+     * up to \a depth with a single request.
+     * \param values receives the property values, keyed by the paths
+     *               or URLs of the items that have the property
+     */
+    bool PropertyGetRecursive(const std::string& name, const CTSVNPath& path, const SVNRev& pegrev, const SVNRev& revision, svn_depth_t depth, std::map<CTSVNPath, std::string>& values);
+
+    /**
+     * Fetches all locks for \a url and the paths below, up to \a depth.
      * \remark The CString key in the map is the absolute path in
      * the repository of the lock. It is \b not an absolute URL, the
      * repository root part is stripped off!
      */
-    bool GetLocks(const CTSVNPath& url, std::map<CString, SVNLock> * locks);
+    bool GetLocks(const CTSVNPath& url, std::map<CString, SVNLock> * locks, svn_depth_t depth = svn_depth_infinity);
 
     /**
      * get a summary of the working copy revisions
@@ -1069,6 +1077,12 @@ protected:
                     const char *external_parent_url,
                     const char *external_target,
                     apr_pool_t *pool);
+    /// List() without svn_client_list4() and using a session from the
+    /// SVNRASessionPool. Returns false, if List() has to fall back to
+    /// svn_client_list4(), e.g. because peg and operative revision differ
+    /// (an unspecified peg revision counts as HEAD) or no session could
+    /// be opened.
+    bool ListWithPooledSession(const char* url, const SVNRev& revision, const SVNRev& pegrev, svn_depth_t depth, bool fetchlocks, apr_uint32_t dirents, apr_pool_t* pool);
     static svn_error_t* conflict_resolver(svn_wc_conflict_result_t **result,
                     const svn_wc_conflict_description2_t *description,
                     void *baton,
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2010-2015, 2019 - TortoiseSVN
+// Copyright (C) 2010-2015, 2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -25,7 +25,12 @@
 #include "SVNInfo.h"
 #include "SVNRev.h"
 #include "SVNProperties.h"
+#include "SVNLogHelper.h"
 #include "UnicodeUtils.h"
+#include "JobScheduler.h"
+#include "AsyncCall.h"
+#include <mutex>
+#include <list>
 
 #pragma warning(push)
 #include <apr_uri.h>
@@ -241,6 +246,118 @@ resolve_relative_external_url(const char **resolved_url,
 }
 
 
+// number of concurrent requests when resolving externals
+static const size_t RESOLVER_THREADS = 8;
+
+// svn:externals values of repository trees at fixed revisions.
+// Those never change, so every tree needs to be fetched only once.
+// Keeps the MAX_ENTRIES most recently used repository revisions.
+class CExternalsTreeCache
+{
+public:
+    typedef std::map<CTSVNPath, std::string> TValues;
+
+    static CExternalsTreeCache& Instance()
+    {
+        static CExternalsTreeCache instance;
+        return instance;
+    }
+
+    // fills \c values, if \c url or a parent of it has been cached for that revision
+    bool Lookup(const CString& root, svn_revnum_t revision, const CTSVNPath& url, TValues& values)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto entry = Find(TKey(root, revision));
+        if (entry == m_entries.end())
+            return false;
+
+        for (const auto& tree : entry->second)
+        {
+            if (!tree.first.IsEquivalentTo(url) && !tree.first.IsAncestorOf(url))
+                continue;
+
+            values.clear();
+            for (const auto& value : tree.second)
+            {
+                if (value.first.IsEquivalentTo(url) || url.IsAncestorOf(value.first))
+                    values.insert(value);
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    void Store(const CString& root, svn_revnum_t revision, const CTSVNPath& url, const TValues& values)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto entry = Find(TKey(root, revision));
+        if (entry == m_entries.end())
+        {
+            if (m_entries.size() >= MAX_ENTRIES)
+                m_entries.pop_back();
+
+            m_entries.emplace_front(TKey(root, revision), TTrees());
+            entry = m_entries.begin();
+        }
+
+        entry->second[url] = values;
+    }
+
+private:
+    enum { MAX_ENTRIES = 16 };
+
+    typedef std::pair<CString, svn_revnum_t> TKey;
+    typedef std::map<CTSVNPath, TValues> TTrees;
+    typedef std::list<std::pair<TKey, TTrees>> TEntries;
+
+    // moves the entry for \c key to the front, i.e. the least recently
+    // used one is always at the back
+    TEntries::iterator Find(const TKey& key)
+    {
+        auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&key](const TEntries::value_type& e) { return e.first == key; });
+        if (iter != m_entries.end())
+            m_entries.splice(m_entries.begin(), m_entries, iter);
+
+        return iter;
+    }
+
+    std::mutex                                          m_mutex;
+    TEntries                                            m_entries;
+};
+
+// executes all \c tasks in the background and waits for them to finish
+static bool RunConcurrently(const std::vector<std::function<void()>>& tasks, const SVNExternals::ProgressFunc& progress)
+{
+    if (tasks.empty())
+        return true;
+
+    volatile LONG done = 0;
+    volatile LONG cancelled = FALSE;
+    {
+        async::CJobScheduler scheduler(min(RESOLVER_THREADS, tasks.size()), 0, true);
+        for (const auto& task : tasks)
+        {
+            new async::CAsyncCall([&task, &done, &cancelled]()
+            {
+                if (!cancelled)
+                    task();
+                InterlockedIncrement(&done);
+            }, &scheduler);
+        }
+
+        while (!scheduler.WaitForEmptyQueueOrTimeout(100))
+        {
+            if (progress && !cancelled && !progress((size_t)done, tasks.size()))
+                InterlockedExchange(&cancelled, TRUE);
+        }
+    }
+
+    return !cancelled;
+}
+
 class sb
 {
 public:
@@ -265,9 +382,64 @@ bool SVNExternals::Add(const CTSVNPath& path, const std::string& extvalue, bool
 {
     SVN svn;
     CString pathurl = svn.GetURLFromPath(path);
-    CStringA dirurl = CUnicodeUtils::GetUTF8(pathurl);
     CStringA root = CUnicodeUtils::GetUTF8(svn.GetRepositoryRoot(path));
 
+    size_t first = size();
+    if (!Parse(path, pathurl, root, extvalue, headrev))
+        return false;
+
+    if (fetchrev)
+        FetchRevisions(first, ProgressFunc());
+
+    return true;
+}
+
+bool SVNExternals::AddTree(const CTSVNPath& path, const SVNRev& revision, bool fetchrev, const ProgressFunc& progress)
+{
+    SVN svn;
+    CString root = svn.GetRepositoryRoot(path);
+    if (root.IsEmpty())
+    {
+        m_sError = svn.GetLastErrorMessage();
+        return false;
+    }
+
+    // one request for the whole tree, unless we already know it
+
+    CExternalsTreeCache::TValues values;
+    bool isFixed = path.IsUrl() && revision.IsNumber();
+    if (!isFixed || !CExternalsTreeCache::Instance().Lookup(root, revision, path, values))
+    {
+        if (!svn.PropertyGetRecursive(SVN_PROP_EXTERNALS, path, revision, revision, svn_depth_infinity, values))
+        {
+            m_sError = svn.GetLastErrorMessage();
+            return false;
+        }
+
+        if (isFixed)
+            CExternalsTreeCache::Instance().Store(root, revision, path, values);
+    }
+
+    size_t first = size();
+    CStringA rootA = CUnicodeUtils::GetUTF8(root);
+    for (const auto& value : values)
+    {
+        CString pathurl = value.first.IsUrl()
+                        ? value.first.GetSVNPathString()
+                        : svn.GetURLFromPath(value.first);
+        Parse(value.first, pathurl, rootA, value.second, -1);
+    }
+
+    if (fetchrev)
+        return FetchRevisions(first, progress);
+
+    return true;
+}
+
+bool SVNExternals::Parse(const CTSVNPath& path, const CString& pathurl, const CStringA& root, const std::string& extvalue, svn_revnum_t headrev)
+{
+    CStringA dirurl = CUnicodeUtils::GetUTF8(pathurl);
+
     SVNExternal ext;
 
     SVNPool pool;
@@ -309,33 +481,6 @@ bool SVNExternals::Add(const CTSVNPath& path, const std::string& extvalue, bool
                 }
                 ext.url = CUnicodeUtils::GetUnicode(e->url);
                 ext.targetDir = CUnicodeUtils::GetUnicode(e->target_dir);
-                if (fetchrev)
-                {
-                    CTSVNPath p = path;
-                    p.AppendPathString(ext.targetDir);
-                    if (p.IsDirectory())
-                    {
-                        bool bswitched, bmodified, bsparse;
-                        svn_revnum_t maxrev, minrev;
-                        if (svn.GetWCRevisionStatus(p, false, minrev, maxrev, bswitched, bmodified, bsparse))
-                        {
-                            ext.revision.kind = svn_opt_revision_number;
-                            ext.revision.value.number = maxrev;
-                        }
-                    }
-                    else
-                    {
-                        // GetWCRevisionStatus() does not work for file externals, that's
-                        // why we use SVNInfo here to get the revision.
-                        SVNInfo svninfo;
-                        const SVNInfoData * info = svninfo.GetFirstFileInfo(p, SVNRev::REV_WC, SVNRev::REV_WC);
-                        if (info)
-                        {
-                            ext.revision.kind = svn_opt_revision_number;
-                            ext.revision.value.number = info->lastchangedrev;
-                        }
-                    }
-                }
 
                 const char * pFullUrl = NULL;
                 svn_error_t * error = resolve_relative_external_url(&pFullUrl, e, root, dirurl, pool, pool);
@@ -353,6 +498,129 @@ bool SVNExternals::Add(const CTSVNPath& path, const std::string& extvalue, bool
     return false;
 }
 
+bool SVNExternals::FetchRevisions(size_t first, const ProgressFunc& progress)
+{
+    // every external has its own working copy to scan
+    // -> do that concurrently
+
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = first; i < size(); ++i)
+    {
+        SVNExternal* ext = &at(i);
+        tasks.push_back([ext]()
+        {
+            CTSVNPath p = ext->path;
+            p.AppendPathString(ext->targetDir);
+            if (p.IsDirectory())
+            {
+                SVN svn;
+                bool bswitched, bmodified, bsparse;
+                svn_revnum_t maxrev, minrev;
+                if (svn.GetWCRevisionStatus(p, false, minrev, maxrev, bswitched, bmodified, bsparse))
+                {
+                    ext->revision.kind = svn_opt_revision_number;
+                    ext->revision.value.number = maxrev;
+                }
+            }
+            else
+            {
+                // GetWCRevisionStatus() does not work for file externals, that's
+                // why we use SVNInfo here to get the revision.
+                SVNInfo svninfo;
+                const SVNInfoData * info = svninfo.GetFirstFileInfo(p, SVNRev::REV_WC, SVNRev::REV_WC);
+                if (info)
+                {
+                    ext->revision.kind = svn_opt_revision_number;
+                    ext->revision.value.number = info->lastchangedrev;
+                }
+            }
+        });
+    }
+
+    return RunConcurrently(tasks, progress);
+}
+
+bool SVNExternals::FetchHeadRevisions(const std::vector<size_t>& indexes, HWND hParent, const ProgressFunc& progress)
+{
+    // the repository roots are stored in the working copy
+
+    SVN svn;
+    svn.SetPromptParentWindow(hParent);
+    for (size_t index : indexes)
+    {
+        SVNExternal& ext = at(index);
+        if (ext.root.IsEmpty())
+        {
+            CTSVNPath p = ext.path;
+            p.AppendPathString(ext.targetDir);
+            ext.root = svn.GetRepositoryRoot(p);
+        }
+    }
+
+    // externals often share their URLs, e.g. for the same library
+    // used in several places -> request each URL only once
+
+    std::map<CString, svn_revnum_t> headRevisions;
+    for (size_t index : indexes)
+    {
+        const SVNExternal& ext = at(index);
+        if (!ext.fullurl.IsEmpty())
+            headRevisions[ext.fullurl] = SVN_INVALID_REVNUM;
+    }
+
+    auto fetchHeadRevision = [hParent](std::pair<const CString, svn_revnum_t>* entry, bool suppressUI)
+    {
+        SVNLogHelper logHelper;
+        logHelper.SetPromptParentWindow(hParent);
+        logHelper.SuppressUI(suppressUI);
+        CTSVNPath url(entry->first);
+        auto youngestRev = logHelper.GetYoungestRev(url);
+        if (!youngestRev.IsValid())
+            entry->second = logHelper.GetHEADRevision(url, true);
+        else
+            entry->second = youngestRev;
+    };
+
+    // Concurrent requests must not prompt for credentials, or the user
+    // would get several dialogs at once. Those that fail get retried one
+    // by one with prompts enabled. Credentials entered for the first of
+    // them will then be used for all others of the same repository.
+
+    std::vector<std::function<void()>> tasks;
+    for (auto& headRevision : headRevisions)
+    {
+        auto* entry = &headRevision;
+        tasks.push_back([entry, fetchHeadRevision]() { fetchHeadRevision(entry, true); });
+    }
+
+    bool result = RunConcurrently(tasks, progress);
+
+    std::vector<std::pair<const CString, svn_revnum_t>*> failed;
+    for (auto& headRevision : headRevisions)
+    {
+        if (headRevision.second == SVN_INVALID_REVNUM)
+            failed.push_back(&headRevision);
+    }
+
+    for (size_t i = 0; result && (i < failed.size()); ++i)
+    {
+        if (progress && !progress(tasks.size() - failed.size() + i, tasks.size()))
+            result = false;
+        else
+            fetchHeadRevision(failed[i], false);
+    }
+
+    for (size_t index : indexes)
+    {
+        SVNExternal& ext = at(index);
+        auto iter = headRevisions.find(ext.fullurl);
+        if ((iter != headRevisions.end()) && (iter->second != SVN_INVALID_REVNUM))
+            ext.headrev = iter->second;
+    }
+
+    return result;
+}
+
 bool SVNExternals::TagExternals(bool bRemote, const CString& message, svn_revnum_t headrev, const CTSVNPath& origurl, const CTSVNPath& tagurl)
 {
     // create a map of paths and external properties
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2010, 2012-2013, 2015 - TortoiseSVN
+// Copyright (C) 2010, 2012-2013, 2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -22,6 +22,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
+
+class SVNRev;
 
 /**
  * Data class to hold information about one svn:external 'line', i.e.,
@@ -58,6 +61,12 @@ public:
 class SVNExternals : public std::vector<SVNExternal>
 {
 public:
+    /**
+     * Called while requests run in the background. Return false to cancel
+     * all requests that have not been started, yet.
+     */
+    typedef std::function<bool(size_t done, size_t total)> ProgressFunc;
+
     SVNExternals();
     virtual ~SVNExternals();
 
@@ -72,6 +81,29 @@ public:
      */
     bool Add(const CTSVNPath& path, const std::string& extvalue, bool fetchrev, svn_revnum_t headrev = -1);
 
+    /**
+     * Adds all svn:externals definitions of \c path and of all folders below it.
+     * The definitions are fetched with a single recursive request and all
+     * revisions are searched concurrently. Definitions of a repository tree at a
+     * fixed revision never change. They are cached per repository root and revision,
+     * for the most recently used revisions.
+     * \param path     a working copy path or an URL
+     * \param revision the revision of the tree, SVNRev::REV_WC for working copies
+     * \param fetchrev see Add()
+     * \param progress optional progress and cancellation callback
+     */
+    bool AddTree(const CTSVNPath& path, const SVNRev& revision, bool fetchrev, const ProgressFunc& progress = ProgressFunc());
+
+    /**
+     * Fills in the \c root and \c headrev members of the externals at \c indexes.
+     * Every external URL gets requested only once and different URLs are
+     * requested concurrently.
+     * \param hParent  parent window for authentication prompts
+     * \param progress optional progress and cancellation callback
+     * \return false if cancelled
+     */
+    bool FetchHeadRevisions(const std::vector<size_t>& indexes, HWND hParent, const ProgressFunc& progress = ProgressFunc());
+
     /**
      * changes the svn:externals property with the fixed revisions.
      * \param bRemote if false, the externals are changed in the working copy. If true
@@ -98,5 +130,11 @@ public:
     static CString GetFullExternalUrl(const CString& extUrl, const CString& root, const CString& dirUrl);
 
 private:
+    /// parses \c extvalue and appends the externals it defines
+    bool Parse(const CTSVNPath& path, const CString& pathurl, const CStringA& root, const std::string& extvalue, svn_revnum_t headrev);
+
+    /// searches the revisions of the working copies of all externals from index \c first on
+    bool FetchRevisions(size_t first, const ProgressFunc& progress);
+
     CString                             m_sError;
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 ﻿// TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2010-2015, 2017, 2019 - TortoiseSVN
+// Copyright (C) 2010-2015, 2017, 2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -25,11 +25,14 @@
 #include "SVNAdminDir.h"
 #include "SVNConfig.h"
 #include "StringUtils.h"
+#include "JobScheduler.h"
+#include "Future.h"
 
 #pragma warning(push)
 #include "svn_dso.h"
 #include "svn_utf.h"
 #include "svn_dirent_uri.h"
+#include "svn_diff.h"
 #pragma warning(pop)
 
 
@@ -64,37 +67,29 @@ SVNPatch::~SVNPatch()
 
 void SVNPatch::notify( void *baton, const svn_wc_notify_t *notify, apr_pool_t * /*pool*/ )
 {
-    SVNPatch * pThis = (SVNPatch*)baton;
-    if (pThis && notify)
+    PatchBaton * pBaton = (PatchBaton*)baton;
+    if (pBaton && notify)
     {
         PathRejects * pInfo = NULL;
-        if (!pThis->m_filePaths.empty())
-            pInfo = &pThis->m_filePaths[pThis->m_filePaths.size()-1];
+        if (!pBaton->filePaths.empty())
+            pInfo = &pBaton->filePaths[pBaton->filePaths.size()-1];
         if ((notify->action == svn_wc_notify_skip)||(notify->action == svn_wc_notify_patch_rejected_hunk))
         {
             if (pInfo)
             {
                 pInfo->rejects++;
-                pThis->m_nRejected++;
+                pBaton->nRejected++;
             }
         }
-        if (notify->action != svn_wc_notify_add)
-        {
-            CString abspath = CUnicodeUtils::GetUnicode(notify->path);
-            if (abspath.Left(pThis->m_targetpath.GetLength()).Compare(pThis->m_targetpath) == 0)
-                pThis->m_testPath = abspath.Mid(pThis->m_targetpath.GetLength());
-            else
-                pThis->m_testPath = abspath;
-        }
         if (pInfo)
         {
             pInfo->content = pInfo->content || (notify->content_state != svn_wc_notify_state_unknown);
             pInfo->props   = pInfo->props   || (notify->prop_state    != svn_wc_notify_state_unknown);
         }
 
-        if (((notify->action == svn_wc_notify_patch)||(notify->action == svn_wc_notify_add))&&(pThis->m_pProgDlg))
+        if (((notify->action == svn_wc_notify_patch)||(notify->action == svn_wc_notify_add))&&(pBaton->bShowProgress)&&(pBaton->pThis->m_pProgDlg))
         {
-            pThis->m_pProgDlg->FormatPathLine(2, IDS_PATCH_PATHINGFILE, (LPCTSTR)CUnicodeUtils::GetUnicode(notify->path));
+            pBaton->pThis->m_pProgDlg->FormatPathLine(2, IDS_PATCH_PATHINGFILE, (LPCTSTR)CUnicodeUtils::GetUnicode(notify->path));
         }
     }
 }
@@ -104,12 +99,12 @@ svn_error_t * SVNPatch::patch_func( void *baton, svn_boolean_t * filtered, const
                                     const char *reject_abspath,
                                     apr_pool_t * /*scratch_pool*/ )
 {
-    SVNPatch * pThis = (SVNPatch*)baton;
-    if (pThis)
+    PatchBaton * pBaton = (PatchBaton*)baton;
+    if (pBaton)
     {
         CString abspath = CUnicodeUtils::GetUnicode(canon_path_from_patchfile);
         PathRejects pr;
-        pr.path = PathIsRelative(abspath) ? abspath : pThis->Strip(abspath);
+        pr.path = PathIsRelative(abspath) ? abspath : pBaton->pThis->Strip(abspath);
         pr.rejects = 0;
         pr.resultPath = CUnicodeUtils::GetUnicode(patch_abspath);
         pr.resultPath.Replace('/', '\\');
@@ -119,7 +114,7 @@ svn_error_t * SVNPatch::patch_func( void *baton, svn_boolean_t * filtered, const
         pr.props = false;
         // only add this entry if it hasn't been added already
         bool bExists = false;
-        for (auto it = pThis->m_filePaths.rbegin(); it != pThis->m_filePaths.rend(); ++it)
+        for (auto it = pBaton->filePaths.rbegin(); it != pBaton->filePaths.rend(); ++it)
         {
             if (it->path.Compare(pr.path) == 0)
             {
@@ -128,12 +123,10 @@ svn_error_t * SVNPatch::patch_func( void *baton, svn_boolean_t * filtered, const
             }
         }
         if (!bExists)
-            pThis->m_filePaths.push_back(pr);
-        pThis->m_nRejected = 0;
+            pBaton->filePaths.push_back(pr);
         *filtered = false;
-
-        CTempFiles::Instance().AddFileToRemove(pr.resultPath);
-        CTempFiles::Instance().AddFileToRemove(pr.rejectsPath);
+        // the temp files are registered in AddResults(), CTempFiles
+        // must only be used by the UI thread
     }
     return NULL;
 }
@@ -168,15 +161,12 @@ int SVNPatch::Init( const CString& patchfile, const CString& targetpath, CProgre
     m_errorStr.Empty();
     m_patchfile = patchfile;
     m_targetpath = targetpath;
-    m_testPath.Empty();
 
     m_patchfile.Replace('\\', '/');
     m_targetpath.Replace('\\', '/');
 
     apr_pool_create_ex(&scratchpool, m_pool, abort_on_pool_failure, NULL);
     svn_error_clear(svn_client_create_context2(&ctx, SVNConfig::Instance().GetConfig(m_pool), scratchpool));
-    ctx->notify_func2 = notify;
-    ctx->notify_baton2 = this;
 
     if (pPprogDlg)
     {
@@ -193,36 +183,32 @@ int SVNPatch::Init( const CString& patchfile, const CString& targetpath, CProgre
     CTSVNPath tsvnpatchfile = CTSVNPath(m_patchfile);
     CTSVNPath tsvntargetpath = CTSVNPath(m_targetpath);
 
-    err = svn_client_patch(tsvnpatchfile.GetSVNApiPath(scratchpool),     // patch_abspath
-                           tsvntargetpath.GetSVNApiPath(scratchpool),    // local_abspath
-                           true,                                    // dry_run
-                           m_nStrip,                                // strip_count
-                           false,                                   // reverse
-                           true,                                    // ignore_whitespace
-                           false,                                   // remove_tempfiles
-                           patch_func,                              // patch_func
-                           this,                                    // patch_baton
-                           ctx,                                     // client context
-                           scratchpool);
-    if (m_filePaths.empty() && (m_nStrip == 0))
-    {
-        // in case no paths matched, try again with one strip.
-        // because if the patch paths are absolute, only stripping
-        // the drive letter will get the svn_client_patch to call
-        // the patch_func and we then get the data we need to later
-        // adjust the strip value correctly.
-        m_nStrip++;
-        err = svn_client_patch(tsvnpatchfile.GetSVNApiPath(scratchpool),     // patch_abspath
-                               tsvntargetpath.GetSVNApiPath(scratchpool),    // local_abspath
-                               true,                                    // dry_run
-                               m_nStrip,                                // strip_count
-                               false,                                   // reverse
-                               true,                                    // ignore_whitespace
-                               false,                                   // remove_tempfiles
-                               patch_func,                              // patch_func
-                               this,                                    // patch_baton
-                               ctx,                                     // client context
-                               scratchpool);
+    // parse the patch file only once and find the strip count from the
+    // paths in it instead of trying different ones with dry runs
+    err = IndexPatchFile(scratchpool);
+    if (err == NULL)
+    {
+        m_nStrip = FindStripCount();
+        if ((m_patchIndex.size() > (size_t)MIN_FILES_PER_JOB) && (m_patchIndex.back().length > 0))
+            err = DryRunParallel();
+        else
+        {
+            PatchBaton baton = { this, std::vector<PathRejects>(), 0, true };
+            ctx->notify_func2 = notify;
+            ctx->notify_baton2 = &baton;
+            err = svn_client_patch(tsvnpatchfile.GetSVNApiPath(scratchpool),     // patch_abspath
+                                   tsvntargetpath.GetSVNApiPath(scratchpool),    // local_abspath
+                                   true,                                    // dry_run
+                                   m_nStrip,                                // strip_count
+                                   false,                                   // reverse
+                                   true,                                    // ignore_whitespace
+                                   false,                                   // remove_tempfiles
+                                   patch_func,                              // patch_func
+                                   &baton,                                  // patch_baton
+                                   ctx,                                     // client context
+                                   scratchpool);
+            AddResults(baton);
+        }
     }
 
     m_pProgDlg = NULL;
@@ -237,68 +223,189 @@ int SVNPatch::Init( const CString& patchfile, const CString& targetpath, CProgre
         svn_error_clear(err);
         return 0;
     }
+    svn_error_clear(err);
+
+    return (int)m_filePaths.size();
+}
+
+void SVNPatch::GetSectionKeys(const PatchEntry& entry, CString keys[2])
+{
+    keys[0] = entry.path;
+    keys[0].MakeLower();
+    // deleted files have no new path
+    if ((entry.newPath.CompareNoCase(entry.path) != 0) && (entry.newPath.Compare(L"/dev/null") != 0))
+    {
+        keys[1] = entry.newPath;
+        keys[1].MakeLower();
+    }
+}
+
+svn_error_t * SVNPatch::DryRunParallel()
+{
+    // the last section of every file, by the old and the new path
+    std::map<CString, size_t> lastSections;
+    for (size_t i = 0; i < m_patchIndex.size(); ++i)
+    {
+        CString keys[2];
+        GetSectionKeys(m_patchIndex[i], keys);
+        for (const CString& key : keys)
+        {
+            if (!key.IsEmpty())
+                lastSections[key] = i;
+        }
+    }
 
-    if ((m_nRejected > ((int)m_filePaths.size() / 3)) && !m_testPath.IsEmpty())
+    // split the patch into a few ranges per thread, so that the threads
+    // stay busy even if some files take much longer than others
+    const size_t threadCount = async::CJobScheduler::GetHWThreadCount();
+    const size_t filesPerJob = std::max(m_patchIndex.size() / (threadCount * JOBS_PER_THREAD) + 1, (size_t)MIN_FILES_PER_JOB);
+    volatile LONG firstFailed = MAXLONG;
+    std::vector<std::unique_ptr<DryRunJob>> jobs;
+    for (size_t first = 0; first < m_patchIndex.size(); )
     {
-        auto startStrip = m_nStrip;
-        for (m_nStrip = 0; m_nStrip < STRIP_LIMIT; ++m_nStrip)
+        size_t last = std::min(first + filesPerJob, m_patchIndex.size());
+        for (size_t i = first; i < last; ++i)
         {
-            int nExisting = 0;
-            for (std::vector<PathRejects>::iterator it = m_filePaths.begin(); it != m_filePaths.end(); ++it)
-            {
-                CString p = Strip(it->path);
-                if (p.IsEmpty())
-                {
-                    m_nStrip = STRIP_LIMIT;
-                    break;
-                }
-                else if (PathFileExists(m_targetpath + L"\\" + p))
-                    ++nExisting;
-            }
-            if (nExisting > int(m_filePaths.size()-m_nRejected))
+            CString keys[2];
+            GetSectionKeys(m_patchIndex[i], keys);
+            for (const CString& key : keys)
             {
-                m_nStrip += startStrip;
-                break;
+                if (!key.IsEmpty())
+                    last = std::max(last, lastSections[key] + 1);
             }
         }
+
+        std::unique_ptr<DryRunJob> job(new DryRunJob());
+        job->first = first;
+        job->last = last;
+        job->patchfile = CTempFiles::Instance().GetTempFilePath(true).GetWinPathString();
+        job->patchfile.Replace('\\', '/');
+        job->baton.pThis = this;
+        job->baton.nRejected = 0;
+        job->baton.bShowProgress = false;
+        job->index = (LONG)jobs.size();
+        job->pFirstFailed = &firstFailed;
+        jobs.push_back(std::move(job));
+        first = last;
     }
 
-    if (m_nStrip >= STRIP_LIMIT)
+    typedef async::CFuture<svn_error_t *> TFuture;
+    async::CJobScheduler scheduler(0, threadCount);
+    std::vector<std::unique_ptr<TFuture>> futures;
+    for (size_t i = 0; i < jobs.size(); ++i)
+        futures.push_back(std::unique_ptr<TFuture>(new TFuture(this, &SVNPatch::DryRunRange, jobs[i].get(), &scheduler)));
+
+    // collect the results in the order of the patch file,
+    // up to and including the first range that failed
+    svn_error_t * err = NULL;
+    bool failed = false;
+    for (size_t i = 0; i < jobs.size(); ++i)
     {
-        m_nStrip = 0;
+        svn_error_t * jobErr = futures[i]->GetResult();
+        if (failed)
+        {
+            // cancelled or superseded by the earlier error
+            svn_error_clear(jobErr);
+            continue;
+        }
+
+        PatchBaton& baton = jobs[i]->baton;
+        if (m_pProgDlg)
+        {
+            for (auto it = baton.filePaths.cbegin(); it != baton.filePaths.cend(); ++it)
+                m_pProgDlg->FormatPathLine(2, IDS_PATCH_PATHINGFILE, (LPCTSTR)it->path);
+        }
+        AddResults(baton);
+
+        // a 'path not found' is expected during a dry run, see Init().
+        // It ends the dry run nonetheless.
+        if (jobErr)
+        {
+            failed = true;
+            if (jobErr->apr_err != SVN_ERR_WC_PATH_NOT_FOUND)
+                err = jobErr;
+            else
+                svn_error_clear(jobErr);
+        }
     }
-    else if (m_nStrip > 0)
-    {
-        apr_pool_create_ex(&scratchpool, m_pool, abort_on_pool_failure, NULL);
-        svn_error_clear(svn_client_create_context2(&ctx, SVNConfig::Instance().GetConfig(m_pool), scratchpool));
-        ctx->notify_func2 = notify;
-        ctx->notify_baton2 = this;
+    return err;
+}
 
-        m_filePaths.clear();
-        m_nRejected = 0;
-        err = svn_client_patch(tsvnpatchfile.GetSVNApiPath(scratchpool),     // patch_abspath
-                               tsvntargetpath.GetSVNApiPath(scratchpool),    // local_abspath
-                               true,                                    // dry_run
-                               m_nStrip,                                // strip_count
-                               false,                                   // reverse
-                               true,                                    // ignore_whitespace
-                               false,                                   // remove_tempfiles
-                               patch_func,                              // patch_func
-                               this,                                    // patch_baton
-                               ctx,                                     // client context
-                               scratchpool);
+svn_error_t * SVNPatch::DryRunCancel(void * baton)
+{
+    DryRunJob * job = (DryRunJob*)baton;
+    if (*job->pFirstFailed < job->index)
+        return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    return NULL;
+}
 
-        apr_pool_destroy(scratchpool);
+svn_error_t * SVNPatch::DryRunRange(DryRunJob * job)
+{
+    // the results of ranges behind a failed one get dropped anyway
+    if (*job->pFirstFailed < job->index)
+        return NULL;
 
-        if (err)
+    // the pools are not thread-safe, use a top-level one for this thread
+    apr_pool_t * pool = NULL;
+    apr_pool_create_ex(&pool, NULL, abort_on_pool_failure, NULL);
+
+    std::string text;
+    for (size_t i = job->first; i < job->last; ++i)
+        text.append(m_patchText, m_patchIndex[i].offset, m_patchIndex[i].length);
+
+    CTSVNPath patchfile = CTSVNPath(job->patchfile);
+    svn_error_t * err = svn_io_file_create_bytes(patchfile.GetSVNApiPath(pool), text.c_str(), text.size(), pool);
+    if (err == NULL)
+    {
+        svn_client_ctx_t * ctx = NULL;
+        err = svn_client_create_context2(&ctx, SVNConfig::Instance().GetConfig(pool), pool);
+        if (err == NULL)
         {
-            m_errorStr = GetErrorMessage(err);
-            m_filePaths.clear();
-            svn_error_clear(err);
+            ctx->notify_func2 = notify;
+            ctx->notify_baton2 = &job->baton;
+            ctx->cancel_func = DryRunCancel;
+            ctx->cancel_baton = job;
+            err = svn_client_patch(patchfile.GetSVNApiPath(pool),               // patch_abspath
+                                   CTSVNPath(m_targetpath).GetSVNApiPath(pool), // local_abspath
+                                   true,                                    // dry_run
+                                   m_nStrip,                                // strip_count
+                                   false,                                   // reverse
+                                   true,                                    // ignore_whitespace
+                                   false,                                   // remove_tempfiles
+                                   patch_func,                              // patch_func
+                                   &job->baton,                             // patch_baton
+                                   ctx,                                     // client context
+                                   pool);
         }
     }
 
-    return (int)m_filePaths.size();
+    apr_pool_destroy(pool);
+
+    // stop the ranges behind this one
+    if (err)
+    {
+        LONG current = *job->pFirstFailed;
+        while (job->index < current)
+        {
+            LONG previous = InterlockedCompareExchange(job->pFirstFailed, job->index, current);
+            if (previous == current)
+                break;
+            current = previous;
+        }
+    }
+    return err;
+}
+
+void SVNPatch::AddResults(PatchBaton& baton)
+{
+    for (auto it = baton.filePaths.cbegin(); it != baton.filePaths.cend(); ++it)
+    {
+        CTempFiles::Instance().AddFileToRemove(it->resultPath);
+        CTempFiles::Instance().AddFileToRemove(it->rejectsPath);
+        m_filePaths.push_back(*it);
+    }
+    m_nRejected += baton.nRejected;
+    baton.filePaths.clear();
 }
 
 bool SVNPatch::PatchPath( const CString& path )
@@ -318,9 +425,31 @@ bool SVNPatch::PatchPath( const CString& path )
     apr_pool_create_ex(&scratchpool, m_pool, abort_on_pool_failure, NULL);
     svn_error_clear(svn_client_create_context2(&ctx, SVNConfig::Instance().GetConfig(m_pool), scratchpool));
 
+    // apply the diffs of this file only instead of parsing the whole patch file again
+    CString patchfile = m_patchfile;
+    std::vector<const PatchEntry *> entries;
+    if (FindPatchEntries(m_filetopatch, entries))
+    {
+        std::string sections;
+        for (const PatchEntry * pEntry : entries)
+            sections.append(m_patchText, pEntry->offset, pEntry->length);
+
+        CTSVNPath filepatch = CTempFiles::Instance().GetTempFilePath(true);
+        err = svn_io_file_create_bytes(filepatch.GetSVNApiPath(scratchpool),
+                                       sections.c_str(), sections.size(),
+                                       scratchpool);
+        if (err)
+            svn_error_clear(err);
+        else
+        {
+            patchfile = filepatch.GetWinPathString();
+            patchfile.Replace('\\', '/');
+        }
+    }
+
     const char *patch_abspath = nullptr;
     err                       = svn_uri_canonicalize_safe(&patch_abspath, nullptr,
-                                    CUnicodeUtils::GetUTF8(m_patchfile),
+                                    CUnicodeUtils::GetUTF8(patchfile),
                                     scratchpool, scratchpool);
     if (err)
     {
@@ -492,10 +621,255 @@ CString SVNPatch::GetStrippedPath( int nIndex ) const
     return L"";
 }
 
-CString SVNPatch::Strip( const CString& filename ) const
+svn_error_t * SVNPatch::IndexPatchFile(apr_pool_t * scratchpool)
+{
+    CTSVNPath tsvnpatchfile = CTSVNPath(m_patchfile);
+    const char * patch_abspath = tsvnpatchfile.GetSVNApiPath(scratchpool);
+
+    svn_stringbuf_t * patchtext = NULL;
+    SVN_ERR(svn_stringbuf_from_file2(&patchtext, patch_abspath, scratchpool));
+    if ((m_patchText.size() == patchtext->len) && (memcmp(m_patchText.c_str(), patchtext->data, patchtext->len) == 0))
+        return SVN_NO_ERROR;
+
+    m_patchIndex.clear();
+    m_patchText.clear();
+
+    svn_patch_file_t * patchfile = NULL;
+    SVN_ERR(svn_diff_open_patch_file(&patchfile, patch_abspath, scratchpool));
+
+    apr_pool_t * iterpool = NULL;
+    apr_pool_create_ex(&iterpool, scratchpool, abort_on_pool_failure, NULL);
+    svn_error_t * err = NULL;
+    for (;;)
+    {
+        apr_pool_clear(iterpool);
+        svn_patch_t * patch = NULL;
+        err = svn_diff_parse_next_patch(&patch, patchfile, false, true, iterpool, iterpool);
+        if (err || (patch == NULL))
+            break;
+
+        PatchEntry entry;
+        entry.newPath = CUnicodeUtils::GetUnicode(patch->new_filename ? patch->new_filename : "");
+        entry.path = CUnicodeUtils::GetUnicode(patch->old_filename ? patch->old_filename : "");
+        if (entry.path.IsEmpty() || (entry.path.Compare(L"/dev/null") == 0))
+            entry.path = entry.newPath;
+        entry.offset = 0;
+        entry.length = 0;
+        m_patchIndex.push_back(entry);
+    }
+    apr_pool_destroy(iterpool);
+    err = svn_error_compose_create(err, svn_diff_close_patch_file(patchfile, scratchpool));
+    if (err)
+    {
+        m_patchIndex.clear();
+        return err;
+    }
+    m_patchText.assign(patchtext->data, patchtext->len);
+
+    // only use the diffs of the single files if they match what svn found
+    std::vector<std::pair<size_t, size_t>> ranges;
+    SplitPatchText(m_patchText, ranges);
+    if (ranges.size() == m_patchIndex.size())
+    {
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            m_patchIndex[i].offset = ranges[i].first;
+            m_patchIndex[i].length = ranges[i].second - ranges[i].first;
+        }
+    }
+    return SVN_NO_ERROR;
+}
+
+int SVNPatch::FindStripCount() const
+{
+    int nBestStrip = 0;
+    int nBestMatches = 0;
+    bool bAbsolutePaths = false;
+    for (int nStrip = 0; nStrip < STRIP_LIMIT; ++nStrip)
+    {
+        int nMatches = 0;
+        bool bStrippedAll = false;
+        for (const auto& entry : m_patchIndex)
+        {
+            if (!PathIsRelative(entry.path))
+                bAbsolutePaths = true;
+            CString p = Strip(entry.path, nStrip);
+            if (p.IsEmpty())
+            {
+                bStrippedAll = true;
+                break;
+            }
+            else if (PathFileExists(m_targetpath + L"\\" + p))
+                ++nMatches;
+        }
+        if (bStrippedAll)
+            break;
+        if (nMatches > nBestMatches)
+        {
+            nBestMatches = nMatches;
+            nBestStrip = nStrip;
+        }
+    }
+
+    // absolute paths must at least lose their drive letter
+    if ((nBestMatches == 0) && bAbsolutePaths)
+        return 1;
+    return nBestStrip;
+}
+
+bool SVNPatch::IsPatchEntryFor(const PatchEntry& entry, const CString& relpath) const
+{
+    return (relpath.CompareNoCase(entry.path) == 0) || (relpath.CompareNoCase(Strip(entry.path)) == 0) ||
+           (relpath.CompareNoCase(entry.newPath) == 0) || (relpath.CompareNoCase(Strip(entry.newPath)) == 0);
+}
+
+bool SVNPatch::FindPatchEntries(const CString& relpath, std::vector<const PatchEntry *>& entries) const
+{
+    entries.clear();
+
+    // the keys of all sections of the file
+    std::vector<CString> fileKeys;
+    for (const auto& entry : m_patchIndex)
+    {
+        if (entry.length == 0)
+            return false;
+        if (!IsPatchEntryFor(entry, relpath))
+            continue;
+
+        CString keys[2];
+        GetSectionKeys(entry, keys);
+        for (const CString& key : keys)
+        {
+            if (!key.IsEmpty() && (std::find(fileKeys.begin(), fileKeys.end(), key) == fileKeys.end()))
+                fileKeys.push_back(key);
+        }
+    }
+
+    for (const auto& entry : m_patchIndex)
+    {
+        CString keys[2];
+        GetSectionKeys(entry, keys);
+        bool bInGroup = false;
+        for (const CString& key : keys)
+        {
+            if (!key.IsEmpty() && (std::find(fileKeys.begin(), fileKeys.end(), key) != fileKeys.end()))
+                bInGroup = true;
+        }
+        if (!bInGroup)
+            continue;
+
+        // e.g. a file got moved and the patch changes its source as well:
+        // only the whole patch applies those sections correctly
+        if (!IsPatchEntryFor(entry, relpath))
+        {
+            entries.clear();
+            return false;
+        }
+        entries.push_back(&entry);
+    }
+
+    return !entries.empty();
+}
+
+/// Parses one side of a hunk header like "@@ -1,5 +1,6 @@",
+/// returns the position after it.
+static const char * ParseHunkRange(const char * range, int& length)
+{
+    char * end = NULL;
+    strtol(range, &end, 10);
+    length = 1;
+    if (*end == ',')
+        length = (int)strtol(end + 1, &end, 10);
+    return end;
+}
+
+void SVNPatch::SplitPatchText(const std::string& text, std::vector<std::pair<size_t, size_t>>& ranges)
+{
+    ranges.clear();
+
+    size_t start = std::string::npos;   // start of the current file's diff
+    bool bHasHeader = false;            // current range contains a diff svn can parse
+    bool bHasUnidiff = false;           // current range contains "---" and "+++" lines
+    int nOriginalLines = 0;             // lines left in the current hunk
+    int nModifiedLines = 0;
+
+    auto startRange = [&](size_t pos)
+    {
+        if ((start != std::string::npos) && bHasHeader)
+            ranges.push_back(std::make_pair(start, pos));
+        start = pos;
+        bHasHeader = false;
+        bHasUnidiff = false;
+    };
+
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t eol = text.find('\n', pos);
+        size_t next = (eol == std::string::npos) ? text.size() : eol + 1;
+        const char * line = text.c_str() + pos;
+
+        if ((nOriginalLines > 0) || (nModifiedLines > 0))
+        {
+            // an empty line is a context line whose whitespace got lost
+            char c = ((line[0] == '\r') || (line[0] == '\n')) ? ' ' : line[0];
+            if ((c == ' ') || (c == '-') || (c == '+'))
+            {
+                if (c != '+')
+                    --nOriginalLines;
+                if (c != '-')
+                    --nModifiedLines;
+                pos = next;
+                continue;
+            }
+            if (c == '\\')
+            {
+                // "\ No newline at end of file"
+                pos = next;
+                continue;
+            }
+            nOriginalLines = nModifiedLines = 0;
+        }
+
+        if (strncmp(line, "Index: ", 7) == 0)
+            startRange(pos);
+        else if (strncmp(line, "diff --git ", 11) == 0)
+        {
+            // "svn diff --git" writes an "Index:" line first
+            if ((start == std::string::npos) || bHasHeader)
+                startRange(pos);
+            bHasHeader = true;
+        }
+        else if ((strncmp(line, "--- ", 4) == 0) && (next < text.size()) && (strncmp(text.c_str() + next, "+++ ", 4) == 0))
+        {
+            if ((start == std::string::npos) || bHasUnidiff)
+                startRange(pos);
+            bHasHeader = true;
+            bHasUnidiff = true;
+        }
+        else if (strncmp(line, "Property changes on: ", 21) == 0)
+        {
+            if (start == std::string::npos)
+                startRange(pos);
+            bHasHeader = true;
+        }
+        else if ((strncmp(line, "@@ -", 4) == 0) || (strncmp(line, "## -", 4) == 0))
+        {
+            const char * modified = ParseHunkRange(line + 4, nOriginalLines);
+            if (strncmp(modified, " +", 2) == 0)
+                ParseHunkRange(modified + 2, nModifiedLines);
+            else
+                nOriginalLines = nModifiedLines = 0;
+        }
+        pos = next;
+    }
+    startRange(text.size());
+}
+
+CString SVNPatch::Strip( const CString& filename, int nStrip )
 {
     CString s = filename;
-    if ( m_nStrip>0 )
+    if ( nStrip>0 )
     {
         // Remove windows drive letter "c:"
         if ( s.GetLength()>2 && s[1]==':')
@@ -503,7 +877,7 @@ CString SVNPatch::Strip( const CString& filename ) const
             s = s.Mid(2);
         }
 
-        for (int nStrip=1;nStrip<=m_nStrip;nStrip++)
+        for (int i=1;i<=nStrip;i++)
         {
             // "/home/ts/my-working-copy/dir/file.txt"
             //  "home/ts/my-working-copy/dir/file.txt"
@@ -1,6 +1,6 @@
 // TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2010-2012, 2014-2015 - TortoiseSVN
+// Copyright (C) 2010-2012, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -33,7 +33,8 @@ public:
     ~SVNPatch();
 
     /**
-     * Does a dry run of the patching, fills in all the arrays.
+     * Parses the patch file (unless it has already been parsed), determines the
+     * strip count and does a dry run of the patching, fills in all the arrays.
      * Call this function first.
      * The progress dialog is used to show progress info if the initialization takes a long time.
      * \return the number of files affected by the patchfile, 0 in case of an error
@@ -57,6 +58,7 @@ public:
 
     /**
      * Applies the patch for the given \c path, including property changes if necessary.
+     * Only the part of the patch file for that path gets parsed again.
      */
     bool                    PatchPath(const CString& path);
 
@@ -108,12 +110,45 @@ public:
     bool                    RemoveFile(const CString& path);
 
 private:
+    /// the files of the patch in the order of the patch file
+    struct PatchEntry
+    {
+        CString     path;       ///< path of the file to patch, as in the patch file
+        CString     newPath;    ///< differs from path if the file gets added, moved or copied
+        size_t      offset;     ///< start of the diff of this file in m_patchText
+        size_t      length;     ///< 0 if the patch file could not be split
+    };
+
     int                     CountMatches(const CString& path) const;
     int                     CountDirMatches(const CString& path) const;
     /**
      * Strips the filename by removing m_nStrip prefixes.
      */
-    CString                 Strip(const CString& filename) const;
+    CString                 Strip(const CString& filename) const { return Strip(filename, m_nStrip); }
+    static CString          Strip(const CString& filename, int nStrip);
+
+    /**
+     * Parses m_patchfile into m_patchIndex unless it has the same content as before.
+     */
+    svn_error_t *           IndexPatchFile(apr_pool_t * scratchpool);
+    /**
+     * Returns the strip count for which most files of the patch exist in m_targetpath.
+     */
+    int                     FindStripCount() const;
+    /**
+     * Fills \a entries with all sections of the file, in the order of the
+     * patch file. The sections are grouped by GetSectionKeys(), like for the
+     * dry run. Returns false if there are none, if the patch file could not be
+     * split into the diffs of the single files or if the group also contains
+     * sections of other files.
+     */
+    bool                    FindPatchEntries(const CString& relpath, std::vector<const PatchEntry *>& entries) const;
+    bool                    IsPatchEntryFor(const PatchEntry& entry, const CString& relpath) const;
+    /**
+     * Finds the diffs of the single files in a patch file, i.e. the ranges
+     * which svn_diff_parse_next_patch() returns a patch for.
+     */
+    static void             SplitPatchText(const std::string& text, std::vector<std::pair<size_t, size_t>>& ranges);
     CString                 GetErrorMessage(svn_error_t * Err) const;
     CString                 GetErrorMessageForNode(svn_error_t* Err) const;
 
@@ -140,13 +175,63 @@ private:
         bool        content;
         bool        props;
     };
+    /// baton of patch_func() and notify(), one per svn_client_patch() call
+    struct PatchBaton
+    {
+        SVNPatch *                  pThis;
+        std::vector<PathRejects>    filePaths;
+        int                         nRejected;
+        bool                        bShowProgress;  ///< false for the worker threads
+    };
+    /// a range of m_patchIndex which gets dry run by a single job
+    struct DryRunJob
+    {
+        size_t      first;
+        size_t      last;       ///< one past the last entry
+        CString     patchfile;  ///< temp file for the diffs of the range
+        PatchBaton  baton;
+        LONG        index;      ///< position of the range in the patch
+        volatile LONG * pFirstFailed;   ///< lowest index of a failed range, shared by all jobs
+    };
+
+    enum
+    {
+        MIN_FILES_PER_JOB = 32,
+        JOBS_PER_THREAD = 4
+    };
+
+    /**
+     * Does the dry run of all files concurrently, in ranges of the patch file.
+     * All diffs of a file which appears more than once in the patch are put
+     * into the same range, so they get applied in order.
+     * The results are reported and stored in the order of the patch file.
+     * Like a single svn_client_patch() call, the dry run ends with the first
+     * error in patch order: the ranges behind it get cancelled and their
+     * results are dropped.
+     */
+    svn_error_t *           DryRunParallel();
+    /**
+     * Returns the lower case paths by which the sections of a file are grouped.
+     * The second key is empty if the file is not added, moved or copied.
+     */
+    static void             GetSectionKeys(const PatchEntry& entry, CString keys[2]);
+    /**
+     * Runs on a worker thread. Must not touch anything but \c job and the
+     * read-only members.
+     */
+    svn_error_t *           DryRunRange(DryRunJob * job);
+    /// cancels a range behind one that failed
+    static svn_error_t *    DryRunCancel(void * baton);
+    void                    AddResults(PatchBaton& baton);
+
     std::vector<PathRejects> m_filePaths;
+    std::vector<PatchEntry> m_patchIndex;
+    std::string             m_patchText;
     int                     m_nStrip;
     bool                    m_bSuccessfullyPatched;
     int                     m_nRejected;
     CString                 m_patchfile;
     CString                 m_targetpath;
-    CString                 m_testPath;
     CString                 m_filetopatch;
     CString                 m_errorStr;
     CProgressDlg *          m_pProgDlg;
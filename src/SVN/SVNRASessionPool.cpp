@@ -0,0 +1,325 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "SVNRASessionPool.h"
+#include "SVNConfig.h"
+#include "SVNHelpers.h"
+#include "SVNTrace.h"
+#pragma warning(push)
+#include "svn_client.h"
+#include "svn_pools.h"
+#pragma warning(pop)
+
+SVNRASessionPool::Entry::Entry()
+    : pool(nullptr)
+    , ctx(nullptr)
+    , session(nullptr)
+    , prompt(true)
+    , lastUsed(0)
+    , busy(true)
+    , cancelFunc(nullptr)
+    , cancelBaton(nullptr)
+{
+}
+
+SVNRASessionPool::Entry::~Entry()
+{
+    // closes the session as well
+    if (pool)
+        svn_pool_destroy(pool);
+}
+
+SVNRASessionPool::Session::Session()
+    : m_pool(nullptr)
+    , m_entry(nullptr)
+    , m_discard(false)
+{
+}
+
+SVNRASessionPool::Session::Session(SVNRASessionPool* pool, Entry* entry)
+    : m_pool(pool)
+    , m_entry(entry)
+    , m_discard(false)
+{
+}
+
+SVNRASessionPool::Session::Session(Session&& rhs)
+    : m_pool(rhs.m_pool)
+    , m_entry(rhs.m_entry)
+    , m_discard(rhs.m_discard)
+{
+    rhs.m_entry = nullptr;
+}
+
+SVNRASessionPool::Session::~Session()
+{
+    if (m_entry)
+        m_pool->Checkin(m_entry, m_discard);
+}
+
+svn_ra_session_t* SVNRASessionPool::Session::Get() const
+{
+    return m_entry ? m_entry->session : nullptr;
+}
+
+SVNRASessionPool::SVNRASessionPool()
+{
+}
+
+SVNRASessionPool::~SVNRASessionPool()
+{
+}
+
+SVNRASessionPool& SVNRASessionPool::Instance()
+{
+    // Never destroyed: the sessions must be closed before apr gets
+    // terminated, i.e. long before static objects get destroyed.
+    // The application calls Clear() instead.
+    static SVNRASessionPool* instance = new SVNRASessionPool();
+    return *instance;
+}
+
+svn_error_t* SVNRASessionPool::CancelCallback(void* baton)
+{
+    // only the thread that checked out the session uses it
+    const Entry* entry = static_cast<const Entry*>(baton);
+    return entry->cancelFunc ? entry->cancelFunc(entry->cancelBaton) : SVN_NO_ERROR;
+}
+
+CStringA SVNRASessionPool::GetHost(const char* url)
+{
+    // scheme://user@host:port
+    const char* start = strstr(url, "://");
+    const char* end = start ? strchr(start + 3, '/') : nullptr;
+    return end ? CStringA(url, (int)(end - url)) : CStringA(url);
+}
+
+bool SVNRASessionPool::IsInRepository(const char* url, const CStringA& root)
+{
+    size_t length = root.GetLength();
+    return (strncmp(url, root, length) == 0)
+        && ((url[length] == 0) || (url[length] == '/'));
+}
+
+SVNRASessionPool::Session SVNRASessionPool::Checkout(const char* url, svn_cancel_func_t cancelFunc, void* cancelBaton)
+{
+    const CStringA host = GetHost(url);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CHECKOUT_TIMEOUT);
+
+    Entry* entry = nullptr;
+    bool timedOut = false;
+    std::vector<std::unique_ptr<Entry>> closed;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (HasOpenFailed(url, GetTickCount64()))
+            return Session();
+
+        for (;;)
+        {
+            EvictIdle(GetTickCount64(), closed);
+
+            // reuse an idle session of the same repository
+
+            auto isReusable = [url](const std::unique_ptr<Entry>& e) { return !e->busy && IsInRepository(url, e->root); };
+            auto iter = std::find_if(m_entries.begin(), m_entries.end(), isReusable);
+            if (iter != m_entries.end())
+            {
+                entry = iter->get();
+                entry->busy = true;
+                break;
+            }
+
+            // open a new one, if the server's limit allows for it
+
+            size_t& count = m_sessionCount[host];
+            if (count < MAX_SESSIONS_PER_HOST)
+            {
+                ++count;
+                break;
+            }
+
+            // make room by closing an idle session to another
+            // repository on the same server or wait for one
+
+            auto isIdleOnHost = [&host](const std::unique_ptr<Entry>& e) { return !e->busy && (e->host == host); };
+            iter = std::find_if(m_entries.begin(), m_entries.end(), isIdleOnHost);
+            if (iter != m_entries.end())
+            {
+                closed.push_back(Remove(iter->get()));
+            }
+            else if (m_sessionAvailable.wait_until(lock, deadline) == std::cv_status::timeout)
+            {
+                // the caller is better off opening a session of its own
+                timedOut = true;
+                break;
+            }
+        }
+    }
+    closed.clear();
+
+    if (timedOut)
+        return Session();
+
+    if (entry == nullptr)
+    {
+        entry = Open(url, host, cancelFunc, cancelBaton);
+        return entry ? Session(this, entry) : Session();
+    }
+
+    entry->cancelFunc = cancelFunc;
+    entry->cancelBaton = cancelBaton;
+
+    SVNPool scratchpool;
+    svn_error_t* err = svn_ra_reparent(entry->session, url, scratchpool);
+    if (err == nullptr)
+        return Session(this, entry);
+
+    // the connection may have been closed by the server
+    svn_error_clear(err);
+    Checkin(entry, true);
+    return Session();
+}
+
+void SVNRASessionPool::Clear()
+{
+    std::vector<std::unique_ptr<Entry>> closed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = m_entries.size(); i > 0; --i)
+        {
+            if (!m_entries[i - 1]->busy)
+                closed.push_back(Remove(m_entries[i - 1].get()));
+        }
+    }
+}
+
+SVNRASessionPool::Entry* SVNRASessionPool::Open(const char* url, const CStringA& host, svn_cancel_func_t cancelFunc, void* cancelBaton)
+{
+    std::unique_ptr<Entry> entry(new Entry());
+    entry->pool = svn_pool_create(NULL);
+    entry->host = host;
+    entry->cancelFunc = cancelFunc;
+    entry->cancelBaton = cancelBaton;
+
+    svn_error_t* err = svn_client_create_context2(&entry->ctx, SVNConfig::Instance().GetConfig(entry->pool), entry->pool);
+    if (err == nullptr)
+    {
+        // set up authentication
+        entry->prompt.Init(entry->pool, entry->ctx);
+        entry->ctx->client_name = SVNHelper::GetUserAgentString(entry->pool);
+
+        // the RA layer keeps calling this for the whole life time of the session
+        entry->ctx->cancel_func = CancelCallback;
+        entry->ctx->cancel_baton = entry.get();
+
+        SVNTRACE(
+            err = svn_client_open_ra_session2(&entry->session, url, NULL, entry->ctx, entry->pool, entry->pool),
+            url);
+    }
+
+    const char* root = nullptr;
+    if (err == nullptr)
+        err = svn_ra_get_repos_root2(entry->session, &root, entry->pool);
+
+    if ((err == nullptr) && IsInRepository(url, root))
+    {
+        entry->root = root;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_knownRoots.insert(entry->root);
+        m_entries.push_back(std::move(entry));
+        return m_entries.back().get();
+    }
+
+    svn_error_clear(err);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_sessionCount[host] == 0)
+            m_sessionCount.erase(host);
+
+        // without e.g. cached credentials, the next attempt would just
+        // fail the same way. Block the whole repository, if we know it.
+        auto iter = std::find_if(m_knownRoots.begin(), m_knownRoots.end(), [url](const CStringA& r) { return IsInRepository(url, r); });
+        m_failedOpens[iter != m_knownRoots.end() ? *iter : CStringA(url)] = GetTickCount64() + FAILED_OPEN_TIMEOUT;
+    }
+    m_sessionAvailable.notify_all();
+
+    return nullptr;
+}
+
+void SVNRASessionPool::Checkin(Entry* entry, bool discard)
+{
+    std::unique_ptr<Entry> closed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry->cancelFunc = nullptr;
+        entry->cancelBaton = nullptr;
+        if (discard)
+        {
+            closed = Remove(entry);
+        }
+        else
+        {
+            entry->busy = false;
+            entry->lastUsed = GetTickCount64();
+        }
+    }
+    m_sessionAvailable.notify_all();
+}
+
+std::unique_ptr<SVNRASessionPool::Entry> SVNRASessionPool::Remove(Entry* entry)
+{
+    auto iter = std::find_if(m_entries.begin(), m_entries.end(), [entry](const std::unique_ptr<Entry>& e) { return e.get() == entry; });
+    std::unique_ptr<Entry> result = std::move(*iter);
+    m_entries.erase(iter);
+
+    if (--m_sessionCount[result->host] == 0)
+        m_sessionCount.erase(result->host);
+
+    return result;
+}
+
+bool SVNRASessionPool::HasOpenFailed(const char* url, ULONGLONG now)
+{
+    bool failed = false;
+    for (auto iter = m_failedOpens.begin(); iter != m_failedOpens.end(); )
+    {
+        if (now >= iter->second)
+        {
+            iter = m_failedOpens.erase(iter);
+        }
+        else
+        {
+            failed = failed || IsInRepository(url, iter->first);
+            ++iter;
+        }
+    }
+
+    return failed;
+}
+
+void SVNRASessionPool::EvictIdle(ULONGLONG now, std::vector<std::unique_ptr<Entry>>& closed)
+{
+    for (size_t i = m_entries.size(); i > 0; --i)
+    {
+        Entry* entry = m_entries[i - 1].get();
+        if (!entry->busy && (now - entry->lastUsed > IDLE_TIMEOUT))
+            closed.push_back(Remove(entry));
+    }
+}
@@ -0,0 +1,169 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+#include "SVNPrompt.h"
+#pragma warning(push)
+#include "svn_ra.h"
+#pragma warning(pop)
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+
+/**
+ * \ingroup SVN
+ * Process-wide pool of open RA sessions.
+ *
+ * Opening a session (connection setup, TLS handshake, authentication)
+ * often takes longer than the request sent through it. Short requests
+ * like listing a folder or fetching the HEAD revision can check out an
+ * idle session of the same repository from this pool instead and return
+ * it once they are done.
+ *
+ * Every session has its own client context which never shows any UI.
+ * I.e. sessions can only be opened with cached credentials, and callers
+ * must fall back to opening their own session if the pool can't provide
+ * one or if a request through a pooled session fails.
+ *
+ * There are at most MAX_SESSIONS_PER_HOST sessions per server. Callers
+ * wait at most CHECKOUT_TIMEOUT ms for one to become available. Sessions
+ * that have not been used for IDLE_TIMEOUT ms get closed, and so do all
+ * sessions that failed with an error.
+ *
+ * If a session can't be opened, e.g. because there are no cached
+ * credentials, the pool doesn't try again for that repository root for
+ * FAILED_OPEN_TIMEOUT ms. If the root is not known yet, the failed URL
+ * and everything below it is skipped instead.
+ */
+class SVNRASessionPool
+{
+private:
+    struct Entry;
+
+public:
+    enum
+    {
+        MAX_SESSIONS_PER_HOST = 4,
+        CHECKOUT_TIMEOUT = 1000,
+        IDLE_TIMEOUT = 60000,
+        FAILED_OPEN_TIMEOUT = 30000
+    };
+
+    /**
+     * A session checked out from the pool. It gets returned to the pool
+     * upon destruction.
+     */
+    class Session
+    {
+    public:
+        Session();
+        Session(Session&& rhs);
+        ~Session();
+
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+        Session& operator=(Session&&) = delete;
+
+        /// the RA session, NULL if there is none
+        svn_ra_session_t* Get() const;
+
+        /// true, if a session could be checked out
+        explicit operator bool() const { return m_entry != nullptr; }
+
+        /// close the session instead of returning it to the pool,
+        /// e.g. because a request failed
+        void Discard() { m_discard = true; }
+
+    private:
+        friend class SVNRASessionPool;
+
+        Session(SVNRASessionPool* pool, Entry* entry);
+
+        SVNRASessionPool*   m_pool;
+        Entry*              m_entry;
+        bool                m_discard;
+    };
+
+    static SVNRASessionPool& Instance();
+
+    /**
+     * Returns a session for the repository containing \a url, reparented
+     * to \a url. Waits up to CHECKOUT_TIMEOUT ms while the server's
+     * session limit has been reached. The result is empty, if no session
+     * could be opened in time.
+     * Requests through the session call \a cancelFunc with \a cancelBaton
+     * to check for cancellation until the session gets returned.
+     */
+    Session Checkout(const char* url, svn_cancel_func_t cancelFunc = nullptr, void* cancelBaton = nullptr);
+
+    /// closes all idle sessions
+    void Clear();
+
+private:
+    SVNRASessionPool();
+    ~SVNRASessionPool();
+
+    SVNRASessionPool(const SVNRASessionPool&) = delete;
+    SVNRASessionPool& operator=(const SVNRASessionPool&) = delete;
+
+    struct Entry
+    {
+        Entry();
+        ~Entry();
+
+        apr_pool_t*         pool;
+        svn_client_ctx_t*   ctx;
+        svn_ra_session_t*   session;
+        SVNPrompt           prompt;
+        CStringA            root;
+        CStringA            host;
+        ULONGLONG           lastUsed;
+        bool                busy;
+
+        /// the current user's cancel callback
+        svn_cancel_func_t   cancelFunc;
+        void*               cancelBaton;
+    };
+
+    static svn_error_t* CancelCallback(void* baton);
+    static CStringA GetHost(const char* url);
+    static bool IsInRepository(const char* url, const CStringA& root);
+
+    Entry* Open(const char* url, const CStringA& host, svn_cancel_func_t cancelFunc, void* cancelBaton);
+    void Checkin(Entry* entry, bool discard);
+
+    /// The following methods must be called with m_mutex being held.
+    /// They return the entries to close to not block other threads
+    /// while the connections get shut down.
+    std::unique_ptr<Entry> Remove(Entry* entry);
+    void EvictIdle(ULONGLONG now, std::vector<std::unique_ptr<Entry>>& closed);
+    bool HasOpenFailed(const char* url, ULONGLONG now);
+
+    std::mutex                          m_mutex;
+    std::condition_variable             m_sessionAvailable;
+    std::vector<std::unique_ptr<Entry>> m_entries;
+
+    /// sessions per host, including those currently being opened
+    std::map<CStringA, size_t>          m_sessionCount;
+
+    /// roots of the repositories sessions have been opened for
+    std::set<CStringA>                  m_knownRoots;
+    /// repository root (or URL) -> time until which no session gets opened
+    std::map<CStringA, ULONGLONG>       m_failedOpens;
+};
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2019 - TortoiseSVN
+// Copyright (C) 2003-2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -716,6 +716,20 @@ int CTSVNPath::Compare(const CTSVNPath& left, const CTSVNPath& right)
     return CStringUtils::FastCompareNoCase (left.m_sBackslashPath, right.m_sBackslashPath);
 }
 
+size_t CTSVNPath::HashNoCase::operator()(const CTSVNPath& path) const
+{
+    path.EnsureBackslashPathSet();
+
+    // FNV-1a over the lower-cased characters
+    size_t hash = 2166136261U;
+    for (LPCTSTR p = path.m_sBackslashPath; *p; ++p)
+    {
+        hash ^= (size_t)towlower(*p);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
 bool operator<(const CTSVNPath& left, const CTSVNPath& right)
 {
     return CTSVNPath::Compare(left, right) < 0;
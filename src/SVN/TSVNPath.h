@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2010, 2012-2017 - TortoiseSVN
+// Copyright (C) 2003-2010, 2012-2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -167,6 +167,18 @@ public:
      * Compares two urls (or paths) case sensitive. Slash format is irrelevant.
      */
     static int CompareWithCase(const CTSVNPath& left, const CTSVNPath& right);
+    /**
+     * Hash and equality functors for unordered containers,
+     * consistent with Compare(), i.e. case insensitive.
+     */
+    struct HashNoCase
+    {
+        size_t operator()(const CTSVNPath& path) const;
+    };
+    struct EqualNoCase
+    {
+        bool operator()(const CTSVNPath& left, const CTSVNPath& right) const { return Compare(left, right) == 0; }
+    };
 
     /** As PredLeftLessThanRight, but for checking if paths are equivalent
      */
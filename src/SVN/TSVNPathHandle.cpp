@@ -0,0 +1,558 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "TSVNPathHandle.h"
+#include "ReaderWriterLock.h"
+#include <deque>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+    /**
+     * The process-wide path component trie.
+     *
+     * Every node stores its parent node, its name and the node of the
+     * same path in lower case ("folded"). The folded nodes are part of
+     * the trie as well; a folded node is its own folded node. Node 0 is
+     * the empty path and the parent of all root components.
+     *
+     * Paths get split at forward slashes. Empty components are kept, so
+     * that e.g. URLs and UNC paths can be reconstructed verbatim. Drive
+     * roots like "C:/" form a single component which is the only case
+     * where a name may end with a slash.
+     *
+     * Nodes are allocated in chunks which never move. Every node counts the
+     * handles, children and original-case nodes referring to it. Once that
+     * count drops to zero, the node gets removed and its slot reused. Names
+     * are reference counted by their nodes the same way.
+     *
+     * The parents and folded nodes of a referenced node are referenced as
+     * well, i.e. they stay unchanged as long as there is a handle to it.
+     * Everything that only follows the links of handles therefore needs no
+     * lock. The lock protects the indices used to find, add and remove nodes.
+     * Finding a node and adding a reference to it happens under the same
+     * lock, so that a node cannot get removed in between.
+     */
+    class CPathTable
+    {
+    public:
+        static const DWORD NO_INDEX = (DWORD)-1;
+
+        static CPathTable& Instance()
+        {
+            // never destroyed, so that handles in static objects
+            // may still be released during shutdown
+            static CPathTable* instance = new CPathTable();
+            return *instance;
+        }
+
+        // the following return a node with an additional reference
+
+        DWORD Find(const CString& svnPath)
+        {
+            CAutoReadLockT<CReaderWriterLockNonReentrance> lock(m_guard);
+            return AddRef(Lookup(svnPath, false));
+        }
+
+        DWORD FindFolded(const CString& svnPath)
+        {
+            CString foldedPath = svnPath;
+            Fold(foldedPath.GetBuffer(), foldedPath.GetLength());
+            foldedPath.ReleaseBuffer();
+
+            CAutoReadLockT<CReaderWriterLockNonReentrance> lock(m_guard);
+            return AddRef(Lookup(foldedPath, false));
+        }
+
+        DWORD Insert(const CString& svnPath)
+        {
+            DWORD result = Find(svnPath);
+            if (result != NO_INDEX)
+                return result;
+
+            CAutoWriteLockT<CReaderWriterLockNonReentrance> lock(m_guard);
+            return AddRef(Lookup(svnPath, true));
+        }
+
+        // the node must be referenced by the caller (or the lock be held)
+
+        DWORD AddRef(DWORD id)
+        {
+            if ((id != 0) && (id != NO_INDEX))
+                InterlockedIncrement(&NodeData(id).refCount);
+
+            return id;
+        }
+
+        void Release(DWORD id)
+        {
+            if ((id == 0) || (id == NO_INDEX))
+                return;
+            if (InterlockedDecrement(&NodeData(id).refCount) != 0)
+                return;
+
+            // the node may have been found again in the meantime
+            CAutoWriteLockT<CReaderWriterLockNonReentrance> lock(m_guard);
+            RemoveUnused(id);
+        }
+
+        void Render(DWORD id, wchar_t separator, CString& buffer) const
+        {
+            int length = 0;
+            for (DWORD node = id; node != 0; node = Node(node).parent)
+            {
+                length += (int)Node(node).name->size();
+                if (NeedsSeparator(node))
+                    ++length;
+            }
+
+            // fill the buffer back to front
+
+            wchar_t* target = buffer.GetBuffer(length) + length;
+            for (DWORD node = id; node != 0; node = Node(node).parent)
+            {
+                const std::wstring& name = *Node(node).name;
+                for (auto iter = name.rbegin(), end = name.rend(); iter != end; ++iter)
+                    *--target = *iter == '/' ? separator : *iter;
+                if (NeedsSeparator(node))
+                    *--target = separator;
+            }
+
+            buffer.ReleaseBuffer(length);
+        }
+
+        CString GetName(DWORD id) const
+        {
+            return Node(id).name->c_str();
+        }
+
+        DWORD GetParent(DWORD id) const
+        {
+            return id == 0 ? 0 : Node(id).parent;
+        }
+
+        DWORD GetFolded(DWORD id) const
+        {
+            return Node(id).folded;
+        }
+
+        bool IsAncestor(DWORD ancestor, DWORD id) const
+        {
+            for (; id != 0; id = Node(id).parent)
+                if (id == ancestor)
+                    return true;
+
+            return ancestor == 0;
+        }
+
+        /**
+         * Orders folded nodes component by component. Parents come
+         * before their children and siblings are ordered by name.
+         */
+        int CompareFolded(DWORD left, DWORD right) const
+        {
+            if (left == right)
+                return 0;
+
+            int leftDepth = GetDepth(left);
+            int rightDepth = GetDepth(right);
+
+            // the deeper node can't be the smaller one if the other
+            // one turns out to be its ancestor
+
+            int result = leftDepth < rightDepth ? -1 : 1;
+            for (; leftDepth > rightDepth; --leftDepth)
+                left = Node(left).parent;
+            for (; rightDepth > leftDepth; --rightDepth)
+                right = Node(right).parent;
+            if (left == right)
+                return result;
+
+            while (Node(left).parent != Node(right).parent)
+            {
+                left = Node(left).parent;
+                right = Node(right).parent;
+            }
+
+            return Node(left).name->compare(*Node(right).name) < 0 ? -1 : 1;
+        }
+
+        size_t size()
+        {
+            CAutoReadLockT<CReaderWriterLockNonReentrance> lock(m_guard);
+            return m_count - m_freeNodes.size();
+        }
+
+    private:
+        enum
+        {
+            CHUNK_SHIFT = 14,
+            CHUNK_SIZE = 1 << CHUNK_SHIFT,
+            MAX_CHUNKS = 1 << 14
+        };
+
+        struct SNode
+        {
+            DWORD parent;
+            DWORD folded;
+            DWORD nameID;
+            const std::wstring* name;       ///< nullptr for unused slots
+            volatile LONG refCount;
+        };
+
+        struct SName
+        {
+            std::wstring text;
+            DWORD refCount;                 ///< protected by the write lock
+        };
+
+        CPathTable()
+            : m_count(0)
+        {
+            AddNode(0, NO_INDEX, AddName(std::wstring_view()));
+        }
+
+        const SNode& Node(DWORD id) const
+        {
+            return m_chunks[id >> CHUNK_SHIFT][id & (CHUNK_SIZE - 1)];
+        }
+
+        SNode& NodeData(DWORD id)
+        {
+            return m_chunks[id >> CHUNK_SHIFT][id & (CHUNK_SIZE - 1)];
+        }
+
+        // caller must hold the write lock
+        DWORD AddNode(DWORD parent, DWORD folded, DWORD nameID)
+        {
+            DWORD result = m_count;
+            if (!m_freeNodes.empty())
+            {
+                result = m_freeNodes.back();
+                m_freeNodes.pop_back();
+            }
+            else
+            {
+                if ((result >> CHUNK_SHIFT) >= MAX_CHUNKS)
+                    throw std::bad_alloc();
+
+                std::unique_ptr<SNode[]>& chunk = m_chunks[result >> CHUNK_SHIFT];
+                if (!chunk)
+                    chunk = std::make_unique<SNode[]>(CHUNK_SIZE);
+
+                ++m_count;
+            }
+
+            SNode& node = NodeData(result);
+            node.parent = parent;
+            node.folded = folded == NO_INDEX ? result : folded;
+            node.nameID = nameID;
+            node.name = &m_names[nameID].text;
+            node.refCount = 0;
+
+            ++m_names[nameID].refCount;
+            if (result != 0)
+                AddRef(parent);
+            if (node.folded != result)
+                AddRef(node.folded);
+
+            return result;
+        }
+
+        // caller must hold the write lock
+        void RemoveUnused(DWORD id)
+        {
+            std::vector<DWORD> candidates(1, id);
+            while (!candidates.empty())
+            {
+                DWORD current = candidates.back();
+                candidates.pop_back();
+
+                SNode& node = NodeData(current);
+                if ((current == 0) || (node.name == nullptr) || (node.refCount != 0))
+                    continue;
+
+                m_childIndex.erase(((unsigned __int64)node.parent << 32) + node.nameID);
+                ReleaseName(node.nameID);
+                node.name = nullptr;
+                m_freeNodes.push_back(current);
+
+                // node 0 is not reference counted
+                if ((node.parent != 0) && (InterlockedDecrement(&NodeData(node.parent).refCount) == 0))
+                    candidates.push_back(node.parent);
+                if ((node.folded != current) && (InterlockedDecrement(&NodeData(node.folded).refCount) == 0))
+                    candidates.push_back(node.folded);
+            }
+        }
+
+        static void Fold(wchar_t* text, int length)
+        {
+            if (length > 0)
+                CharLowerBuffW(text, length);
+        }
+
+        int GetDepth(DWORD id) const
+        {
+            int depth = 0;
+            for (; id != 0; id = Node(id).parent)
+                ++depth;
+
+            return depth;
+        }
+
+        // the parent's name already ends with a slash for drive roots
+        bool NeedsSeparator(DWORD node) const
+        {
+            DWORD parent = Node(node).parent;
+            if (parent == 0)
+                return false;
+
+            const std::wstring& name = *Node(parent).name;
+            return name.empty() || (name.back() != '/');
+        }
+
+        // the name gets referenced by the node it is added for
+        DWORD AddName(std::wstring_view name)
+        {
+            auto iter = m_nameIndex.find(name);
+            if (iter != m_nameIndex.end())
+                return iter->second;
+
+            DWORD result = (DWORD)m_names.size();
+            if (!m_freeNames.empty())
+            {
+                result = m_freeNames.back();
+                m_freeNames.pop_back();
+                m_names[result].text.assign(name);
+            }
+            else
+            {
+                m_names.push_back({ std::wstring(name), 0 });
+            }
+
+            m_nameIndex.emplace(std::wstring_view(m_names[result].text), result);
+            return result;
+        }
+
+        void ReleaseName(DWORD nameID)
+        {
+            SName& name = m_names[nameID];
+            if (--name.refCount != 0)
+                return;
+
+            m_nameIndex.erase(std::wstring_view(name.text));
+            name.text.clear();
+            name.text.shrink_to_fit();
+            m_freeNames.push_back(nameID);
+        }
+
+        DWORD GetChild(DWORD parent, std::wstring_view name, bool add)
+        {
+            DWORD nameID = NO_INDEX;
+            if (add)
+            {
+                nameID = AddName(name);
+            }
+            else
+            {
+                auto iter = m_nameIndex.find(name);
+                if (iter == m_nameIndex.end())
+                    return NO_INDEX;
+                nameID = iter->second;
+            }
+
+            unsigned __int64 key = ((unsigned __int64)parent << 32) + nameID;
+            auto iter = m_childIndex.find(key);
+            if (iter != m_childIndex.end())
+                return iter->second;
+            if (!add)
+                return NO_INDEX;
+
+            // link the node to its lower case variant, adding that first if necessary
+
+            std::wstring foldedName(name);
+            Fold(&foldedName[0], (int)foldedName.size());
+            DWORD foldedParent = Node(parent).folded;
+            DWORD folded = (foldedParent != parent) || (foldedName != name)
+                ? GetChild(foldedParent, foldedName, true)
+                : NO_INDEX;
+
+            DWORD result = AddNode(parent, folded, nameID);
+            m_childIndex.emplace(key, result);
+            return result;
+        }
+
+        // caller must hold the appropriate lock
+        DWORD Lookup(const CString& svnPath, bool add)
+        {
+            std::wstring_view path((LPCWSTR)svnPath, svnPath.GetLength());
+            if (path.empty())
+                return 0;
+
+            DWORD node = 0;
+            size_t start = 0;
+            if ((path.size() >= 3) && (path[1] == ':') && (path[2] == '/'))
+            {
+                node = GetChild(node, path.substr(0, 3), add);
+                start = 3;
+                if (start == path.size())
+                    return node;
+            }
+
+            while (node != NO_INDEX)
+            {
+                size_t end = path.find('/', start);
+                if (end == std::wstring_view::npos)
+                    return GetChild(node, path.substr(start), add);
+
+                node = GetChild(node, path.substr(start, end - start), add);
+                start = end + 1;
+            }
+
+            return NO_INDEX;
+        }
+
+        // fixed size, so that lock-free readers never see a reallocation
+        std::unique_ptr<SNode[]> m_chunks[MAX_CHUNKS];
+        DWORD m_count;
+        std::vector<DWORD> m_freeNodes;
+        std::deque<SName> m_names;
+        std::vector<DWORD> m_freeNames;
+        std::unordered_map<std::wstring_view, DWORD> m_nameIndex;
+        std::unordered_map<unsigned __int64, DWORD> m_childIndex;
+
+        CReaderWriterLockNonReentrance m_guard;
+    };
+
+    CString& GetScratchBuffer()
+    {
+        thread_local CString buffer;
+        return buffer;
+    }
+}
+
+CTSVNPathHandle::CTSVNPathHandle(const CTSVNPath& path)
+    : m_id(CPathTable::Instance().Insert(path.GetSVNPathString()))
+{
+}
+
+CTSVNPathHandle::CTSVNPathHandle(const CTSVNPathHandle& rhs)
+    : m_id(CPathTable::Instance().AddRef(rhs.m_id))
+{
+}
+
+CTSVNPathHandle::~CTSVNPathHandle()
+{
+    CPathTable::Instance().Release(m_id);
+}
+
+CTSVNPathHandle& CTSVNPathHandle::operator=(const CTSVNPathHandle& rhs)
+{
+    CPathTable& table = CPathTable::Instance();
+    table.AddRef(rhs.m_id);
+    table.Release(m_id);
+    m_id = rhs.m_id;
+    return *this;
+}
+
+CTSVNPathHandle CTSVNPathHandle::Find(const CTSVNPath& path)
+{
+    return CTSVNPathHandle(CPathTable::Instance().Find(path.GetSVNPathString()));
+}
+
+CTSVNPathHandle CTSVNPathHandle::FindNoCase(const CTSVNPath& path)
+{
+    return CTSVNPathHandle(CPathTable::Instance().FindFolded(path.GetSVNPathString()));
+}
+
+CTSVNPath CTSVNPathHandle::GetPath() const
+{
+    CTSVNPath result;
+    if (IsValid() && !IsEmpty())
+        result.SetFromSVN(CString(GetSVNPath()));
+
+    return result;
+}
+
+LPCTSTR CTSVNPathHandle::GetWinPath() const
+{
+    CString& buffer = GetScratchBuffer();
+    CPathTable::Instance().Render(IsValid() ? m_id : 0, '\\', buffer);
+    return buffer;
+}
+
+LPCTSTR CTSVNPathHandle::GetSVNPath() const
+{
+    CString& buffer = GetScratchBuffer();
+    CPathTable::Instance().Render(IsValid() ? m_id : 0, '/', buffer);
+    return buffer;
+}
+
+CString CTSVNPathHandle::GetFileOrDirectoryName() const
+{
+    if (!IsValid() || IsEmpty())
+        return CString();
+
+    CString result = CPathTable::Instance().GetName(m_id);
+    result.TrimRight('/');
+    return result;
+}
+
+CTSVNPathHandle CTSVNPathHandle::GetParent() const
+{
+    if (!IsValid())
+        return *this;
+
+    CPathTable& table = CPathTable::Instance();
+    return CTSVNPathHandle(table.AddRef(table.GetParent(m_id)));
+}
+
+bool CTSVNPathHandle::IsAncestorOf(const CTSVNPathHandle& possibleDescendant) const
+{
+    return IsValid()
+        && possibleDescendant.IsValid()
+        && CPathTable::Instance().IsAncestor(m_id, possibleDescendant.m_id);
+}
+
+bool CTSVNPathHandle::IsAncestorOfNoCase(const CTSVNPathHandle& possibleDescendant) const
+{
+    if (!IsValid() || !possibleDescendant.IsValid())
+        return false;
+
+    const CPathTable& table = CPathTable::Instance();
+    return table.IsAncestor(table.GetFolded(m_id), table.GetFolded(possibleDescendant.m_id));
+}
+
+int CTSVNPathHandle::Compare(const CTSVNPathHandle& left, const CTSVNPathHandle& right)
+{
+    if (left.m_id == right.m_id)
+        return 0;
+
+    const CPathTable& table = CPathTable::Instance();
+    return table.CompareFolded(left.IsValid() ? table.GetFolded(left.m_id) : 0,
+                               right.IsValid() ? table.GetFolded(right.m_id) : 0);
+}
+
+size_t CTSVNPathHandle::GetInternedCount()
+{
+    return CPathTable::Instance().size();
+}
@@ -0,0 +1,140 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+#include "TSVNPath.h"
+
+/**
+ * \ingroup Utils
+ * A compact, interned replacement for CTSVNPath in large containers.
+ *
+ * All handles refer to nodes of one process-wide path component trie.
+ * A handle itself is just the 4-byte ID of its node, i.e. equal paths
+ * always get the same ID and copying / comparing for equality is trivial.
+ * String representations are not stored per path but assembled on demand
+ * into a thread-local scratch buffer.
+ *
+ * Paths are interned case-sensitively and independent of the slash
+ * direction, i.e. two handles are equal if and only if the corresponding
+ * CTSVNPath objects are IsEquivalentTo() each other.
+ *
+ * Handles are reference counted. A path gets released when the last
+ * handle to it (or to any of its sub-paths) goes away. Copying a handle
+ * is an interlocked increment, so prefer passing them by reference.
+ */
+class CTSVNPathHandle
+{
+public:
+    /// the empty path
+    CTSVNPathHandle() : m_id(0) {}
+    /// interns \a path, if necessary
+    explicit CTSVNPathHandle(const CTSVNPath& path);
+    CTSVNPathHandle(const CTSVNPathHandle& rhs);
+    CTSVNPathHandle(CTSVNPathHandle&& rhs) : m_id(rhs.m_id) { rhs.m_id = 0; }
+    ~CTSVNPathHandle();
+
+    CTSVNPathHandle& operator=(const CTSVNPathHandle& rhs);
+    CTSVNPathHandle& operator=(CTSVNPathHandle&& rhs) { std::swap(m_id, rhs.m_id); return *this; }
+
+    /**
+     * Returns the handle for \a path, if it has already been interned.
+     * Otherwise, an invalid handle will be returned and the path table
+     * remains unchanged.
+     */
+    static CTSVNPathHandle Find(const CTSVNPath& path);
+    /**
+     * Like Find() but case insensitive. Returns the handle of the lower
+     * case variant of \a path, i.e. the key under which any spelling of
+     * the path gets sorted by Less.
+     */
+    static CTSVNPathHandle FindNoCase(const CTSVNPath& path);
+
+    bool IsValid() const { return m_id != NO_INDEX; }
+    bool IsEmpty() const { return m_id == 0; }
+    DWORD GetID() const { return m_id; }
+
+    /// convert back into a full path object
+    CTSVNPath GetPath() const;
+
+    /**
+     * Returns the path in Windows format, i.e. with backslashes.
+     * \remark The result is stored in a thread-local buffer and is
+     * only valid until the next call to GetWinPath() or GetSVNPath()
+     * from the same thread.
+     */
+    LPCTSTR GetWinPath() const;
+    /**
+     * Returns the path with forward slashes.
+     * \remark Same buffer life time restrictions as for GetWinPath().
+     */
+    LPCTSTR GetSVNPath() const;
+
+    /// the item's name without the full path
+    CString GetFileOrDirectoryName() const;
+    /// the path without the last component. Empty for root paths.
+    CTSVNPathHandle GetParent() const;
+
+    /**
+     * Checks if \c possibleDescendant is this path or a child of it.
+     * Unlike CTSVNPath::IsAncestorOf(), this is case-sensitive.
+     */
+    bool IsAncestorOf(const CTSVNPathHandle& possibleDescendant) const;
+    /// case insensitive variant of IsAncestorOf()
+    bool IsAncestorOfNoCase(const CTSVNPathHandle& possibleDescendant) const;
+
+    bool operator==(const CTSVNPathHandle& rhs) const { return m_id == rhs.m_id; }
+    bool operator!=(const CTSVNPathHandle& rhs) const { return m_id != rhs.m_id; }
+
+    /**
+     * Compares two paths, case insensitive. Paths are ordered component
+     * by component, so a path sorts directly before all its descendants.
+     * This walks the interned (lower case) nodes and never assembles
+     * the path strings, i.e. it takes no lock either.
+     */
+    static int Compare(const CTSVNPathHandle& left, const CTSVNPathHandle& right);
+
+    /// ordering predicate for sorted containers
+    struct Less
+    {
+        bool operator()(const CTSVNPathHandle& left, const CTSVNPathHandle& right) const
+        {
+            return (left.m_id != right.m_id) && (Compare(left, right) < 0);
+        }
+    };
+
+    /// hash function for unordered containers
+    struct Hash
+    {
+        size_t operator()(const CTSVNPathHandle& handle) const
+        {
+            return handle.m_id;
+        }
+    };
+
+    /// number of path nodes currently interned (for statistics)
+    static size_t GetInternedCount();
+
+private:
+    static const DWORD NO_INDEX = (DWORD)-1;
+
+    /// takes over a reference to \a id
+    explicit CTSVNPathHandle(DWORD id) : m_id(id) {}
+
+    DWORD m_id;
+};
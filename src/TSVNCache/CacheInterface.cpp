@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2007,2009-2012, 2014-2015 - TortoiseSVN
+// External Cache Copyright (C) 2007,2009-2012, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -37,6 +37,16 @@ CString GetCacheMutexName()
     return TSVN_CACHE_MUTEX_NAME + GetCacheID();
 }
 
+CString GetCacheStatusTableName()
+{
+    return TSVN_CACHE_STATUSTABLE_NAME + GetCacheID();
+}
+
+CString GetCacheAskedKeysName()
+{
+    return TSVN_CACHE_ASKEDKEYS_NAME + GetCacheID();
+}
+
 CString GetCacheID()
 {
     CString t;
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005-2006,2008-2010, 2014 - TortoiseSVN
+// External Cache Copyright (C) 2005-2006,2008-2010, 2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -19,16 +19,21 @@
 
 #pragma once
 #include <wininet.h>
+#include "StatusTable.h"
 
 // The name of the named-pipe for the cache
 #define TSVN_CACHE_WINDOW_NAME L"TSVNCacheWindow"
 #define TSVN_CACHE_MUTEX_NAME L"TSVNCacheMutex"
 #define TSVN_CACHE_COMMANDPIPE_NAME L"\\\\.\\pipe\\TSVNCacheCommand"
 #define TSVN_CACHE_PIPE_NAME L"\\\\.\\pipe\\TSVNCache"
+#define TSVN_CACHE_STATUSTABLE_NAME L"TSVNCacheStatusTable"
+#define TSVN_CACHE_ASKEDKEYS_NAME L"TSVNCacheAskedKeys"
 
 CString GetCachePipeName();
 CString GetCacheCommandPipeName();
 CString GetCacheMutexName();
+CString GetCacheStatusTableName();
+CString GetCacheAskedKeysName();
 
 CString GetCacheID();
 bool    SendCacheCommand(BYTE command, const WCHAR * path = NULL);
@@ -81,6 +86,21 @@ struct TSVNCacheResponse
     INT64 m_cmt_rev;
 };
 
+/**
+ * \ingroup TSVNCache
+ * The responses the cache shares with its clients in the named shared
+ * memory block GetCacheStatusTableName(), keyed by request path and flags.
+ * Clients only have to ask through the pipe if they can't find the path there.
+ */
+typedef CSharedStatusTable<TSVNCacheResponse> CCacheStatusTable;
+
+/**
+ * \ingroup TSVNCache
+ * The keys of the responses that clients have recently found in the
+ * status table, in the named shared memory block GetCacheAskedKeysName().
+ */
+typedef CSharedKeyRing CCacheAskedKeys;
+
 #endif // SVN_WC_H
 
 /**
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005-2011, 2014 - TortoiseSVN
+// External Cache Copyright (C) 2005-2011, 2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -23,6 +23,7 @@
 #include "SVNStatus.h"
 #include "UnicodeUtils.h"
 #include "SmartHandle.h"
+#include "WCDbReader.h"
 #include <set>
 
 #define CACHEDIRECTORYDISKVERSION 3
@@ -514,6 +515,13 @@ CCachedDirectory::SvnUpdateMembersStatus()
         CSVNStatusCache::Instance().BlockPath(m_directoryPath, true, 5);
         return false;
     }
+    if (GetMembersStatusFromWCDb(svnapipath, subPool))
+    {
+        InterlockedExchange(&m_FetchingStatus, FALSE);
+        RefreshMostImportant(false);
+        return true;
+    }
+
     m_pCtx = CSVNStatusCache::Instance().m_svnHelp.ClientContext(subPool);
     svn_error_t * pErr = nullptr;
     if (m_pCtx)
@@ -611,6 +619,79 @@ CCachedDirectory::SvnUpdateMembersStatus()
     return true;
 }
 
+bool
+CCachedDirectory::GetMembersStatusFromWCDb(const char * svnapipath, apr_pool_t * pool)
+{
+    // the simple cases can be read from wc.db without the overhead
+    // of svn_client_status(). That's most folders in a typical WC.
+    CTSVNPath wcRoot = CSVNStatusCache::Instance().WCRoots()->GetWCRoot(m_directoryPath);
+    if (wcRoot.IsEmpty())
+        return false;
+
+    std::vector<CWCDbReader::Node> nodes;
+    if (!CWCDbReader::GetDirectoryStatus(wcRoot, m_directoryPath, nodes))
+        return false;
+
+    // only unversioned items need the svn API: to tell whether
+    // they're ignored, the ignore patterns have to be checked
+    apr_array_header_t * ignores = NULL;
+    if (std::any_of(nodes.begin(), nodes.end(), [](const CWCDbReader::Node& node) { return !node.versioned; }))
+    {
+        svn_client_ctx_t * ctx = CSVNStatusCache::Instance().m_svnHelp.ClientContext(pool);
+        if (ctx == NULL)
+            return false;
+        svn_error_t * pErr = svn_wc_get_ignores2(&ignores, ctx->wc_ctx, svnapipath, ctx->config, pool, pool);
+        svn_wc_context_destroy(ctx->wc_ctx);
+        ctx->wc_ctx = NULL;
+        if (pErr)
+        {
+            svn_error_clear(pErr);
+            return false;
+        }
+    }
+
+    CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": read %d entries from wc.db for %s\n", (int)nodes.size(), m_directoryPath.GetWinPath());
+
+    for (std::vector<CWCDbReader::Node>::const_iterator it = nodes.begin(); it != nodes.end(); ++it)
+    {
+        CStringA path(svnapipath);
+        if (!it->name.IsEmpty())
+        {
+            if (path.Right(1) != "/")
+                path += "/";
+            path += it->name;
+        }
+
+        svn_lock_t lock = {};
+        lock.owner = it->lockOwner;
+
+        svn_client_status_t status = {};
+        status.kind = it->kind;
+        status.local_abspath = path;
+        status.filesize = SVN_INVALID_FILESIZE;
+        status.versioned = it->versioned;
+        status.node_status = it->nodeStatus;
+        status.text_status = it->textStatus;
+        if (!it->versioned && svn_wc_match_ignore_list(it->name, ignores, pool))
+            status.node_status = status.text_status = svn_wc_status_ignored;
+        status.prop_status = it->propStatus;
+        status.revision = SVN_INVALID_REVNUM;
+        status.changed_rev = it->changedRev;
+        status.switched = it->switched;
+        status.lock = it->lockOwner.IsEmpty() ? NULL : &lock;
+        status.changelist = it->changelist.IsEmpty() ? NULL : (const char*)it->changelist;
+        status.depth = svn_depth_unknown;
+        status.repos_node_status = svn_wc_status_none;
+        status.repos_text_status = svn_wc_status_none;
+        status.repos_prop_status = svn_wc_status_none;
+        status.ood_changed_rev = SVN_INVALID_REVNUM;
+
+        AddMemberStatus(path, &status, it->needsLock);
+    }
+
+    return true;
+}
+
 svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path, const svn_client_status_t *status, apr_pool_t * pool)
 {
     CCachedDirectory* pThis = (CCachedDirectory*)baton;
@@ -618,9 +699,28 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
     if (path == NULL)
         return SVN_NO_ERROR;
 
+    // only fetch the svn:needs-lock property if the status of this file is 'normal', because
+    // if the status is something else, the needs-lock overlay won't show up anyway
+    bool needsLock = false;
+    if ((pThis->m_pCtx)&&(status->versioned)&&(status->kind != svn_node_dir)&&(status->node_status == svn_wc_status_normal))
+    {
+        const svn_string_t * value = NULL;
+        svn_error_t * err = svn_wc_prop_get2(&value, pThis->m_pCtx->wc_ctx, path, "svn:needs-lock", pool, pool);
+        if ((err==NULL) && value)
+            needsLock = true;
+        if (err)
+            svn_error_clear(err);
+    }
+
+    pThis->AddMemberStatus(path, status, needsLock);
+
+    return SVN_NO_ERROR;
+}
+
+void CCachedDirectory::AddMemberStatus(const char *path, const svn_client_status_t *status, bool needsLock)
+{
     CTSVNPath svnPath;
     bool forceNormal = false;
-    bool needsLock = false;
 
     const svn_wc_status_kind nodeStatus = status->node_status;
     if(status->versioned)
@@ -632,7 +732,7 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
 
         if(svnPath.IsDirectory())
         {
-            if(!svnPath.IsEquivalentToWithoutCase(pThis->m_directoryPath))
+            if(!svnPath.IsEquivalentToWithoutCase(m_directoryPath))
             {
                 // Make sure we know about this child directory
                 // This initial status value is likely to be overwritten from below at some point
@@ -645,7 +745,7 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
                     // This child directory is already in our cache!
                     // So ask this dir about its recursive status
                     svn_wc_status_kind st = SVNStatus::GetMoreImportant(s, cdir->GetCurrentFullStatus());
-                    pThis->SetChildStatus(svnPath, st);
+                    SetChildStatus(svnPath, st);
                 }
                 else
                 {
@@ -653,24 +753,10 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
                     // initially 'unversioned'. But we added that directory to the crawling list above, which
                     // means the cache will be updated soon.
                     CSVNStatusCache::Instance().GetDirectoryCacheEntry(svnPath);
-                    pThis->SetChildStatus(svnPath, s);
+                    SetChildStatus(svnPath, s);
                 }
             }
         }
-        else
-        {
-            // only fetch the svn:needs-lock property if the status of this file is 'normal', because
-            // if the status is something else, the needs-lock overlay won't show up anyway
-            if ((pThis->m_pCtx)&&(nodeStatus == svn_wc_status_normal))
-            {
-                const svn_string_t * value = NULL;
-                svn_error_t * err = svn_wc_prop_get2(&value, pThis->m_pCtx->wc_ctx, path, "svn:needs-lock", pool, pool);
-                if ((err==NULL) && value)
-                    needsLock = true;
-                if (err)
-                    svn_error_clear(err);
-            }
-        }
     }
     else
     {
@@ -683,14 +769,14 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
         // part of another working copy (nested layouts).
         // So we have to make sure that such an 'unversioned' folder really
         // is unversioned.
-        if (((nodeStatus == svn_wc_status_unversioned)||(nodeStatus == svn_wc_status_ignored))&&(!svnPath.IsEquivalentToWithoutCase(pThis->m_directoryPath))&&(svnPath.IsDirectory()))
+        if (((nodeStatus == svn_wc_status_unversioned)||(nodeStatus == svn_wc_status_ignored))&&(!svnPath.IsEquivalentToWithoutCase(m_directoryPath))&&(svnPath.IsDirectory()))
         {
             if (svnPath.IsWCRoot())
             {
                 CSVNStatusCache::Instance().AddFolderForCrawling(svnPath);
                 // Mark the directory as 'versioned' (status 'normal' for now).
                 // This initial value will be overwritten from below some time later
-                pThis->SetChildStatus(svnPath, svn_wc_status_normal);
+                SetChildStatus(svnPath, svn_wc_status_normal);
                 // Make sure the entry is also in the cache
                 CSVNStatusCache::Instance().GetDirectoryCacheEntry(svnPath);
                 // also mark the status in the status object as normal
@@ -698,7 +784,7 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
             }
             else
             {
-                pThis->SetChildStatus(svnPath, nodeStatus);
+                SetChildStatus(svnPath, nodeStatus);
             }
         }
         else if (nodeStatus == svn_wc_status_external)
@@ -708,7 +794,7 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
                 CSVNStatusCache::Instance().AddFolderForCrawling(svnPath);
                 // Mark the directory as 'versioned' (status 'normal' for now).
                 // This initial value will be overwritten from below some time later
-                pThis->SetChildStatus(svnPath, svn_wc_status_normal);
+                SetChildStatus(svnPath, svn_wc_status_normal);
                 // we have added a directory to the child-directory list of this
                 // directory. We now must make sure that this directory also has
                 // an entry in the cache.
@@ -724,14 +810,12 @@ svn_error_t * CCachedDirectory::GetStatusCallback(void *baton, const char *path,
                 svn_wc_status_kind s = nodeStatus;
                 if (status->conflicted)
                     s = SVNStatus::GetMoreImportant(s, svn_wc_status_conflicted);
-                pThis->SetChildStatus(svnPath, s);
+                SetChildStatus(svnPath, s);
             }
         }
     }
 
-    pThis->AddEntry(svnPath, status, needsLock, forceNormal);
-
-    return SVN_NO_ERROR;
+    AddEntry(svnPath, status, needsLock, forceNormal);
 }
 
 bool
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005-2006, 2008, 2010, 2014 - TortoiseSVN
+// External Cache Copyright (C) 2005-2006, 2008, 2010, 2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -20,6 +20,7 @@
 
 #include "StatusCacheEntry.h"
 #include "TSVNPath.h"
+#include "TSVNPathHandle.h"
 
 /**
  * \ingroup TSVNCache
@@ -29,7 +30,7 @@
 class CCachedDirectory
 {
 public:
-    typedef std::map<CTSVNPath, CCachedDirectory *> CachedDirMap;
+    typedef std::map<CTSVNPathHandle, CCachedDirectory *, CTSVNPathHandle::Less> CachedDirMap;
     typedef CachedDirMap::iterator ItDir;
 
 public:
@@ -50,12 +51,16 @@ public:
     svn_wc_status_kind GetCurrentFullStatus() const {return m_currentFullStatus;}
 private:
     static svn_error_t* GetStatusCallback(void *baton, const char *path, const svn_client_status_t *status, apr_pool_t *pool);
+    void AddMemberStatus(const char *path, const svn_client_status_t *status, bool needsLock);
     void AddEntry(const CTSVNPath& path, const svn_client_status_t* pSVNStatus, bool needsLock, bool forceNormal);
     CStringA GetCacheKey(const CTSVNPath& path);
     CString GetFullPathString(const CStringA& cacheKey);
     CStatusCacheEntry LookForItemInCache(const CTSVNPath& path, bool &bFound);
     void UpdateChildDirectoryStatus(const CTSVNPath& childDir, svn_wc_status_kind childStatus);
     bool SvnUpdateMembersStatus();
+    /// Fast path for SvnUpdateMembersStatus(): reads the status from wc.db
+    /// directly. Returns false if svn_client_status() is required.
+    bool GetMembersStatusFromWCDb(const char * svnapipath, apr_pool_t * pool);
 
     // Calculate the complete, composite status from ourselves, our files, and our descendants
     svn_wc_status_kind CalculateRecursiveStatus();
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005-2012, 2014-2015 - TortoiseSVN
+// External Cache Copyright (C) 2005-2012, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -28,12 +28,16 @@
 #pragma warning(pop)
 
 
+// upper limit for the number of crawler threads. More threads
+// would mainly compete for the disk.
+#define MAX_CRAWLER_THREADS 4
+
 CFolderCrawler::CFolderCrawler(void)
     : m_lCrawlInhibitSet(0)
+    , m_lQueuedCount(0)
     , m_crawlHoldoffReleasesAt((LONGLONG)GetTickCount64())
     , m_bRun(false)
-    , m_bPathsAddedSinceLastCrawl(false)
-    , m_bItemsAddedSinceLastCrawl(false)
+    , m_bRecursive(true)
     , m_blockReleasesAt(0)
 {
     m_hWakeEvent = CreateEvent(NULL,FALSE,FALSE,NULL);
@@ -51,12 +55,15 @@ void CFolderCrawler::Stop()
     if (m_hTerminationEvent)
     {
         SetEvent(m_hTerminationEvent);
-        if(WaitForSingleObject(m_hThread, 4000) != WAIT_OBJECT_0)
+        for (auto& hThread : m_hThreads)
         {
-            CTraceToOutputDebugString::Instance()(__FUNCTION__ ": Error terminating crawler thread\n");
+            if(WaitForSingleObject(hThread, 4000) != WAIT_OBJECT_0)
+            {
+                CTraceToOutputDebugString::Instance()(__FUNCTION__ ": Error terminating crawler thread\n");
+            }
         }
     }
-    m_hThread.CloseHandle();
+    m_hThreads.clear();
     m_hTerminationEvent.CloseHandle();
     m_hWakeEvent.CloseHandle();
 }
@@ -64,31 +71,53 @@ void CFolderCrawler::Stop()
 void CFolderCrawler::Initialise()
 {
     // Don't call Initialize more than once
-    ATLASSERT(!m_hThread);
+    ATLASSERT(m_hThreads.empty());
 
-    // Just start the worker thread.
-    // It will wait for event being signaled.
+    // Just start the worker threads.
+    // They will wait for event being signaled.
     // If m_hWakeEvent is already signaled the worker thread
     // will behave properly (with normal priority at worst).
 
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    DWORD threadCount = max<DWORD>(1, min<DWORD>(si.dwNumberOfProcessors, MAX_CRAWLER_THREADS));
+
+    m_bRecursive = !!(DWORD)CRegStdDWORD(L"Software\\TortoiseSVN\\RecursiveOverlay", TRUE);
     m_bRun = true;
-    unsigned int threadId = 0;
-    m_hThread = (HANDLE)_beginthreadex(NULL,0,ThreadEntry,this,0,&threadId);
-    SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+    for (DWORD i = 0; i < threadCount; ++i)
+    {
+        unsigned int threadId = 0;
+        CAutoGeneralHandle hThread = (HANDLE)_beginthreadex(NULL,0,ThreadEntry,this,0,&threadId);
+        if (!hThread)
+            break;
+        SetThreadPriority(hThread, THREAD_PRIORITY_BELOW_NORMAL);
+        m_hThreads.push_back(std::move(hThread));
+    }
+}
+
+CTSVNPath CFolderCrawler::GetRootKey(const CTSVNPath& path) const
+{
+    return CSVNStatusCache::Instance().WCRoots()->GetWCRoot(path);
 }
 
 void CFolderCrawler::AddDirectoryForUpdate(const CTSVNPath& path)
 {
     if (!CSVNStatusCache::Instance().IsPathGood(path))
         return;
+    CTSVNPath root = GetRootKey(path);
     {
         AutoLocker lock(m_critSec);
 
-        m_foldersToUpdate.Push(path);
+        // Requests for sub folders of a queued folder are kept: crawling
+        // the parent refreshes its own status only and does not
+        // invalidate the cached status of its sub folders.
+        RootQueue& queue = m_roots[root];
+        size_t count = queue.foldersToUpdate.size();
+        if (queue.foldersToUpdate.Push(path) > count)
+            InterlockedIncrement(&m_lQueuedCount);
+        if (!queue.busy && !m_pendingRoots.contains(root))
+            m_pendingRoots.Push(root);
         ATLASSERT(path.IsDirectory() || !path.Exists());
-        // set this flag while we are sync'ed
-        // with the worker thread
-        m_bItemsAddedSinceLastCrawl = true;
     }
     SetEvent(m_hWakeEvent);
 }
@@ -97,14 +126,34 @@ void CFolderCrawler::AddPathForUpdate(const CTSVNPath& path)
 {
     if (!CSVNStatusCache::Instance().IsPathGood(path))
         return;
+    CTSVNPath root = GetRootKey(path);
     {
         AutoLocker lock(m_critSec);
-        m_pathsToUpdate.Push(path);
-        m_bPathsAddedSinceLastCrawl = true;
+
+        RootQueue& queue = m_roots[root];
+        size_t count = queue.pathsToUpdate.size();
+        if (queue.pathsToUpdate.Push(path) > count)
+            InterlockedIncrement(&m_lQueuedCount);
+        if (!queue.busy && !m_pendingRoots.contains(root))
+            m_pendingRoots.Push(root);
     }
     SetEvent(m_hWakeEvent);
 }
 
+void CFolderCrawler::EraseRequest(const CTSVNPath& root, const CTSVNPath& path, bool isFolder)
+{
+    AutoLocker lock(m_critSec);
+
+    RootQueueMap::iterator it = m_roots.find(root);
+    if (it == m_roots.end())
+        return;
+
+    PathQueue& queue = isFolder ? it->second.foldersToUpdate : it->second.pathsToUpdate;
+    size_t count = queue.size();
+    if (queue.erase(path) < count)
+        InterlockedDecrement(&m_lQueuedCount);
+}
+
 unsigned int CFolderCrawler::ThreadEntry(void* pContext)
 {
     CCrashReportThread crashthread;
@@ -117,12 +166,14 @@ void CFolderCrawler::WorkerThread()
     HANDLE hWaitHandles[2];
     hWaitHandles[0] = m_hTerminationEvent;
     hWaitHandles[1] = m_hWakeEvent;
+    CTSVNPath root;
     CTSVNPath workingPath;
+    bool isFolder = false;
+    DWORD waitTime = INFINITE;
 
     for(;;)
     {
-        bool bRecursive = !!(DWORD)CRegStdDWORD(L"Software\\TortoiseSVN\\RecursiveOverlay", TRUE);
-        DWORD waitResult = WaitForMultipleObjects(_countof(hWaitHandles), hWaitHandles, FALSE, INFINITE);
+        DWORD waitResult = WaitForMultipleObjects(_countof(hWaitHandles), hWaitHandles, FALSE, waitTime);
 
         // exit event/working loop if the first event (m_hTerminationEvent)
         // has been signaled or if one of the events has been abandoned
@@ -132,275 +183,390 @@ void CFolderCrawler::WorkerThread()
             // Termination event
             break;
         }
-        CTraceToOutputDebugString::Instance()(__FUNCTION__ ": FolderCrawler.cpp: waking up crawler\n");
+        m_bRecursive = !!(DWORD)CRegStdDWORD(L"Software\\TortoiseSVN\\RecursiveOverlay", TRUE);
+
+        if (waitResult == WAIT_OBJECT_0+1)
+        {
+            // If we get here, we've been woken up by something being added to the queue.
+            // Give the notifications of bulk changes a moment to arrive.
+            CTraceToOutputDebugString::Instance()(__FUNCTION__ ": FolderCrawler.cpp: waking up crawler\n");
+            if (WaitForSingleObject(m_hTerminationEvent, 20) == WAIT_OBJECT_0)
+                break;
+        }
 
-        // If we get here, we've been woken up by something being added to the queue.
-        // However, it's important that we don't do our crawling while
-        // the shell is still asking for items
-        //
-        bool bFirstRunAfterWakeup = true;
         SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
         OnOutOfScope(SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END));
         for (;;)
         {
+            waitTime = INFINITE;
             if (!m_bRun)
                 break;
-            if (IsHoldOff())
-            {
-                Sleep(2000);
-                continue;
-            }
+
+            // it's important that we don't do our crawling while
+            // the shell is still asking for items
+            waitTime = GetWaitTime();
+            if (waitTime != 0)
+                break;
+
             // Any locks today?
             if (CSVNStatusCache::Instance().m_bClearMemory)
             {
                 CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
-                CSVNStatusCache::Instance().ClearCache();
-                CSVNStatusCache::Instance().m_bClearMemory = false;
-            }
-            if(m_lCrawlInhibitSet > 0)
-            {
-                // We're in crawl hold-off
-                Sleep(200);
-                continue;
-            }
-            if (bFirstRunAfterWakeup)
-            {
-                Sleep(20);
-                bFirstRunAfterWakeup = false;
-                continue;
-            }
-            if ((m_blockReleasesAt < GetTickCount64())&&(!m_blockedPath.IsEmpty()))
-            {
-                m_blockedPath.Reset();
+                if (CSVNStatusCache::Instance().m_bClearMemory)
+                {
+                    CSVNStatusCache::Instance().ClearCache();
+                    CSVNStatusCache::Instance().m_bClearMemory = false;
+                }
             }
             CSVNStatusCache::Instance().RemoveTimedoutBlocks();
 
-            if ((m_foldersToUpdate.size() == 0)&&(m_pathsToUpdate.size() == 0))
+            if (!TakeNextRequest(root, workingPath, isFolder))
             {
-                // Nothing left to do
+                // Nothing left to do for us. Either the queues are empty, other
+                // workers will wake us up when releasing their roots or we
+                // have to wait for the blocked path to be released.
+                waitTime = INFINITE;
+                AutoLocker lock(m_critSec);
+                ULONGLONG now = GetTickCount64();
+                if ((m_lQueuedCount > 0) && !m_blockedPath.IsEmpty() && (m_blockReleasesAt > now))
+                    waitTime = (DWORD)(m_blockReleasesAt - now);
                 break;
             }
-            if (m_pathsToUpdate.size())
-            {
-                {
-                    AutoLocker lock(m_critSec);
 
-                    m_bPathsAddedSinceLastCrawl = false;
+            if (isFolder)
+                CrawlFolder(root, workingPath);
+            else
+                CrawlPath(root, workingPath);
+
+            ReleaseRoot(root);
+        }
+    }
+    _endthread();
+}
+
+DWORD CFolderCrawler::GetWaitTime() const
+{
+    // CCrawlInhibitor will wake us up when released
+    if (m_lCrawlInhibitSet > 0)
+        return INFINITE;
+
+    LONGLONG remaining = m_crawlHoldoffReleasesAt - (LONGLONG)GetTickCount64();
+    return remaining > 0 ? (DWORD)remaining : 0;
+}
 
-                    workingPath = m_pathsToUpdate.Pop();
-                    if ((!m_blockedPath.IsEmpty())&&(m_blockedPath.IsAncestorOf(workingPath)))
+bool CFolderCrawler::TakeRecentlyAsked(RootQueue& queue, const CTSVNPath& recentPath, CTSVNPath& workingPath, bool& isFolder)
+{
+    bool bBlocked = !m_blockedPath.IsEmpty();
+    if (bBlocked && m_blockedPath.IsAncestorOf(recentPath))
+        return false;
+
+    if (queue.pathsToUpdate.contains(recentPath))
+    {
+        queue.pathsToUpdate.erase(recentPath);
+        workingPath = recentPath;
+        isFolder = false;
+        return true;
+    }
+
+    // the folder itself or the closest parent folder that needs crawling
+    for (CTSVNPath folder = recentPath; !folder.IsEmpty(); folder = folder.GetContainingDirectory())
+    {
+        if (queue.foldersToUpdate.contains(folder))
+        {
+            queue.foldersToUpdate.erase(folder);
+            workingPath = CTSVNPath(folder.GetWinPath());
+            isFolder = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CFolderCrawler::TakeNextRequest(CTSVNPath& root, CTSVNPath& workingPath, bool& isFolder)
+{
+    // prefer the working copy the shell asked about most recently
+    CTSVNPath recentPath = CSVNStatusCache::Instance().GetMostRecentAskedPath();
+    CTSVNPath recentRoot = recentPath.IsEmpty() ? CTSVNPath() : GetRootKey(recentPath);
+
+    AutoLocker lock(m_critSec);
+
+    if ((m_blockReleasesAt < GetTickCount64())&&(!m_blockedPath.IsEmpty()))
+    {
+        m_blockedPath.Reset();
+    }
+    bool bBlocked = !m_blockedPath.IsEmpty();
+
+    workingPath.Reset();
+    RootQueueMap::iterator it = m_roots.end();
+    if (!recentRoot.IsEmpty())
+    {
+        it = m_roots.find(recentRoot);
+        if ((it != m_roots.end()) && (it->second.busy || !TakeRecentlyAsked(it->second, recentPath, workingPath, isFolder)))
+            it = m_roots.end();
+    }
+
+    // take the next request of the roots in turn
+
+    for (size_t attempts = m_pendingRoots.size(); (it == m_roots.end()) && (attempts > 0); --attempts)
+    {
+        CTSVNPath candidate = m_pendingRoots.Pop();
+        it = m_roots.find(candidate);
+        if (it == m_roots.end())
+            continue;
+
+        if (!bBlocked || !m_blockedPath.IsAncestorOf(candidate))
+        {
+            // process changed paths before crawling folders,
+            // but skip the ones that are blocked
+            PathQueue* queues[] = { &it->second.pathsToUpdate, &it->second.foldersToUpdate };
+            for (int i = 0; i < _countof(queues); ++i)
+            {
+                PathQueue& queue = *queues[i];
+                for (size_t count = queue.size(); count > 0; --count)
+                {
+                    CTSVNPath path = queue.Pop();
+                    if (bBlocked && m_blockedPath.IsAncestorOf(path))
                     {
                         // move the path to the end of the list
-                        m_pathsToUpdate.Push(workingPath);
-                        if (m_pathsToUpdate.size() < 3)
-                            Sleep(200);
+                        queue.Push(path);
                         continue;
                     }
+
+                    // create a new CTSVNPath object for folders to make sure the cached flags
+                    // are requested again. Without this, a missing file/folder is still treated
+                    // as missing even if it is available now when crawling.
+                    isFolder = (i == 1);
+                    workingPath = isFolder ? CTSVNPath(path.GetWinPath()) : path;
+                    break;
                 }
-                // don't crawl paths that are excluded
-                if (!CSVNStatusCache::Instance().IsPathAllowed(workingPath))
-                    continue;
-                if (!CSVNStatusCache::Instance().IsPathGood(workingPath))
-                    continue;
-                // check if the changed path is inside an .svn folder
-                if ((workingPath.IsDirectory() && (SVNHelper::IsVersioned(workingPath, true))) || workingPath.IsAdminDir())
-                {
-                    // we don't crawl for paths changed in a tmp folder inside an .svn folder.
-                    // Because we also get notifications for those even if we just ask for the status!
-                    // And changes there don't affect the file status at all, so it's safe
-                    // to ignore notifications on those paths.
-                    if (workingPath.IsAdminDir())
-                    {
-                        CString lowerpath = workingPath.GetWinPathString();
-                        lowerpath.MakeLower();
-                        if (lowerpath.Find(L"\\wc.db-journal")>0)
-                            continue;
-                        if (lowerpath.Find(L"\\wc.db")>0)
-                        {
-                            bool changed = CSVNStatusCache::Instance().WCRoots()->NotifyChange(workingPath);
-                            // do nothing if the file hasn't really changed
-                            // this is required to avoid an endless loop because of some virus scanners:
-                            // McAfee opens files to scan and triggers a change notification, but then restores
-                            // the last-modified-time of the file. We can detect this here: if the file time
-                            // did not change, then the notification was due to a virus scanner or some other
-                            // 'security' tool.
-                            if (!changed)
-                                continue;
-                        }
-                    }
-                    else if (!workingPath.Exists())
-                    {
-                        CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
-                        CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
-                        continue;
-                    }
+                if (!workingPath.IsEmpty())
+                    break;
+            }
+        }
 
-                    do
-                    {
-                        workingPath = workingPath.GetContainingDirectory();
-                    } while(workingPath.IsAdminDir());
+        if (workingPath.IsEmpty())
+        {
+            // nothing to do here right now
+            m_pendingRoots.Push(candidate);
+            it = m_roots.end();
+        }
+    }
 
-                    {
-                        AutoLocker print(critSec);
-                        _sntprintf_s(szCurrentCrawledPath[nCurrentCrawledpathIndex], MAX_CRAWLEDPATHSLEN, _TRUNCATE, L"Invalidating and refreshing folder: %s", workingPath.GetWinPath());
-                        nCurrentCrawledpathIndex++;
-                        if (nCurrentCrawledpathIndex >= MAX_CRAWLEDPATHS)
-                            nCurrentCrawledpathIndex = 0;
-                        CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": Invalidating/refreshing folder %s\n", workingPath.GetWinPath());
-                    }
-                    InvalidateRect(hWndHidden, NULL, FALSE);
-                    {
-                        CAutoReadLock readLock(CSVNStatusCache::Instance().GetGuard());
-                        // Invalidate the cache of this folder, to make sure its status is fetched again.
-                        CCachedDirectory * pCachedDir = CSVNStatusCache::Instance().GetDirectoryCacheEntry(workingPath);
-                        if (pCachedDir)
-                        {
-                            svn_wc_status_kind status = pCachedDir->GetCurrentFullStatus();
-                            pCachedDir->Invalidate();
-                            if (workingPath.Exists())
-                            {
-                                pCachedDir->RefreshStatus(bRecursive);
-                                // if the previous status wasn't normal and now it is, then
-                                // send a notification too.
-                                // We do this here because GetCurrentFullStatus() doesn't send
-                                // notifications for 'normal' status - if it would, we'd get tons
-                                // of notifications when crawling a working copy not yet in the cache.
-                                if ((status != svn_wc_status_normal)&&(pCachedDir->GetCurrentFullStatus() != status))
-                                {
-                                    CSVNStatusCache::Instance().UpdateShell(workingPath);
-                                }
-                            }
-                            else
-                            {
-                                CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
-                                CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
-                            }
-                        }
-                    }
-                    //In case that svn_client_stat() modified a file and we got
-                    //a notification about that in the directory watcher,
-                    //remove that here again - this is to prevent an endless loop
-                    AutoLocker lock(m_critSec);
-                    m_pathsToUpdate.erase(workingPath);
-                }
-                else if (SVNHelper::IsVersioned(workingPath, true))
+    if (it == m_roots.end())
+        return false;
+
+    root = it->first;
+    it->second.busy = true;
+    m_pendingRoots.erase(root);
+    InterlockedDecrement(&m_lQueuedCount);
+
+    // there is more work another worker could do
+    if (m_pendingRoots.size())
+        SetEvent(m_hWakeEvent);
+
+    return true;
+}
+
+void CFolderCrawler::ReleaseRoot(const CTSVNPath& root)
+{
+    AutoLocker lock(m_critSec);
+
+    RootQueueMap::iterator it = m_roots.find(root);
+    if (it == m_roots.end())
+        return;
+
+    it->second.busy = false;
+    if (it->second.pathsToUpdate.size() + it->second.foldersToUpdate.size() == 0)
+    {
+        m_roots.erase(it);
+    }
+    else
+    {
+        m_pendingRoots.Push(root);
+        if (m_pendingRoots.size() > 1)
+            SetEvent(m_hWakeEvent);
+    }
+}
+
+void CFolderCrawler::CrawlPath(const CTSVNPath& root, CTSVNPath workingPath)
+{
+    // don't crawl paths that are excluded
+    if (!CSVNStatusCache::Instance().IsPathAllowed(workingPath))
+        return;
+    if (!CSVNStatusCache::Instance().IsPathGood(workingPath))
+        return;
+    // check if the changed path is inside an .svn folder
+    if ((workingPath.IsDirectory() && (SVNHelper::IsVersioned(workingPath, true))) || workingPath.IsAdminDir())
+    {
+        // we don't crawl for paths changed in a tmp folder inside an .svn folder.
+        // Because we also get notifications for those even if we just ask for the status!
+        // And changes there don't affect the file status at all, so it's safe
+        // to ignore notifications on those paths.
+        if (workingPath.IsAdminDir())
+        {
+            CString lowerpath = workingPath.GetWinPathString();
+            lowerpath.MakeLower();
+            if (lowerpath.Find(L"\\wc.db-journal")>0)
+                return;
+            if (lowerpath.Find(L"\\wc.db")>0)
+            {
+                bool changed = CSVNStatusCache::Instance().WCRoots()->NotifyChange(workingPath);
+                // do nothing if the file hasn't really changed
+                // this is required to avoid an endless loop because of some virus scanners:
+                // McAfee opens files to scan and triggers a change notification, but then restores
+                // the last-modified-time of the file. We can detect this here: if the file time
+                // did not change, then the notification was due to a virus scanner or some other
+                // 'security' tool.
+                if (!changed)
+                    return;
+            }
+        }
+        else if (!workingPath.Exists())
+        {
+            CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
+            CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
+            return;
+        }
+
+        do
+        {
+            workingPath = workingPath.GetContainingDirectory();
+        } while(workingPath.IsAdminDir());
+
+        {
+            AutoLocker print(critSec);
+            _sntprintf_s(szCurrentCrawledPath[nCurrentCrawledpathIndex], MAX_CRAWLEDPATHSLEN, _TRUNCATE, L"Invalidating and refreshing folder: %s", workingPath.GetWinPath());
+            nCurrentCrawledpathIndex++;
+            if (nCurrentCrawledpathIndex >= MAX_CRAWLEDPATHS)
+                nCurrentCrawledpathIndex = 0;
+            CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": Invalidating/refreshing folder %s\n", workingPath.GetWinPath());
+        }
+        InvalidateRect(hWndHidden, NULL, FALSE);
+        {
+            CAutoReadLock readLock(CSVNStatusCache::Instance().GetGuard());
+            // Invalidate the cache of this folder, to make sure its status is fetched again.
+            CCachedDirectory * pCachedDir = CSVNStatusCache::Instance().GetDirectoryCacheEntry(workingPath);
+            if (pCachedDir)
+            {
+                svn_wc_status_kind status = pCachedDir->GetCurrentFullStatus();
+                pCachedDir->Invalidate();
+                if (workingPath.Exists())
                 {
-                    if (!workingPath.Exists())
+                    pCachedDir->RefreshStatus(m_bRecursive);
+                    // if the previous status wasn't normal and now it is, then
+                    // send a notification too.
+                    // We do this here because GetCurrentFullStatus() doesn't send
+                    // notifications for 'normal' status - if it would, we'd get tons
+                    // of notifications when crawling a working copy not yet in the cache.
+                    if ((status != svn_wc_status_normal)&&(pCachedDir->GetCurrentFullStatus() != status))
                     {
-                        CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
-                        CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
-                        if (!workingPath.GetContainingDirectory().Exists())
-                            continue;
-                        else
-                            workingPath = workingPath.GetContainingDirectory();
+                        CSVNStatusCache::Instance().UpdateShell(workingPath);
                     }
-                    {
-                        AutoLocker print(critSec);
-                        _sntprintf_s(szCurrentCrawledPath[nCurrentCrawledpathIndex], MAX_CRAWLEDPATHSLEN, _TRUNCATE, L"Updating path: %s", workingPath.GetWinPath());
-                        nCurrentCrawledpathIndex++;
-                        if (nCurrentCrawledpathIndex >= MAX_CRAWLEDPATHS)
-                            nCurrentCrawledpathIndex = 0;
-                        CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": updating path %s\n", workingPath.GetWinPath());
-                    }
-                    InvalidateRect(hWndHidden, NULL, FALSE);
-                    {
-                        CAutoReadLock readLock(CSVNStatusCache::Instance().GetGuard());
-                        // Invalidate the cache of folders manually. The cache of files is invalidated
-                        // automatically if the status is asked for it and the file times don't match
-                        // anymore, so we don't need to manually invalidate those.
-                        CCachedDirectory * cachedDir = CSVNStatusCache::Instance().GetDirectoryCacheEntry(workingPath.GetDirectory());
-                        if (cachedDir && workingPath.IsDirectory())
-                        {
-                            cachedDir->Invalidate();
-                        }
-                        if (cachedDir && cachedDir->GetStatusForMember(workingPath, bRecursive).GetEffectiveStatus() > svn_wc_status_unversioned)
-                        {
-                            CSVNStatusCache::Instance().UpdateShell(workingPath);
-                        }
-                    }
-                    AutoLocker lock(m_critSec);
-                    m_pathsToUpdate.erase(workingPath);
                 }
                 else
                 {
-                    if (!workingPath.Exists())
-                    {
-                        CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
-                        CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
-                    }
+                    CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
+                    CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
                 }
             }
-            if (m_foldersToUpdate.size())
+        }
+        //In case that svn_client_stat() modified a file and we got
+        //a notification about that in the directory watcher,
+        //remove that here again - this is to prevent an endless loop
+        EraseRequest(root, workingPath, false);
+    }
+    else if (SVNHelper::IsVersioned(workingPath, true))
+    {
+        if (!workingPath.Exists())
+        {
+            CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
+            CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
+            if (!workingPath.GetContainingDirectory().Exists())
+                return;
+            else
+                workingPath = workingPath.GetContainingDirectory();
+        }
+        {
+            AutoLocker print(critSec);
+            _sntprintf_s(szCurrentCrawledPath[nCurrentCrawledpathIndex], MAX_CRAWLEDPATHSLEN, _TRUNCATE, L"Updating path: %s", workingPath.GetWinPath());
+            nCurrentCrawledpathIndex++;
+            if (nCurrentCrawledpathIndex >= MAX_CRAWLEDPATHS)
+                nCurrentCrawledpathIndex = 0;
+            CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": updating path %s\n", workingPath.GetWinPath());
+        }
+        InvalidateRect(hWndHidden, NULL, FALSE);
+        {
+            CAutoReadLock readLock(CSVNStatusCache::Instance().GetGuard());
+            // Invalidate the cache of folders manually. The cache of files is invalidated
+            // automatically if the status is asked for it and the file times don't match
+            // anymore, so we don't need to manually invalidate those.
+            CCachedDirectory * cachedDir = CSVNStatusCache::Instance().GetDirectoryCacheEntry(workingPath.GetDirectory());
+            if (cachedDir && workingPath.IsDirectory())
+            {
+                cachedDir->Invalidate();
+            }
+            if (cachedDir && cachedDir->GetStatusForMember(workingPath, m_bRecursive).GetEffectiveStatus() > svn_wc_status_unversioned)
             {
-                {
-                    AutoLocker lock(m_critSec);
-
-                    m_bItemsAddedSinceLastCrawl = false;
-
-                    // create a new CTSVNPath object to make sure the cached flags are requested again.
-                    // without this, a missing file/folder is still treated as missing even if it is available
-                    // now when crawling.
-                    workingPath = CTSVNPath(m_foldersToUpdate.Pop().GetWinPath());
-
-                    if ((!m_blockedPath.IsEmpty())&&(m_blockedPath.IsAncestorOf(workingPath)))
-                    {
-                        // move the path to the end of the list
-                        m_foldersToUpdate.Push (workingPath);
-                        if (m_foldersToUpdate.size() < 3)
-                            Sleep(200);
-                        continue;
-                    }
-                }
-                if (!CSVNStatusCache::Instance().IsPathAllowed(workingPath))
-                    continue;
-                if (!CSVNStatusCache::Instance().IsPathGood(workingPath))
-                    continue;
+                CSVNStatusCache::Instance().UpdateShell(workingPath);
+            }
+        }
+        EraseRequest(root, workingPath, false);
+    }
+    else
+    {
+        if (!workingPath.Exists())
+        {
+            CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
+            CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
+        }
+    }
+}
 
-                {
-                    AutoLocker print(critSec);
-                    _sntprintf_s(szCurrentCrawledPath[nCurrentCrawledpathIndex], MAX_CRAWLEDPATHSLEN, _TRUNCATE, L"Crawling folder: %s", workingPath.GetWinPath());
-                    nCurrentCrawledpathIndex++;
-                    if (nCurrentCrawledpathIndex >= MAX_CRAWLEDPATHS)
-                        nCurrentCrawledpathIndex = 0;
-                    CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": Crawling folder %s\n", workingPath.GetWinPath());
-                }
-                InvalidateRect(hWndHidden, NULL, FALSE);
-                {
-                    CAutoReadLock readLock(CSVNStatusCache::Instance().GetGuard());
-                    // Now, we need to visit this folder, to make sure that we know its 'most important' status
-                    CCachedDirectory * cachedDir = CSVNStatusCache::Instance().GetDirectoryCacheEntry(workingPath.GetDirectory());
-                    // check if the path is monitored by the watcher. If it isn't, then we have to invalidate the cache
-                    // for that path and add it to the watcher.
-                    if (!CSVNStatusCache::Instance().IsPathWatched(workingPath))
-                    {
-                        if (SVNHelper::IsVersioned(workingPath, true))
-                            CSVNStatusCache::Instance().AddPathToWatch(workingPath);
-                        if (cachedDir)
-                            cachedDir->Invalidate();
-                        else
-                        {
-                            CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
-                            CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
-                            // now cacheDir is invalid because it got deleted in the RemoveCacheForPath() call above.
-                            cachedDir = NULL;
-                        }
-                    }
-                    if (cachedDir)
-                        cachedDir->RefreshStatus(bRecursive);
-                }
+void CFolderCrawler::CrawlFolder(const CTSVNPath& root, CTSVNPath workingPath)
+{
+    if (!CSVNStatusCache::Instance().IsPathAllowed(workingPath))
+        return;
+    if (!CSVNStatusCache::Instance().IsPathGood(workingPath))
+        return;
 
-                // While refreshing the status, we could get another crawl request for the same folder.
-                // This can happen if the crawled folder has a lower status than one of the child folders
-                // (recursively). To avoid double crawlings, remove such a crawl request here
-                AutoLocker lock(m_critSec);
-                if (m_bItemsAddedSinceLastCrawl)
-                {
-                    m_foldersToUpdate.erase (workingPath);
-                }
+    {
+        AutoLocker print(critSec);
+        _sntprintf_s(szCurrentCrawledPath[nCurrentCrawledpathIndex], MAX_CRAWLEDPATHSLEN, _TRUNCATE, L"Crawling folder: %s", workingPath.GetWinPath());
+        nCurrentCrawledpathIndex++;
+        if (nCurrentCrawledpathIndex >= MAX_CRAWLEDPATHS)
+            nCurrentCrawledpathIndex = 0;
+        CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": Crawling folder %s\n", workingPath.GetWinPath());
+    }
+    InvalidateRect(hWndHidden, NULL, FALSE);
+    {
+        CAutoReadLock readLock(CSVNStatusCache::Instance().GetGuard());
+        // Now, we need to visit this folder, to make sure that we know its 'most important' status
+        CCachedDirectory * cachedDir = CSVNStatusCache::Instance().GetDirectoryCacheEntry(workingPath.GetDirectory());
+        // check if the path is monitored by the watcher. If it isn't, then we have to invalidate the cache
+        // for that path and add it to the watcher.
+        if (!CSVNStatusCache::Instance().IsPathWatched(workingPath))
+        {
+            if (SVNHelper::IsVersioned(workingPath, true))
+                CSVNStatusCache::Instance().AddPathToWatch(workingPath);
+            if (cachedDir)
+                cachedDir->Invalidate();
+            else
+            {
+                CAutoWriteLock writeLock(CSVNStatusCache::Instance().GetGuard());
+                CSVNStatusCache::Instance().RemoveCacheForPath(workingPath);
+                // now cacheDir is invalid because it got deleted in the RemoveCacheForPath() call above.
+                cachedDir = NULL;
             }
         }
+        if (cachedDir)
+            cachedDir->RefreshStatus(m_bRecursive);
     }
-    _endthread();
+
+    // While refreshing the status, we could get another crawl request for the same folder.
+    // This can happen if the crawled folder has a lower status than one of the child folders
+    // (recursively). To avoid double crawlings, remove such a crawl request here
+    EraseRequest(root, workingPath, true);
 }
 
 bool CFolderCrawler::SetHoldoff(DWORD milliseconds /* = 500*/)
@@ -411,6 +577,15 @@ bool CFolderCrawler::SetHoldoff(DWORD milliseconds /* = 500*/)
     return ret;
 }
 
+void CFolderCrawler::OnInhibitReleased()
+{
+    SetHoldoff();
+
+    // the workers wait for the last inhibitor to go away
+    if ((::InterlockedDecrement(&m_lCrawlInhibitSet) == 0) && (m_lQueuedCount > 0))
+        SetEvent(m_hWakeEvent);
+}
+
 bool CFolderCrawler::IsHoldOff() const
 {
     return (((LONGLONG)GetTickCount64() - m_crawlHoldoffReleasesAt) < 0);
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005-2007, 2009-2010, 2014 TortoiseSVN
+// External Cache Copyright (C) 2005-2007, 2009-2010, 2014, 2026 TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -23,6 +23,8 @@
 #include "UniqueQueue.h"
 #include "SmartHandle.h"
 #include <set>
+#include <map>
+#include <vector>
 //////////////////////////////////////////////////////////////////////////
 
 
@@ -31,8 +33,16 @@
 
 /**
  * \ingroup TSVNCache
- * Helper class to crawl folders in the background (in a separate thread)
+ * Helper class to crawl folders in the background (in separate threads)
  * so that the main cache isn't blocked until all the status are fetched.
+ *
+ * Requests are queued per working copy root. Every root is processed by
+ * at most one worker thread at a time, so working copies are crawled in
+ * parallel without the workers competing for the same wc.db.
+ * Folders and paths the shell asked for recently get crawled first.
+ *
+ * The workers sleep until new requests arrive, the crawl hold-off
+ * expires or a blocked path gets released.
  */
 class CFolderCrawler
 {
@@ -49,14 +59,46 @@ public:
     bool IsHoldOff() const;
     void BlockPath(const CTSVNPath& path, DWORD ticks = 0);
 private:
+    typedef UniqueQueue<CTSVNPath, CTSVNPath::HashNoCase, CTSVNPath::EqualNoCase> PathQueue;
+
+    /// pending requests for a single working copy root
+    struct RootQueue
+    {
+        RootQueue() : busy(false) {}
+
+        PathQueue   foldersToUpdate;
+        PathQueue   pathsToUpdate;
+        bool        busy;           ///< a worker is processing this root
+    };
+    typedef std::map<CTSVNPath, RootQueue> RootQueueMap;
+
     static unsigned int __stdcall ThreadEntry(void* pContext);
     void WorkerThread();
 
+    /// returns how long the workers have to wait before crawling
+    DWORD GetWaitTime() const;
+    /// picks the next request of a root that no other worker is processing.
+    /// returns false if there is none that can be processed right now.
+    bool TakeNextRequest(CTSVNPath& root, CTSVNPath& workingPath, bool& isFolder);
+    void ReleaseRoot(const CTSVNPath& root);
+    bool TakeRecentlyAsked(RootQueue& queue, const CTSVNPath& recentPath, CTSVNPath& workingPath, bool& isFolder);
+
+    void EraseRequest(const CTSVNPath& root, const CTSVNPath& path, bool isFolder);
+
+    void CrawlPath(const CTSVNPath& root, CTSVNPath workingPath);
+    void CrawlFolder(const CTSVNPath& root, CTSVNPath workingPath);
+
+    void OnInhibitReleased();
+
+    /// the WC root or an empty path for unversioned paths
+    CTSVNPath GetRootKey(const CTSVNPath& path) const;
+
 private:
     CComAutoCriticalSection m_critSec;
-    CAutoGeneralHandle m_hThread;
-    UniqueQueue<CTSVNPath> m_foldersToUpdate;
-    UniqueQueue<CTSVNPath> m_pathsToUpdate;
+    std::vector<CAutoGeneralHandle> m_hThreads;
+    RootQueueMap m_roots;
+    PathQueue m_pendingRoots;       ///< roots with requests that are not busy
+    volatile LONG m_lQueuedCount;   ///< total number of queued requests
     CAutoGeneralHandle m_hTerminationEvent;
     CAutoGeneralHandle m_hWakeEvent;
 
@@ -70,11 +112,10 @@ private:
     // every shell request, and stops us crawling until
     // a bit of quiet time has elapsed
     LONGLONG m_crawlHoldoffReleasesAt;
-    bool m_bItemsAddedSinceLastCrawl;
-    bool m_bPathsAddedSinceLastCrawl;
 
     CTSVNPath m_blockedPath;
     ULONGLONG m_blockReleasesAt;
+    volatile bool m_bRecursive;
     bool m_bRun;
 
 
@@ -100,8 +141,7 @@ public:
     }
     ~CCrawlInhibitor()
     {
-        ::InterlockedDecrement(&m_pCrawler->m_lCrawlInhibitSet);
-        m_pCrawler->SetHoldoff();
+        m_pCrawler->OnInhibitReleased();
     }
 private:
     CFolderCrawler* m_pCrawler;
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005-2006,2008-2015, 2017 - TortoiseSVN
+// External Cache Copyright (C) 2005-2006,2008-2015, 2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -34,6 +34,11 @@
 
 #define CACHEDISKVERSION 2
 
+// how long (ms) clients may use a status from the shared status table.
+// Changes are handled by invalidating the table, this only makes sure that
+// clients still ask us every now and then, which keeps the crawler going.
+#define STATUSTABLE_ENTRY_LIFETIME 3000
+
 #ifdef _WIN64
 #define STATUSCACHEFILENAME L"\\cache64"
 #else
@@ -124,7 +129,7 @@ void CSVNStatusCache::Create()
                             if ((cacheddir->GetCurrentFullStatus() != svn_wc_status_unversioned)&&(cacheddir->GetCurrentFullStatus() != svn_wc_status_none))
                                 m_pInstance->watcher.AddPath(KeyPath, false);
 
-                            m_pInstance->m_directoryCache[KeyPath] = cacheddir.release();
+                            m_pInstance->m_directoryCache[CTSVNPathHandle(KeyPath)] = cacheddir.release();
 
                             // do *not* add the paths for crawling!
                             // because crawled paths will trigger a shell
@@ -189,7 +194,7 @@ bool CSVNStatusCache::SaveCache()
                     WRITEVALUETOFILE(value);
                     continue;
                 }
-                const CString& key = I->first.GetWinPathString();
+                const CString key = I->first.GetWinPath();
                 value = key.GetLength();
                 WRITEVALUETOFILE(value);
                 if (value)
@@ -225,6 +230,8 @@ void CSVNStatusCache::Destroy()
 
 void CSVNStatusCache::Stop()
 {
+    // let the clients use the pipe again which tells them that we're gone
+    m_statusTable.SetActive(false);
     m_svnHelp.Cancel(true);
     watcher.Stop();
     m_folderCrawler.Stop();
@@ -235,6 +242,116 @@ void CSVNStatusCache::Init()
 {
     m_folderCrawler.Initialise();
     m_shellUpdater.Initialise();
+    CreateStatusTable();
+    CreateAskedKeys();
+}
+
+void CSVNStatusCache::CreateStatusTable()
+{
+    // if clients still have the table of a previous cache instance open,
+    // we get that one. CCacheStatusTable::Create() invalidates its content.
+    m_hStatusTable = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)CCacheStatusTable::GetMemorySize(), GetCacheStatusTableName());
+    if (!m_hStatusTable)
+    {
+        CTraceToOutputDebugString::Instance()(__FUNCTION__ ": CreateFileMapping failed\n");
+        return;
+    }
+
+    m_statusTableView = MapViewOfFile(m_hStatusTable, FILE_MAP_WRITE, 0, 0, 0);
+    if (!m_statusTableView || !m_statusTable.Create(m_statusTableView))
+    {
+        CTraceToOutputDebugString::Instance()(__FUNCTION__ ": status table not available\n");
+        return;
+    }
+
+    m_statusTable.SetActive(true);
+}
+
+void CSVNStatusCache::CreateAskedKeys()
+{
+    // unlike the status table, the clients write to this one
+    m_hAskedKeys = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)CCacheAskedKeys::GetMemorySize(), GetCacheAskedKeysName());
+    if (!m_hAskedKeys)
+    {
+        CTraceToOutputDebugString::Instance()(__FUNCTION__ ": CreateFileMapping failed\n");
+        return;
+    }
+
+    m_askedKeysView = MapViewOfFile(m_hAskedKeys, FILE_MAP_WRITE, 0, 0, 0);
+    if (!m_askedKeysView || !m_askedKeys.Create(m_askedKeysView))
+    {
+        CTraceToOutputDebugString::Instance()(__FUNCTION__ ": asked keys not available\n");
+        return;
+    }
+
+    AutoLocker lock(m_critSec);
+    m_publishedPaths.resize(CCacheStatusTable::ENTRY_COUNT);
+}
+
+void CSVNStatusCache::PublishStatus(const TSVNCacheRequest& request, const TSVNCacheResponse& response, DWORD generation)
+{
+    const CCacheStatusTable::Key key = CCacheStatusTable::GetKey(request.path, request.flags);
+
+    {
+        // before publishing, so UpdateShell() can't miss the entry
+        AutoLocker lock(m_critSec);
+        const DWORD flagsBit = 1 << (request.flags & TSVNCACHE_FLAGS_MASK);
+        if ((m_publishedFlags & flagsBit) == 0)
+        {
+            // UpdateShell() may have skipped these flags while
+            // the response was being determined
+            m_publishedFlags |= flagsBit;
+            m_statusTable.Invalidate();
+        }
+        if (!m_publishedPaths.empty())
+        {
+            auto& published = m_publishedPaths[key.hash % m_publishedPaths.size()];
+            published.first = key.hash;
+            published.second = request.path;
+        }
+    }
+
+    m_statusTable.Publish(key, response, generation, GetTickCount64() + STATUSTABLE_ENTRY_LIFETIME);
+}
+
+void CSVNStatusCache::RemovePublishedStatus(const CTSVNPath& path)
+{
+    DWORD publishedFlags = 0;
+    {
+        AutoLocker lock(m_critSec);
+        publishedFlags = m_publishedFlags;
+    }
+    if (publishedFlags == 0)
+        return;
+
+    // the recursive status of the parent folders may change as well
+    for (CTSVNPath p(path); !p.IsEmpty(); p = p.GetContainingDirectory())
+    {
+        for (DWORD flags = 0; flags <= TSVNCACHE_FLAGS_MASK; ++flags)
+        {
+            if (publishedFlags & (1 << flags))
+                m_statusTable.Remove(CCacheStatusTable::GetKey(p.GetWinPath(), flags));
+        }
+    }
+}
+
+CTSVNPath CSVNStatusCache::GetMostRecentAskedPath()
+{
+    AutoLocker lock(m_critSec);
+
+    // lookups served by the status table never reach GetStatusForPath()
+    unsigned __int64 key = 0;
+    if (m_askedKeys.GetLatest(m_askedKeysSeen, key) && !m_publishedPaths.empty())
+    {
+        const auto& published = m_publishedPaths[key % m_publishedPaths.size()];
+        if (published.first == key)
+        {
+            m_mostRecentLookedUpPath.SetFromWin(published.second);
+            m_bLookedUpPathIsNewer = true;
+        }
+    }
+
+    return m_bLookedUpPathIsNewer ? m_mostRecentLookedUpPath : m_mostRecentAskedPath;
 }
 
 CSVNStatusCache::CSVNStatusCache(void)
@@ -251,6 +368,9 @@ CSVNStatusCache::CSVNStatusCache(void)
     m_NoWatchPaths[CTSVNPath(GetSpecialFolder(FOLDERID_SearchHistory))] = forever;
     m_bClearMemory = false;
     m_mostRecentExpiresAt = 0;
+    m_askedKeysSeen = 0;
+    m_publishedFlags = 0;
+    m_bLookedUpPathIsNewer = false;
 }
 
 CSVNStatusCache::~CSVNStatusCache(void)
@@ -260,6 +380,7 @@ CSVNStatusCache::~CSVNStatusCache(void)
 
 void CSVNStatusCache::Refresh()
 {
+    m_statusTable.Invalidate();
     m_shellCache.RefreshIfNeeded();
     SVNConfig::Instance().Refresh();
     if (!m_pInstance->m_directoryCache.empty())
@@ -271,7 +392,7 @@ void CSVNStatusCache::Refresh()
                 I->second->RefreshMostImportant();
             else
             {
-                CSVNStatusCache::Instance().RemoveCacheForPath(I->first);
+                CSVNStatusCache::Instance().RemoveCacheForPath(I->first.GetPath());
                 I = m_pInstance->m_directoryCache.begin();
                 if (I == m_pInstance->m_directoryCache.end())
                     break;
@@ -393,11 +514,13 @@ bool CSVNStatusCache::RemoveTimedoutBlocks()
 
 void CSVNStatusCache::UpdateShell(const CTSVNPath& path)
 {
+    RemovePublishedStatus(path);
     m_shellUpdater.AddPathForUpdate(path);
 }
 
 void CSVNStatusCache::ClearCache()
 {
+    m_statusTable.Invalidate();
     CAutoWriteLock writeLock(m_guard);
     for (CCachedDirectory::CachedDirMap::iterator I = m_directoryCache.begin(); I != m_directoryCache.end(); ++I)
     {
@@ -429,18 +552,21 @@ bool CSVNStatusCache::RemoveCacheForDirectory(CCachedDirectory * cdir)
         }
     }
     cdir->m_childDirectories.clear();
-    m_directoryCache.erase(cdir->m_directoryPath);
+    CTSVNPathHandle dirHandle = CTSVNPathHandle::FindNoCase(cdir->m_directoryPath);
+    CCachedDirectory::ItDir itMap = FindDirectory(dirHandle);
+    if (itMap != m_directoryCache.end())
+        m_directoryCache.erase(itMap);
 
     // we could have entries versioned and/or stored in our cache which are
     // children of the specified directory, but not in the m_childDirectories
     // member: this can happen for nested layouts or if we fetched the status
     // while e.g., an update/checkout was in progress
-    CCachedDirectory::ItDir itMap = m_directoryCache.lower_bound(cdir->m_directoryPath);
+    itMap = m_directoryCache.lower_bound(dirHandle);
     do
     {
         if (itMap != m_directoryCache.end())
         {
-            if (cdir->m_directoryPath.IsAncestorOf(itMap->first))
+            if (dirHandle.IsAncestorOfNoCase(itMap->first))
             {
                 // just in case (see issue #255)
                 if (itMap->second == cdir)
@@ -451,32 +577,46 @@ bool CSVNStatusCache::RemoveCacheForDirectory(CCachedDirectory * cdir)
                     RemoveCacheForDirectory(itMap->second);
             }
         }
-        itMap = m_directoryCache.lower_bound(cdir->m_directoryPath);
-    } while (itMap != m_directoryCache.end() && cdir->m_directoryPath.IsAncestorOf(itMap->first));
+        itMap = m_directoryCache.lower_bound(dirHandle);
+    } while (itMap != m_directoryCache.end() && dirHandle.IsAncestorOfNoCase(itMap->first));
 
     CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": removed from cache %s\n", cdir->m_directoryPath.GetWinPath());
     delete cdir;
     return true;
 }
 
+CCachedDirectory::ItDir CSVNStatusCache::FindDirectory(const CTSVNPathHandle& handle)
+{
+    // paths that were never interned can't be in the map
+    return handle.IsValid()
+        ? m_directoryCache.find(handle)
+        : m_directoryCache.end();
+}
+
+CCachedDirectory::ItDir CSVNStatusCache::FindDirectory(const CTSVNPath& path)
+{
+    return FindDirectory(CTSVNPathHandle::FindNoCase(path));
+}
+
 void CSVNStatusCache::RemoveCacheForPath(const CTSVNPath& path)
 {
     // Stop the crawler starting on a new folder
     CCrawlInhibitor crawlInhibit(&m_folderCrawler);
-    CCachedDirectory::ItDir itMap = m_directoryCache.find(path);
+    CCachedDirectory::ItDir itMap = FindDirectory(path);
 
     CCachedDirectory * dirtoremove = NULL;
     if ((itMap != m_directoryCache.end())&&(itMap->second))
         dirtoremove = itMap->second;
     if (dirtoremove == NULL)
         return;
+    m_statusTable.Invalidate();
     ATLASSERT(path.IsEquivalentToWithoutCase(dirtoremove->m_directoryPath));
     RemoveCacheForDirectory(dirtoremove);
 }
 
 CCachedDirectory * CSVNStatusCache::GetDirectoryCacheEntry(const CTSVNPath& path)
 {
-    CCachedDirectory::ItDir itMap = m_directoryCache.find(path);
+    CCachedDirectory::ItDir itMap = FindDirectory(path);
     if ((itMap != m_directoryCache.end())&&(itMap->second))
     {
         // We've found this directory in the cache
@@ -493,7 +633,7 @@ CCachedDirectory * CSVNStatusCache::GetDirectoryCacheEntry(const CTSVNPath& path
         // Since above there's a small chance that before we can upgrade to
         // writer state some other thread gained writer state and changed
         // the data, we have to recreate the iterator here again.
-        itMap = m_directoryCache.find(path);
+        itMap = FindDirectory(path);
         if (itMap!=m_directoryCache.end())
         {
             delete itMap->second;
@@ -514,12 +654,13 @@ CCachedDirectory * CSVNStatusCache::GetDirectoryCacheEntry(const CTSVNPath& path
                 auto newcdir = std::make_unique<CCachedDirectory>(path);
                 if (newcdir.get())
                 {
-                    itMap = m_directoryCache.lower_bound (path);
+                    CTSVNPathHandle handle(path);
+                    itMap = m_directoryCache.lower_bound (handle);
                     ASSERT (   (itMap == m_directoryCache.end())
                             || (itMap->path != path));
 
                     itMap = m_directoryCache.insert
-                        (itMap, std::make_pair (path, newcdir.release()));
+                        (itMap, std::make_pair (handle, newcdir.release()));
                     if (!path.IsEmpty())
                         CSVNStatusCache::Instance().AddFolderForCrawling(path);
 
@@ -534,7 +675,7 @@ CCachedDirectory * CSVNStatusCache::GetDirectoryCacheEntry(const CTSVNPath& path
 
 CCachedDirectory * CSVNStatusCache::GetDirectoryCacheEntryNoCreate(const CTSVNPath& path)
 {
-    CCachedDirectory::ItDir itMap = m_directoryCache.find(path);
+    CCachedDirectory::ItDir itMap = FindDirectory(path);
     if(itMap != m_directoryCache.end())
     {
         // We've found this directory in the cache
@@ -560,6 +701,7 @@ CStatusCacheEntry CSVNStatusCache::GetStatusForPath(const CTSVNPath& path, DWORD
         AutoLocker lock(m_critSec);
         m_mostRecentAskedPath = path;
         m_mostRecentExpiresAt = now+1000;
+        m_bLookedUpPathIsNewer = false;
     }
 
     if (m_shellCache.IsPathAllowed(path.GetWinPath()))
@@ -599,7 +741,7 @@ CStatusCacheEntry CSVNStatusCache::GetStatusForPath(const CTSVNPath& path, DWORD
         {
             // path is blocked for some reason: return the cached status if we have one
             // we do here only a cache search, absolutely no disk access is allowed!
-            CCachedDirectory::ItDir itMap = m_directoryCache.find(path);
+            CCachedDirectory::ItDir itMap = FindDirectory(path);
             if ((itMap != m_directoryCache.end())&&(itMap->second))
             {
                 // We've found this directory in the cache
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2005-2006, 2013-2014 - TortoiseSVN
+// Copyright (C) 2005-2006, 2013-2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -27,6 +27,8 @@
 #include "ShellUpdater.h"
 #include "WCRoots.h"
 #include "ReaderWriterLock.h"
+#include "CacheInterface.h"
+#include "SmartHandle.h"
 #include <atlcoll.h>
 
 //////////////////////////////////////////////////////////////////////////
@@ -94,12 +96,29 @@ public:
     bool RemoveTimedoutBlocks();
 
     CWCRoots * WCRoots() { return &m_wcRoots; }
+    /// The path the shell asked for most recently, through the pipe
+    /// or through the status table.
+    CTSVNPath GetMostRecentAskedPath();
 
     CReaderWriterLock& GetGuard() { return m_guard; }
+
+    /// The responses shared with the clients. The entries of a path
+    /// and its parents get removed when its status changes.
+    CCacheStatusTable& GetStatusTable() { return m_statusTable; }
+    /// Adds \a response to the status table. \a generation must have
+    /// been taken from it before the response has been determined.
+    void PublishStatus(const TSVNCacheRequest& request, const TSVNCacheResponse& response, DWORD generation);
     bool m_bClearMemory;
 private:
     bool RemoveCacheForDirectory(CCachedDirectory * cdir);
+    /// case insensitive lookup without interning \a path
+    CCachedDirectory::ItDir FindDirectory(const CTSVNPathHandle& handle);
+    CCachedDirectory::ItDir FindDirectory(const CTSVNPath& path);
     static CString GetSpecialFolder(REFKNOWNFOLDERID rfid);
+    void CreateStatusTable();
+    void CreateAskedKeys();
+    /// removes the published responses for \a path and its parents
+    void RemovePublishedStatus(const CTSVNPath& path);
     CReaderWriterLock   m_guard;
     CAtlList<CString> m_askedList;
     CCachedDirectory::CachedDirMap m_directoryCache;
@@ -123,5 +142,20 @@ private:
 
     CDirectoryWatcher watcher;
 
+    CAutoGeneralHandle m_hStatusTable;
+    CAutoViewOfFile m_statusTableView;
+    CCacheStatusTable m_statusTable;
+
+    /// keys the clients found in the status table, plus the paths
+    /// of the published keys, one per status table slot
+    CAutoGeneralHandle m_hAskedKeys;
+    CAutoViewOfFile m_askedKeysView;
+    CCacheAskedKeys m_askedKeys;
+    DWORD m_askedKeysSeen;
+    std::vector<std::pair<unsigned __int64, CString>> m_publishedPaths;
+    DWORD m_publishedFlags;         ///< bit n set: responses for flags n have been published
+    CTSVNPath m_mostRecentLookedUpPath;
+    bool m_bLookedUpPathIsNewer;
+
     friend class CCachedDirectory;  // Needed for access to the SVN helpers
 };
@@ -0,0 +1,449 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// External Cache Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <type_traits>
+
+/**
+ * \ingroup TSVNCache
+ * A fixed-size table of status responses (\c T) in a memory block that
+ * the cache shares with its clients. The cache is the only process that
+ * writes to the table, the clients only read from it.
+ *
+ * Every slot is protected by a sequence counter (seqlock): writers make
+ * it odd while they update the slot. Readers do not retry but report a
+ * miss if the counter was odd or changed while they read the slot. Hence
+ * readers never block and never write to the shared memory, so they may
+ * map it read-only. All shared data consists of 32 bit atomics which are
+ * lock-free and address-free on all supported platforms.
+ *
+ * Slots are addressed directly by key, i.e. newer entries replace older
+ * ones with a colliding key. A key consists of two independent hashes of
+ * the request, so a lookup for a different path practically never
+ * returns a foreign entry.
+ *
+ * Entries expire after the time given by the writer. The writer can
+ * remove single entries with Remove() or all of them with Invalidate().
+ * Both use a common clock (the generation): an entry is not published if
+ * its value has been determined before a removal hit its slot.
+ *
+ * The class knows nothing about how the memory block gets created and
+ * mapped, so the protocol does not depend on any OS API.
+ */
+template <class T>
+class CSharedStatusTable
+{
+public:
+
+    enum
+    {
+        ENTRY_COUNT = 4096
+    };
+
+    struct Key
+    {
+        uint64_t hash;          ///< selects the slot, never 0
+        uint64_t check;         ///< independent of \c hash
+    };
+
+    CSharedStatusTable() : m_layout(nullptr) {}
+
+    /// size of the memory block to share
+    static size_t GetMemorySize() { return sizeof(Layout); }
+
+    /// writer: prepares the zero-initialized or previously used \c memory.
+    /// Returns false, if the block has been set up with a different layout.
+    bool Create(void* memory)
+    {
+        Layout* layout = static_cast<Layout*>(memory);
+        uint32_t magic = layout->magic.load(std::memory_order_acquire);
+        if (magic == 0)
+        {
+            layout->size.store(sizeof(Layout), std::memory_order_relaxed);
+            layout->magic.store(MAGIC, std::memory_order_release);
+        }
+        else if ((magic != MAGIC) || (layout->size.load(std::memory_order_relaxed) != sizeof(Layout)))
+        {
+            return false;
+        }
+
+        // entries of a previous writer are not valid for us
+        m_layout = layout;
+        Invalidate();
+        return true;
+    }
+
+    /// reader: uses the block \c memory set up by the writer.
+    /// Returns false, if the block has not been set up (properly).
+    bool Attach(const void* memory)
+    {
+        Layout* layout = static_cast<Layout*>(const_cast<void*>(memory));
+        if (   (layout->magic.load(std::memory_order_acquire) != MAGIC)
+            || (layout->size.load(std::memory_order_relaxed) != sizeof(Layout)))
+            return false;
+
+        m_layout = layout;
+        return true;
+    }
+
+    bool IsAttached() const { return m_layout != nullptr; }
+
+    /// writer: readers will only find entries while the table is active
+    void SetActive(bool active)
+    {
+        if (m_layout)
+            m_layout->active.store(active ? 1 : 0, std::memory_order_release);
+    }
+
+    /// writer: pass the result to Publish() for data fetched from now on
+    uint32_t GetGeneration() const
+    {
+        return m_layout ? m_layout->generation.load(std::memory_order_acquire) : 0;
+    }
+
+    /// writer: makes all current entries invalid
+    void Invalidate()
+    {
+        if (m_layout)
+        {
+            const uint32_t generation = m_layout->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+            m_layout->validFrom.store(generation, std::memory_order_release);
+        }
+    }
+
+    /// writer: makes the entry for \c key invalid. Data for \c key that
+    /// has been determined before this call will not be published.
+    void Remove(const Key& key)
+    {
+        if (m_layout == nullptr)
+            return;
+
+        Entry& entry = GetEntry(key);
+        const uint32_t generation = m_layout->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+        entry.removedAt.store(generation, std::memory_order_seq_cst);
+
+        // a concurrent Publish() either sees the new removedAt or
+        // finishes before we get the slot
+        const uint32_t sequence = Lock(entry, true);
+        if ((Load(entry.key) == key.hash) && (Load(entry.check) == key.check))
+            Store(entry.key, 0);
+        entry.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /// writer: adds or replaces the entry for \c key. \c generation must have
+    /// been taken before \c value has been determined. The entry expires when
+    /// the reader's clock reaches \c expiresAt.
+    void Publish(const Key& key, const T& value, uint32_t generation, uint64_t expiresAt)
+    {
+        if (m_layout == nullptr)
+            return;
+
+        Entry& entry = GetEntry(key);
+
+        // another thread is writing to that slot -> this is just a cache
+        const uint32_t sequence = Lock(entry, false);
+        if (sequence & 1)
+            return;
+
+        if (IsOlder(generation, entry.removedAt.load(std::memory_order_seq_cst)))
+        {
+            entry.sequence.store(sequence, std::memory_order_release);
+            return;
+        }
+
+        uint32_t words[VALUE_WORDS] = { 0 };
+        memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < VALUE_WORDS; ++i)
+            entry.value[i].store(words[i], std::memory_order_relaxed);
+
+        Store(entry.key, key.hash);
+        Store(entry.check, key.check);
+        Store(entry.expiresAt, expiresAt);
+        entry.generation.store(generation, std::memory_order_relaxed);
+
+        entry.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /// reader: returns true and sets \c value if there is a valid entry for \c key
+    bool Lookup(const Key& key, uint64_t now, T& value) const
+    {
+        if ((m_layout == nullptr) || (m_layout->active.load(std::memory_order_acquire) == 0))
+            return false;
+
+        const uint32_t validFrom = m_layout->validFrom.load(std::memory_order_acquire);
+        const Entry& entry = GetEntry(key);
+
+        const uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            return false;
+
+        uint32_t words[VALUE_WORDS];
+        for (size_t i = 0; i < VALUE_WORDS; ++i)
+            words[i] = entry.value[i].load(std::memory_order_relaxed);
+
+        const uint64_t entryKey = Load(entry.key);
+        const uint64_t entryCheck = Load(entry.check);
+        const uint64_t expiresAt = Load(entry.expiresAt);
+        const uint32_t entryGeneration = entry.generation.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != sequence)
+            return false;
+
+        if (   (entryKey != key.hash) || (entryCheck != key.check)
+            || IsOlder(entryGeneration, validFrom) || (now >= expiresAt))
+            return false;
+
+        memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    /// the key for a request of the status of \c path with \c flags
+    static Key GetKey(const wchar_t* path, uint32_t flags)
+    {
+        // FNV-1a for the slot and a multiply-rotate hash as an independent
+        // check, both case-insensitive just like the file system
+        uint64_t hash = 14695981039346656037ULL;
+        uint64_t check = 0x9e3779b97f4a7c15ULL;
+        for (const wchar_t* p = path; *p; ++p)
+        {
+            const uint64_t c = (uint32_t)towlower(*p);
+            hash ^= c;
+            hash *= 1099511628211ULL;
+            check = ((check << 27) | (check >> 37)) + c;
+            check *= 0xff51afd7ed558ccdULL;
+        }
+        hash ^= flags;
+        hash *= 1099511628211ULL;
+        check ^= (uint64_t)flags << 32;
+        check *= 0xc4ceb9fe1a85ec53ULL;
+        check ^= check >> 33;
+
+        // 0 marks unused slots
+        Key key = { hash ? hash : 1, check };
+        return key;
+    }
+
+private:
+
+    enum
+    {
+        MAGIC = 0x54535354,     // "TSST"
+        VALUE_WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t)
+    };
+
+    typedef std::atomic<uint32_t> Word;
+
+    struct Entry
+    {
+        Word sequence;          ///< odd while being written
+        Word generation;
+        Word removedAt;         ///< generation of the last Remove() (writer only)
+        Word key[2];
+        Word check[2];
+        Word expiresAt[2];
+        Word value[VALUE_WORDS];
+    };
+
+    struct Layout
+    {
+        Word magic;
+        Word size;
+        Word active;
+        Word generation;        ///< writer clock
+        Word validFrom;         ///< generation of the last Invalidate()
+        Entry entries[ENTRY_COUNT];
+    };
+
+    static_assert(std::is_trivially_copyable<T>::value, "status table values must be trivially copyable");
+    static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory requires lock-free atomics");
+    static_assert(sizeof(Word) == sizeof(uint32_t), "atomics must not carry extra data");
+
+    Entry& GetEntry(const Key& key) const { return m_layout->entries[key.hash % ENTRY_COUNT]; }
+
+    /// generations wrap around
+    static bool IsOlder(uint32_t generation, uint32_t reference)
+    {
+        return (int32_t)(generation - reference) < 0;
+    }
+
+    /// makes the sequence of \c entry odd and returns its previous value.
+    /// Returns an odd value if the slot is busy and \c wait is false.
+    static uint32_t Lock(Entry& entry, bool wait)
+    {
+        for (;;)
+        {
+            uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+            if (((sequence & 1) == 0) && entry.sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire))
+            {
+                std::atomic_thread_fence(std::memory_order_release);
+                return sequence;
+            }
+            if (!wait && (sequence & 1))
+                return sequence;
+        }
+    }
+
+    static void Store(Word* words, uint64_t value)
+    {
+        words[0].store((uint32_t)value, std::memory_order_relaxed);
+        words[1].store((uint32_t)(value >> 32), std::memory_order_relaxed);
+    }
+
+    static uint64_t Load(const Word* words)
+    {
+        return words[0].load(std::memory_order_relaxed)
+            | ((uint64_t)words[1].load(std::memory_order_relaxed) << 32);
+    }
+
+    Layout* m_layout;
+};
+
+/**
+ * \ingroup TSVNCache
+ * A small ring of the key hashes (see CSharedStatusTable::GetKey()) that
+ * clients have recently found in the status table. Those lookups never
+ * reach the cache otherwise, so this is how it learns what the clients
+ * are currently interested in.
+ *
+ * Unlike the status table, this block is written by the clients and read
+ * by the cache. Every slot carries the index of the push that filled it.
+ * The reader checks it before and after reading the key, so a torn or
+ * overwritten key gets ignored.
+ */
+class CSharedKeyRing
+{
+public:
+
+    enum
+    {
+        ENTRY_COUNT = 16
+    };
+
+    CSharedKeyRing() : m_layout(nullptr) {}
+
+    /// size of the memory block to share
+    static size_t GetMemorySize() { return sizeof(Layout); }
+
+    /// reader: prepares the zero-initialized or previously used \c memory.
+    /// Returns false, if the block has been set up with a different layout.
+    bool Create(void* memory)
+    {
+        Layout* layout = static_cast<Layout*>(memory);
+        uint32_t magic = layout->magic.load(std::memory_order_acquire);
+        if (magic == 0)
+        {
+            layout->size.store(sizeof(Layout), std::memory_order_relaxed);
+            layout->magic.store(MAGIC, std::memory_order_release);
+        }
+        else if ((magic != MAGIC) || (layout->size.load(std::memory_order_relaxed) != sizeof(Layout)))
+        {
+            return false;
+        }
+
+        m_layout = layout;
+        return true;
+    }
+
+    /// writer: uses the block \c memory set up by the reader.
+    /// Returns false, if the block has not been set up (properly).
+    bool Attach(void* memory)
+    {
+        Layout* layout = static_cast<Layout*>(memory);
+        if (   (layout->magic.load(std::memory_order_acquire) != MAGIC)
+            || (layout->size.load(std::memory_order_relaxed) != sizeof(Layout)))
+            return false;
+
+        m_layout = layout;
+        return true;
+    }
+
+    /// writer: records \c key as the most recent one
+    void Push(uint64_t key)
+    {
+        if (m_layout == nullptr)
+            return;
+
+        const uint32_t index = m_layout->next.fetch_add(1, std::memory_order_relaxed) + 1;
+        Entry& entry = m_layout->entries[index % ENTRY_COUNT];
+
+        entry.index.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry.key[0].store((uint32_t)key, std::memory_order_relaxed);
+        entry.key[1].store((uint32_t)(key >> 32), std::memory_order_relaxed);
+        entry.index.store(index, std::memory_order_release);
+    }
+
+    /// reader: returns true and sets \c key if there has been a push since
+    /// the one \c lastSeen refers to. Updates \c lastSeen in that case.
+    bool GetLatest(uint32_t& lastSeen, uint64_t& key) const
+    {
+        if (m_layout == nullptr)
+            return false;
+
+        const uint32_t index = m_layout->next.load(std::memory_order_acquire);
+        if (index == lastSeen)
+            return false;
+
+        lastSeen = index;
+        const Entry& entry = m_layout->entries[index % ENTRY_COUNT];
+        if (entry.index.load(std::memory_order_acquire) != index)
+            return false;
+
+        const uint64_t result = entry.key[0].load(std::memory_order_relaxed)
+                              | ((uint64_t)entry.key[1].load(std::memory_order_relaxed) << 32);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.index.load(std::memory_order_relaxed) != index)
+            return false;
+
+        key = result;
+        return true;
+    }
+
+private:
+
+    enum
+    {
+        MAGIC = 0x54534b52      // "TSKR"
+    };
+
+    typedef std::atomic<uint32_t> Word;
+
+    struct Entry
+    {
+        Word index;             ///< 0 while being written
+        Word key[2];
+    };
+
+    struct Layout
+    {
+        Word magic;
+        Word size;
+        Word next;              ///< index of the latest push
+        Entry entries[ENTRY_COUNT];
+    };
+
+    Layout* m_layout;
+};
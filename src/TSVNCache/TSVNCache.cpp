@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2005 - 2009, 2011-2012, 2014-2016 - TortoiseSVN
+// External Cache Copyright (C) 2005 - 2009, 2011-2012, 2014-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -413,8 +413,15 @@ VOID GetAnswerToRequest(const TSVNCacheRequest* pRequest, TSVNCacheResponse* pRe
 
     if (readLock.IsAcquired())
     {
+        // any change from now on invalidates the response
+        CCacheStatusTable& statusTable = CSVNStatusCache::Instance().GetStatusTable();
+        const DWORD generation = statusTable.GetGeneration();
+
         CTraceToOutputDebugString::Instance()(_T(__FUNCTION__) L": app asked for status of %s\n", pRequest->path);
         CSVNStatusCache::Instance().GetStatusForPath(path, pRequest->flags, false).BuildCacheResponse(*pReply, *pResponseLength);
+
+        // let the clients find the response without asking us again
+        CSVNStatusCache::Instance().PublishStatus(*pRequest, *pReply, generation);
     }
     else
     {
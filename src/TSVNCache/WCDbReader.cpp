@@ -0,0 +1,488 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// External Cache Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "WCDbReader.h"
+#include "SVNAdminDir.h"
+#include "UnicodeUtils.h"
+#include "SmartHandle.h"
+#include "sqlite3.h"
+
+namespace
+{
+    // the wc.db format used since Subversion 1.8
+    const int WC_DB_FORMAT = 31;
+
+    // offset between the FILETIME and the apr_time_t epoch, in microseconds
+    const __int64 EPOCH_DELTA_IN_USEC = 11644473600000000LL;
+
+    const char SELECT_FORMAT[] = "PRAGMA user_version";
+
+    const char SELECT_WC_ID[] = "SELECT id FROM wcroot WHERE local_abspath IS NULL";
+
+    // anything that makes svn_client_status() necessary
+    const char SELECT_AMBIGUOUS[] =
+        "SELECT EXISTS (SELECT 1 FROM work_queue) "
+        "    OR EXISTS (SELECT 1 FROM wc_lock) "
+        "    OR EXISTS (SELECT 1 FROM actual_node "
+        "               WHERE wc_id = ?1 AND (parent_relpath = ?2 OR local_relpath = ?2) "
+        "                 AND conflict_data IS NOT NULL) "
+        "    OR EXISTS (SELECT 1 FROM externals WHERE wc_id = ?1 AND parent_relpath = ?2)";
+
+    // all layers of the folder, its parent folder and its immediate children
+    const char SELECT_NODES[] =
+        "SELECT n.local_relpath, n.op_depth, n.presence, n.kind, n.repos_id, n.repos_path, "
+        "       n.changed_revision, n.translated_size, n.last_mod_time, n.file_external, "
+        "       n.properties, a.properties, a.changelist, l.lock_owner "
+        "FROM nodes n "
+        "LEFT OUTER JOIN actual_node a ON a.wc_id = n.wc_id AND a.local_relpath = n.local_relpath "
+        "LEFT OUTER JOIN lock l ON l.repos_id = n.repos_id AND l.repos_relpath = n.repos_path "
+        "WHERE n.wc_id = ?1 AND (n.parent_relpath = ?2 OR n.local_relpath = ?2 OR n.local_relpath = ?3)";
+
+    enum NodeColumns
+    {
+        COL_LOCAL_RELPATH,
+        COL_OP_DEPTH,
+        COL_PRESENCE,
+        COL_KIND,
+        COL_REPOS_ID,
+        COL_REPOS_PATH,
+        COL_CHANGED_REVISION,
+        COL_TRANSLATED_SIZE,
+        COL_LAST_MOD_TIME,
+        COL_FILE_EXTERNAL,
+        COL_PRISTINE_PROPS,
+        COL_ACTUAL_PROPS,
+        COL_CHANGELIST,
+        COL_LOCK_OWNER
+    };
+
+    class CDatabase
+    {
+    public:
+        CDatabase() : m_db(NULL) {}
+        ~CDatabase()
+        {
+            // also rolls back the read transaction
+            if (m_db)
+                sqlite3_close(m_db);
+        }
+
+        bool Open(const CStringA& path)
+        {
+            return sqlite3_open_v2(path, &m_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) == SQLITE_OK;
+        }
+
+        bool Execute(const char* sql)
+        {
+            return sqlite3_exec(m_db, sql, NULL, NULL, NULL) == SQLITE_OK;
+        }
+
+        operator sqlite3*() const { return m_db; }
+
+    private:
+        sqlite3*    m_db;
+    };
+
+    class CStatement
+    {
+    public:
+        CStatement(sqlite3* db, const char* sql) : m_stmt(NULL)
+        {
+            if (sqlite3_prepare_v2(db, sql, -1, &m_stmt, NULL) != SQLITE_OK)
+                m_stmt = NULL;
+        }
+        ~CStatement()
+        {
+            if (m_stmt)
+                sqlite3_finalize(m_stmt);
+        }
+
+        bool IsValid() const { return m_stmt != NULL; }
+
+        /// returns true while there are rows left
+        bool Step() { return sqlite3_step(m_stmt) == SQLITE_ROW; }
+
+        void Bind(int index, __int64 value) { sqlite3_bind_int64(m_stmt, index, value); }
+        void Bind(int index, const CStringA& value) { sqlite3_bind_text(m_stmt, index, value, value.GetLength(), SQLITE_STATIC); }
+
+        bool IsNull(int column) const { return sqlite3_column_type(m_stmt, column) == SQLITE_NULL; }
+        __int64 GetInt(int column) const { return sqlite3_column_int64(m_stmt, column); }
+        CStringA GetText(int column) const
+        {
+            return CStringA((const char*)sqlite3_column_text(m_stmt, column), sqlite3_column_bytes(m_stmt, column));
+        }
+        const char* GetBlob(int column, int& size) const
+        {
+            const char* data = (const char*)sqlite3_column_blob(m_stmt, column);
+            size = sqlite3_column_bytes(m_stmt, column);
+            return data;
+        }
+
+    private:
+        sqlite3_stmt*   m_stmt;
+    };
+
+    struct DiskEntry
+    {
+        bool        isDir;
+        __int64     size;
+        __int64     lastModTime;    ///< as apr_time_t, just like in wc.db
+        bool        versioned;
+    };
+
+    typedef std::map<CStringA, DiskEntry> DiskEntries;
+
+    bool ReadDirectory(const CTSVNPath& directory, DiskEntries& entries)
+    {
+        CString pattern = directory.GetWinPathString();
+        if (pattern.Right(1) != L"\\")
+            pattern += L"\\";
+        pattern += L"*";
+
+        WIN32_FIND_DATA findData;
+        CAutoFindFile hFind = FindFirstFileEx(pattern, FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+        if (!hFind)
+            return false;
+
+        do
+        {
+            if ((wcscmp(findData.cFileName, L".") == 0) || (wcscmp(findData.cFileName, L"..") == 0))
+                continue;
+            if (g_SVNAdminDir.IsAdminDirName(CString(findData.cFileName)))
+                continue;
+
+            // symlinks and junctions need special handling
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+                return false;
+
+            ULARGE_INTEGER time;
+            time.LowPart = findData.ftLastWriteTime.dwLowDateTime;
+            time.HighPart = findData.ftLastWriteTime.dwHighDateTime;
+
+            DiskEntry& entry = entries[CUnicodeUtils::GetUTF8(CString(findData.cFileName))];
+            entry.isDir = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            entry.size = ((__int64)findData.nFileSizeHigh << 32) + findData.nFileSizeLow;
+            entry.lastModTime = (__int64)(time.QuadPart / 10) - EPOCH_DELTA_IN_USEC;
+            entry.versioned = false;
+        } while (FindNextFile(hFind, &findData));
+
+        return true;
+    }
+
+    bool IsSkelSpace(char c)
+    {
+        return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\f');
+    }
+
+    /// reads the next atom of a skel. Returns false on anything else.
+    bool ReadAtom(const char*& pos, const char* end, const char*& data, size_t& length)
+    {
+        if ((pos != end) && isdigit((unsigned char)*pos))
+        {
+            // explicit length, followed by exactly one space
+            size_t size = 0;
+            for (; (pos != end) && isdigit((unsigned char)*pos); ++pos)
+                size = size * 10 + (*pos - '0');
+
+            if ((pos == end) || !IsSkelSpace(*pos) || ((size_t)(end - pos - 1) < size))
+                return false;
+
+            data = pos + 1;
+            length = size;
+            pos = data + size;
+            return true;
+        }
+
+        if ((pos != end) && isalpha((unsigned char)*pos))
+        {
+            // implicit length
+            data = pos;
+            while ((pos != end) && !IsSkelSpace(*pos) && (*pos != '(') && (*pos != ')'))
+                ++pos;
+
+            length = pos - data;
+            return true;
+        }
+
+        return false;
+    }
+
+    /// parses a property list as stored in wc.db, i.e. a skel
+    /// of the form "(name value name value ...)"
+    bool ParseProperties(const char* data, int size, bool& hasProperties, bool& needsLock)
+    {
+        hasProperties = false;
+        needsLock = false;
+        if (data == NULL)
+            return true;
+
+        const char* pos = data;
+        const char* end = data + size;
+
+        while ((pos != end) && IsSkelSpace(*pos))
+            ++pos;
+        if ((pos == end) || (*pos++ != '('))
+            return false;
+
+        for (;;)
+        {
+            while ((pos != end) && IsSkelSpace(*pos))
+                ++pos;
+            if (pos == end)
+                return false;
+            if (*pos == ')')
+                return true;
+
+            const char* name;
+            size_t nameLength;
+            const char* value;
+            size_t valueLength;
+            if (!ReadAtom(pos, end, name, nameLength))
+                return false;
+            while ((pos != end) && IsSkelSpace(*pos))
+                ++pos;
+            if (!ReadAtom(pos, end, value, valueLength))
+                return false;
+
+            hasProperties = true;
+            if ((nameLength == strlen(SVN_PROP_NEEDS_LOCK)) && (strncmp(name, SVN_PROP_NEEDS_LOCK, nameLength) == 0))
+                needsLock = true;
+        }
+    }
+}
+
+bool CWCDbReader::GetDirectoryStatus(const CTSVNPath& wcRoot, const CTSVNPath& directory, std::vector<Node>& nodes)
+{
+    nodes.clear();
+    if (!wcRoot.IsAncestorOf(directory))
+        return false;
+
+    // wc.db paths are relative to the wc root and use forward slashes
+
+    CString relPath = directory.GetWinPathString().Mid(wcRoot.GetWinPathString().GetLength());
+    relPath.Trim(L'\\');
+    relPath.Replace(L'\\', L'/');
+
+    const CStringA localRelPath = CUnicodeUtils::GetUTF8(relPath);
+    const bool isRoot = localRelPath.IsEmpty();
+    const int slashPos = localRelPath.ReverseFind('/');
+    const CStringA parentRelPath = slashPos >= 0 ? localRelPath.Left(slashPos) : CStringA();
+    const CStringA childPrefix = isRoot ? CStringA() : localRelPath + "/";
+
+    DiskEntries diskEntries;
+    if (!ReadDirectory(directory, diskEntries))
+        return false;
+
+    CTSVNPath dbPath(wcRoot);
+    dbPath.AppendPathString(g_SVNAdminDir.GetAdminDirName() + L"\\wc.db");
+
+    CDatabase db;
+    if (!db.Open(CUnicodeUtils::GetUTF8(dbPath.GetWinPathString())))
+        return false;
+
+    // read everything from the same snapshot
+    if (!db.Execute("BEGIN"))
+        return false;
+
+    CStatement format(db, SELECT_FORMAT);
+    if (!format.IsValid() || !format.Step() || (format.GetInt(0) != WC_DB_FORMAT))
+        return false;
+
+    CStatement wcId(db, SELECT_WC_ID);
+    if (!wcId.IsValid() || !wcId.Step())
+        return false;
+    const __int64 id = wcId.GetInt(0);
+
+    CStatement ambiguous(db, SELECT_AMBIGUOUS);
+    if (!ambiguous.IsValid())
+        return false;
+    ambiguous.Bind(1, id);
+    ambiguous.Bind(2, localRelPath);
+    if (!ambiguous.Step() || (ambiguous.GetInt(0) != 0))
+        return false;
+
+    CStatement select(db, SELECT_NODES);
+    if (!select.IsValid())
+        return false;
+    select.Bind(1, id);
+    select.Bind(2, localRelPath);
+    if (!isRoot)
+        select.Bind(3, parentRelPath);
+
+    // repository locations, needed to detect switched nodes
+
+    struct Location
+    {
+        __int64     reposId;
+        CStringA    reposPath;
+    };
+
+    Location parentLocation = { -1 };
+    std::vector<Location> locations;
+    bool foundSelf = false;
+
+    while (select.Step())
+    {
+        // anything but plain BASE nodes needs the full status logic
+        if (select.GetInt(COL_OP_DEPTH) != 0)
+            return false;
+        if (!select.IsNull(COL_FILE_EXTERNAL))
+            return false;
+
+        const CStringA presence = select.GetText(COL_PRESENCE);
+        if (presence == "not-present")
+            continue;
+        if (presence != "normal")
+            return false;
+
+        Location location = { select.GetInt(COL_REPOS_ID), select.GetText(COL_REPOS_PATH) };
+        const CStringA nodeRelPath = select.GetText(COL_LOCAL_RELPATH);
+        if (!isRoot && (nodeRelPath == parentRelPath))
+        {
+            parentLocation = location;
+            continue;
+        }
+
+        Node node;
+        node.name = nodeRelPath.Mid(nodeRelPath == localRelPath ? nodeRelPath.GetLength() : childPrefix.GetLength());
+        node.versioned = true;
+        node.changedRev = (svn_revnum_t)select.GetInt(COL_CHANGED_REVISION);
+        node.switched = false;
+        node.lockOwner = select.IsNull(COL_LOCK_OWNER) ? CStringA() : select.GetText(COL_LOCK_OWNER);
+        node.changelist = select.IsNull(COL_CHANGELIST) ? CStringA() : select.GetText(COL_CHANGELIST);
+
+        const CStringA kind = select.GetText(COL_KIND);
+        if (kind == "file")
+            node.kind = svn_node_file;
+        else if (kind == "dir")
+            node.kind = svn_node_dir;
+        else
+            return false;
+
+        // property status
+
+        int pristineSize = 0;
+        const char* pristine = select.IsNull(COL_PRISTINE_PROPS) ? NULL : select.GetBlob(COL_PRISTINE_PROPS, pristineSize);
+        bool hasProperties = false;
+        if (!ParseProperties(pristine, pristineSize, hasProperties, node.needsLock))
+            return false;
+        if (node.kind != svn_node_file)
+            node.needsLock = false;
+
+        bool propsModified = false;
+        if (!select.IsNull(COL_ACTUAL_PROPS))
+        {
+            int actualSize = 0;
+            const char* actual = select.GetBlob(COL_ACTUAL_PROPS, actualSize);
+            propsModified = (actualSize != pristineSize)
+                         || ((actualSize > 0) && (memcmp(actual, pristine, actualSize) != 0));
+        }
+        node.propStatus = propsModified
+                        ? svn_wc_status_modified
+                        : (hasProperties ? svn_wc_status_normal : svn_wc_status_none);
+
+        // text status
+
+        node.textStatus = svn_wc_status_normal;
+        if (node.name.IsEmpty())
+        {
+            foundSelf = true;
+        }
+        else
+        {
+            DiskEntries::iterator it = diskEntries.find(node.name);
+            if (it == diskEntries.end())
+            {
+                node.textStatus = svn_wc_status_missing;
+            }
+            else
+            {
+                it->second.versioned = true;
+
+                // obstructed
+                if (it->second.isDir != (node.kind == svn_node_dir))
+                    return false;
+
+                // svn would have to compare the file content with the pristine
+                if (   (node.kind == svn_node_file)
+                    && (   select.IsNull(COL_TRANSLATED_SIZE)
+                        || select.IsNull(COL_LAST_MOD_TIME)
+                        || (select.GetInt(COL_TRANSLATED_SIZE) != it->second.size)
+                        || (select.GetInt(COL_LAST_MOD_TIME) != it->second.lastModTime)))
+                    return false;
+            }
+        }
+
+        if (node.textStatus == svn_wc_status_missing)
+            node.nodeStatus = svn_wc_status_missing;
+        else if (propsModified)
+            node.nodeStatus = svn_wc_status_modified;
+        else
+            node.nodeStatus = svn_wc_status_normal;
+
+        nodes.push_back(node);
+        locations.push_back(location);
+    }
+
+    if (!foundSelf)
+        return false;
+
+    // a node is switched if its repository path differs from the one
+    // that its parent's repository path implies
+
+    const Location* selfLocation = NULL;
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (nodes[i].name.IsEmpty())
+            selfLocation = &locations[i];
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const Location* parent = nodes[i].name.IsEmpty() ? &parentLocation : selfLocation;
+        if (isRoot && (parent == &parentLocation))
+            continue;
+        if (parent->reposId != locations[i].reposId)
+            return false;
+
+        CStringA name = nodes[i].name.IsEmpty() ? localRelPath.Mid(slashPos + 1) : nodes[i].name;
+        CStringA expected = parent->reposPath.IsEmpty() ? name : parent->reposPath + "/" + name;
+        nodes[i].switched = expected != locations[i].reposPath;
+    }
+
+    // unversioned items, reported just like svn_client_status() does.
+    // The ignore patterns are left to the caller.
+    for (DiskEntries::const_iterator it = diskEntries.begin(); it != diskEntries.end(); ++it)
+    {
+        if (it->second.versioned)
+            continue;
+
+        Node node;
+        node.name = it->first;
+        node.versioned = false;
+        node.kind = svn_node_unknown;
+        node.nodeStatus = svn_wc_status_unversioned;
+        node.textStatus = svn_wc_status_unversioned;
+        node.propStatus = svn_wc_status_none;
+        node.changedRev = SVN_INVALID_REVNUM;
+        node.switched = false;
+        node.needsLock = false;
+        nodes.push_back(node);
+    }
+
+    return true;
+}
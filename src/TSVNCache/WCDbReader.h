@@ -0,0 +1,65 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// External Cache Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+#include "TSVNPath.h"
+
+/**
+ * \ingroup TSVNCache
+ * Reads the status of a folder and its immediate children directly from
+ * the wc.db of the working copy, without going through svn_client_status().
+ *
+ * Only the simple, but by far most common cases are handled: unmodified
+ * or missing nodes, property modifications, locks and changelists. Files
+ * are considered unmodified only if their size and last write time match
+ * the values recorded in wc.db. Whenever svn_client_status() would have to
+ * look any closer (e.g. compare file contents, handle added, deleted or
+ * conflicted nodes, externals or working copy locks), the reader gives up
+ * and the caller has to fall back to svn_client_status().
+ *
+ * Unversioned items are returned as 'unversioned'. Whether they are
+ * ignored depends on the ignore patterns, which the caller has to check.
+ *
+ * The database is opened read-only for each call only, so the cache never
+ * keeps the wc.db file open.
+ */
+class CWCDbReader
+{
+public:
+    struct Node
+    {
+        CStringA            name;           ///< empty for the folder itself
+        bool                versioned;
+        svn_node_kind_t     kind;           ///< svn_node_unknown for unversioned items
+        svn_wc_status_kind  nodeStatus;
+        svn_wc_status_kind  textStatus;
+        svn_wc_status_kind  propStatus;
+        svn_revnum_t        changedRev;
+        bool                switched;
+        bool                needsLock;
+        CStringA            lockOwner;
+        CStringA            changelist;
+    };
+
+    /// Fills \c nodes with the status of \c directory and all items
+    /// directly inside it. \c wcRoot must be the working copy root containing
+    /// \c directory.
+    /// Returns false if the status could not be determined reliably.
+    static bool GetDirectoryStatus(const CTSVNPath& wcRoot, const CTSVNPath& directory, std::vector<Node>& nodes);
+};
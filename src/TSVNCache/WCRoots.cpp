@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2010, 2014-2015 - TortoiseSVN
+// External Cache Copyright (C) 2010, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -23,6 +23,8 @@
 
 
 #define DBTIMEOUT 10000
+#define DIRROOTTIMEOUT 60000
+#define MAXDIRROOTS 10000
 
 CWCRoots::CWCRoots()
 {
@@ -108,6 +110,104 @@ bool CWCRoots::AddPath( const CTSVNPath& path )
     return AddPathInternal(path) != m_WCDBs.end();
 }
 
+CTSVNPath CWCRoots::GetWCRoot( const CTSVNPath& path )
+{
+    // Walk up to the first folder with a wc.db or with a recently
+    // resolved root. The disk gets only checked for folders that have
+    // not been resolved yet, and never while holding the lock.
+    // Files share the result of their folder, so they start there.
+    ULONGLONG ticks = GetTickCount64();
+    std::vector<CTSVNPath> unresolved;
+    CTSVNPath root;
+    WCRootsTimes dbTimes = { 0, 0 };
+    CTSVNPath dir = path.IsDirectory() ? path : path.GetContainingDirectory();
+    for (CTSVNPath p(dir); !p.IsEmpty(); p = p.GetContainingDirectory())
+    {
+        {
+            AutoLocker lock(m_critSec);
+            std::map<CTSVNPath, WCRootsDirRoot>::const_iterator it = m_dirRoots.find(p);
+            if ((it != m_dirRoots.end()) && (ticks - it->second.LastTicks < DIRROOTTIMEOUT))
+            {
+                root = it->second.Root;
+                break;
+            }
+        }
+
+        CTSVNPath dbPath(p);
+        dbPath.AppendPathString(g_SVNAdminDir.GetAdminDirName() + L"\\wc.db");
+        if (dbPath.Exists())
+        {
+            root = p;
+            dbTimes.LastTicks = ticks;
+            dbTimes.FileTime = dbPath.GetLastWriteTime();
+        }
+        unresolved.push_back(p);
+        if (!root.IsEmpty())
+            break;
+    }
+
+    AutoLocker lock(m_critSec);
+    if (dbTimes.LastTicks != 0)
+        m_WCDBs.emplace(root, dbTimes);
+
+    if (m_dirRoots.size() + unresolved.size() > MAXDIRROOTS)
+    {
+        m_dirRoots.clear();
+        m_rootDirs.clear();
+    }
+    for (const auto& p : unresolved)
+    {
+        auto result = m_dirRoots.emplace(p, WCRootsDirRoot{ root, ticks });
+        if (!result.second)
+        {
+            if (CTSVNPath::Compare(result.first->second.Root, root) != 0)
+                m_rootDirs[result.first->second.Root].erase(p);
+            result.first->second = { root, ticks };
+        }
+        m_rootDirs[root].insert(p);
+    }
+
+    return root;
+}
+
+void CWCRoots::RemoveDirRoots( const CTSVNPath& path )
+{
+    // The folders below path were resolved either to path itself or
+    // to the root path (or one of its parents) was resolved to. Only
+    // those roots need to be looked at.
+    std::vector<CTSVNPath> roots(1, path);
+    for (CTSVNPath p(path); !p.IsEmpty(); p = p.GetContainingDirectory())
+    {
+        std::map<CTSVNPath, WCRootsDirRoot>::const_iterator it = m_dirRoots.find(p);
+        if (it != m_dirRoots.end())
+        {
+            roots.push_back(it->second.Root);
+            break;
+        }
+    }
+
+    for (const auto& root : roots)
+    {
+        std::map<CTSVNPath, std::set<CTSVNPath>>::iterator rootIt = m_rootDirs.find(root);
+        if (rootIt == m_rootDirs.end())
+            continue;
+
+        std::set<CTSVNPath>& dirs = rootIt->second;
+        for (std::set<CTSVNPath>::iterator dirIt = dirs.begin(); dirIt != dirs.end(); )
+        {
+            if (path.IsAncestorOf(*dirIt))
+            {
+                m_dirRoots.erase(*dirIt);
+                dirIt = dirs.erase(dirIt);
+            }
+            else
+                ++dirIt;
+        }
+        if (dirs.empty())
+            m_rootDirs.erase(rootIt);
+    }
+}
+
 bool CWCRoots::NotifyChange( const CTSVNPath& path )
 {
     AutoLocker lock(m_critSec);
@@ -117,6 +217,10 @@ bool CWCRoots::NotifyChange( const CTSVNPath& path )
     {
         p = p.GetContainingDirectory();
     }
+
+    // a working copy may have been created or removed at p
+    RemoveDirRoots(p);
+
     std::map<CTSVNPath, WCRootsTimes>::iterator it = m_WCDBs.lower_bound(p);
     if (it != m_WCDBs.end())
     {
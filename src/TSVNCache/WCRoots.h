@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// External Cache Copyright (C) 2010, 2014 - TortoiseSVN
+// External Cache Copyright (C) 2010, 2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -20,6 +20,7 @@
 
 #include "TSVNPath.h"
 #include <map>
+#include <set>
 
 struct WCRootsTimes
 {
@@ -27,6 +28,12 @@ struct WCRootsTimes
     ULONGLONG   LastTicks;
 };
 
+struct WCRootsDirRoot
+{
+    CTSVNPath   Root;
+    ULONGLONG   LastTicks;
+};
+
 class CWCRoots
 {
 public:
@@ -44,13 +51,23 @@ public:
     /// found for it. Returns false otherwise.
     bool AddPath(const CTSVNPath& path);
 
+    /// Returns the WC root containing \c path, or an empty path
+    /// if \c path is not inside a working copy. Nested working
+    /// copies and externals are their own roots.
+    /// The result is cached per folder, including negative results.
+    CTSVNPath GetWCRoot(const CTSVNPath& path);
+
     /// Forces a re-read of the last-write-filetime of the wc.db
     /// file for the specified \c path.
     bool NotifyChange(const CTSVNPath& path);
 
 private:
     std::map<CTSVNPath, WCRootsTimes>::iterator AddPathInternal(const CTSVNPath& path);
+    /// Drops the cached roots of \c path and all folders below it.
+    void RemoveDirRoots(const CTSVNPath& path);
 
     CComAutoCriticalSection                 m_critSec;
     std::map<CTSVNPath, WCRootsTimes>       m_WCDBs;
+    std::map<CTSVNPath, WCRootsDirRoot>     m_dirRoots;     ///< folder -> its WC root (may be empty)
+    std::map<CTSVNPath, std::set<CTSVNPath>> m_rootDirs;    ///< WC root -> folders resolved to it
 };
@@ -1,6 +1,6 @@
 ﻿// TortoiseBlame - a Viewer for Subversion Blames
 
-// Copyright (C) 2003-2019 - TortoiseSVN
+// Copyright (C) 2003-2019, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -106,6 +106,9 @@ TortoiseBlame::TortoiseBlame()
     , m_directFunction(0)
     , m_lowestRev(LONG_MAX)
     , m_highestRev(0)
+    , m_bHasMergePaths(false)
+    , m_pendingGotoLine(0)
+    , m_lastLoadTicks(0)
 {
     m_szTip[0]      = 0;
     m_wszTip[0]     = 0;
@@ -251,13 +254,6 @@ BOOL TortoiseBlame::OpenFile(const TCHAR *fileName)
     SendEditor(EM_EMPTYUNDOBUFFER);
     ::ShowWindow(wEditor, SW_HIDE);
 
-    int stringBufLen = 4096;
-    auto stringbuf = std::make_unique<char[]>(stringBufLen);
-    int wideBufLen = 4096;
-    auto wideBuf = std::make_unique<wchar_t[]>(wideBufLen);
-    int utf8BufLen = 4096;
-    auto utf8Buf = std::make_unique<char[]>(utf8BufLen);
-
     FILE * File = NULL;
     int retrycount = 10;
     while (retrycount)
@@ -276,351 +272,286 @@ BOOL TortoiseBlame::OpenFile(const TCHAR *fileName)
 
     ProfileTimer profiler(L"Blame: OpenFile");
 
-    //m_revs.reserve(100000);
-    //m_mergedRevs.reserve(100000);
-    //m_dates.reserve(100000);
-    //m_mergedDates.reserve(100000);
-    //m_authors.reserve(100000);
-    //m_mergedAuthors.reserve(100000);
-    //m_mergedPaths.reserve(100000);
-
     m_lowestRev = LONG_MAX;
     m_highestRev = 0;
-    LONG linenumber = 0;
-    svn_revnum_t rev = 0;
-    svn_revnum_t merged_rev = 0;
-    int strLen = 0;
-    bool bHasMergePaths = false;
-    for (;;)
+    m_bHasMergePaths = false;
+    m_strings.assign(1, tstring());
+    m_convertedStrings.assign(1, true);
+    m_knownAuthors.clear();
+
+    char magic[sizeof(CBlameFile::MAGIC)] = { 0 };
+    bool bChunked = (fread(magic, sizeof(magic), 1, File) == 1)
+                 && (memcmp(magic, CBlameFile::MAGIC, sizeof(magic)) == 0);
+    bool bSuccess = false;
+    if (bChunked)
+    {
+        // show the first chunk of lines as soon as possible and
+        // add the rest in the background
+        fclose(File);
+        m_reader = std::make_unique<CBlameFileReader>();
+        bSuccess = m_reader->Open(fileName) && ReadChunks(true);
+    }
+    else
     {
-        rev = 0;
-        merged_rev = 0;
-        // line number
-        size_t len = fread(&linenumber, sizeof(LONG), 1, File);
-        if (len == 0)
-            break;
-        // revision
-        len = fread(&rev, sizeof(svn_revnum_t), 1, File);
-        if (len == 0)
-            break;
-        m_revs.push_back(rev);
-        m_revset.insert(rev);
-        // author
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
-            break;
-        if (strLen)
-        {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            if (len == 0)
-                break;
-            stringbuf[strLen] = 0;
-            auto author = CUnicodeUtils::StdGetUnicode(stringbuf.get());
-            m_authors.push_back(author);
-            m_authorset.insert(author);
-        }
-        else
-        {
-            m_authors.push_back(L"");
-            m_authorset.insert(L"");
-        }
-        // date
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
-            break;
-        if (strLen)
-        {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            if (len == 0)
-                break;
-            stringbuf[strLen] = 0;
-            m_dates.push_back(CUnicodeUtils::StdGetUnicode(stringbuf.get()));
-        }
-        else
-            m_dates.push_back(L"");
-        // merged revision
-        len = fread(&merged_rev, sizeof(svn_revnum_t), 1, File);
-        if (len == 0)
-            break;
-        m_mergedRevs.push_back(merged_rev);
-        if ((merged_rev > 0)&&(merged_rev < rev))
-        {
-            m_lowestRev = min(m_lowestRev, merged_rev);
-            m_highestRev = max(m_highestRev, merged_rev);
-        }
+        fseek(File, 0, SEEK_SET);
+        bSuccess = ReadLegacyFile(File);
+        fclose(File);
+    }
+
+    SendEditor(SCI_SETUNDOCOLLECTION, 1);
+    ::SetFocus(wEditor);
+    SendEditor(EM_EMPTYUNDOBUFFER);
+    SendEditor(SCI_SETSAVEPOINT);
+    SendEditor(SCI_GOTOPOS, 0);
+    SendEditor(SCI_SETSCROLLWIDTHTRACKING, TRUE);
+    SendEditor(SCI_SETREADONLY, TRUE);
+
+    //check which lexer to use, depending on the filetype
+    SetupLexer(fileName);
+    ::ShowWindow(wEditor, SW_SHOW);
+    RECT rc;
+    GetWindowRect(wMain, &rc);
+    SetWindowPos(wMain, 0, rc.left, rc.top, rc.right-rc.left-1, rc.bottom - rc.top, 0);
+    UpdateAfterLoad();
+
+    if (!bSuccess)
+    {
+        m_reader.reset();
+        return FALSE;
+    }
+
+    if (m_reader)
+    {
+        if (m_reader->IsComplete())
+            m_reader.reset();
         else
         {
-            m_lowestRev = min(m_lowestRev, rev);
-            m_highestRev = max(m_highestRev, rev);
+            m_lastLoadTicks = GetTickCount64();
+            SetTimer(wMain, TIMER_LOADBLAME, 10, NULL);
         }
-        // merged author
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
-            break;
-        if (strLen)
+    }
+
+    return TRUE;
+}
+
+void TortoiseBlame::LoadMoreData()
+{
+    if (!m_reader)
+    {
+        KillTimer(wMain, TIMER_LOADBLAME);
+        return;
+    }
+
+    // if nothing arrives for a while, the writer may have died.
+    // Check that before reading, so we don't miss its last data.
+    bool bWriterGone = (GetTickCount64() - m_lastLoadTicks > LOADBLAME_STALL_TIME)
+                    && !m_reader->IsWriterActive();
+
+    size_t oldLineCount = m_revs.size();
+    SendEditor(SCI_SETREADONLY, FALSE);
+    SendEditor(SCI_SETUNDOCOLLECTION, 0);
+    bool bSuccess = ReadChunks(false);
+    if (bWriterGone)
+    {
+        // nothing more will be written -> read all that is left
+        for (size_t lineCount = 0; bSuccess && !m_reader->IsComplete() && (lineCount != m_revs.size()); )
         {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            if (len == 0)
-                break;
-            stringbuf[strLen] = 0;
-            m_mergedAuthors.push_back(CUnicodeUtils::StdGetUnicode(stringbuf.get()));
+            lineCount = m_revs.size();
+            bSuccess = ReadChunks(false);
         }
-        else
-            m_mergedAuthors.push_back(L"");
-        // merged date
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
-            break;
-        if (strLen)
+    }
+    SendEditor(SCI_SETUNDOCOLLECTION, 1);
+    SendEditor(EM_EMPTYUNDOBUFFER);
+    SendEditor(SCI_SETSAVEPOINT);
+    SendEditor(SCI_SETREADONLY, TRUE);
+
+    if (m_revs.size() != oldLineCount)
+    {
+        UpdateAfterLoad();
+        m_lastLoadTicks = GetTickCount64();
+    }
+
+    // a file without END chunk whose writer is gone has been truncated
+    bool bIncomplete = !bSuccess || (bWriterGone && !m_reader->IsComplete());
+    if (bIncomplete || m_reader->IsComplete())
+    {
+        KillTimer(wMain, TIMER_LOADBLAME);
+        m_reader.reset();
+        if (m_pendingGotoLine > 0)
+            GotoLine(m_pendingGotoLine);
+        m_pendingGotoLine = 0;
+    }
+
+    if (bIncomplete)
+    {
+        TCHAR szMessage[MAX_LOADSTRING] = { 0 };
+        LoadString(hResource, IDS_BLAMEINCOMPLETE, szMessage, _countof(szMessage));
+        ::MessageBox(wMain, szMessage, L"TortoiseBlame", MB_ICONERROR);
+    }
+}
+
+bool TortoiseBlame::ReadChunks(bool bFirstChunkOnly)
+{
+    // don't block the UI for too long while loading in the background
+    const ULONGLONG timeLimit = 100;
+    ULONGLONG startTicks = GetTickCount64();
+
+    const CBlameFile::SBlameLine* lines = nullptr;
+    size_t count = 0;
+    const char* text = nullptr;
+    size_t textSize = 0;
+    while (m_reader->NextLines(lines, count, text, textSize))
+    {
+        const std::vector<std::string>& strings = m_reader->GetStrings();
+        m_strings.resize(strings.size());
+        m_convertedStrings.resize(strings.size());
+
+        for (size_t i = 0; i < count; ++i)
         {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            if (len == 0)
-                break;
-            stringbuf[strLen] = 0;
-            m_mergedDates.push_back(CUnicodeUtils::StdGetUnicode(stringbuf.get()));
+            const CBlameFile::SBlameLine& line = lines[i];
+            AddLine(line.revision, line.mergedRevision, line.author, line.date, line.mergedAuthor, line.mergedDate, line.mergedPath);
         }
-        else
-            m_mergedDates.push_back(L"");
-        // merged path
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
+        for (const auto& logMessage : m_reader->TakeLogMessages())
+            AddLogMessage(logMessage.first, strings[logMessage.second]);
+
+        SendEditor(SCI_APPENDTEXT, textSize, reinterpret_cast<LPARAM>(text));
+
+        if (bFirstChunkOnly || (GetTickCount64() - startTicks > timeLimit))
             break;
-        if (strLen)
-        {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            if (len == 0)
-                break;
-            stringbuf[strLen] = 0;
-            m_mergedPaths.push_back(CUnicodeUtils::StdGetUnicode(stringbuf.get()));
-            bHasMergePaths = true;
-        }
-        else
-            m_mergedPaths.push_back(L"");
-        // text line
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (strLen)
-        {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            if (len == 0)
-                break;
-            stringbuf.get()[strLen] = 0;
-            char * lineptr = stringbuf.get();
-            // in case we find an UTF8 BOM at the beginning of the line, we remove it
-            if (((unsigned char)lineptr[0] == 0xEF)&&((unsigned char)lineptr[1] == 0xBB)&&((unsigned char)lineptr[2] == 0xBF))
-            {
-                lineptr += 3;
-            }
-            if (((unsigned char)lineptr[0] == 0xBB)&&((unsigned char)lineptr[1] == 0xEF)&&((unsigned char)lineptr[2] == 0xBF))
-            {
-                lineptr += 3;
-            }
-            // check each line for illegal utf8 sequences. If one is found, we treat
-            // the file as ASCII, otherwise we assume an UTF8 file.
-            unsigned char * utf8CheckBuf = (unsigned char*)lineptr;
-            bool bUTF8 = false;
-            while (*utf8CheckBuf)
-            {
-                if ((*utf8CheckBuf == 0xC0)||(*utf8CheckBuf == 0xC1)||(*utf8CheckBuf >= 0xF5))
-                {
-                    bUTF8 = false;
-                    break;
-                }
-                else if ((*utf8CheckBuf & 0xE0)==0xC0)
-                {
-                    bUTF8 = true;
-                    utf8CheckBuf++;
-                    if (*utf8CheckBuf == 0)
-                        break;
-                    if ((*utf8CheckBuf & 0xC0)!=0x80)
-                    {
-                        bUTF8 = false;
-                        break;
-                    }
-                }
-                else if ((*utf8CheckBuf & 0xF0)==0xE0)
-                {
-                    bUTF8 = true;
-                    utf8CheckBuf++;
-                    if (*utf8CheckBuf == 0)
-                        break;
-                    if ((*utf8CheckBuf & 0xC0)!=0x80)
-                    {
-                        bUTF8 = false;
-                        break;
-                    }
-                    utf8CheckBuf++;
-                    if (*utf8CheckBuf == 0)
-                        break;
-                    if ((*utf8CheckBuf & 0xC0)!=0x80)
-                    {
-                        bUTF8 = false;
-                        break;
-                    }
-                }
-                else if ((*utf8CheckBuf & 0xF8)==0xF0)
-                {
-                    bUTF8 = true;
-                    utf8CheckBuf++;
-                    if (*utf8CheckBuf == 0)
-                        break;
-                    if ((*utf8CheckBuf & 0xC0)!=0x80)
-                    {
-                        bUTF8 = false;
-                        break;
-                    }
-                    utf8CheckBuf++;
-                    if (*utf8CheckBuf == 0)
-                        break;
-                    if ((*utf8CheckBuf & 0xC0)!=0x80)
-                    {
-                        bUTF8 = false;
-                        break;
-                    }
-                    utf8CheckBuf++;
-                    if (*utf8CheckBuf == 0)
-                        break;
-                    if ((*utf8CheckBuf & 0xC0)!=0x80)
-                    {
-                        bUTF8 = false;
-                        break;
-                    }
-                }
-                else if (*utf8CheckBuf >= 0x80)
-                {
-                    bUTF8 = false;
-                    break;
-                }
+    }
 
-                utf8CheckBuf++;
-            }
-            if (!bUTF8)
-            {
-                if (strLen >= wideBufLen)
-                {
-                    wideBufLen = strLen * 2 + 1024;
-                    wideBuf = std::make_unique<wchar_t[]>(wideBufLen + 1);
-                }
+    return !m_reader->HasFailed();
+}
 
-                int mblen = MultiByteToWideChar(CP_ACP, 0, lineptr, strLen, wideBuf.get(), wideBufLen);
-                if (mblen)
-                {
-                    if (mblen >= utf8BufLen)
-                    {
-                        utf8BufLen = mblen + 1024;
-                        utf8Buf = std::make_unique<char[]>(utf8BufLen + 1);
-                    }
-                    mblen = WideCharToMultiByte(CP_UTF8, 0, wideBuf.get(), mblen, utf8Buf.get(), utf8BufLen, 0, NULL);
-                    if (mblen)
-                        SendEditor(SCI_APPENDTEXT, mblen, reinterpret_cast<LPARAM>(utf8Buf.get()));
-                    else
-                        SendEditor(SCI_APPENDTEXT, strlen(lineptr), reinterpret_cast<LPARAM>(static_cast<char *>(lineptr)));
-                }
-                else
-                    SendEditor(SCI_APPENDTEXT, strlen(lineptr), reinterpret_cast<LPARAM>(static_cast<char *>(lineptr)));
-            }
-            else
-                SendEditor(SCI_APPENDTEXT, strlen(lineptr), reinterpret_cast<LPARAM>(static_cast<char *>(lineptr)));
-        }
-        if (len == 0)
+bool TortoiseBlame::ReadLegacyFile(FILE * File)
+{
+    // one record per line with all strings written out in full
+
+    std::map<std::string, DWORD> stringIDs;
+    stringIDs[std::string()] = 0;
+    auto intern = [&](const std::string& text) -> DWORD
+    {
+        auto it = stringIDs.find(text);
+        if (it != stringIDs.end())
+            return it->second;
+
+        DWORD id = (DWORD)m_strings.size();
+        stringIDs[text] = id;
+        m_strings.push_back(CUnicodeUtils::StdGetUnicode(text));
+        m_convertedStrings.push_back(true);
+        return id;
+    };
+    auto readString = [File](std::string& target) -> bool
+    {
+        int strLen = 0;
+        if ((fread(&strLen, sizeof(int), 1, File) != 1) || (strLen < 0))
+            return false;
+        target.resize(strLen);
+        return (strLen == 0) || (fread(&target[0], sizeof(char), strLen, File) == (size_t)strLen);
+    };
+
+    std::string author, date, mergedAuthor, mergedDate, mergedPath, line, logMessage;
+    std::string editorText;
+    for (;;)
+    {
+        LONG linenumber = 0;
+        svn_revnum_t rev = 0;
+        svn_revnum_t merged_rev = 0;
+        if (   (fread(&linenumber, sizeof(LONG), 1, File) != 1)
+            || (fread(&rev, sizeof(svn_revnum_t), 1, File) != 1)
+            || !readString(author)
+            || !readString(date)
+            || (fread(&merged_rev, sizeof(svn_revnum_t), 1, File) != 1)
+            || !readString(mergedAuthor)
+            || !readString(mergedDate)
+            || !readString(mergedPath)
+            || !readString(line))
             break;
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
+
+        AddLine(rev, merged_rev, intern(author), intern(date), intern(mergedAuthor), intern(mergedDate), intern(mergedPath));
+        editorText += CBlameFile::ToEditorText(line);
+        editorText += '\n';
+
+        if (!readString(logMessage))
             break;
-        if (strLen)
-        {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            stringbuf[strLen] = 0;
-            if (rev)
-            {
-                auto foundIt = m_logMessages.find(rev);
-                if (foundIt == m_logMessages.end())
-                {
-                    auto msg = CUnicodeUtils::StdGetUnicode(stringbuf.get());
-                    if (msg.size() > MAX_LOG_LENGTH)
-                    {
-                        msg = msg.substr(0, MAX_LOG_LENGTH-5);
-                        msg = msg + L"\n...";
-                    }
-                    m_logMessages[rev] = msg;
-                }
-            }
-        }
-        len = fread(&strLen, sizeof(int), 1, File);
-        if (len == 0)
+        if (rev)
+            AddLogMessage(rev, logMessage);
+        if (!readString(logMessage))
             break;
-        if (strLen)
-        {
-            if (strLen >= stringBufLen)
-            {
-                stringBufLen = strLen + 1024;
-                stringbuf = std::make_unique<char[]>(stringBufLen + 1);
-            }
-            len = fread(stringbuf.get(), sizeof(char), strLen, File);
-            stringbuf[strLen] = 0;
-            if (merged_rev)
-            {
-                auto foundIt = m_logMessages.find(merged_rev);
-                if (foundIt == m_logMessages.end())
-                {
-                    auto msg = CUnicodeUtils::StdGetUnicode(stringbuf.get());
-                    if (msg.size() > MAX_LOG_LENGTH)
-                    {
-                        msg = msg.substr(0, MAX_LOG_LENGTH-5);
-                        msg = msg + L"\n...";
-                    }
-                    m_logMessages[merged_rev] = msg;
-                }
-            }
-        }
+        if (merged_rev)
+            AddLogMessage(merged_rev, logMessage);
+    }
 
-        SendEditor(SCI_APPENDTEXT, 1, (LPARAM)"\n");
-    };
+    SendEditor(SCI_APPENDTEXT, editorText.size(), reinterpret_cast<LPARAM>(editorText.c_str()));
+    return true;
+}
 
-    fclose(File);
+void TortoiseBlame::ConvertString(DWORD id)
+{
+    if (!m_convertedStrings[id])
+    {
+        m_strings[id] = CUnicodeUtils::StdGetUnicode(m_reader->GetStrings()[id]);
+        m_convertedStrings[id] = true;
+    }
+}
 
-    SendEditor(SCI_SETUNDOCOLLECTION, 1);
-    ::SetFocus(wEditor);
-    SendEditor(EM_EMPTYUNDOBUFFER);
-    SendEditor(SCI_SETSAVEPOINT);
-    SendEditor(SCI_GOTOPOS, 0);
-    SendEditor(SCI_SETSCROLLWIDTHTRACKING, TRUE);
+void TortoiseBlame::AddLine(svn_revnum_t rev, svn_revnum_t mergedRev, DWORD author, DWORD date, DWORD mergedAuthor, DWORD mergedDate, DWORD mergedPath)
+{
+    ConvertString(author);
+    ConvertString(date);
+    ConvertString(mergedAuthor);
+    ConvertString(mergedDate);
+    ConvertString(mergedPath);
+
+    m_revs.push_back(rev);
+    m_revset.insert(rev);
+    m_mergedRevs.push_back(mergedRev);
+    if ((mergedRev > 0)&&(mergedRev < rev))
+    {
+        m_lowestRev = min(m_lowestRev, mergedRev);
+        m_highestRev = max(m_highestRev, mergedRev);
+    }
+    else
+    {
+        m_lowestRev = min(m_lowestRev, rev);
+        m_highestRev = max(m_highestRev, rev);
+    }
+
+    m_authors.push_back(author);
+    m_dates.push_back(date);
+    m_mergedAuthors.push_back(mergedAuthor);
+    m_mergedDates.push_back(mergedDate);
+    m_mergedPaths.push_back(mergedPath);
+
+    if (author >= m_knownAuthors.size())
+        m_knownAuthors.resize(m_strings.size());
+    if (!m_knownAuthors[author])
+    {
+        m_knownAuthors[author] = true;
+        m_authorset.insert(m_strings[author]);
+    }
+    if (mergedPath)
+        m_bHasMergePaths = true;
+}
+
+void TortoiseBlame::AddLogMessage(svn_revnum_t rev, const std::string& message)
+{
+    if (message.empty() || (m_logMessages.find(rev) != m_logMessages.end()))
+        return;
+
+    auto msg = CUnicodeUtils::StdGetUnicode(message);
+    if (msg.size() > MAX_LOG_LENGTH)
+    {
+        msg = msg.substr(0, MAX_LOG_LENGTH-5);
+        msg = msg + L"\n...";
+    }
+    m_logMessages[rev] = msg;
+}
+
+void TortoiseBlame::UpdateAfterLoad()
+{
     int numDigits = 0;
-    int lineCount = (int)m_authors.size();
+    int lineCount = (int)m_revs.size();
     while (lineCount)
     {
         lineCount /= 10;
@@ -634,44 +565,15 @@ BOOL TortoiseBlame::OpenFile(const TCHAR *fileName)
         else
             SendEditor(SCI_SETMARGINWIDTHN, 0);
     }
-    SendEditor(SCI_SETREADONLY, TRUE);
 
-    //check which lexer to use, depending on the filetype
-    SetupLexer(fileName);
-    ::ShowWindow(wEditor, SW_SHOW);
     ::InvalidateRect(wMain, NULL, TRUE);
-    RECT rc;
-    GetWindowRect(wMain, &rc);
-    SetWindowPos(wMain, 0, rc.left, rc.top, rc.right-rc.left-1, rc.bottom - rc.top, 0);
 
     m_blameWidth = 0;
     SetupColoring();
     InitSize();
 
-    if (!bHasMergePaths)
-    {
-        HMENU hMenu = GetMenu(wMain);
-        EnableMenuItem(hMenu, ID_VIEW_MERGEPATH, MF_DISABLED | MF_GRAYED | MF_BYCOMMAND);
-    }
-
-    if ( (m_revs.size() != m_mergedRevs.size()) ||
-        (m_mergedRevs.size() != m_dates.size()) ||
-        (m_dates.size() != m_mergedDates.size()) ||
-        (m_mergedDates.size() != m_authors.size()) ||
-        (m_authors.size() != m_mergedAuthors.size()) ||
-        (m_mergedAuthors.size() != m_mergedPaths.size()) )
-    {
-        m_revs.clear();
-        m_mergedRevs.clear();
-        m_dates.clear();
-        m_mergedDates.clear();
-        m_authors.clear();
-        m_mergedAuthors.clear();
-        m_mergedPaths.clear();
-        return FALSE;
-    }
-
-    return TRUE;
+    HMENU hMenu = GetMenu(wMain);
+    EnableMenuItem(hMenu, ID_VIEW_MERGEPATH, (m_bHasMergePaths ? MF_ENABLED : MF_DISABLED | MF_GRAYED) | MF_BYCOMMAND);
 }
 
 void TortoiseBlame::SetAStyle(int style, COLORREF fore, COLORREF back, int size, const char *face)
@@ -741,8 +643,8 @@ void TortoiseBlame::SelectLine(int yPos, bool bAlwaysSelect) const
         {
             app.m_selectedRev = bUseMerged ? app.m_mergedRevs[line] : app.m_revs[line];
             app.m_selectedOrigRev = app.m_revs[line];
-            app.m_selectedAuthor = bUseMerged ? app.m_mergedAuthors[line] : app.m_authors[line];
-            app.m_selectedDate = bUseMerged ? app.m_mergedDates[line] : app.m_dates[line];
+            app.m_selectedAuthor = bUseMerged ? app.m_strings[app.m_mergedAuthors[line]] : app.m_strings[app.m_authors[line]];
+            app.m_selectedDate = bUseMerged ? app.m_strings[app.m_mergedDates[line]] : app.m_strings[app.m_dates[line]];
         }
         else
         {
@@ -847,7 +749,7 @@ bool TortoiseBlame::DoSearch(LPTSTR what, DWORD flags)
     int i=0;
     int linebufsize = 4096;
     auto linebuf = std::make_unique<char[]>(linebufsize + 1);
-    for (i = line; (bSearchDown ? (i < (int)m_authors.size()) : (i >= 0)) && (!bFound); bSearchDown ? ++i : --i)
+    for (i = line; (bSearchDown ? (i < (int)m_revs.size()) : (i >= 0)) && (!bFound); bSearchDown ? ++i : --i)
     {
         const int bufsize = (int)SendEditor(SCI_GETLINE, i);
         if (bufsize >= linebufsize)
@@ -863,9 +765,9 @@ bool TortoiseBlame::DoSearch(LPTSTR what, DWORD flags)
             std::transform(sLine.begin(), sLine.end(), sLine.begin(), ::towlower);
         }
         swprintf_s(buf, L"%ld", m_revs[i]);
-        if (m_authors[i].compare(sWhat)==0)
+        if (m_strings[m_authors[i]].compare(sWhat)==0)
             bFound = true;
-        else if ((!bCaseSensitive)&&(_wcsicmp(m_authors[i].c_str(), szWhat)==0))
+        else if ((!bCaseSensitive)&&(_wcsicmp(m_strings[m_authors[i]].c_str(), szWhat)==0))
             bFound = true;
         else if (wcscmp(buf, szWhat) == 0)
             bFound = true;
@@ -879,7 +781,7 @@ bool TortoiseBlame::DoSearch(LPTSTR what, DWORD flags)
     }
     if (!bFound)
     {
-        for (bSearchDown ? i = 0 : i = (int)m_authors.size() -1; (bSearchDown ? (i < line) : (i > line)) && (!bFound); bSearchDown ? ++i : --i)
+        for (bSearchDown ? i = 0 : i = (int)m_revs.size() -1; (bSearchDown ? (i < line) : (i > line)) && (!bFound); bSearchDown ? ++i : --i)
         {
             const int bufsize = (int)SendEditor(SCI_GETLINE, i);
             if (bufsize >= linebufsize)
@@ -895,9 +797,9 @@ bool TortoiseBlame::DoSearch(LPTSTR what, DWORD flags)
                 std::transform(sLine.begin(), sLine.end(), sLine.begin(), ::towlower);
             }
             swprintf_s(buf, L"%ld", m_revs[i]);
-            if (m_authors[i].compare(sWhat)==0)
+            if (m_strings[m_authors[i]].compare(sWhat)==0)
                 bFound = true;
-            else if ((!bCaseSensitive)&&(_wcsicmp(m_authors[i].c_str(), szWhat)==0))
+            else if ((!bCaseSensitive)&&(_wcsicmp(m_strings[m_authors[i]].c_str(), szWhat)==0))
                 bFound = true;
             else if (wcscmp(buf, szWhat) == 0)
                 bFound = true;
@@ -935,12 +837,17 @@ bool TortoiseBlame::DoSearch(LPTSTR what, DWORD flags)
 
 bool TortoiseBlame::GotoLine(long line)
 {
+    if (m_reader && ((unsigned long)line > m_revs.size()))
+    {
+        // the line has not been loaded yet: go there once it is
+        m_pendingGotoLine = line;
+    }
     --line;
     if (line < 0)
         return false;
-    if ((unsigned long)line >= m_authors.size())
+    if ((unsigned long)line >= m_revs.size())
     {
-        line = (long)m_authors.size()-1;
+        line = (long)m_revs.size()-1;
     }
 
     int nCurrentPos = (int)SendEditor(SCI_GETCURRENTPOS);
@@ -1393,7 +1300,7 @@ LONG TortoiseBlame::GetBlameWidth()
     if (ShowAuthor)
     {
         SIZE maxwidth = {0};
-        for (auto I = m_authors.begin(); I != m_authors.end(); ++I)
+        for (auto I = m_authorset.begin(); I != m_authorset.end(); ++I)
         {
             ::GetTextExtentPoint32(hDC, I->c_str(), (int)I->size(), &width);
             if (width.cx > maxwidth.cx)
@@ -1405,9 +1312,11 @@ LONG TortoiseBlame::GetBlameWidth()
     if (ShowPath)
     {
         SIZE maxwidth = {0};
-        for (auto I = m_mergedPaths.begin(); I != m_mergedPaths.end(); ++I)
+        std::set<DWORD> paths(m_mergedPaths.begin(), m_mergedPaths.end());
+        for (auto I = paths.begin(); I != paths.end(); ++I)
         {
-            ::GetTextExtentPoint32(hDC, I->c_str(), (int)I->size(), &width);
+            const tstring& path = m_strings[*I];
+            ::GetTextExtentPoint32(hDC, path.c_str(), (int)path.size(), &width);
             if (width.cx > maxwidth.cx)
                 maxwidth = width;
         }
@@ -1471,8 +1380,8 @@ void TortoiseBlame::DrawBlame(HDC hDC)
             ::SetBkColor(hDC, m_windowColor);
             ::SetTextColor(hDC, m_textColor);
             tstring author;
-            if (i < (int)m_authors.size())
-                author = bUseMerged ? m_mergedAuthors[i] : m_authors[i];
+            if (i < (int)m_revs.size())
+                author = bUseMerged ? m_strings[m_mergedAuthors[i]] : m_strings[m_authors[i]];
             if (!author.empty())
             {
                 if (author.compare(m_mouseAuthor)==0)
@@ -1502,7 +1411,7 @@ void TortoiseBlame::DrawBlame(HDC hDC)
             if (ShowDate)
             {
                 rc.right = rc.left + Left + m_dateWidth;
-                swprintf_s(buf, L"%30s            ", bUseMerged ? m_mergedDates[i].c_str() : m_dates[i].c_str());
+                swprintf_s(buf, L"%30s            ", bUseMerged ? m_strings[m_mergedDates[i]].c_str() : m_strings[m_dates[i]].c_str());
                 ::ExtTextOut(hDC, Left, (int)Y, ETO_CLIPPED, &rc, buf, (UINT)wcslen(buf), 0);
                 Left += m_dateWidth;
             }
@@ -1516,7 +1425,7 @@ void TortoiseBlame::DrawBlame(HDC hDC)
             if (ShowPath && !m_mergedPaths.empty())
             {
                 rc.right = rc.left + Left + m_pathWidth;
-                swprintf_s(buf, L"%-60s            ", m_mergedPaths[i].c_str());
+                swprintf_s(buf, L"%-60s            ", m_strings[m_mergedPaths[i]].c_str());
                 ::ExtTextOut(hDC, Left, (int)Y, ETO_CLIPPED, &rc, buf, (UINT)wcslen(buf), 0);
                 Left += m_authorWidth;
             }
@@ -2079,7 +1988,7 @@ COLORREF TortoiseBlame::GetLineColor(Sci_Position line, bool bLocatorBar)
             return InterColor(DWORD(m_regOldLinesColor), DWORD(m_regNewLinesColor), (m_revs[line]-m_lowestRev)*100/((m_highestRev-m_lowestRev)+1));
         break;
     case COLORBYAUTHOR:
-        return m_authorcolormap[m_authors[line]];
+        return m_authorcolormap[m_strings[m_authors[line]]];
         break;
     case COLORBYNONE:
     default:
@@ -2212,6 +2121,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_COMMAND:
         app.Command(LOWORD(wParam));
         break;
+    case WM_TIMER:
+        if (wParam == TIMER_LOADBLAME)
+            app.LoadMoreData();
+        break;
     case WM_NOTIFY:
         app.Notify(reinterpret_cast<SCNotification *>(lParam));
         return 0;
@@ -2293,13 +2206,13 @@ LRESULT CALLBACK WndBlameProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPa
                 tstring msg;
                 if (!ShowAuthor)
                 {
-                    msg += app.m_authors[line];
+                    msg += app.m_strings[app.m_authors[line]];
                 }
                 if (!ShowDate)
                 {
                     if (!ShowAuthor)
                         msg += L"  ";
-                    msg += app.m_dates[line];
+                    msg += app.m_strings[app.m_dates[line]];
                 }
                 if ((iter = app.m_logMessages.find(rev)) != app.m_logMessages.end())
                 {
@@ -2391,9 +2304,9 @@ LRESULT CALLBACK WndBlameProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPa
             app.m_ttVisible = (line < (LONG)app.m_revs.size());
             if ( app.m_ttVisible )
             {
-                if (app.m_authors[line].compare(app.m_mouseAuthor) != 0)
+                if (app.m_strings[app.m_authors[line]].compare(app.m_mouseAuthor) != 0)
                 {
-                    app.m_mouseAuthor = app.m_authors[line];
+                    app.m_mouseAuthor = app.m_strings[app.m_authors[line]];
                 }
                 if (app.m_revs[line] != app.m_mouseRev)
                 {
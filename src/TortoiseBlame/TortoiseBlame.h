@@ -1,6 +1,6 @@
 ﻿// TortoiseBlame - a Viewer for Subversion Blames
 
-// Copyright (C) 2003-2010, 2012-2014, 2017-2018 - TortoiseSVN
+// Copyright (C) 2003-2010, 2012-2014, 2017-2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -22,9 +22,11 @@
 #include "Scintilla.h"
 #include "SciLexer.h"
 #include "registry.h"
+#include "BlameFile.h"
 
 #include <set>
 #include <deque>
+#include <memory>
 
 const COLORREF black = RGB(0,0,0);
 const COLORREF white = RGB(0xff,0xff,0xff);
@@ -41,6 +43,10 @@ const int blockSize = 128 * 1024;
 
 #define MAX_LOG_LENGTH 20000
 
+#define TIMER_LOADBLAME 100
+/// check whether the blame file is still being written after this many ms without new lines
+#define LOADBLAME_STALL_TIME 1000
+
 
 #ifndef GET_X_LPARAM
 #define GET_X_LPARAM(lp)                        ((int)(short)LOWORD(lp))
@@ -80,6 +86,8 @@ public:
 
     void SetTitle();
     BOOL OpenFile(const TCHAR *fileName);
+    /// adds the data that arrived since the last call in progressive mode
+    void LoadMoreData();
 
     void Command(int id);
     void Notify(SCNotification *notification);
@@ -123,11 +131,13 @@ public:
 
     std::deque<svn_revnum_t>    m_revs;
     std::deque<svn_revnum_t>    m_mergedRevs;
-    std::deque<tstring>         m_dates;
-    std::deque<tstring>         m_mergedDates;
-    std::deque<tstring>         m_authors;
-    std::deque<tstring>         m_mergedAuthors;
-    std::deque<tstring>         m_mergedPaths;
+    // per-line indices into m_strings
+    std::deque<DWORD>           m_dates;
+    std::deque<DWORD>           m_mergedDates;
+    std::deque<DWORD>           m_authors;
+    std::deque<DWORD>           m_mergedAuthors;
+    std::deque<DWORD>           m_mergedPaths;
+    std::vector<tstring>        m_strings;
     std::map<LONG, tstring>     m_logMessages;
     std::set<svn_revnum_t>      m_revset;
     std::set<tstring>           m_authorset;
@@ -147,6 +157,20 @@ protected:
     void SetupColoring();
     static std::wstring GetAppDirectory();
 
+    bool ReadLegacyFile(FILE * File);
+    bool ReadChunks(bool bFirstChunkOnly);
+    void AddLine(svn_revnum_t rev, svn_revnum_t mergedRev, DWORD author, DWORD date, DWORD mergedAuthor, DWORD mergedDate, DWORD mergedPath);
+    void AddLogMessage(svn_revnum_t rev, const std::string& message);
+    void ConvertString(DWORD id);
+    void UpdateAfterLoad();
+
+    std::unique_ptr<CBlameFileReader> m_reader;     ///< set while progressively loading
+    std::vector<bool>           m_convertedStrings;
+    std::vector<bool>           m_knownAuthors;
+    bool                        m_bHasMergePaths;
+    long                        m_pendingGotoLine;
+    ULONGLONG                   m_lastLoadTicks;    ///< when new lines were read the last time
+
     //std::vector<COLORREF>     m_colors;
     HFONT                       m_font;
     HFONT                       m_italicFont;
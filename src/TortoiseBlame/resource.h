@@ -12,6 +12,7 @@
 #define IDR_BLAMEPOPUP                  129
 #define IDD_GOTODLG                     130
 #define IDS_COMMANDLINE_INFO            200
+#define IDS_BLAMEINCOMPLETE             201
 #define IDS_HEADER_REVISION             300
 #define IDS_HEADER_DATE                 301
 #define IDS_HEADER_AUTHOR               302
@@ -0,0 +1,488 @@
+// TortoiseIDiff - an image diff viewer in TortoiseSVN
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "ImageCompare.h"
+#include <algorithm>
+#include <bitset>
+#include <system_error>
+#include <thread>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define IMAGECOMPARE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+    /// images below this size are not worth starting threads for
+    const uint64_t MIN_PIXELS_FOR_THREADS = 512 * 512;
+
+    inline int PixelDifference(uint32_t a, uint32_t b)
+    {
+        int maxDiff = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            int diff = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+            if (diff > maxDiff)
+                maxDiff = diff;
+        }
+        return maxDiff;
+    }
+
+    void DiffRowScalar(const uint32_t * pixels1, const uint32_t * pixels2, uint8_t * mask,
+                       size_t count, int threshold, uint64_t& sum, uint64_t& changed, int& maxDiff)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            int diff = PixelDifference(pixels1[i], pixels2[i]);
+            mask[i] = (uint8_t)diff;
+            sum += diff;
+            if (diff > threshold)
+                ++changed;
+            if (diff > maxDiff)
+                maxDiff = diff;
+        }
+    }
+
+#ifdef IMAGECOMPARE_X86
+    /// the largest channel difference of four pixels, in the low byte of each 32 bit lane
+    TARGET_SSE2 inline __m128i PixelDifferenceSSE2(__m128i a, __m128i b)
+    {
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        diff = _mm_max_epu8(diff, _mm_srli_epi32(diff, 8));
+        diff = _mm_max_epu8(diff, _mm_srli_epi32(diff, 16));
+        return _mm_and_si128(diff, _mm_set1_epi32(0xFF));
+    }
+
+    TARGET_SSE2 void DiffRowSSE2(const uint32_t * pixels1, const uint32_t * pixels2, uint8_t * mask,
+                                 size_t count, int threshold, uint64_t& sum, uint64_t& changed, int& maxDiff)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i thresholdVec = _mm_set1_epi8((char)threshold);
+        __m128i sumVec = zero;
+        __m128i maxVec = zero;
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i d0 = PixelDifferenceSSE2(_mm_loadu_si128((const __m128i*)(pixels1 + i)),      _mm_loadu_si128((const __m128i*)(pixels2 + i)));
+            __m128i d1 = PixelDifferenceSSE2(_mm_loadu_si128((const __m128i*)(pixels1 + i + 4)),  _mm_loadu_si128((const __m128i*)(pixels2 + i + 4)));
+            __m128i d2 = PixelDifferenceSSE2(_mm_loadu_si128((const __m128i*)(pixels1 + i + 8)),  _mm_loadu_si128((const __m128i*)(pixels2 + i + 8)));
+            __m128i d3 = PixelDifferenceSSE2(_mm_loadu_si128((const __m128i*)(pixels1 + i + 12)), _mm_loadu_si128((const __m128i*)(pixels2 + i + 12)));
+            __m128i diffs = _mm_packus_epi16(_mm_packs_epi32(d0, d1), _mm_packs_epi32(d2, d3));
+            _mm_storeu_si128((__m128i*)(mask + i), diffs);
+
+            sumVec = _mm_add_epi64(sumVec, _mm_sad_epu8(diffs, zero));
+            maxVec = _mm_max_epu8(maxVec, diffs);
+            unsigned int unchanged = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(diffs, thresholdVec), zero));
+            changed += 16 - std::bitset<16>(unchanged).count();
+        }
+
+        alignas(16) uint64_t sums[2];
+        _mm_store_si128((__m128i*)sums, sumVec);
+        sum += sums[0] + sums[1];
+        alignas(16) uint8_t maxima[16];
+        _mm_store_si128((__m128i*)maxima, maxVec);
+        for (uint8_t value : maxima)
+            maxDiff = (std::max<int>)(maxDiff, value);
+
+        DiffRowScalar(pixels1 + i, pixels2 + i, mask + i, count - i, threshold, sum, changed, maxDiff);
+    }
+
+    TARGET_AVX2 inline __m256i PixelDifferenceAVX2(__m256i a, __m256i b)
+    {
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+        diff = _mm256_max_epu8(diff, _mm256_srli_epi32(diff, 8));
+        diff = _mm256_max_epu8(diff, _mm256_srli_epi32(diff, 16));
+        return _mm256_and_si256(diff, _mm256_set1_epi32(0xFF));
+    }
+
+    TARGET_AVX2 void DiffRowAVX2(const uint32_t * pixels1, const uint32_t * pixels2, uint8_t * mask,
+                                 size_t count, int threshold, uint64_t& sum, uint64_t& changed, int& maxDiff)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i thresholdVec = _mm256_set1_epi8((char)threshold);
+        // the packs work within the 128 bit lanes, this restores the pixel order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        __m256i sumVec = zero;
+        __m256i maxVec = zero;
+        size_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            __m256i d0 = PixelDifferenceAVX2(_mm256_loadu_si256((const __m256i*)(pixels1 + i)),      _mm256_loadu_si256((const __m256i*)(pixels2 + i)));
+            __m256i d1 = PixelDifferenceAVX2(_mm256_loadu_si256((const __m256i*)(pixels1 + i + 8)),  _mm256_loadu_si256((const __m256i*)(pixels2 + i + 8)));
+            __m256i d2 = PixelDifferenceAVX2(_mm256_loadu_si256((const __m256i*)(pixels1 + i + 16)), _mm256_loadu_si256((const __m256i*)(pixels2 + i + 16)));
+            __m256i d3 = PixelDifferenceAVX2(_mm256_loadu_si256((const __m256i*)(pixels1 + i + 24)), _mm256_loadu_si256((const __m256i*)(pixels2 + i + 24)));
+            __m256i diffs = _mm256_packus_epi16(_mm256_packs_epi32(d0, d1), _mm256_packs_epi32(d2, d3));
+            diffs = _mm256_permutevar8x32_epi32(diffs, order);
+            _mm256_storeu_si256((__m256i*)(mask + i), diffs);
+
+            sumVec = _mm256_add_epi64(sumVec, _mm256_sad_epu8(diffs, zero));
+            maxVec = _mm256_max_epu8(maxVec, diffs);
+            unsigned int unchanged = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(diffs, thresholdVec), zero));
+            changed += 32 - std::bitset<32>(unchanged).count();
+        }
+
+        alignas(32) uint64_t sums[4];
+        _mm256_store_si256((__m256i*)sums, sumVec);
+        sum += sums[0] + sums[1] + sums[2] + sums[3];
+        alignas(32) uint8_t maxima[32];
+        _mm256_store_si256((__m256i*)maxima, maxVec);
+        for (uint8_t value : maxima)
+            maxDiff = (std::max<int>)(maxDiff, value);
+
+        DiffRowSSE2(pixels1 + i, pixels2 + i, mask + i, count - i, threshold, sum, changed, maxDiff);
+    }
+#endif
+
+    void XorPixelsScalar(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            dest[i] = ~(pixels1[i] ^ pixels2[i]);
+    }
+
+    void BlendPixelsScalar(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count, int weight)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t a = pixels1[i];
+            uint32_t b = pixels2[i];
+            // two channels at once, the products fit into 16 bits
+            uint32_t rb = (((a & 0xFF00FF) * (256 - weight) + (b & 0xFF00FF) * weight) >> 8) & 0xFF00FF;
+            uint32_t ga = ((((a >> 8) & 0xFF00FF) * (256 - weight) + ((b >> 8) & 0xFF00FF) * weight)) & 0xFF00FF00;
+            dest[i] = rb | ga;
+        }
+    }
+
+#ifdef IMAGECOMPARE_X86
+    TARGET_SSE2 void XorPixelsSSE2(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count)
+    {
+        const __m128i ones = _mm_set1_epi32(-1);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(pixels1 + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(pixels2 + i));
+            _mm_storeu_si128((__m128i*)(dest + i), _mm_xor_si128(_mm_xor_si128(a, b), ones));
+        }
+        XorPixelsScalar(pixels1 + i, pixels2 + i, dest + i, count - i);
+    }
+
+    TARGET_SSE2 void BlendPixelsSSE2(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count, int weight)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weight1 = _mm_set1_epi16((short)(256 - weight));
+        const __m128i weight2 = _mm_set1_epi16((short)weight);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(pixels1 + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(pixels2 + i));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), weight1),
+                                       _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), weight2));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), weight1),
+                                       _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), weight2));
+            _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+        }
+        BlendPixelsScalar(pixels1 + i, pixels2 + i, dest + i, count - i, weight);
+    }
+#endif
+}
+
+CImageCompare::CImageCompare()
+    : m_kernel(KERNEL_SCALAR)
+    , m_diffRow(nullptr)
+{
+    SetKernel(GetBestKernel());
+    Clear();
+}
+
+CImageCompare::~CImageCompare(void)
+{
+}
+
+CImageCompare::Kernel CImageCompare::GetBestKernel()
+{
+#ifdef IMAGECOMPARE_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool bSSE2 = (info[3] & (1 << 26)) != 0;
+    // AVX needs support by the OS as well, for saving the ymm registers
+    bool bAVX = ((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 6) == 6);
+    if (bAVX && (maxLeaf >= 7))
+    {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return KERNEL_AVX2;
+    }
+    if (bSSE2)
+        return KERNEL_SSE2;
+#else
+    if (__builtin_cpu_supports("avx2"))
+        return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return KERNEL_SSE2;
+#endif
+#endif
+    return KERNEL_SCALAR;
+}
+
+void CImageCompare::SetKernel(Kernel kernel)
+{
+    m_kernel = (std::min)(kernel, GetBestKernel());
+    switch (m_kernel)
+    {
+#ifdef IMAGECOMPARE_X86
+    case KERNEL_AVX2:
+        m_diffRow = DiffRowAVX2;
+        break;
+    case KERNEL_SSE2:
+        m_diffRow = DiffRowSSE2;
+        break;
+#endif
+    default:
+        m_kernel = KERNEL_SCALAR;
+        m_diffRow = DiffRowScalar;
+        break;
+    }
+}
+
+void CImageCompare::Clear()
+{
+    m_width = 0;
+    m_height = 0;
+    m_threshold = 0;
+    m_tilesX = 0;
+    m_tilesY = 0;
+    m_mask.clear();
+    m_mask.shrink_to_fit();
+    m_tileBounds.clear();
+    m_regions.clear();
+    m_result = Result();
+    m_statistics = Statistics();
+}
+
+void CImageCompare::Compare(const Image& image1, const Image& image2, int threshold)
+{
+    Begin((std::min)(image1.width, image2.width), (std::min)(image1.height, image2.height), threshold);
+    CompareRows(image1, image2, 0);
+    End();
+}
+
+void CImageCompare::Begin(int width, int height, int threshold)
+{
+    Clear();
+    m_width = (std::max)(width, 0);
+    m_height = (std::max)(height, 0);
+    m_threshold = (std::min)((std::max)(threshold, 0), 255);
+    m_tilesX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+    m_mask.assign((size_t)m_width * m_height, 0);
+    Region empty = { 0, 0, 0, 0 };
+    m_tileBounds.assign((size_t)m_tilesX * m_tilesY, empty);
+}
+
+void CImageCompare::CompareRows(const Image& strip1, const Image& strip2, int firstRow)
+{
+    if ((firstRow < 0) || (firstRow >= m_height) || (strip1.width < m_width) || (strip2.width < m_width))
+        return;
+    int endRow = (std::min)(m_height, firstRow + (std::min)(strip1.height, strip2.height));
+    if (endRow <= firstRow)
+        return;
+
+    // the bands consist of whole tile rows, so every tile is written by one thread only
+    int firstTileRow = firstRow / TILE_SIZE;
+    int tileRows = (endRow - 1) / TILE_SIZE - firstTileRow + 1;
+    int threadCount = 1;
+    if ((uint64_t)m_width * (endRow - firstRow) >= MIN_PIXELS_FOR_THREADS)
+    {
+        threadCount = (std::max<int>)(1, std::thread::hardware_concurrency());
+        threadCount = (std::max)(1, (std::min)(threadCount, tileRows / MIN_TILE_ROWS_PER_THREAD));
+    }
+
+    std::vector<Result> results(threadCount);
+    std::vector<std::thread> threads;
+    int band = 0;
+    for (; band < threadCount; ++band)
+    {
+        int beginRow = (std::max)(firstRow, (firstTileRow + tileRows * band / threadCount) * TILE_SIZE);
+        int bandEnd = (std::min)(endRow, (firstTileRow + tileRows * (band + 1) / threadCount) * TILE_SIZE);
+        if (band + 1 == threadCount)
+        {
+            // the last band is done by this thread
+            CompareBand(strip1, strip2, firstRow, beginRow, bandEnd, results[band]);
+            break;
+        }
+        try
+        {
+            threads.emplace_back(&CImageCompare::CompareBand, this, std::cref(strip1), std::cref(strip2),
+                                 firstRow, beginRow, bandEnd, std::ref(results[band]));
+        }
+        catch (const std::system_error&)
+        {
+            // no more threads available: do the remaining bands here
+            CompareBand(strip1, strip2, firstRow, beginRow, endRow, results[band]);
+            break;
+        }
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& result : results)
+    {
+        m_result.sum += result.sum;
+        m_result.changed += result.changed;
+        m_result.max = (std::max)(m_result.max, result.max);
+    }
+}
+
+void CImageCompare::CompareBand(const Image& strip1, const Image& strip2, int firstRow,
+                                int beginRow, int endRow, Result& result)
+{
+    for (int y = beginRow; y < endRow; ++y)
+    {
+        const uint32_t * row1 = strip1.pixels + (y - firstRow) * strip1.stride;
+        const uint32_t * row2 = strip2.pixels + (y - firstRow) * strip2.stride;
+        uint8_t * maskRow = &m_mask[(size_t)y * m_width];
+        Region * tiles = &m_tileBounds[(size_t)(y / TILE_SIZE) * m_tilesX];
+        for (int x = 0; x < m_width; x += TILE_SIZE)
+        {
+            size_t count = (std::min<size_t>)(TILE_SIZE, m_width - x);
+            uint64_t changed = 0;
+            m_diffRow(row1 + x, row2 + x, maskRow + x, count, m_threshold, result.sum, changed, result.max);
+            if (changed == 0)
+                continue;
+            result.changed += changed;
+
+            // shrink the tile bounds to the changed pixels
+            int left = 0;
+            while (maskRow[x + left] <= m_threshold)
+                ++left;
+            int right = (int)count;
+            while (maskRow[x + right - 1] <= m_threshold)
+                --right;
+            Region& tile = tiles[x / TILE_SIZE];
+            if (tile.left >= tile.right)
+            {
+                tile.left = x + left;
+                tile.right = x + right;
+                tile.top = y;
+            }
+            else
+            {
+                tile.left = (std::min)(tile.left, x + left);
+                tile.right = (std::max)(tile.right, x + right);
+            }
+            tile.bottom = y + 1;
+        }
+    }
+}
+
+void CImageCompare::End()
+{
+    m_statistics.comparedPixels = (uint64_t)m_width * m_height;
+    m_statistics.changedPixels = m_result.changed;
+    m_statistics.maxDifference = m_result.max;
+    m_statistics.meanDifference = m_statistics.comparedPixels ? (double)m_result.sum / m_statistics.comparedPixels : 0.0;
+    FindRegions();
+}
+
+void CImageCompare::FindRegions()
+{
+    // changed tiles which touch each other, also diagonally, form one region
+    m_regions.clear();
+    std::vector<bool> visited(m_tileBounds.size());
+    std::vector<int> stack;
+    for (size_t start = 0; start < m_tileBounds.size(); ++start)
+    {
+        if (visited[start] || (m_tileBounds[start].left >= m_tileBounds[start].right))
+            continue;
+
+        Region region = m_tileBounds[start];
+        visited[start] = true;
+        stack.push_back((int)start);
+        while (!stack.empty())
+        {
+            int tile = stack.back();
+            stack.pop_back();
+            const Region& bounds = m_tileBounds[tile];
+            region.left = (std::min)(region.left, bounds.left);
+            region.top = (std::min)(region.top, bounds.top);
+            region.right = (std::max)(region.right, bounds.right);
+            region.bottom = (std::max)(region.bottom, bounds.bottom);
+
+            int tx = tile % m_tilesX;
+            int ty = tile / m_tilesX;
+            for (int ny = (std::max)(ty - 1, 0); ny <= (std::min)(ty + 1, m_tilesY - 1); ++ny)
+            {
+                for (int nx = (std::max)(tx - 1, 0); nx <= (std::min)(tx + 1, m_tilesX - 1); ++nx)
+                {
+                    int neighbor = ny * m_tilesX + nx;
+                    if (!visited[neighbor] && (m_tileBounds[neighbor].left < m_tileBounds[neighbor].right))
+                    {
+                        visited[neighbor] = true;
+                        stack.push_back(neighbor);
+                    }
+                }
+            }
+        }
+        m_regions.push_back(region);
+    }
+
+    std::sort(m_regions.begin(), m_regions.end(), [](const Region& a, const Region& b)
+    {
+        return (a.top < b.top) || ((a.top == b.top) && (a.left < b.left));
+    });
+}
+
+void CImageCompare::XorPixels(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count)
+{
+#ifdef IMAGECOMPARE_X86
+    static const bool bSSE2 = GetBestKernel() != KERNEL_SCALAR;
+    if (bSSE2)
+        return XorPixelsSSE2(pixels1, pixels2, dest, count);
+#endif
+    XorPixelsScalar(pixels1, pixels2, dest, count);
+}
+
+void CImageCompare::BlendPixels(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count, int alpha)
+{
+    // maps 0..255 to 0..256, so both ends give one of the images unchanged
+    alpha = (std::min)((std::max)(alpha, 0), 255);
+    int weight = alpha + (alpha >> 7);
+#ifdef IMAGECOMPARE_X86
+    static const bool bSSE2 = GetBestKernel() != KERNEL_SCALAR;
+    if (bSSE2)
+        return BlendPixelsSSE2(pixels1, pixels2, dest, count, weight);
+#endif
+    BlendPixelsScalar(pixels1, pixels2, dest, count, weight);
+}
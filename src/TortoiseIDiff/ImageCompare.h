@@ -0,0 +1,153 @@
+// TortoiseIDiff - an image diff viewer in TortoiseSVN
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \ingroup TortoiseIDiff
+ * Compares two images pixel by pixel.
+ *
+ * The images are passed as 32 bit pixels with 8 bits per channel. The
+ * channel order doesn't matter as long as it is the same for both images.
+ * Only the area which is covered by both images, aligned at the top left
+ * corner, is compared.
+ *
+ * The images are split into tiles, and bands of tile rows are compared by
+ * several threads. The rows are processed with SSE2 or AVX2 if the CPU
+ * supports it. This class does not depend on GDI or GDI+.
+ */
+class CImageCompare
+{
+public:
+    /// the pixels of an image, \c stride is the distance between two rows in pixels
+    struct Image
+    {
+        const uint32_t *    pixels;
+        int                 width;
+        int                 height;
+        ptrdiff_t           stride;
+    };
+
+    /// a changed area of the images, right and bottom are exclusive
+    struct Region
+    {
+        int                 left;
+        int                 top;
+        int                 right;
+        int                 bottom;
+    };
+
+    struct Statistics
+    {
+        uint64_t            comparedPixels;
+        uint64_t            changedPixels;      ///< pixels which differ by more than the threshold
+        int                 maxDifference;
+        double              meanDifference;     ///< average difference of all compared pixels
+    };
+
+    enum Kernel
+    {
+        KERNEL_SCALAR,
+        KERNEL_SSE2,
+        KERNEL_AVX2
+    };
+
+    CImageCompare();
+    ~CImageCompare(void);
+
+    /**
+     * Compares the images. A pixel has changed if one of its channels
+     * differs by more than \a threshold.
+     */
+    void                        Compare(const Image& image1, const Image& image2, int threshold = 0);
+
+    /**
+     * Compares images which are too big to be kept in memory as a whole.
+     * Begin() sets the size of the compared area, then CompareRows() is
+     * called for consecutive strips of rows. The first pixel of the strips
+     * is the first pixel of row \a firstRow. End() finishes the statistics
+     * and the regions.
+     */
+    void                        Begin(int width, int height, int threshold = 0);
+    void                        CompareRows(const Image& strip1, const Image& strip2, int firstRow);
+    void                        End();
+
+    void                        Clear();
+
+    /// size of the compared area
+    int                         GetWidth() const { return m_width; }
+    int                         GetHeight() const { return m_height; }
+    /// the largest channel difference of every compared pixel, row by row
+    const std::vector<uint8_t>& GetMask() const { return m_mask; }
+    /// the bounding boxes of the changed areas, ordered from top to bottom
+    const std::vector<Region>&  GetRegions() const { return m_regions; }
+    const Statistics&           GetStatistics() const { return m_statistics; }
+
+    /// returns the fastest kernel the CPU supports
+    static Kernel               GetBestKernel();
+    /// uses \a kernel for the comparisons if the CPU supports it
+    void                        SetKernel(Kernel kernel);
+    Kernel                      GetKernel() const { return m_kernel; }
+
+    /// dest = ~(pixels1 ^ pixels2), the same as drawing one image over the
+    /// other with SRCINVERT and inverting the result. \a dest may be \a pixels1.
+    static void                 XorPixels(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count);
+    /// dest = pixels1 + (pixels2 - pixels1) * alpha / 255 for every channel.
+    /// \a dest may be \a pixels1.
+    static void                 BlendPixels(const uint32_t * pixels1, const uint32_t * pixels2, uint32_t * dest, size_t count, int alpha);
+
+private:
+    enum
+    {
+        TILE_SIZE = 64,
+        MIN_TILE_ROWS_PER_THREAD = 4
+    };
+
+    /// results of a part of the images
+    struct Result
+    {
+        uint64_t            sum;
+        uint64_t            changed;
+        int                 max;
+    };
+
+    /// writes the mask of \a count pixels and adds their difference to \a sum,
+    /// \a changed and \a maxDiff
+    typedef void (*DiffRowFunc)(const uint32_t * pixels1, const uint32_t * pixels2, uint8_t * mask,
+                                size_t count, int threshold, uint64_t& sum, uint64_t& changed, int& maxDiff);
+
+    void                        CompareBand(const Image& strip1, const Image& strip2, int firstRow,
+                                            int beginRow, int endRow, Result& result);
+    void                        FindRegions();
+
+    int                         m_width;
+    int                         m_height;
+    int                         m_threshold;
+    int                         m_tilesX;
+    int                         m_tilesY;
+    std::vector<uint8_t>        m_mask;
+    std::vector<Region>         m_tileBounds;   ///< changed pixels per tile, empty if left >= right
+    std::vector<Region>         m_regions;
+    Result                      m_result;
+    Statistics                  m_statistics;
+    Kernel                      m_kernel;
+    DiffRowFunc                 m_diffRow;
+};
@@ -0,0 +1,310 @@
+// TortoiseIDiff - an image diff viewer in TortoiseSVN
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "ImagePyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+namespace
+{
+    /// interpolates every channel between \a a and \a b, \a weight is 0..256
+    inline uint32_t Lerp(uint32_t a, uint32_t b, uint32_t weight)
+    {
+        if (weight == 0)
+            return a;
+        // two channels at once, the products fit into 16 bits
+        uint32_t rb = (((a & 0xFF00FF) * (256 - weight) + (b & 0xFF00FF) * weight) >> 8) & 0xFF00FF;
+        uint32_t ag = (((a >> 8) & 0xFF00FF) * (256 - weight) + ((b >> 8) & 0xFF00FF) * weight) & 0xFF00FF00;
+        return rb | ag;
+    }
+
+    inline uint32_t Average(uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3)
+    {
+        uint32_t rb = (((p0 & 0xFF00FF) + (p1 & 0xFF00FF) + (p2 & 0xFF00FF) + (p3 & 0xFF00FF) + 0x20002) >> 2) & 0xFF00FF;
+        uint32_t ag = ((((p0 >> 8) & 0xFF00FF) + ((p1 >> 8) & 0xFF00FF) + ((p2 >> 8) & 0xFF00FF) + ((p3 >> 8) & 0xFF00FF) + 0x20002) << 6) & 0xFF00FF00;
+        return rb | ag;
+    }
+
+    /// blends a premultiplied pixel over the background
+    inline uint32_t Compose(uint32_t pixel, uint32_t background)
+    {
+        uint32_t alpha = pixel >> 24;
+        if (alpha == 255)
+            return pixel & 0xFFFFFF;
+        uint32_t weight = 256 - (alpha + (alpha >> 7));
+        uint32_t rb = (pixel & 0xFF00FF) + ((((background & 0xFF00FF) * weight) >> 8) & 0xFF00FF);
+        uint32_t g = (pixel & 0xFF00) + ((((background & 0xFF00) * weight) >> 8) & 0xFF00);
+        return rb | g;
+    }
+
+    /// maps the pixels of a scaled image to the two nearest source pixels and their weight
+    struct SourcePos
+    {
+        int         pos0;
+        int         pos1;
+        uint32_t    weight;
+    };
+
+    inline SourcePos GetSourcePos(int pos, double ratio, int size)
+    {
+        // pixel centers are at +0.5
+        double source = (pos + 0.5) * ratio - 0.5;
+        SourcePos result;
+        if (source <= 0.0)
+        {
+            result.pos0 = result.pos1 = 0;
+            result.weight = 0;
+            return result;
+        }
+        double base = std::floor(source);
+        result.pos0 = (std::min)((int)base, size - 1);
+        result.pos1 = (std::min)(result.pos0 + 1, size - 1);
+        result.weight = (uint32_t)((source - base) * 256.0 + 0.5);
+        return result;
+    }
+}
+
+CImagePyramid::CImagePyramid()
+    : m_width(0)
+    , m_height(0)
+    , m_readyLevels(0)
+    , m_bLoading(false)
+    , m_bCancel(false)
+{
+}
+
+CImagePyramid::~CImagePyramid(void)
+{
+    Clear();
+}
+
+void CImagePyramid::Clear()
+{
+    m_bCancel = true;
+    if (m_thread.joinable())
+        m_thread.join();
+    m_bCancel = false;
+    m_bLoading = false;
+    m_source = nullptr;
+    m_onLevelReady = nullptr;
+    m_readyLevels = 0;
+    m_levels.clear();
+    m_width = 0;
+    m_height = 0;
+}
+
+bool CImagePyramid::Create(int width, int height)
+{
+    Clear();
+    if ((width <= 0) || (height <= 0))
+        return false;
+
+    try
+    {
+        for (;;)
+        {
+            Level level;
+            level.width = width;
+            level.height = height;
+            level.tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+            size_t tileCount = (size_t)level.tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+            level.tiles.reserve(tileCount);
+            for (size_t i = 0; i < tileCount; ++i)
+                level.tiles.emplace_back(new uint32_t[TILE_SIZE * TILE_SIZE]);
+            m_levels.push_back(std::move(level));
+
+            // the last level fits into a single tile
+            if ((width <= TILE_SIZE) && (height <= TILE_SIZE))
+                break;
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        m_levels.clear();
+        return false;
+    }
+    m_width = m_levels[0].width;
+    m_height = m_levels[0].height;
+    return true;
+}
+
+void CImagePyramid::SetRows(const uint32_t * pixels, ptrdiff_t stride, int firstRow, int rows)
+{
+    if (m_levels.empty())
+        return;
+    Level& level = m_levels[0];
+    int endRow = (std::min)(firstRow + rows, level.height);
+    for (int y = (std::max)(firstRow, 0); y < endRow; ++y)
+    {
+        const uint32_t * source = pixels + (y - firstRow) * stride;
+        for (int x = 0; x < level.width; x += TILE_SIZE)
+        {
+            uint32_t * tile = level.tiles[(size_t)(y >> TILE_SHIFT) * level.tilesX + (x >> TILE_SHIFT)].get();
+            int count = (std::min)((int)TILE_SIZE, level.width - x);
+            memcpy(tile + ((y & (TILE_SIZE - 1)) << TILE_SHIFT), source + x, count * sizeof(uint32_t));
+        }
+    }
+}
+
+bool CImagePyramid::LoadTiles(const PixelSource& source)
+{
+    if (m_levels.empty())
+        return false;
+    // the source writes right into the tiles, the image is never copied as a whole
+    Level& level = m_levels[0];
+    for (int y = 0; y < level.height; y += TILE_SIZE)
+    {
+        for (int x = 0; x < level.width; x += TILE_SIZE)
+        {
+            if (m_bCancel)
+                return false;
+            uint32_t * tile = level.tiles[(size_t)(y >> TILE_SHIFT) * level.tilesX + (x >> TILE_SHIFT)].get();
+            if (!source(x, y, (std::min)((int)TILE_SIZE, level.width - x), (std::min)((int)TILE_SIZE, level.height - y), tile, TILE_SIZE))
+                return false;
+        }
+    }
+    return true;
+}
+
+void CImagePyramid::BuildLevels()
+{
+    if (m_levels.empty())
+        return;
+    m_readyLevels.store(1, std::memory_order_release);
+    for (int level = 1; level < (int)m_levels.size(); ++level)
+    {
+        Downsample(level);
+        if (m_bCancel)
+            return;
+        m_readyLevels.store(level + 1, std::memory_order_release);
+        if (m_onLevelReady)
+            m_onLevelReady(level);
+    }
+}
+
+void CImagePyramid::BuildAsync(const PixelSource& source, const ReadyCallback& onLevelReady)
+{
+    if (m_levels.empty() || m_thread.joinable())
+        return;
+    m_source = source;
+    m_onLevelReady = onLevelReady;
+    m_bLoading.store(true, std::memory_order_release);
+    try
+    {
+        m_thread = std::thread(&CImagePyramid::BuildThread, this);
+    }
+    catch (const std::system_error&)
+    {
+        BuildThread();
+    }
+}
+
+void CImagePyramid::BuildThread()
+{
+    bool bLoaded = LoadTiles(m_source);
+    m_source = nullptr;
+    if (bLoaded)
+        m_readyLevels.store(1, std::memory_order_release);
+    m_bLoading.store(false, std::memory_order_release);
+    if (m_bCancel)
+        return;
+    if (m_onLevelReady)
+        m_onLevelReady(bLoaded ? 0 : -1);
+    if (bLoaded)
+        BuildLevels();
+}
+
+void CImagePyramid::Downsample(int level)
+{
+    const Level& source = m_levels[level - 1];
+    Level& dest = m_levels[level];
+    for (int y = 0; y < dest.height; ++y)
+    {
+        if (m_bCancel)
+            return;
+        int y0 = 2 * y;
+        int y1 = (std::min)(y0 + 1, source.height - 1);
+        for (int x = 0; x < dest.width; x += TILE_SIZE)
+        {
+            uint32_t * target = dest.tiles[(size_t)(y >> TILE_SHIFT) * dest.tilesX + (x >> TILE_SHIFT)].get()
+                                + ((y & (TILE_SIZE - 1)) << TILE_SHIFT);
+            int count = (std::min)((int)TILE_SIZE, dest.width - x);
+            for (int i = 0; i < count; ++i)
+            {
+                int x0 = 2 * (x + i);
+                int x1 = (std::min)(x0 + 1, source.width - 1);
+                target[i] = Average(Pixel(source, x0, y0), Pixel(source, x1, y0),
+                                    Pixel(source, x0, y1), Pixel(source, x1, y1));
+            }
+        }
+    }
+}
+
+int CImagePyramid::GetLevel(double scale) const
+{
+    int level = 0;
+    while ((level + 1 < (int)m_levels.size()) && (scale * m_width <= m_levels[level + 1].width) && (scale * m_height <= m_levels[level + 1].height))
+        ++level;
+    return level;
+}
+
+bool CImagePyramid::Sample(int picWidth, int picHeight, int left, int top, int width, int height,
+                           uint32_t * dest, ptrdiff_t stride, uint32_t background) const
+{
+    int readyLevels = GetReadyLevels();
+    if ((readyLevels == 0) || (picWidth <= 0) || (picHeight <= 0))
+        return false;
+
+    // only the part which is covered by the scaled image
+    int startX = (std::max)(0, -left);
+    int endX = (std::min)(width, picWidth - left);
+    int startY = (std::max)(0, -top);
+    int endY = (std::min)(height, picHeight - top);
+    if ((startX >= endX) || (startY >= endY))
+        return true;
+
+    double scale = (std::max)((double)picWidth / m_width, (double)picHeight / m_height);
+    const Level& level = m_levels[(std::min)(GetLevel(scale), readyLevels - 1)];
+    double ratioX = (double)level.width / picWidth;
+    double ratioY = (double)level.height / picHeight;
+
+    std::vector<SourcePos> columns(endX - startX);
+    for (int x = startX; x < endX; ++x)
+        columns[x - startX] = GetSourcePos(left + x, ratioX, level.width);
+
+    for (int y = startY; y < endY; ++y)
+    {
+        SourcePos row = GetSourcePos(top + y, ratioY, level.height);
+        uint32_t * target = dest + y * stride;
+        for (int x = startX; x < endX; ++x)
+        {
+            const SourcePos& column = columns[x - startX];
+            uint32_t pixel = Lerp(Pixel(level, column.pos0, row.pos0), Pixel(level, column.pos1, row.pos0), column.weight);
+            if (row.weight)
+                pixel = Lerp(pixel, Lerp(Pixel(level, column.pos0, row.pos1), Pixel(level, column.pos1, row.pos1), column.weight), row.weight);
+            target[x] = Compose(pixel, background);
+        }
+    }
+    return true;
+}
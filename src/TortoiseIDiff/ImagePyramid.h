@@ -0,0 +1,129 @@
+// TortoiseIDiff - an image diff viewer in TortoiseSVN
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * \ingroup TortoiseIDiff
+ * Stores an image in tiles, together with versions of it at half, a quarter,
+ * ... of its size (a mip pyramid).
+ *
+ * The pixels are premultiplied ARGB. The full size level is filled with
+ * SetRows() or LoadTiles(), the smaller levels are then generated by
+ * BuildLevels(). BuildAsync() does both in a background thread. Until a
+ * level is ready, Sample() uses the next larger one.
+ *
+ * Drawing only reads the tiles of the level which matches the zoom, and
+ * only the part of them which is visible. This class does not depend on
+ * GDI or GDI+.
+ */
+class CImagePyramid
+{
+public:
+    enum
+    {
+        TILE_SHIFT = 8,
+        TILE_SIZE = 1 << TILE_SHIFT
+    };
+
+    /// called with the index of a level which can be used, -1 if the full size level couldn't be read
+    typedef std::function<void(int level)> ReadyCallback;
+    /// copies a part of the full size image into \a pixels, \a stride is the
+    /// distance between two rows in pixels. Returns false if that fails.
+    typedef std::function<bool(int left, int top, int width, int height, uint32_t * pixels, ptrdiff_t stride)> PixelSource;
+
+    CImagePyramid();
+    ~CImagePyramid(void);
+
+    /// allocates the tiles of all levels for an image of the given size
+    bool        Create(int width, int height);
+    /// stops building the levels and frees the tiles
+    void        Clear();
+
+    /// copies \a rows rows of the full size image, starting with row \a firstRow.
+    /// \a stride is the distance between two rows in pixels.
+    void        SetRows(const uint32_t * pixels, ptrdiff_t stride, int firstRow, int rows);
+    /// reads the full size level from \a source, one tile at a time
+    bool        LoadTiles(const PixelSource& source);
+    /// generates the smaller levels, after the full size level has been filled
+    void        BuildLevels();
+    /// reads the full size level and generates the smaller ones in a background
+    /// thread. \a onLevelReady is called from that thread for every level which
+    /// can be used. \a source is only called until the full size level is done.
+    void        BuildAsync(const PixelSource& source, const ReadyCallback& onLevelReady);
+
+    /// true if the full size level is complete
+    bool        IsValid() const { return GetReadyLevels() > 0; }
+    /// true while BuildAsync() is still reading the full size level
+    bool        IsLoading() const { return m_bLoading.load(std::memory_order_acquire); }
+    int         GetWidth() const { return m_width; }
+    int         GetHeight() const { return m_height; }
+    int         GetLevelCount() const { return (int)m_levels.size(); }
+    int         GetReadyLevels() const { return m_readyLevels.load(std::memory_order_acquire); }
+    int         GetLevelWidth(int level) const { return m_levels[level].width; }
+    int         GetLevelHeight(int level) const { return m_levels[level].height; }
+    /// returns the smallest level which still has enough pixels for drawing at \a scale
+    int         GetLevel(double scale) const;
+    /// returns the pixel of a level which is ready
+    uint32_t    GetPixel(int level, int x, int y) const { return Pixel(m_levels[level], x, y); }
+
+    /**
+     * Draws a part of the image, scaled to \a picWidth x \a picHeight, into
+     * \a dest. The part starts at \a left, \a top of the scaled image and is
+     * \a width x \a height pixels big. Pixels outside the scaled image are
+     * not touched. The image is blended over \a background (0x00RRGGBB), the
+     * alpha channel of \a dest is cleared.
+     */
+    bool        Sample(int picWidth, int picHeight, int left, int top, int width, int height,
+                       uint32_t * dest, ptrdiff_t stride, uint32_t background) const;
+
+private:
+    struct Level
+    {
+        int                                     width;
+        int                                     height;
+        int                                     tilesX;
+        std::vector<std::unique_ptr<uint32_t[]>> tiles;
+    };
+
+    static uint32_t Pixel(const Level& level, int x, int y)
+    {
+        return level.tiles[(size_t)(y >> TILE_SHIFT) * level.tilesX + (x >> TILE_SHIFT)]
+                          [((y & (TILE_SIZE - 1)) << TILE_SHIFT) + (x & (TILE_SIZE - 1))];
+    }
+
+    void        Downsample(int level);
+    void        BuildThread();
+
+    int                 m_width;
+    int                 m_height;
+    std::vector<Level>  m_levels;
+    std::atomic<int>    m_readyLevels;
+    std::atomic<bool>   m_bLoading;
+    std::atomic<bool>   m_bCancel;
+    PixelSource         m_source;
+    ReadyCallback       m_onLevelReady;
+    std::thread         m_thread;
+};
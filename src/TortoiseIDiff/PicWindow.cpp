@@ -1,6 +1,6 @@
 ﻿// TortoiseIDiff - an image diff viewer in TortoiseSVN
 
-// Copyright (C) 2006-2016, 2018 - TortoiseSVN
+// Copyright (C) 2006-2016, 2018, 2026 - TortoiseSVN
 // Copyright (C) 2016 - TortoiseGit
 
 // This program is free software; you can redistribute it and/or
@@ -29,6 +29,12 @@
 #pragma comment(lib, "Msimg32.lib")
 #pragma comment(lib, "shell32.lib")
 
+/// animations and multi page images get no pyramid, it could only hold the active frame
+static bool IsSingleImage(CPicture& pic)
+{
+    return (pic.GetNumberOfDimensions() <= 1) && (pic.GetNumberOfFrames(0) <= 1);
+}
+
 bool CPicWindow::RegisterAndCreateWindow(HWND hParent)
 {
     WNDCLASSEX wcx;
@@ -143,6 +149,9 @@ LRESULT CALLBACK CPicWindow::WinMsgHandler(HWND hwnd, UINT uMsg, WPARAM wParam,
     case WM_PAINT:
         Paint(hwnd);
         break;
+    case WM_PYRAMIDLOADED:
+        OnPyramidLoaded();
+        break;
     case WM_SIZE:
         PositionTrackBar();
         SetupScrollBars();
@@ -526,6 +535,7 @@ void CPicWindow::NextImage()
     if (nCurrentFrame > picture.GetNumberOfFrames(0))
         nCurrentFrame = picture.GetNumberOfFrames(0);
     picture.SetActiveFrame(nCurrentFrame >= nCurrentDimension ? nCurrentFrame : nCurrentDimension);
+    CompareImages();
     InvalidateRect(*this, nullptr, FALSE);
     PositionChildren();
 }
@@ -539,6 +549,7 @@ void CPicWindow::PrevImage()
     if (nCurrentFrame < 1)
         nCurrentFrame = 1;
     picture.SetActiveFrame(nCurrentFrame >= nCurrentDimension ? nCurrentFrame : nCurrentDimension);
+    CompareImages();
     InvalidateRect(*this, nullptr, FALSE);
     PositionChildren();
 }
@@ -561,11 +572,19 @@ void CPicWindow::SetPic(const tstring& path, const tstring& title, bool bFirst)
 {
     bMainPic = bFirst;
     picpath=path;pictitle=title;
+    // the pyramid may still be reading the old picture
+    m_pyramid.Clear();
     picture.SetInterpolationMode(InterpolationModeHighQualityBicubic);
     bValid = picture.Load(picpath);
     nDimensions = picture.GetNumberOfDimensions();
     if (nDimensions)
         nFrames = picture.GetNumberOfFrames(0);
+    BuildPyramid();
+    // drop the old results, the other window may show this picture as its
+    // overlay. OnPyramidLoaded() compares again without waiting for a paint.
+    CompareImages();
+    if (pTheOtherPic && (pTheOtherPic->pSecondPic == &picture))
+        pTheOtherPic->CompareImages();
     if (bValid)
     {
         picscale = 100;
@@ -769,7 +788,7 @@ void CPicWindow::OnVScroll(UINT nSBCode, UINT nPos)
     switch (nSBCode)
     {
     case SB_BOTTOM:
-        nVScrollPos = LONG(picture.GetHeight()*picscale/100);
+        nVScrollPos = LONG(picture.m_Height*picscale/100);
         break;
     case SB_TOP:
         nVScrollPos = 0;
@@ -795,10 +814,10 @@ void CPicWindow::OnVScroll(UINT nSBCode, UINT nPos)
     default:
         return;
     }
-    LONG height = LONG(picture.GetHeight()*picscale/100);
+    LONG height = LONG(picture.m_Height*picscale/100);
     if (pSecondPic)
     {
-        height = max(height, LONG(pSecondPic->GetHeight()*picscale/100));
+        height = max(height, LONG(pSecondPic->m_Height*picscale/100));
         nVSecondScrollPos = nVScrollPos;
     }
     SetupScrollBars();
@@ -814,7 +833,7 @@ void CPicWindow::OnHScroll(UINT nSBCode, UINT nPos)
     switch (nSBCode)
     {
     case SB_RIGHT:
-        nHScrollPos = LONG(picture.GetWidth()*picscale/100);
+        nHScrollPos = LONG(picture.m_Width*picscale/100);
         break;
     case SB_LEFT:
         nHScrollPos = 0;
@@ -840,10 +859,10 @@ void CPicWindow::OnHScroll(UINT nSBCode, UINT nPos)
     default:
         return;
     }
-    LONG width = LONG(picture.GetWidth()*picscale/100);
+    LONG width = LONG(picture.m_Width*picscale/100);
     if (pSecondPic)
     {
-        width = max(width, LONG(pSecondPic->GetWidth()*picscale/100));
+        width = max(width, LONG(pSecondPic->m_Width*picscale/100));
         nHSecondScrollPos = nHScrollPos;
     }
     SetupScrollBars();
@@ -1153,6 +1172,14 @@ void CPicWindow::ShowPicWithBorder(HDC hdc, const RECT &bounds, CPicture &pic, i
     ::SetBkColor(hdc, transparentColor);
     ::ExtTextOut(hdc, 0, 0, ETO_OPAQUE, &bounds, nullptr, 0, nullptr);
 
+    RECT picrect = GetPicRect(bounds, pic, scale);
+    if (!DrawPyramid(hdc, bounds, pic, picrect) && !IsPyramidLoading(pic))
+        pic.Show(hdc, picrect);
+    DrawPicBorder(hdc, picrect);
+}
+
+RECT CPicWindow::GetPicRect(const RECT &bounds, CPicture &pic, int scale)
+{
     RECT picrect;
     picrect.left =  bounds.left - nHScrollPos;
     picrect.top = bounds.top - nVScrollPos;
@@ -1168,9 +1195,11 @@ void CPicWindow::ShowPicWithBorder(HDC hdc, const RECT &bounds, CPicture &pic, i
         picrect.right = picrect.left + m_linkedWidth;
     if (bFitHeights && m_linkedHeight)
         picrect.bottom = picrect.top + m_linkedHeight;
+    return picrect;
+}
 
-    pic.Show(hdc, picrect);
-
+void CPicWindow::DrawPicBorder(HDC hdc, const RECT &picrect)
+{
     const auto bordersize = CDPIAware::Instance().Scale(1);
 
     RECT border;
@@ -1190,6 +1219,238 @@ void CPicWindow::ShowPicWithBorder(HDC hdc, const RECT &bounds, CPicture &pic, i
     DeleteObject(hPen);
 }
 
+void CPicWindow::BuildPyramid()
+{
+    m_pyramid.Clear();
+    if (!bValid || !IsSingleImage(picture))
+        return;
+
+    long width = picture.m_Width;
+    long height = picture.m_Height;
+    if ((width <= 0) || (height <= 0) || !m_pyramid.Create(width, height))
+        return;
+
+    // the tiles are read in the background, right into the pyramid. Until
+    // OnPyramidLoaded() this thread must not use the pixels of the picture.
+    CPicture * pPicture = &picture;
+    m_pyramid.BuildAsync([pPicture](int left, int top, int cx, int cy, uint32_t * pixels, ptrdiff_t stride) -> bool
+    {
+        return pPicture->GetPixels(left, top, cx, cy, pixels, (int)stride);
+    },
+    [this](int level)
+    {
+        if (level <= 0)
+        {
+            if (m_hwnd)
+                PostMessage(*this, WM_PYRAMIDLOADED, 0, 0);
+            return;
+        }
+        // the overlay in the other window may show this picture too
+        if (m_hwnd)
+            InvalidateRect(*this, nullptr, FALSE);
+        if (pTheOtherPic && (HWND)*pTheOtherPic)
+            InvalidateRect(*pTheOtherPic, nullptr, FALSE);
+    });
+}
+
+void CPicWindow::OnPyramidLoaded()
+{
+    // a newer picture is being read, its own message follows
+    if (m_pyramid.IsLoading())
+        return;
+    if (m_pyramid.IsValid())
+        picture.ReleasePixels();
+    else
+        m_pyramid.Clear();  // GDI+ draws the picture
+
+    CompareImages();
+    if (pTheOtherPic && (pTheOtherPic->pSecondPic == &picture))
+    {
+        pTheOtherPic->CompareImages();
+        InvalidateRect(*pTheOtherPic, nullptr, FALSE);
+    }
+    InvalidateRect(*this, nullptr, FALSE);
+}
+
+const CImagePyramid * CPicWindow::FindPyramid(CPicture &pic) const
+{
+    if (&pic == &picture)
+        return &m_pyramid;
+    if (pTheOtherPic && (&pic == &pTheOtherPic->picture))
+        return &pTheOtherPic->m_pyramid;
+    return nullptr;
+}
+
+const CImagePyramid * CPicWindow::GetPyramid(CPicture &pic) const
+{
+    const CImagePyramid * pPyramid = FindPyramid(pic);
+    return (pPyramid && pPyramid->IsValid()) ? pPyramid : nullptr;
+}
+
+bool CPicWindow::IsPyramidLoading(CPicture &pic) const
+{
+    const CImagePyramid * pPyramid = FindPyramid(pic);
+    return pPyramid && pPyramid->IsLoading();
+}
+
+uint32_t CPicWindow::GetBackgroundPixel() const
+{
+    return (GetRValue(transparentColor) << 16) | (GetGValue(transparentColor) << 8) | GetBValue(transparentColor);
+}
+
+/// draws 32 bit top-down pixels
+static void DrawPixels(HDC hdc, long left, long top, long width, long height, const uint32_t * pixels)
+{
+    BITMAPINFO bmi = { 0 };
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    SetDIBitsToDevice(hdc, left, top, width, height, 0, 0, 0, height, pixels, &bmi, DIB_RGB_COLORS);
+}
+
+bool CPicWindow::DrawPyramid(HDC hdc, const RECT &bounds, CPicture &pic, const RECT &picrect)
+{
+    const CImagePyramid * pPyramid = GetPyramid(pic);
+    if (pPyramid == nullptr)
+        return false;
+
+    RECT visible;
+    if (!IntersectRect(&visible, &bounds, &picrect))
+        return true;
+    long width = visible.right - visible.left;
+    long height = visible.bottom - visible.top;
+    std::vector<uint32_t> pixels;
+    try
+    {
+        pixels.resize((size_t)width * height);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+    pPyramid->Sample(picrect.right - picrect.left, picrect.bottom - picrect.top,
+                     visible.left - picrect.left, visible.top - picrect.top, width, height,
+                     pixels.data(), width, GetBackgroundPixel());
+    DrawPixels(hdc, visible.left, visible.top, width, height, pixels.data());
+    return true;
+}
+
+bool CPicWindow::PaintComposite(HDC hdc, const RECT &bounds)
+{
+    if ((pSecondPic == nullptr) || (pTheOtherPic == nullptr))
+        return false;
+    const CImagePyramid * pPyramid1 = GetPyramid(picture);
+    const CImagePyramid * pPyramid2 = GetPyramid(*pSecondPic);
+    if ((pPyramid1 == nullptr) || (pPyramid2 == nullptr))
+        return false;
+
+    long width = bounds.right - bounds.left;
+    long height = bounds.bottom - bounds.top;
+    if ((width <= 0) || (height <= 0))
+        return false;
+
+    uint32_t background = GetBackgroundPixel();
+    std::vector<uint32_t> layer1;
+    std::vector<uint32_t> layer2;
+    try
+    {
+        layer1.assign((size_t)width * height, background);
+        layer2.assign((size_t)width * height, background);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+    RECT picrect1 = GetPicRect(bounds, picture, picscale);
+    RECT picrect2 = GetPicRect(bounds, *pSecondPic, pTheOtherPic->GetZoom());
+    pPyramid1->Sample(picrect1.right - picrect1.left, picrect1.bottom - picrect1.top,
+                      bounds.left - picrect1.left, bounds.top - picrect1.top, width, height,
+                      layer1.data(), width, background);
+    pPyramid2->Sample(picrect2.right - picrect2.left, picrect2.bottom - picrect2.top,
+                      bounds.left - picrect2.left, bounds.top - picrect2.top, width, height,
+                      layer2.data(), width, background);
+
+    if (m_blend == BLEND_XOR)
+        CImageCompare::XorPixels(layer1.data(), layer2.data(), layer1.data(), layer1.size());
+    else
+        CImageCompare::BlendPixels(layer1.data(), layer2.data(), layer1.data(), layer1.size(), (int)(blendAlpha * 255));
+    DrawPixels(hdc, bounds.left, bounds.top, width, height, layer1.data());
+
+    DrawPicBorder(hdc, picrect1);
+    DrawPicBorder(hdc, picrect2);
+    return true;
+}
+
+void CPicWindow::CompareImages()
+{
+    m_compare.Clear();
+    if (pSecondPic == nullptr)
+        return;
+    const CImagePyramid * pPyramid1 = GetPyramid(picture);
+    const CImagePyramid * pPyramid2 = GetPyramid(*pSecondPic);
+    if ((pPyramid1 == nullptr) || (pPyramid2 == nullptr))
+        return;
+
+    long width = min(pPyramid1->GetWidth(), pPyramid2->GetWidth());
+    long height = min(pPyramid1->GetHeight(), pPyramid2->GetHeight());
+    long stripHeight = min(height, max(64L, (long)(STRIP_PIXELS / width)));
+    uint32_t background = GetBackgroundPixel();
+    try
+    {
+        std::vector<uint32_t> strip1((size_t)width * stripHeight);
+        std::vector<uint32_t> strip2((size_t)width * stripHeight);
+        m_compare.Begin(width, height);
+        for (long row = 0; row < height; row += stripHeight)
+        {
+            long rows = min(stripHeight, height - row);
+            pPyramid1->Sample(pPyramid1->GetWidth(), pPyramid1->GetHeight(), 0, row, width, rows, strip1.data(), width, background);
+            pPyramid2->Sample(pPyramid2->GetWidth(), pPyramid2->GetHeight(), 0, row, width, rows, strip2.data(), width, background);
+            CImageCompare::Image image1 = { strip1.data(), (int)width, (int)rows, width };
+            CImageCompare::Image image2 = { strip2.data(), (int)width, (int)rows, width };
+            m_compare.CompareRows(image1, image2, row);
+        }
+        m_compare.End();
+    }
+    catch (const std::bad_alloc&)
+    {
+        m_compare.Clear();
+    }
+}
+
+void CPicWindow::DrawChangedRegions(HDC hdc, const RECT &bounds)
+{
+    const auto& regions = m_compare.GetRegions();
+    if (regions.empty() || (picture.m_Width <= 0) || (picture.m_Height <= 0))
+        return;
+
+    // the regions are in picture pixels, the picture may be zoomed or stretched
+    RECT picrect = GetPicRect(bounds, picture, picscale);
+    long picwidth = picrect.right - picrect.left;
+    long picheight = picrect.bottom - picrect.top;
+    HPEN hPen = CreatePen(PS_SOLID, 1, RGB(255, 0, 0));
+    HPEN hOldPen = (HPEN)SelectObject(hdc, hPen);
+    HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
+    for (const auto& region : regions)
+    {
+        RECT rc;
+        rc.left = picrect.left + (long)((__int64)region.left * picwidth / picture.m_Width) - 1;
+        rc.top = picrect.top + (long)((__int64)region.top * picheight / picture.m_Height) - 1;
+        rc.right = picrect.left + (long)((__int64)region.right * picwidth / picture.m_Width) + 1;
+        rc.bottom = picrect.top + (long)((__int64)region.bottom * picheight / picture.m_Height) + 1;
+        if ((rc.bottom < bounds.top) || (rc.top > bounds.bottom))
+            continue;
+        if ((rc.right < bounds.left) || (rc.left > bounds.right))
+            continue;
+        Rectangle(hdc, rc.left, rc.top, rc.right + 1, rc.bottom + 1);
+    }
+    SelectObject(hdc, hOldBrush);
+    SelectObject(hdc, hOldPen);
+    DeleteObject(hPen);
+}
+
 void CPicWindow::Paint(HWND hwnd)
 {
     PAINTSTRUCT ps;
@@ -1221,8 +1482,10 @@ void CPicWindow::Paint(HWND hwnd)
         GetClientRect(&rect);
         if (bValid)
         {
-            ShowPicWithBorder(memDC, rect, picture, picscale);
-            if (pSecondPic)
+            bool bComposed = PaintComposite(memDC, rect);
+            if (!bComposed)
+                ShowPicWithBorder(memDC, rect, picture, picscale);
+            if (pSecondPic && !bComposed)
             {
                 HDC secondhdc = CreateCompatibleDC(hdc);
                 HBITMAP hBitmap = CreateCompatibleBitmap(hdc, rect.right - rect.left, rect.bottom - rect.top);
@@ -1277,7 +1540,7 @@ void CPicWindow::Paint(HWND hwnd)
                 DeleteObject(hBitmap);
                 DeleteDC(secondhdc);
             }
-            else if (bDragging && pTheOtherPic && !bLinkedPositions)
+            else if (!pSecondPic && bDragging && pTheOtherPic && !bLinkedPositions)
             {
                 // when dragging, show lines indicating the position of the other image
                 HPEN hPen = CreatePen(PS_SOLID, 1, GetSysColor(/*COLOR_ACTIVEBORDER*/COLOR_HIGHLIGHT));
@@ -1304,6 +1567,9 @@ void CPicWindow::Paint(HWND hwnd)
                 DeleteObject(hPen);
             }
 
+            if (pSecondPic && bShowInfo)
+                DrawChangedRegions(memDC, rect);
+
             int sliderwidth = 0;
             if ((pSecondPic)&&(m_blend == BLEND_ALPHA))
                 sliderwidth = slider_width;
@@ -1557,6 +1823,18 @@ void CPicWindow::BuildInfoString(TCHAR * buf, int size, bool bTooltip)
             pSecondPic->GetHorizontalResolution(), pSecondPic->GetVerticalResolution(),
             pSecondPic->m_ColorDepth,
             (UINT)pTheOtherPic->GetZoom());
+
+        const CImageCompare::Statistics& stats = m_compare.GetStatistics();
+        if (stats.comparedPixels)
+        {
+            size_t len = wcslen(buf);
+            swprintf_s(buf + len, size - len,
+                (TCHAR const *)ResString(hResource, bTooltip ? IDS_COMPARESTATSTT : IDS_COMPARESTATS),
+                stats.changedPixels, stats.changedPixels * 100.0 / stats.comparedPixels,
+                stats.maxDifference,
+                stats.meanDifference,
+                (int)m_compare.GetRegions().size());
+        }
     }
     else
     {
@@ -1,6 +1,6 @@
 // TortoiseIDiff - an image diff viewer in TortoiseSVN
 
-// Copyright (C) 2006-2010, 2012-2016 - TortoiseSVN
+// Copyright (C) 2006-2010, 2012-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -22,6 +22,9 @@
 #include "TortoiseIDiff.h"
 #include "Picture.h"
 #include "NiceTrackbar.h"
+#include "ImageCompare.h"
+#include "ImagePyramid.h"
+#include <vector>
 
 #define HEADER_HEIGHT 30
 
@@ -41,6 +44,8 @@
 #define SLIDER_HEIGHT 30
 #define SLIDER_WIDTH 30
 
+#define WM_PYRAMIDLOADED (WM_APP + 1)
+
 
 #ifndef GET_X_LPARAM
 #define GET_X_LPARAM(lp)                        ((int)(short)LOWORD(lp))
@@ -138,6 +143,7 @@ public:
         picpath2 = secpath;
         nVSecondScrollPos = vpos;
         nHSecondScrollPos = hpos;
+        CompareImages();
     }
 
     void StopTimer() {KillTimer(*this, ID_ANIMATIONTIMER);}
@@ -201,6 +207,11 @@ public:
     /// Handles the mouse wheel
     void                OnMouseWheel(short fwKeys, short zDelta);
 protected:
+    enum
+    {
+        STRIP_PIXELS = 4 * 1024 * 1024     ///< huge pictures are compared in strips of this size
+    };
+
     /// the message handler for this window
     LRESULT CALLBACK    WinMsgHandler(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
     /// Draws the view title bar
@@ -220,6 +231,32 @@ protected:
     void                Paint(HWND hwnd);
     /// Draw pic to hdc, with a border, scaled by scale.
     void                ShowPicWithBorder(HDC hdc, const RECT &bounds, CPicture &pic, int scale);
+    /// returns the rectangle the picture is drawn to
+    RECT                GetPicRect(const RECT &bounds, CPicture &pic, int scale);
+    /// draws the border around a picture
+    void                DrawPicBorder(HDC hdc, const RECT &picrect);
+    /// draws the overlay of both pictures from their pyramids, returns false if that's not possible
+    bool                PaintComposite(HDC hdc, const RECT &bounds);
+    /// marks the areas where the pictures differ
+    void                DrawChangedRegions(HDC hdc, const RECT &bounds);
+    /// draws the visible part of the picture from its pyramid, returns false if it has none
+    bool                DrawPyramid(HDC hdc, const RECT &bounds, CPicture &pic, const RECT &picrect);
+    /// starts copying the picture into m_pyramid and generating the smaller levels
+    void                BuildPyramid();
+    /// the full size level of m_pyramid is done: frees the picture's own pixels
+    /// and compares the pictures
+    void                OnPyramidLoaded();
+    /// returns the pyramid of this or the other window's picture, nullptr if there is none
+    const CImagePyramid * FindPyramid(CPicture &pic) const;
+    /// returns the pyramid of this or the other window's picture, nullptr if it isn't available
+    const CImagePyramid * GetPyramid(CPicture &pic) const;
+    /// true while the picture is read by its pyramid and must not be drawn with GDI+
+    bool                IsPyramidLoading(CPicture &pic) const;
+    /// the background color as a 32 bit pixel
+    uint32_t            GetBackgroundPixel() const;
+    /// compares both pictures at their full size. Called whenever one of them
+    /// changes, so painting can use the result right away.
+    void                CompareImages();
     /// Positions the buttons
     void                PositionChildren();
     /// advance to the next image in the file
@@ -244,6 +281,7 @@ protected:
     tstring             pictitle;           ///< the string to show in the image view as a title
     CPicture            picture;            ///< the picture object of the image
     bool                bValid;             ///< true if the picture object is valid, i.e. if the image could be loaded and can be shown
+    CImagePyramid       m_pyramid;          ///< the tiles of the picture at all zoom levels
     int                 picscale;           ///< the scale factor of the image in percent
     COLORREF            transparentColor;   ///< the color to draw under the images
     bool                bFirstpaint;        ///< true if the image is painted the first time. Used to initialize some stuff when the window is valid for sure.
@@ -299,4 +337,7 @@ protected:
     // linked image sizes/positions
     long                m_linkedWidth;
     long                m_linkedHeight;
+
+    // comparison of the overlay pictures
+    CImageCompare       m_compare;          ///< empty if there is no overlay or the comparison failed
 };
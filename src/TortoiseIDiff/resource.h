@@ -19,6 +19,8 @@
 #define IDS_DUALIMAGEINFOTT             112
 #define IDS_ALPHABUTTONTT               113
 #define IDS_SELECT                      114
+#define IDS_COMPARESTATS                115
+#define IDS_COMPARESTATSTT              116
 #define IDD_OPEN                        130
 #define IDR_TORTOISEIDIFF               131
 #define IDI_OVERLAP                     134
@@ -1,6 +1,6 @@
 ﻿// TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2003-2019 - TortoiseSVN
+// Copyright (C) 2003-2019, 2026 - TortoiseSVN
 // Copyright (C) 2019 - TortoiseGit
 
 // This program is free software; you can redistribute it and/or
@@ -704,7 +704,8 @@ CString CBaseView::GetLineChars(int index)
         {
             if (subLine < CountMultiLines(viewLine))
             {
-                return m_ScreenedViewLine[viewLine].SubLines[subLine];
+                int nStart = GetSubLineStart(viewLine, subLine);
+                return m_pViewData->GetLine(viewLine).Mid(nStart, GetSubLineStart(viewLine, subLine + 1) - nStart);
             }
             return L"";
         }
@@ -1501,6 +1502,14 @@ void CBaseView::OnDraw(CDC * pDC)
         rcLine.OffsetRect(0, nLineHeight);
     }
 
+    // diff the pages around the viewport in the background,
+    // the lines next to the viewport first
+    int nScreenLines = nCurrentLine - m_nTopLine;
+    if (nCurrentLine < nLineCount)
+        PrefetchInlineDiffs(std::min<int>(nCurrentLine + nScreenLines, nLineCount) - 1, nCurrentLine);
+    if (m_nTopLine > 0)
+        PrefetchInlineDiffs(std::max<int>(m_nTopLine - nScreenLines, 0), m_nTopLine - 1);
+
     cacheDC.SelectObject(pOldBitmap);
     cacheDC.DeleteDC();
 }
@@ -1873,13 +1882,7 @@ void CBaseView::DrawTextLine(
 
     // @ this point we may cache data for next line which may be same in wrapped mode
 
-    int nTextOffset = 0;
-    int nSubline = GetSubLineOffset(nLineIndex);
-    for (int n=0; n<nSubline; n++)
-    {
-        CString sLine = m_ScreenedViewLine[nViewLine].SubLines[n];
-        nTextOffset += sLine.GetLength();
-    }
+    int nTextOffset = GetSubLineStart(nViewLine, GetSubLineOffset(nLineIndex));
 
     CString sLine = GetLineChars(nLineIndex);
     int nLineLength = sLine.GetLength();
@@ -4635,46 +4638,25 @@ bool CBaseView::GetInlineDiffPositions(int nViewLine, std::vector<inlineDiffPos>
     if (sDiffLine.IsEmpty())
         return false;
 
-    svn_diff_t* diff = nullptr;
     auto pLine1 = (this == m_pwndLeft) ? &sLine : &sDiffLine;
     auto pLine2 = (this == m_pwndLeft) ? &sDiffLine : &sLine;
-    m_svnlinediff.Diff(&diff, *pLine1, pLine1->GetLength(), *pLine2, pLine2->GetLength(), m_bInlineWordDiff);
-    if (!diff || !SVNLineDiff::ShowInlineDiff(diff))
+    auto result = m_pMainFrame->m_InlineDiffCache.Get(*pLine1, *pLine2, m_bInlineWordDiff, true);
+    if (!result->bShowInlineDiff)
         return false;
 
-    size_t lineoffset = 0;
     size_t position = 0;
-    while (diff)
+    for (const auto& hunk : result->hunks)
     {
-        if (this == m_pwndRight)
-        {
-            apr_off_t nTmp = diff->modified_length;
-            diff->modified_length = diff->original_length;
-            diff->original_length = nTmp;
-
-            nTmp = diff->modified_start;
-            diff->modified_start = diff->original_start;
-            diff->original_start = nTmp;
-        }
-
-        apr_off_t len = diff->original_length;
         size_t oldpos = position;
+        position += (this == m_pwndRight) ? hunk.modifiedChars : hunk.originalChars;
 
-        for (apr_off_t i = 0; i < len; ++i)
-        {
-            position += (this == m_pwndRight) ? m_svnlinediff.m_line2tokens[lineoffset].size() : m_svnlinediff.m_line1tokens[lineoffset].size();
-            lineoffset++;
-        }
-
-        if (diff->type == svn_diff__type_diff_modified)
+        if (hunk.bModified)
         {
             inlineDiffPos p;
             p.start = oldpos;
             p.end = position;
             positions.push_back(p);
         }
-
-        diff = diff->next;
     }
 
     return !positions.empty();
@@ -4838,10 +4820,6 @@ int CBaseView::CleanEmptyLines()
             {
                 m_pwndBottom->RemoveViewData(nViewLine);
             }
-            if (CUndo::GetInstance().IsGrouping()) // if use group undo -> ensure back adding goes in right (reversed) order
-            {
-                SaveUndoStep();
-            }
             nViewLineCount--;
             nRemovedCount++;
             continue;
@@ -4865,28 +4843,127 @@ int CBaseView::CountMultiLines( int nViewLine )
 
     if (m_ScreenedViewLine[nViewLine].bSublinesSet)
     {
-        return (int)m_ScreenedViewLine[nViewLine].SubLines.size();
+        return (int)m_ScreenedViewLine[nViewLine].SubLineStarts.size() + 1;
     }
 
     CString multiline = CStringUtils::WordWrap(m_pViewData->GetLine(nViewLine), GetScreenChars()-1, false, true, GetTabSize()); // GetMultiLine(nLine);
 
-    TScreenedViewLine oScreenedLine;
-    // tokenize string
-    int prevpos = 0;
+    // WordWrap only inserts line breaks, so each break
+    // corresponds to an offset in the original line
+    TScreenedViewLine& oScreenedLine = m_ScreenedViewLine[nViewLine];
+    oScreenedLine.SubLineStarts.clear();
     int pos = 0;
     while ((pos = multiline.Find('\n', pos)) >= 0)
     {
-        oScreenedLine.SubLines.push_back(multiline.Mid(prevpos, pos-prevpos)); // WordWrap could return vector/list of lines instead of string
         pos++;
-        prevpos = pos;
+        oScreenedLine.SubLineStarts.push_back(pos - (int)oScreenedLine.SubLineStarts.size() - 1);
     }
-    oScreenedLine.SubLines.push_back(multiline.Mid(prevpos));
     oScreenedLine.bSublinesSet = true;
-    m_ScreenedViewLine[nViewLine] = oScreenedLine;
 
     return CountMultiLines(nViewLine);
 }
 
+int CBaseView::EstimateMultiLines(int nViewLine, bool& bExact)
+{
+    bExact = true;
+    if (m_ScreenedViewLine.empty())
+        return 0;   // in case the view is completely empty
+
+    ASSERT(nViewLine < (int)m_ScreenedViewLine.size());
+
+    if (m_ScreenedViewLine[nViewLine].bSublinesSet)
+    {
+        return (int)m_ScreenedViewLine[nViewLine].SubLineStarts.size() + 1;
+    }
+
+    // a line that would fit even if all its chars were tabs never gets wrapped
+    int nLength = GetViewLineLength(nViewLine);
+    int nLimit = GetScreenChars() - 1;
+    if ((nLength == 0) || (nLength * (GetTabSize() + 1) <= nLimit))
+        return 1;
+
+    bExact = false;
+    if (nLimit <= 0)
+        return nLength;
+    return (nLength + nLimit - 1) / nLimit;
+}
+
+int CBaseView::GetSubLineStart(int nViewLine, int nSubLine)
+{
+    if (nSubLine <= 0)
+        return 0;
+    if (nSubLine >= CountMultiLines(nViewLine))
+        return GetViewLineLength(nViewLine);
+    return m_ScreenedViewLine[nViewLine].SubLineStarts[nSubLine - 1];
+}
+
+bool CBaseView::GetInlineDiffLines(int nViewLine, CString& sLine1, CString& sLine2)
+{
+    if (!m_bShowInlineDiff)
+        return false;
+
+    DiffStates diffState = m_pViewData->GetState(nViewLine);
+    if (((diffState == DIFFSTATE_NORMAL) || (diffState == DIFFSTATE_FILTEREDDIFF)) && (!m_bWhitespaceInlineDiffs))
+        return false;
+
+    CString sLine = GetViewLineChars(nViewLine);
+    if (sLine.IsEmpty())
+        return false;
+    CString sDiffLine;
+    if (!m_pOtherView)
+    {
+        switch (diffState)
+        {
+            case DIFFSTATE_ADDED:
+            {
+                if ((nViewLine > 0) && (m_pViewData->GetState(nViewLine - 1) == DIFFSTATE_REMOVED))
+                    sDiffLine = GetViewLineChars(nViewLine - 1);
+            }
+            break;
+            case DIFFSTATE_REMOVED:
+            {
+                if (((nViewLine + 1) < m_pViewData->GetCount()) && (m_pViewData->GetState(nViewLine + 1) == DIFFSTATE_ADDED))
+                    sDiffLine = GetViewLineChars(nViewLine + 1);
+            }
+            break;
+        }
+    }
+    else
+        sDiffLine = m_pOtherView->GetViewLineChars(nViewLine);
+    if (sDiffLine.IsEmpty())
+        return false;
+
+    if (sLine.GetLength() > (int)m_nInlineDiffMaxLineLength)
+        return false;
+    sLine1 = (this == m_pwndLeft) ? sLine : sDiffLine;
+    sLine2 = (this == m_pwndLeft) ? sDiffLine : sLine;
+    return true;
+}
+
+/// queues the inline diffs of the screen lines from nFirstScreenLine to nLastScreenLine
+/// (in that order, which may be descending). The last ones get diffed first.
+void CBaseView::PrefetchInlineDiffs(int nFirstScreenLine, int nLastScreenLine)
+{
+    if (!m_bShowInlineDiff || !m_pViewData)
+        return;
+
+    int nStep = (nFirstScreenLine <= nLastScreenLine) ? 1 : -1;
+    int nPrevViewLine = -1;
+    for (int nScreenLine = nFirstScreenLine; nScreenLine != nLastScreenLine + nStep; nScreenLine += nStep)
+    {
+        int nViewLine = GetViewLineForScreen(nScreenLine);
+        if ((nViewLine == nPrevViewLine) || (nViewLine < 0) || (nViewLine >= (int)m_ScreenedViewLine.size()))
+            continue;
+        nPrevViewLine = nViewLine;
+        if (m_ScreenedViewLine[nViewLine].bLineColorsSet)
+            continue;
+
+        CString sLine1, sLine2;
+        if (GetInlineDiffLines(nViewLine, sLine1, sLine2))
+            m_pMainFrame->m_InlineDiffCache.Prefetch(sLine1, sLine2, m_bInlineWordDiff);
+    }
+}
+
 /// prepare inline diff cache
 LineColors & CBaseView::GetLineColors(int nViewLine)
 {
@@ -4910,76 +4987,33 @@ LineColors & CBaseView::GetLineColors(int nViewLine)
     CDiffColors::GetInstance().GetColors(diffState, crBkgnd, crText);
     oLineColors.SetColor(0, crText, crBkgnd);
 
+    bool bPending = false;
     do {
-        if (!m_bShowInlineDiff)
-            break;
-
-        if (((diffState == DIFFSTATE_NORMAL) || (diffState == DIFFSTATE_FILTEREDDIFF)) && (!m_bWhitespaceInlineDiffs))
+        CString sLine1, sLine2;
+        if (!GetInlineDiffLines(nViewLine, sLine1, sLine2))
             break;
 
-        CString sLine = GetViewLineChars(nViewLine);
-        if (sLine.IsEmpty())
-            break;
-        CString sDiffLine;
-        if (!m_pOtherView)
+        auto result = m_pMainFrame->m_InlineDiffCache.Get(sLine1, sLine2, m_bInlineWordDiff, false);
+        if (!result)
         {
-            switch (diffState)
-            {
-                case DIFFSTATE_ADDED:
-                {
-                    if ((nViewLine > 0) && (m_pViewData->GetState(nViewLine - 1) == DIFFSTATE_REMOVED))
-                        sDiffLine = GetViewLineChars(nViewLine - 1);
-                }
-                break;
-                case DIFFSTATE_REMOVED:
-                {
-                    if (((nViewLine + 1) < m_pViewData->GetCount()) && (m_pViewData->GetState(nViewLine + 1) == DIFFSTATE_ADDED))
-                        sDiffLine = GetViewLineChars(nViewLine + 1);
-                }
-                break;
-            }
-        }
-        else
-            sDiffLine = m_pOtherView->GetViewLineChars(nViewLine);
-        if (sDiffLine.IsEmpty())
+            // the diff is computed in the background, we get repainted when it's done
+            bPending = true;
             break;
-
-        svn_diff_t* diff = nullptr;
-        if (sLine.GetLength() > (int)m_nInlineDiffMaxLineLength)
-            break;
-        auto pLine1 = (this == m_pwndLeft) ? &sLine : &sDiffLine;
-        auto pLine2 = (this == m_pwndLeft) ? &sDiffLine : &sLine;
-        m_svnlinediff.Diff(&diff, *pLine1, pLine1->GetLength(), *pLine2, pLine2->GetLength(), m_bInlineWordDiff);
-        if (!diff || !SVNLineDiff::ShowInlineDiff(diff) || !diff->next)
+        }
+        if (!result->bShowInlineDiff || (result->hunks.size() < 2))
             break;
 
-        int lineoffset = 0;
         int nTextStartOffset = 0;
         std::map<int, COLORREF> removedPositions;
-        while (diff)
+        for (const auto& hunk : result->hunks)
         {
-            if (this == m_pwndRight)
-            {
-                apr_off_t nTmp = diff->modified_length;
-                diff->modified_length = diff->original_length;
-                diff->original_length = nTmp;
-
-                nTmp = diff->modified_start;
-                diff->modified_start = diff->original_start;
-                diff->original_start = nTmp;
-            }
-            apr_off_t len = diff->original_length;
-
-            size_t nTextLength = 0;
-            for (int i = 0; i < len; ++i)
-            {
-                nTextLength += (this == m_pwndRight) ? m_svnlinediff.m_line2tokens[lineoffset].size() : m_svnlinediff.m_line1tokens[lineoffset].size();
-                lineoffset++;
-            }
-            bool bInlineDiff = (diff->type == svn_diff__type_diff_modified);
+            // the right view shows the modified line
+            int len = (this == m_pwndRight) ? hunk.modifiedTokens : hunk.originalTokens;
+            int otherLen = (this == m_pwndRight) ? hunk.originalTokens : hunk.modifiedTokens;
+            int nTextLength = (this == m_pwndRight) ? hunk.modifiedChars : hunk.originalChars;
 
             CDiffColors::GetInstance().GetColors(diffState, crBkgnd, crText);
-            if ((m_bShowInlineDiff)&&(bInlineDiff))
+            if ((m_bShowInlineDiff)&&(hunk.bModified))
             {
                 crBkgnd = InlineViewLineDiffColor(nViewLine);
             }
@@ -4988,14 +5022,13 @@ LineColors & CBaseView::GetLineColors(int nViewLine)
                 crBkgnd = m_ModifiedBk;
             }
 
-            if (len < diff->modified_length)
+            if (len < otherLen)
             {
                 removedPositions[nTextStartOffset] = m_InlineRemovedBk;
             }
             oLineColors.SetColor(nTextStartOffset, crText, crBkgnd);
 
-            nTextStartOffset += (int)nTextLength;
-            diff = diff->next;
+            nTextStartOffset += nTextLength;
         }
         for (std::map<int, COLORREF>::const_iterator it = removedPositions.begin(); it != removedPositions.end(); ++it)
         {
@@ -5003,6 +5036,13 @@ LineColors & CBaseView::GetLineColors(int nViewLine)
         }
     } while (false); // error catch
 
+    if (bPending)
+    {
+        // don't cache the colors without the inline diff
+        m_PendingLineColors = oLineColors;
+        return m_PendingLineColors;
+    }
+
     if (!m_bWhitespaceInlineDiffs)
     {
         m_ScreenedViewLine[nViewLine].lineColors = oLineColors;
@@ -5086,37 +5126,37 @@ void CBaseView::SaveUndoStep()
 
 void CBaseView::InsertViewData( int index, const CString& sLine, DiffStates state, int linenumber, EOL ending, HIDESTATE hide, int movedline )
 {
-    m_pState->addedlines.push_back(index);
     m_pViewData->InsertData(index, sLine, state, linenumber, ending, hide, movedline);
+    m_pState->AddInsertedLine(index);
 }
 
 void CBaseView::InsertViewData( int index, const viewdata& data )
 {
-    m_pState->addedlines.push_back(index);
     m_pViewData->InsertData(index, data);
+    m_pState->AddInsertedLine(index);
 }
 
 void CBaseView::RemoveViewData( int index )
 {
-    m_pState->removedlines[index] = m_pViewData->GetData(index);
+    m_pState->AddRemovedLine(index, m_pViewData->GetData(index));
     m_pViewData->RemoveData(index);
 }
 
 void CBaseView::SetViewData( int index, const viewdata& data )
 {
-    m_pState->replacedlines[index] = m_pViewData->GetData(index);
+    m_pState->AddReplacedLine(index, m_pViewData->GetData(index));
     m_pViewData->SetData(index, data);
 }
 
 void CBaseView::SetViewState( int index, DiffStates state )
 {
-    m_pState->linestates[index] = m_pViewData->GetState(index);
+    m_pState->AddChangedState(index, m_pViewData->GetState(index));
     m_pViewData->SetState(index, state);
 }
 
 void CBaseView::SetViewLine( int index, const CString& sLine )
 {
-    m_pState->difflines[index] = m_pViewData->GetLine(index);
+    m_pState->AddChangedLine(index, m_pViewData->GetLine(index));
     m_pViewData->SetLine(index, sLine);
 }
 
@@ -5124,20 +5164,20 @@ void CBaseView::SetViewLineNumber( int index, int linenumber )
 {
     int oldLineNumber = m_pViewData->GetLineNumber(index);
     if (oldLineNumber != linenumber) {
-        m_pState->linelines[index] = oldLineNumber;
+        m_pState->AddChangedLineNumber(index, oldLineNumber);
         m_pViewData->SetLineNumber(index, linenumber);
     }
 }
 
 void CBaseView::SetViewLineEnding( int index, EOL ending )
 {
-    m_pState->linesEOL[index] = m_pViewData->GetLineEnding(index);
+    m_pState->AddChangedLineEnding(index, m_pViewData->GetLineEnding(index));
     m_pViewData->SetLineEnding(index, ending);
 }
 
 void CBaseView::SetViewMarked(int index, bool marked)
 {
-    m_pState->markedlines[index] = m_pViewData->GetMarked(index);
+    m_pState->AddChangedMarked(index, m_pViewData->GetMarked(index));
     m_pViewData->SetMarked(index, marked);
 }
 
@@ -5158,25 +5198,26 @@ int CBaseView::Screen2View::GetViewLineForScreen( int screenLine )
     RebuildIfNecessary();
     if ((size() <= screenLine) || (screenLine < 0))
         return 0;
-    return m_Screen2View[screenLine].nViewLine;
+    return LocateScreenLine(screenLine).nViewLine;
 }
 
 int CBaseView::Screen2View::size()
 {
     RebuildIfNecessary();
-    return (int)m_Screen2View.size();
+    return m_nScreenLines;
 }
 
 int CBaseView::Screen2View::GetSubLineOffset( int screenLine )
 {
     RebuildIfNecessary();
-    if (size() <= screenLine)
+    if ((size() <= screenLine) || (screenLine < 0))
         return 0;
-    return m_Screen2View[screenLine].nViewSubLine;
+    return LocateScreenLine(screenLine).nViewSubLine;
 }
 
 /**
-    doing partial rebuild, whole screen2view vector is built, but uses ScreenedViewLine cache to do it faster
+    doing partial rebuild, only the screen lines of the view lines in the rebuild ranges are updated
+    unless the number of view lines has changed; lines get wrapped only when they are accessed
 */
 void CBaseView::Screen2View::RebuildIfNecessary()
 {
@@ -5201,42 +5242,29 @@ void CBaseView::Screen2View::RebuildIfNecessary()
         ResetScreenedViewLineCache(m_pwndRight);
         ResetScreenedViewLineCache(m_pwndBottom);
     }
-    m_RebuildRanges.clear();
-    m_bFull = false;
 
-    size_t OldSize = m_Screen2View.size();
-    m_Screen2View.clear();
-    m_Screen2View.reserve(OldSize); // guess same size
-    for (int i = 0; i < m_pViewData->GetCount(); ++i)
+    const int nViewCount = m_pViewData->GetCount();
+    if (m_bFull || ((int)m_ScreenLines.size() != nViewCount))
+    {
+        m_ScreenLines.resize(nViewCount);
+        m_LineStates.resize(nViewCount);
+        for (int i = 0; i < nViewCount; ++i)
+            m_ScreenLines[i] = CountScreenLines(m_pViewData, i, m_LineStates[i]);
+        RebuildScreenLinesTree();
+    }
+    else
     {
-        if (m_pMainFrame->m_bCollapsed)
+        for (auto it = m_RebuildRanges.cbegin(); it != m_RebuildRanges.cend(); ++it)
         {
-            while ((i < m_pViewData->GetCount())&&(m_pViewData->GetHideState(i) == HIDESTATE_HIDDEN))
-                ++i;
-            if (!(i < m_pViewData->GetCount()))
-                break;
-        }
-        TScreenLineInfo oLineInfo;
-        oLineInfo.nViewLine = i;
-        oLineInfo.nViewSubLine = -1; // no wrap
-        if (m_pMainFrame->m_bWrapLines && !IsViewLineHidden(m_pViewData, i))
-        {
-            int nMaxLines = 0;
-            if (IsLeftViewGood())
-                nMaxLines = std::max<int>(nMaxLines, m_pwndLeft->CountMultiLines(i));
-            if (IsRightViewGood())
-                nMaxLines = std::max<int>(nMaxLines, m_pwndRight->CountMultiLines(i));
-            if (IsBottomViewGood())
-                nMaxLines = std::max<int>(nMaxLines, m_pwndBottom->CountMultiLines(i));
-            for (int l = 0; l < (nMaxLines-1); ++l)
+            for (int i = std::max<int>(it->FirstViewLine, 0); i <= std::min<int>(it->LastViewLine, nViewCount - 1); ++i)
             {
-                oLineInfo.nViewSubLine++;
-                m_Screen2View.push_back(oLineInfo);
+                int nScreenLines = CountScreenLines(m_pViewData, i, m_LineStates[i]);
+                AddToScreenLines(i, nScreenLines - m_ScreenLines[i]);
             }
-            oLineInfo.nViewSubLine++;
         }
-        m_Screen2View.push_back(oLineInfo);
     }
+    m_RebuildRanges.clear();
+    m_bFull = false;
     m_pViewData = nullptr;
 
     if (IsLeftViewGood())
@@ -5250,47 +5278,139 @@ void CBaseView::Screen2View::RebuildIfNecessary()
     RecalcAllHorzScrollBars();
 }
 
-int CBaseView::Screen2View::FindScreenLineForViewLine( int viewLine )
+int CBaseView::Screen2View::CountScreenLines(CViewData * pViewData, int nViewLine, LineState& state) const
 {
-    RebuildIfNecessary();
+    state = LINE_SINGLE;
+    if (m_pMainFrame->m_bCollapsed && (pViewData->GetHideState(nViewLine) == HIDESTATE_HIDDEN))
+        return 0;
+    if (!m_pMainFrame->m_bWrapLines || IsViewLineHidden(pViewData, nViewLine))
+        return 1;
+
+    bool bExact = true;
+    int nMaxLines = 1;
+    for (CBaseView* pwndView : { m_pwndLeft, m_pwndRight, m_pwndBottom })
+    {
+        if (IsViewGood(pwndView))
+        {
+            bool bViewExact = true;
+            nMaxLines = std::max<int>(nMaxLines, pwndView->EstimateMultiLines(nViewLine, bViewExact));
+            bExact = bExact && bViewExact;
+        }
+    }
+    state = bExact ? LINE_WRAPPED : LINE_ESTIMATED;
+    return nMaxLines;
+}
 
-    int nScreenLineCount = (int)m_Screen2View.size();
+void CBaseView::Screen2View::WrapViewLine(int nViewLine)
+{
+    if (m_LineStates[nViewLine] != LINE_ESTIMATED)
+        return;
 
-    int nPos = 0;
-    if (nScreenLineCount>16)
-    {
-        // for enough long data search for last screen
-        // with viewline less than one we are looking for
-        // use approximate method (based on) binary search using asymmetric start point
-        // in form 2**n (determined as MSB of length) to go around division and rounding;
-        // this effectively looks for bit values from MSB to LSB
-
-        int nTestBit;
-        //GetMostSignificantBitValue
-        // note _BitScanReverse(&nTestBit, nScreenLineCount); can be used instead
-        nTestBit = nScreenLineCount;
-        nTestBit |= nTestBit>>1;
-        nTestBit |= nTestBit>>2;
-        nTestBit |= nTestBit>>4;
-        nTestBit |= nTestBit>>8;
-        nTestBit |= nTestBit>>16;
-        nTestBit ^= (nTestBit>>1);
-
-        while (nTestBit)
-        {
-            int nTestPos = nPos | nTestBit;
-            if (nTestPos < nScreenLineCount && m_Screen2View[nTestPos].nViewLine < viewLine)
+    int nMaxLines = 1;
+    if (IsLeftViewGood())
+        nMaxLines = std::max<int>(nMaxLines, m_pwndLeft->CountMultiLines(nViewLine));
+    if (IsRightViewGood())
+        nMaxLines = std::max<int>(nMaxLines, m_pwndRight->CountMultiLines(nViewLine));
+    if (IsBottomViewGood())
+        nMaxLines = std::max<int>(nMaxLines, m_pwndBottom->CountMultiLines(nViewLine));
+    m_LineStates[nViewLine] = LINE_WRAPPED;
+    AddToScreenLines(nViewLine, nMaxLines - m_ScreenLines[nViewLine]);
+}
+
+void CBaseView::Screen2View::WrapViewLines(int nFirstViewLine, int nLastViewLine)
+{
+    nFirstViewLine = std::max<int>(nFirstViewLine, 0);
+    nLastViewLine = std::min<int>(nLastViewLine, (int)m_LineStates.size() - 1);
+    for (int i = nFirstViewLine; i <= nLastViewLine; ++i)
+        WrapViewLine(i);
+}
+
+CBaseView::TScreenLineInfo CBaseView::Screen2View::LocateScreenLine(int screenLine)
+{
+    for (;;)
+    {
+        // wrapping a line may have reduced the number of screen lines
+        screenLine = std::min<int>(screenLine, m_nScreenLines - 1);
+
+        // descend the Fenwick tree
+        int node = 0;
+        int remaining = screenLine;
+        int nodeCount = (int)m_ScreenLinesTree.size();
+        int step = 1;
+        while (step * 2 <= nodeCount)
+            step *= 2;
+        for (; step > 0; step /= 2)
+        {
+            if ((node + step <= nodeCount) && (m_ScreenLinesTree[node + step - 1] <= remaining))
             {
-                nPos = nTestPos;
+                node += step;
+                remaining -= m_ScreenLinesTree[node - 1];
             }
-            nTestBit >>= 1;
         }
+        ASSERT(node < nodeCount);
+
+        TScreenLineInfo oLineInfo;
+        oLineInfo.nViewLine = node;
+        oLineInfo.nViewSubLine = -1; // no wrap
+        if (m_LineStates[node] == LINE_SINGLE)
+            return oLineInfo;
+        if (m_LineStates[node] == LINE_WRAPPED)
+        {
+            oLineInfo.nViewSubLine = remaining;
+            return oLineInfo;
+        }
+
+        // the line is about to be shown, replace the estimate
+        WrapViewLine(node);
+    }
+}
+
+void CBaseView::Screen2View::AddToScreenLines(int nViewLine, int nDelta)
+{
+    if (nDelta == 0)
+        return;
+    m_ScreenLines[nViewLine] += nDelta;
+    m_nScreenLines += nDelta;
+    for (int node = nViewLine + 1; node <= (int)m_ScreenLinesTree.size(); node += node & -node)
+        m_ScreenLinesTree[node - 1] += nDelta;
+}
+
+void CBaseView::Screen2View::RebuildScreenLinesTree()
+{
+    // O(n) construction: every node passes its sum on to its parent
+    m_ScreenLinesTree = m_ScreenLines;
+    m_nScreenLines = 0;
+    const int nodeCount = (int)m_ScreenLinesTree.size();
+    for (int node = 1; node <= nodeCount; ++node)
+    {
+        m_nScreenLines += m_ScreenLines[node - 1];
+        int parent = node + (node & -node);
+        if (parent <= nodeCount)
+            m_ScreenLinesTree[parent - 1] += m_ScreenLinesTree[node - 1];
     }
-    while (nPos < nScreenLineCount && m_Screen2View[nPos].nViewLine < viewLine)
+}
+
+int CBaseView::Screen2View::FindScreenLineForViewLine( int viewLine )
+{
+    RebuildIfNecessary();
+
+    viewLine = std::max<int>(0, std::min<int>(viewLine, (int)m_ScreenLines.size()));
+
+    // wrap the lines around the view line now, so that its
+    // screen line does not move once they get drawn
+    CBaseView * pwndView = GetFirstGoodView();
+    if (pwndView)
     {
-        nPos++;
+        int nScreenLines = pwndView->GetScreenLines();
+        WrapViewLines(viewLine - nScreenLines, viewLine + nScreenLines);
     }
 
+    // the first screen line of viewLine is the
+    // number of screen lines of all lines before it
+    int nPos = 0;
+    for (int node = viewLine; node > 0; node -= node & -node)
+        nPos += m_ScreenLinesTree[node - 1];
+
     return nPos;
 }
 
@@ -1,6 +1,6 @@
 ﻿// TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2003-2015, 2017-2018 - TortoiseSVN
+// Copyright (C) 2003-2015, 2017-2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -122,6 +122,8 @@ public: // methods
     int             FindScreenLineForViewLine(int viewLine);
     // TODO: find better consistent names for Multiline(line with sublines) and Subline, Count.. or Get..Count ?
     int             CountMultiLines(int nViewLine);
+    int             EstimateMultiLines(int nViewLine, bool& bExact);           ///< CountMultiLines() without wrapping the line
+    int             GetSubLineStart(int nViewLine, int nSubLine);              ///< offset of the sub line in the view line
     int             GetSubLineOffset(int index);
     LineColors &    GetLineColors(int nViewLine);
     static void     UpdateLocator() { if (m_pwndLocator) m_pwndLocator->DocumentUpdated(); }
@@ -394,6 +396,8 @@ protected:  // methods
     COLORREF        InlineDiffColor(int nLineIndex);
     COLORREF        InlineViewLineDiffColor(int nLineIndex);
     bool            GetInlineDiffPositions(int lineIndex, std::vector<inlineDiffPos>& positions);
+    bool            GetInlineDiffLines(int nViewLine, CString& sLine1, CString& sLine2); ///< the line pair to diff for GetLineColors()
+    void            PrefetchInlineDiffs(int nFirstViewLine, int nLastViewLine);
     void            CheckOtherView();
     void            GetWhitespaceBlock(CViewData *viewData, int nLineIndex, int & nStartBlock, int & nEndBlock);
     CString         GetWhitespaceString(CViewData *viewData, int nStartBlock, int nEndBlock);
@@ -474,8 +478,8 @@ protected:  // variables
     COLORREF        m_WhiteSpaceFg;
     UINT            m_nStatusBarID;     ///< The ID of the status bar pane used by this view. Must be set by the parent class.
 
-    SVNLineDiff     m_svnlinediff;
     DWORD           m_nInlineDiffMaxLineLength;
+    LineColors      m_PendingLineColors;    ///< colors of a line whose inline diff is not available yet
     BOOL            m_bOtherDiffChecked;
     bool            m_bModified;
     BOOL            m_bFocused;
@@ -588,7 +592,7 @@ protected:  // variables
         }
 
         bool bSublinesSet;
-        std::vector<CString> SubLines;
+        std::vector<int> SubLineStarts; ///< offsets of the second and following sub lines in the view line
 
         enum EIcon
         {
@@ -646,11 +650,20 @@ protected:  // variables
         POPUPCOMMAND__LAST,
     };
 
+    /**
+     * Maps screen lines to view lines and vice versa.
+     *
+     * The number of screen lines per view line is held in a Fenwick tree,
+     * so both directions take O(log n). With word wrap enabled, only the
+     * view lines being accessed get wrapped; the screen lines of all others
+     * are estimated from their length until then.
+     */
     class Screen2View
     {
     public:
         Screen2View()
             : m_pViewData(nullptr)
+            , m_nScreenLines(0)
         {m_bFull=false; }
 
         int             GetViewLineForScreen(int screenLine);
@@ -667,15 +680,33 @@ protected:  // variables
             int LastViewLine;
         };
 
+        enum LineState : BYTE
+        {
+            LINE_SINGLE,        ///< not wrapped, the sub line offset is -1
+            LINE_ESTIMATED,     ///< wrapped, the number of sub lines is estimated
+            LINE_WRAPPED,       ///< wrapped, the number of sub lines is exact
+        };
+
         bool            FixScreenedCacheSize(CBaseView* View);
         void            RebuildIfNecessary();
         bool            ResetScreenedViewLineCache(CBaseView* View) const;
         bool            ResetScreenedViewLineCache(CBaseView* View, const TRebuildRange& Range) const;
 
+        int             CountScreenLines(CViewData * ViewData, int ViewLine, LineState& State) const;
+        void            WrapViewLine(int ViewLine);
+        void            WrapViewLines(int FirstViewLine, int LastViewLine);
+        TScreenLineInfo LocateScreenLine(int screenLine);
+        void            AddToScreenLines(int ViewLine, int Delta);
+        void            RebuildScreenLinesTree();
+
         CViewData *                     m_pViewData;
         bool                            m_bFull;
-        std::vector<TScreenLineInfo>    m_Screen2View;
         std::vector<TRebuildRange>      m_RebuildRanges;
+
+        std::vector<int>                m_ScreenLines;      ///< number of screen lines per view line
+        std::vector<LineState>          m_LineStates;
+        std::vector<int>                m_ScreenLinesTree;  ///< Fenwick tree over m_ScreenLines
+        int                             m_nScreenLines;
     };
 
     static Screen2View m_Screen2View;
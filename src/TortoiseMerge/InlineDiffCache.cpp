@@ -0,0 +1,239 @@
+// TortoiseMerge - a Diff/Patch program
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "InlineDiffCache.h"
+#include "AsyncCall.h"
+#include <string_view>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+const UINT CInlineDiffCache::WM_INLINEDIFFSREADY = RegisterWindowMessage(L"TortoiseMerge_InlineDiffsReady");
+
+static int CountChars(const std::vector<std::wstring>& tokens, size_t& offset, apr_off_t count)
+{
+    int nChars = 0;
+    for (apr_off_t i = 0; (i < count) && (offset < tokens.size()); ++i)
+        nChars += (int)tokens[offset++].size();
+    return nChars;
+}
+
+size_t CInlineDiffCache::KeyHash::operator()(const Key& key) const
+{
+    std::hash<std::wstring_view> hasher;
+    size_t hash1 = hasher(std::wstring_view((LPCWSTR)key.sLine1, key.sLine1.GetLength()));
+    size_t hash2 = hasher(std::wstring_view((LPCWSTR)key.sLine2, key.sLine2.GetLength()));
+    return (hash1 * 31 + hash2) * 2 + (key.bWordDiff ? 1 : 0);
+}
+
+CInlineDiffCache::CInlineDiffCache()
+    : m_bJobScheduled(false)
+    , m_bNotifyPending(false)
+    , m_bShutdown(false)
+    , m_hNotifyWnd(nullptr)
+    , m_scheduler(1, 0)
+{
+}
+
+CInlineDiffCache::~CInlineDiffCache()
+{
+    {
+        async::CCriticalSectionLock lock(m_mutex);
+        m_bShutdown = true;
+        m_visibleQueue.clear();
+        m_prefetchQueue.clear();
+        m_hNotifyWnd = nullptr;
+    }
+    m_scheduler.WaitForEmptyQueue();
+}
+
+CInlineDiffCache::ResultPtr CInlineDiffCache::Get(const CString& sLine1, const CString& sLine2, bool bWordDiff, bool bWait)
+{
+    Key key = { sLine1, sLine2, bWordDiff };
+    {
+        async::CCriticalSectionLock lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end())
+        {
+            if (it->second.result)
+                return it->second.result;
+            if (!bWait)
+            {
+                // queued for prefetching only: move it in front of the other requests
+                if (!it->second.bVisible)
+                {
+                    it->second.bVisible = true;
+                    m_visibleQueue.push_back(key);
+                }
+                return nullptr;
+            }
+        }
+        else if (!bWait)
+        {
+            Enqueue(key, true);
+            return nullptr;
+        }
+    }
+
+    // the caller can't continue without the result, e.g. when navigating
+    ResultPtr result = Compute(m_lineDiff, key);
+    async::CCriticalSectionLock lock(m_mutex);
+    m_entries[key].result = result;
+    return result;
+}
+
+void CInlineDiffCache::Prefetch(const CString& sLine1, const CString& sLine2, bool bWordDiff)
+{
+    Key key = { sLine1, sLine2, bWordDiff };
+    async::CCriticalSectionLock lock(m_mutex);
+    if (m_entries.find(key) == m_entries.end())
+        Enqueue(key, false);
+}
+
+void CInlineDiffCache::SetNotifyWindow(HWND hWnd)
+{
+    async::CCriticalSectionLock lock(m_mutex);
+    m_hNotifyWnd = hWnd;
+    m_bNotifyPending = false;
+}
+
+void CInlineDiffCache::OnNotified()
+{
+    async::CCriticalSectionLock lock(m_mutex);
+    m_bNotifyPending = false;
+}
+
+void CInlineDiffCache::Clear()
+{
+    async::CCriticalSectionLock lock(m_mutex);
+    m_entries.clear();
+    m_visibleQueue.clear();
+    m_prefetchQueue.clear();
+}
+
+CInlineDiffCache::ResultPtr CInlineDiffCache::Compute(SVNLineDiff& lineDiff, const Key& key)
+{
+    auto result = std::make_shared<Result>();
+    result->bShowInlineDiff = false;
+
+    svn_diff_t* diff = nullptr;
+    lineDiff.Diff(&diff, key.sLine1, key.sLine1.GetLength(), key.sLine2, key.sLine2.GetLength(), key.bWordDiff);
+    if (!diff)
+        return result;
+
+    result->bShowInlineDiff = SVNLineDiff::ShowInlineDiff(diff);
+    size_t offset1 = 0;
+    size_t offset2 = 0;
+    for (; diff; diff = diff->next)
+    {
+        Hunk hunk;
+        hunk.bModified = (diff->type == svn_diff__type_diff_modified);
+        hunk.originalTokens = (int)diff->original_length;
+        hunk.modifiedTokens = (int)diff->modified_length;
+        hunk.originalChars = CountChars(lineDiff.m_line1tokens, offset1, diff->original_length);
+        hunk.modifiedChars = CountChars(lineDiff.m_line2tokens, offset2, diff->modified_length);
+        result->hunks.push_back(hunk);
+    }
+    return result;
+}
+
+/// must be called with m_mutex being held
+void CInlineDiffCache::Enqueue(const Key& key, bool bVisible)
+{
+    if (m_bShutdown)
+        return;
+
+    if (m_entries.size() >= MAX_RESULTS)
+    {
+        // drop the finished diffs, the queued ones are still needed
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            if (it->second.result)
+                it = m_entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    Entry& entry = m_entries[key];
+    entry.bVisible = bVisible;
+    if (bVisible)
+        m_visibleQueue.push_back(key);
+    else
+    {
+        m_prefetchQueue.push_front(key);
+        if (m_prefetchQueue.size() > MAX_PREFETCH)
+        {
+            // the oldest requests are the farthest away from the viewport
+            auto it = m_entries.find(m_prefetchQueue.back());
+            if ((it != m_entries.end()) && !it->second.result && !it->second.bVisible)
+                m_entries.erase(it);
+            m_prefetchQueue.pop_back();
+        }
+    }
+
+    if (!m_bJobScheduled)
+    {
+        m_bJobScheduled = true;
+        new async::CAsyncCall(this, &CInlineDiffCache::ProcessQueue, &m_scheduler);
+    }
+}
+
+void CInlineDiffCache::ProcessQueue()
+{
+    for (;;)
+    {
+        Key key;
+        {
+            async::CCriticalSectionLock lock(m_mutex);
+            std::deque<Key>& queue = m_visibleQueue.empty() ? m_prefetchQueue : m_visibleQueue;
+            if (queue.empty())
+            {
+                m_bJobScheduled = false;
+                return;
+            }
+            key = queue.front();
+            queue.pop_front();
+
+            // already diffed on the UI thread or requested twice
+            auto it = m_entries.find(key);
+            if ((it == m_entries.end()) || it->second.result)
+                continue;
+        }
+
+        ResultPtr result = Compute(m_workerLineDiff, key);
+
+        HWND hNotifyWnd = nullptr;
+        {
+            async::CCriticalSectionLock lock(m_mutex);
+            auto it = m_entries.find(key);
+            if ((it == m_entries.end()) || it->second.result)
+                continue;
+            it->second.result = result;
+            if (it->second.bVisible && !m_bNotifyPending && m_hNotifyWnd)
+            {
+                m_bNotifyPending = true;
+                hNotifyWnd = m_hNotifyWnd;
+            }
+        }
+        if (hNotifyWnd)
+            ::PostMessage(hNotifyWnd, WM_INLINEDIFFSREADY, 0, 0);
+    }
+}
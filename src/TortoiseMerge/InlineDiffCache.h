@@ -0,0 +1,128 @@
+// TortoiseMerge - a Diff/Patch program
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+#include "SVNLineDiff.h"
+#include "JobScheduler.h"
+#include "CriticalSection.h"
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * \ingroup TortoiseMerge
+ * Caches the inline diffs of line pairs and computes them in the background.
+ *
+ * The results are keyed by the texts of both lines and the diff options,
+ * so they stay valid while lines are edited, scrolled or reordered. Lines
+ * which are requested while painting are diffed before the ones which are
+ * only prefetched ahead of the viewport. Whenever the result of a painted
+ * line becomes available, the notification window receives a
+ * WM_INLINEDIFFSREADY message and should repaint the views.
+ *
+ * The background job only works on copies of the line texts, never on the
+ * view data.
+ */
+class CInlineDiffCache
+{
+public:
+    /// a run of tokens which is either equal or modified in both lines
+    struct Hunk
+    {
+        bool    bModified;
+        int     originalTokens;     ///< number of tokens in the first line
+        int     modifiedTokens;     ///< number of tokens in the second line
+        int     originalChars;      ///< number of chars in the first line
+        int     modifiedChars;      ///< number of chars in the second line
+    };
+
+    struct Result
+    {
+        bool                bShowInlineDiff;    ///< see SVNLineDiff::ShowInlineDiff()
+        std::vector<Hunk>   hunks;
+    };
+
+    typedef std::shared_ptr<const Result> ResultPtr;
+
+    static const UINT WM_INLINEDIFFSREADY;
+
+    CInlineDiffCache();
+    ~CInlineDiffCache();
+
+    /// returns the inline diff of the two lines. If it is not available yet,
+    /// the diff is either computed right away (\a bWait) or queued and nullptr
+    /// is returned.
+    ResultPtr   Get(const CString& sLine1, const CString& sLine2, bool bWordDiff, bool bWait);
+    /// queues the inline diff of the two lines behind the ones being painted
+    void        Prefetch(const CString& sLine1, const CString& sLine2, bool bWordDiff);
+
+    void        SetNotifyWindow(HWND hWnd);
+    /// called by the notification window before it repaints the views
+    void        OnNotified();
+    void        Clear();
+
+private:
+    struct Key
+    {
+        CString     sLine1;
+        CString     sLine2;
+        bool        bWordDiff;
+
+        bool operator==(const Key& other) const
+        {
+            return (bWordDiff == other.bWordDiff) && (sLine1 == other.sLine1) && (sLine2 == other.sLine2);
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        ResultPtr   result;     ///< nullptr while the diff is queued
+        bool        bVisible;   ///< the line has been painted while queued
+    };
+
+    typedef std::unordered_map<Key, Entry, KeyHash> EntryMap;
+
+    enum
+    {
+        MAX_RESULTS = 20000,
+        MAX_PREFETCH = 2000
+    };
+
+    static ResultPtr    Compute(SVNLineDiff& lineDiff, const Key& key);
+    void                Enqueue(const Key& key, bool bVisible);
+    void                ProcessQueue();
+
+    async::CCriticalSection m_mutex;
+    EntryMap                m_entries;
+    std::deque<Key>         m_visibleQueue;     ///< processed in paint order
+    std::deque<Key>         m_prefetchQueue;    ///< most recent requests first
+    bool                    m_bJobScheduled;
+    bool                    m_bNotifyPending;
+    bool                    m_bShutdown;
+    HWND                    m_hNotifyWnd;
+
+    SVNLineDiff             m_lineDiff;         ///< used by the UI thread
+    SVNLineDiff             m_workerLineDiff;   ///< used by the background job
+
+    async::CJobScheduler    m_scheduler;
+};
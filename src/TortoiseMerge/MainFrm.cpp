@@ -1,6 +1,6 @@
 ﻿// TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2004-2018 - TortoiseSVN
+// Copyright (C) 2004-2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -135,6 +135,7 @@ BEGIN_MESSAGE_MAP(CMainFrame, CFrameWndEx)
     ON_COMMAND(ID_VIEW_WRAPLONGLINES, &CMainFrame::OnViewWraplonglines)
     ON_UPDATE_COMMAND_UI(ID_VIEW_WRAPLONGLINES, &CMainFrame::OnUpdateViewWraplonglines)
     ON_REGISTERED_MESSAGE( TaskBarButtonCreated, CMainFrame::OnTaskbarButtonCreated )
+    ON_REGISTERED_MESSAGE( CInlineDiffCache::WM_INLINEDIFFSREADY, CMainFrame::OnInlineDiffsReady )
     ON_UPDATE_COMMAND_UI(ID_EDIT_PASTE, &CMainFrame::OnUpdateEditPaste)
     ON_COMMAND(ID_INDICATOR_LEFTVIEW, &CMainFrame::OnIndicatorLeftview)
     ON_COMMAND(ID_INDICATOR_RIGHTVIEW, &CMainFrame::OnIndicatorRightview)
@@ -238,12 +239,29 @@ LRESULT CMainFrame::OnTaskbarButtonCreated(WPARAM /*wParam*/, LPARAM /*lParam*/)
     return 0;
 }
 
+LRESULT CMainFrame::OnInlineDiffsReady(WPARAM /*wParam*/, LPARAM /*lParam*/)
+{
+    // lines painted without their inline diffs get their colors now
+    m_InlineDiffCache.OnNotified();
+    if (m_pwndLeftView)
+        m_pwndLeftView->Invalidate();
+    if (m_pwndRightView)
+        m_pwndRightView->Invalidate();
+    if (m_pwndBottomView)
+        m_pwndBottomView->Invalidate();
+    if (m_wndLineDiffBar.GetSafeHwnd())
+        m_wndLineDiffBar.Invalidate();
+    return 0;
+}
+
 
 int CMainFrame::OnCreate(LPCREATESTRUCT lpCreateStruct)
 {
     if (CFrameWndEx::OnCreate(lpCreateStruct) == -1)
         return -1;
 
+    m_InlineDiffCache.SetNotifyWindow(m_hWnd);
+
     if (m_bUseRibbons)
     {
         HRESULT hr;
@@ -374,6 +392,7 @@ int CMainFrame::OnCreate(LPCREATESTRUCT lpCreateStruct)
 
 void CMainFrame::OnDestroy()
 {
+    m_InlineDiffCache.SetNotifyWindow(nullptr);
     if (m_pRibbonFramework)
     {
         m_pRibbonFramework->Destroy();
@@ -677,6 +696,7 @@ void CMainFrame::ClearViewNamesAndPaths()
 bool CMainFrame::LoadViews(int line)
 {
     LoadIgnoreCommentData();
+    m_InlineDiffCache.Clear();
     m_Data.SetBlame(m_bBlame);
     m_Data.SetMovedBlocks(m_bViewMovedBlocks);
     m_bHasConflicts = false;
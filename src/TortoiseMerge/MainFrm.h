@@ -1,6 +1,6 @@
 // TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2006-2015, 2017 - TortoiseSVN
+// Copyright (C) 2006-2015, 2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -21,6 +21,7 @@
 #include "DiffData.h"
 #include "LocatorBar.h"
 #include "LineDiffBar.h"
+#include "InlineDiffCache.h"
 #include "FilePatchesDlg.h"
 #include "TempFile.h"
 #include "XSplitter.h"
@@ -82,6 +83,7 @@ protected:
 
     afx_msg LRESULT OnTaskbarButtonCreated(WPARAM wParam, LPARAM lParam);
     afx_msg LRESULT OnIdleUpdateCmdUI(WPARAM wParam, LPARAM);
+    afx_msg LRESULT OnInlineDiffsReady(WPARAM wParam, LPARAM lParam);
 
     afx_msg void    OnFileSave();
     afx_msg void    OnFileSaveAs();
@@ -290,6 +292,7 @@ public:
     BOOL            m_bOneWay;
     BOOL            m_bReversedPatch;
     CDiffData       m_Data;
+    CInlineDiffCache m_InlineDiffCache;     ///< must be destroyed before m_Data terminates APR
     bool            m_bReadOnly;
     bool            m_bBlame;
     int             m_nMoveMovesToIgnore;
@@ -1,6 +1,6 @@
 ﻿// TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2006-2007, 2010-2011, 2013-2015 - TortoiseSVN
+// Copyright (C) 2006-2007, 2010-2011, 2013-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -21,34 +21,364 @@
 #include "Undo.h"
 
 #include "BaseView.h"
+#include "registry.h"
+#include "TempFile.h"
+
+bool viewstate::CanExtend(OpType type, int index) const
+{
+    // only the last operation can be extended, so that its
+    // payload is still at the end of the respective pool
+    if (m_ops.empty() || m_ops.back().type != type)
+        return false;
+    const Op& op = m_ops.back();
+    switch (type)
+    {
+    case OP_INSERT:
+        // any line inserted within or right after the range keeps it contiguous
+        return (index >= op.index) && (index <= op.index + op.count);
+    case OP_REMOVE:
+        // lines removed one after the other at the same position
+        return index == op.index;
+    default:
+        return index == op.index + op.count;
+    }
+}
+
+void viewstate::AddInsertedLine(int index)
+{
+    if (CanExtend(OP_INSERT, index))
+    {
+        ++m_ops.back().count;
+        return;
+    }
+    Op op = { OP_INSERT, index, 1, 0 };
+    m_ops.push_back(op);
+}
+
+void viewstate::AddRemovedLine(int index, const viewdata& oldData)
+{
+    ASSERT(!IsSpilled());
+    if (CanExtend(OP_REMOVE, index))
+        ++m_ops.back().count;
+    else
+    {
+        Op op = { OP_REMOVE, index, 1, (int)m_lines.size() };
+        m_ops.push_back(op);
+    }
+    m_lines.push_back(oldData);
+    m_nPayloadSize += sizeof(viewdata) + oldData.sLine.GetLength() * sizeof(wchar_t);
+}
+
+void viewstate::AddReplacedLine(int index, const viewdata& oldData)
+{
+    ASSERT(!IsSpilled());
+    if (CanExtend(OP_REPLACE, index))
+        ++m_ops.back().count;
+    else
+    {
+        Op op = { OP_REPLACE, index, 1, (int)m_lines.size() };
+        m_ops.push_back(op);
+    }
+    m_lines.push_back(oldData);
+    m_nPayloadSize += sizeof(viewdata) + oldData.sLine.GetLength() * sizeof(wchar_t);
+}
+
+void viewstate::AddChangedLine(int index, const CString& oldLine)
+{
+    ASSERT(!IsSpilled());
+    if (CanExtend(OP_LINE, index))
+        ++m_ops.back().count;
+    else
+    {
+        Op op = { OP_LINE, index, 1, (int)m_texts.size() };
+        m_ops.push_back(op);
+    }
+    m_texts.push_back(oldLine);
+    m_nPayloadSize += sizeof(CString) + oldLine.GetLength() * sizeof(wchar_t);
+}
+
+void viewstate::AddValue(OpType type, int index, int value)
+{
+    if (CanExtend(type, index))
+        ++m_ops.back().count;
+    else
+    {
+        Op op = { type, index, 1, (int)m_values.size() };
+        m_ops.push_back(op);
+    }
+    m_values.push_back(value);
+}
+
+void viewstate::AddChangedState(int index, DiffStates oldState)
+{
+    AddValue(OP_STATE, index, oldState);
+}
+
+void viewstate::AddChangedLineNumber(int index, int oldLineNumber)
+{
+    AddValue(OP_LINENUMBER, index, oldLineNumber);
+}
+
+void viewstate::AddChangedLineEnding(int index, EOL oldEnding)
+{
+    AddValue(OP_EOL, index, oldEnding);
+}
+
+void viewstate::AddChangedMarked(int index, bool oldMarked)
+{
+    AddValue(OP_MARKED, index, oldMarked);
+}
 
 void viewstate::AddViewLineFromView(CBaseView *pView, int nViewLine, bool bAddEmptyLine)
 {
     // is undo good place for this ?
     if (!pView || !pView->m_pViewData)
         return;
-    replacedlines[nViewLine] = pView->m_pViewData->GetData(nViewLine);
+    AddReplacedLine(nViewLine, pView->m_pViewData->GetData(nViewLine));
     if (bAddEmptyLine)
     {
-        addedlines.push_back(nViewLine + 1);
         pView->AddEmptyViewLine(nViewLine);
+        AddInsertedLine(nViewLine + 1);
     }
 }
 
 void viewstate::Clear()
 {
-    difflines.clear();
-    linestates.clear();
-    linelines.clear();
-    linesEOL.clear();
-    markedlines.clear();
-    addedlines.clear();
-
-    removedlines.clear();
-    replacedlines.clear();
+    m_ops.clear();
+    m_lines.clear();
+    m_texts.clear();
+    m_values.clear();
+    m_nPayloadSize = 0;
+    m_nSpillOffset = -1;
     modifies = false;
 }
 
+viewstate viewstate::Revert(CViewData* pViewData) const
+{
+    ASSERT(!IsSpilled());
+    viewstate revstate; // the reversed viewstate
+    revstate.m_ops.reserve(m_ops.size());
+
+    for (auto it = m_ops.crbegin(); it != m_ops.crend(); ++it)
+    {
+        const Op& op = *it;
+        switch (op.type)
+        {
+        case OP_INSERT:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddRemovedLine(op.index, pViewData->GetData(op.index));
+                pViewData->RemoveData(op.index);
+            }
+            break;
+        case OP_REMOVE:
+            for (int i = 0; i < op.count; ++i)
+            {
+                pViewData->InsertData(op.index + i, m_lines[op.first + i]);
+                revstate.AddInsertedLine(op.index + i);
+            }
+            break;
+        case OP_REPLACE:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddReplacedLine(op.index + i, pViewData->GetData(op.index + i));
+                pViewData->SetData(op.index + i, m_lines[op.first + i]);
+            }
+            break;
+        case OP_LINE:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddChangedLine(op.index + i, pViewData->GetLine(op.index + i));
+                pViewData->SetLine(op.index + i, m_texts[op.first + i]);
+            }
+            break;
+        case OP_STATE:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddChangedState(op.index + i, pViewData->GetState(op.index + i));
+                pViewData->SetState(op.index + i, (DiffStates)m_values[op.first + i]);
+            }
+            break;
+        case OP_LINENUMBER:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddChangedLineNumber(op.index + i, pViewData->GetLineNumber(op.index + i));
+                pViewData->SetLineNumber(op.index + i, m_values[op.first + i]);
+            }
+            break;
+        case OP_EOL:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddChangedLineEnding(op.index + i, pViewData->GetLineEnding(op.index + i));
+                pViewData->SetLineEnding(op.index + i, (EOL)m_values[op.first + i]);
+            }
+            break;
+        case OP_MARKED:
+            for (int i = 0; i < op.count; ++i)
+            {
+                revstate.AddChangedMarked(op.index + i, pViewData->GetMarked(op.index + i));
+                pViewData->SetMarked(op.index + i, m_values[op.first + i] != 0);
+            }
+            break;
+        }
+    }
+    return revstate;
+}
+
+namespace
+{
+    // fixed size part of a pooled line in the spill file
+    struct SpilledLine
+    {
+        int     length;
+        int     state;
+        int     linenumber;
+        int     movedIndex;
+        int     ending;
+        int     hidestate;
+        BYTE    movedFrom;
+        BYTE    marked;
+    };
+
+    template<class T>
+    void Append(std::vector<BYTE>& buffer, const T& value)
+    {
+        const BYTE* p = reinterpret_cast<const BYTE*>(&value);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+
+    void AppendText(std::vector<BYTE>& buffer, const CString& text)
+    {
+        const BYTE* p = reinterpret_cast<const BYTE*>((LPCWSTR)text);
+        buffer.insert(buffer.end(), p, p + text.GetLength() * sizeof(wchar_t));
+    }
+
+    template<class T>
+    bool Extract(const std::vector<BYTE>& buffer, size_t& pos, T& value)
+    {
+        if (pos + sizeof(T) > buffer.size())
+            return false;
+        memcpy(&value, &buffer[pos], sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool ExtractText(const std::vector<BYTE>& buffer, size_t& pos, int length, CString& text)
+    {
+        size_t size = length * sizeof(wchar_t);
+        if ((length < 0) || (pos + size > buffer.size()))
+            return false;
+        text = CString(reinterpret_cast<LPCWSTR>(buffer.data() + pos), length);
+        pos += size;
+        return true;
+    }
+}
+
+size_t viewstate::GetSpillSize() const
+{
+    size_t size = 2 * sizeof(int);
+    for (const auto& line : m_lines)
+        size += sizeof(SpilledLine) + line.sLine.GetLength() * sizeof(wchar_t);
+    for (const auto& text : m_texts)
+        size += sizeof(int) + text.GetLength() * sizeof(wchar_t);
+    return size;
+}
+
+bool viewstate::Spill(HANDLE hFile, LONGLONG offset)
+{
+    if (IsSpilled() || (m_nPayloadSize == 0))
+        return true;
+
+    std::vector<BYTE> buffer;
+    buffer.reserve(m_nPayloadSize + 2 * sizeof(int));
+    Append(buffer, (int)m_lines.size());
+    Append(buffer, (int)m_texts.size());
+    for (const auto& line : m_lines)
+    {
+        SpilledLine header = { line.sLine.GetLength(), line.state, line.linenumber, line.movedIndex
+                             , line.ending, line.hidestate, line.movedFrom, line.marked };
+        Append(buffer, header);
+        AppendText(buffer, line.sLine);
+    }
+    for (const auto& text : m_texts)
+    {
+        Append(buffer, text.GetLength());
+        AppendText(buffer, text);
+    }
+
+    ASSERT(buffer.size() == GetSpillSize());
+
+    LARGE_INTEGER position;
+    position.QuadPart = offset;
+    DWORD written = 0;
+    if (!SetFilePointerEx(hFile, position, nullptr, FILE_BEGIN)
+        || !WriteFile(hFile, buffer.data(), (DWORD)buffer.size(), &written, nullptr)
+        || (written != buffer.size()))
+        return false;
+
+    m_nSpillOffset = offset;
+
+    // release the memory, the pool sizes are part of the file
+    std::vector<viewdata>().swap(m_lines);
+    std::vector<CString>().swap(m_texts);
+    m_nPayloadSize = buffer.size();
+    return true;
+}
+
+bool viewstate::Reload(HANDLE hFile)
+{
+    if (!IsSpilled())
+        return true;
+
+    // while spilled, m_nPayloadSize is the size of the data in the file
+    std::vector<BYTE> buffer(m_nPayloadSize);
+    LARGE_INTEGER offset;
+    offset.QuadPart = m_nSpillOffset;
+    DWORD read = 0;
+    if (!SetFilePointerEx(hFile, offset, nullptr, FILE_BEGIN)
+        || !ReadFile(hFile, buffer.data(), (DWORD)buffer.size(), &read, nullptr)
+        || (read != buffer.size()))
+        return false;
+
+    size_t pos = 0;
+    int lineCount = 0;
+    int textCount = 0;
+    if (!Extract(buffer, pos, lineCount) || !Extract(buffer, pos, textCount))
+        return false;
+
+    std::vector<viewdata> lines(lineCount);
+    for (auto& line : lines)
+    {
+        SpilledLine header;
+        if (!Extract(buffer, pos, header) || !ExtractText(buffer, pos, header.length, line.sLine))
+            return false;
+        line.state = (DiffStates)header.state;
+        line.linenumber = header.linenumber;
+        line.movedIndex = header.movedIndex;
+        line.ending = (EOL)header.ending;
+        line.hidestate = (HIDESTATE)header.hidestate;
+        line.movedFrom = header.movedFrom != 0;
+        line.marked = header.marked != 0;
+    }
+    std::vector<CString> texts(textCount);
+    for (auto& text : texts)
+    {
+        int length = 0;
+        if (!Extract(buffer, pos, length) || !ExtractText(buffer, pos, length, text))
+            return false;
+    }
+
+    m_lines.swap(lines);
+    m_texts.swap(texts);
+    m_nSpillOffset = -1;
+    m_nPayloadSize = 0;
+    for (const auto& line : m_lines)
+        m_nPayloadSize += sizeof(viewdata) + line.sLine.GetLength() * sizeof(wchar_t);
+    for (const auto& text : m_texts)
+        m_nPayloadSize += sizeof(CString) + text.GetLength() * sizeof(wchar_t);
+    return true;
+}
+
 void CUndo::MarkAsOriginalState(bool bLeft, bool bRight, bool bBottom)
 {
     // TODO reduce code duplication
@@ -92,7 +422,9 @@ CUndo& CUndo::GetInstance()
 }
 
 CUndo::CUndo()
+    : m_nSpillFileSize(0)
 {
+    m_nMemoryLimit = (size_t)(DWORD)CRegDWORD(L"Software\\TortoiseMerge\\UndoMemoryLimit", 64) * 1024 * 1024;
     Clear();
 }
 
@@ -106,9 +438,155 @@ void CUndo::AddState(const allviewstate& allstate, POINT pt)
     m_caretpoints.push_back(pt);
     // a new action that can be undone clears the redo since
     // after this there is nothing to redo anymore
+    ReleaseSpillSpace(m_redoviewstates);
     m_redoviewstates.clear();
     m_redocaretpoints.clear();
     m_redogroups.clear();
+
+    LimitMemory();
+}
+
+void CUndo::LimitMemory()
+{
+    if (m_nMemoryLimit == 0)
+        return;
+
+    // keep the most recent steps in memory,
+    // they are the most likely to be undone or redone
+    size_t nSize = 0;
+    LimitMemory(m_viewstates, nSize);
+    LimitMemory(m_redoviewstates, nSize);
+}
+
+void CUndo::LimitMemory(std::list<allviewstate>& states, size_t& nSize)
+{
+    for (auto it = states.rbegin(); it != states.rend(); ++it)
+    {
+        for (viewstate* pState : { &it->left, &it->right, &it->bottom })
+        {
+            nSize += pState->GetPayloadSize();
+            if ((nSize <= m_nMemoryLimit) || pState->IsSpilled())
+                continue;
+
+            if (!m_hSpillFile)
+            {
+                m_hSpillFile = CreateFile(CTempFiles::Instance().GetTempFilePathString(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                          FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+                m_nSpillFileSize = 0;
+                m_spillGaps.clear();
+                if (!m_hSpillFile)
+                {
+                    // keep everything in memory
+                    m_nMemoryLimit = 0;
+                    return;
+                }
+            }
+
+            LONGLONG size = (LONGLONG)pState->GetSpillSize();
+            LONGLONG offset = AllocateSpillSpace(size);
+            if (!pState->Spill(m_hSpillFile, offset))
+            {
+                // e.g. the disk is full: keep everything in memory
+                ReleaseSpillSpace(offset, size);
+                m_nMemoryLimit = 0;
+                return;
+            }
+        }
+    }
+}
+
+bool CUndo::Reload(std::list<allviewstate>& states, size_t count)
+{
+    for (auto it = states.rbegin(); (it != states.rend()) && (count > 0); ++it, --count)
+    {
+        if (!Reload(it->left) || !Reload(it->right) || !Reload(it->bottom))
+            return false;
+    }
+    return true;
+}
+
+bool CUndo::Reload(viewstate& state)
+{
+    if (!state.IsSpilled())
+        return true;
+
+    LONGLONG offset = state.GetSpillOffset();
+    LONGLONG size = (LONGLONG)state.GetSpilledSize();
+    if (!state.Reload(m_hSpillFile))
+        return false;
+
+    ReleaseSpillSpace(offset, size);
+    return true;
+}
+
+LONGLONG CUndo::AllocateSpillSpace(LONGLONG size)
+{
+    // first fit, the remainder of the gap stays available
+    for (auto it = m_spillGaps.begin(); it != m_spillGaps.end(); ++it)
+    {
+        if (it->second < size)
+            continue;
+
+        LONGLONG offset = it->first;
+        LONGLONG remainder = it->second - size;
+        m_spillGaps.erase(it);
+        if (remainder > 0)
+            m_spillGaps[offset + size] = remainder;
+        return offset;
+    }
+
+    LONGLONG offset = m_nSpillFileSize;
+    m_nSpillFileSize += size;
+    return offset;
+}
+
+void CUndo::ReleaseSpillSpace(LONGLONG offset, LONGLONG size)
+{
+    if (size <= 0)
+        return;
+
+    // merge with the adjacent gaps
+    auto next = m_spillGaps.lower_bound(offset);
+    if ((next != m_spillGaps.end()) && (next->first == offset + size))
+    {
+        size += next->second;
+        next = m_spillGaps.erase(next);
+    }
+    if (next != m_spillGaps.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            m_spillGaps.erase(previous);
+        }
+    }
+
+    if (offset + size < m_nSpillFileSize)
+    {
+        m_spillGaps[offset] = size;
+        return;
+    }
+
+    // the end of the file is unused now
+    m_nSpillFileSize = offset;
+    LARGE_INTEGER position;
+    position.QuadPart = offset;
+    if (SetFilePointerEx(m_hSpillFile, position, nullptr, FILE_BEGIN))
+        SetEndOfFile(m_hSpillFile);
+}
+
+void CUndo::ReleaseSpillSpace(std::list<allviewstate>& states)
+{
+    for (auto& state : states)
+    {
+        for (viewstate* pState : { &state.left, &state.right, &state.bottom })
+        {
+            if (pState->IsSpilled())
+                ReleaseSpillSpace(pState->GetSpillOffset(), (LONGLONG)pState->GetSpilledSize());
+        }
+    }
 }
 
 bool CUndo::Undo(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
@@ -116,6 +594,14 @@ bool CUndo::Undo(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
     if (!CanUndo())
         return false;
 
+    // all line pools of the step or group must be available,
+    // otherwise nothing gets undone and the steps stay where they are
+    size_t count = 1;
+    if (m_groups.size() && m_groups.back() == m_caretpoints.size())
+        count = m_caretpoints.size() - *std::next(m_groups.rbegin());
+    if (!Reload(m_viewstates, count))
+        return false;
+
     if (m_groups.size() && m_groups.back() == m_caretpoints.size())
     {
         m_groups.pop_back();
@@ -225,12 +711,13 @@ bool CUndo::Undo(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
         pActiveView->RefreshViews();
     }
 
+    LimitMemory();
     return true;
 }
 
 void CUndo::UndoOne(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
 {
-    allviewstate allstate = m_viewstates.back();
+    allviewstate allstate = std::move(m_viewstates.back());
     POINT pt = m_caretpoints.back();
 
     if (pLeft->IsTarget())
@@ -255,6 +742,12 @@ bool CUndo::Redo(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
     if (!CanRedo())
         return false;
 
+    size_t count = 1;
+    if (m_redogroups.size() && m_redogroups.back() == m_redocaretpoints.size())
+        count = m_redocaretpoints.size() - *std::next(m_redogroups.rbegin());
+    if (!Reload(m_redoviewstates, count))
+        return false;
+
     if (m_redogroups.size() && m_redogroups.back() == m_redocaretpoints.size())
     {
         m_redogroups.pop_back();
@@ -364,12 +857,13 @@ bool CUndo::Redo(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
         pActiveView->RefreshViews();
     }
 
+    LimitMemory();
     return true;
 }
 
 void CUndo::RedoOne(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
 {
-    allviewstate allstate = m_redoviewstates.back();
+    allviewstate allstate = std::move(m_redoviewstates.back());
     POINT pt = m_redocaretpoints.back();
 
     if (pLeft->IsTarget())
@@ -388,7 +882,7 @@ void CUndo::RedoOne(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom)
     m_redoviewstates.pop_back();
     m_redocaretpoints.pop_back();
 }
-viewstate CUndo::Do(const viewstate& state, CBaseView * pView, const POINT& pt)
+viewstate CUndo::Do(viewstate& state, CBaseView * pView, const POINT& pt)
 {
     if (!pView)
         return state;
@@ -397,49 +891,15 @@ viewstate CUndo::Do(const viewstate& state, CBaseView * pView, const POINT& pt)
     if (!viewData)
         return state;
 
-    viewstate revstate; // the reversed viewstate
-
-    for (std::list<int>::const_reverse_iterator it = state.addedlines.rbegin(); it != state.addedlines.rend(); ++it)
-    {
-        revstate.removedlines[*it] = viewData->GetData(*it);
-        viewData->RemoveData(*it);
-    }
-    for (std::map<int, DWORD>::const_iterator it = state.linelines.begin(); it != state.linelines.end(); ++it)
-    {
-        revstate.linelines[it->first] = viewData->GetLineNumber(it->first);
-        viewData->SetLineNumber(it->first, it->second);
-    }
-    for (std::map<int, DWORD>::const_iterator it = state.linestates.begin(); it != state.linestates.end(); ++it)
+    // Undo() and Redo() reload the line pools before
+    if (state.IsSpilled())
     {
-        revstate.linestates[it->first] = viewData->GetState(it->first);
-        viewData->SetState(it->first, (DiffStates)it->second);
-    }
-    for (std::map<int, EOL>::const_iterator it = state.linesEOL.begin(); it != state.linesEOL.end(); ++it)
-    {
-        revstate.linesEOL[it->first] = viewData->GetLineEnding(it->first);
-        viewData->SetLineEnding(it->first, it->second);
-    }
-    for (std::map<int, bool>::const_iterator it = state.markedlines.begin(); it != state.markedlines.end(); ++it)
-    {
-        revstate.markedlines[it->first] = viewData->GetMarked(it->first);
-        viewData->SetMarked(it->first, it->second);
-    }
-    for (std::map<int, CString>::const_iterator it = state.difflines.begin(); it != state.difflines.end(); ++it)
-    {
-        revstate.difflines[it->first] = viewData->GetLine(it->first);
-        viewData->SetLine(it->first, it->second);
-    }
-    for (std::map<int, viewdata>::const_iterator it = state.removedlines.begin(); it != state.removedlines.end(); ++it)
-    {
-        revstate.addedlines.push_back(it->first);
-        viewData->InsertData(it->first, it->second);
-    }
-    for (std::map<int, viewdata>::const_iterator it = state.replacedlines.begin(); it != state.replacedlines.end(); ++it)
-    {
-        revstate.replacedlines[it->first] = viewData->GetData(it->first);
-        viewData->SetData(it->first, it->second);
+        ASSERT(false);
+        return state;
     }
 
+    viewstate revstate = state.Revert(viewData);
+
     if (pView->IsTarget())
     {
         pView->SetCaretViewPosition(pt);
@@ -460,4 +920,7 @@ void CUndo::Clear()
     m_originalstateRight = 0;
     m_originalstateBottom = 0;
     m_groupCount = 0;
+    m_hSpillFile.CloseHandle();
+    m_nSpillFileSize = 0;
+    m_spillGaps.clear();
 }
@@ -1,6 +1,6 @@
 // TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2006-2007, 2009-2015 - TortoiseSVN
+// Copyright (C) 2006-2007, 2009-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -18,36 +18,100 @@
 //
 #pragma once
 #include "ViewData.h"
-#include <map>
+#include "SmartHandle.h"
+#include <vector>
 #include <list>
+#include <map>
 
 class CBaseView;
 
 /**
  * \ingroup TortoiseMerge
  * this struct holds all the information of a single change in TortoiseMerge.
+ *
+ * The change is recorded as a journal of operations in the order they were
+ * made. Operations on consecutive lines are merged into range operations
+ * which refer to the previous line contents in pools. Undoing the change
+ * replays the journal backwards, i.e. it costs O(changed lines), and yields
+ * the journal of the reverse change.
+ *
+ * The line pools may be written to a file to limit the memory used by
+ * older steps, see CUndo::LimitMemory().
  */
 class viewstate
 {
 public:
     viewstate()
         : modifies(false)
+        , m_nPayloadSize(0)
+        , m_nSpillOffset(-1)
     {}
 
-    std::map<int, CString>  difflines;
-    std::map<int, DWORD>    linestates;
-    std::map<int, DWORD>    linelines;
-    std::map<int, EOL>      linesEOL;
-    std::map<int, bool>     markedlines;
-    std::list<int>          addedlines;
-
-    std::map<int, viewdata> removedlines;
-    std::map<int, viewdata> replacedlines;
     bool                    modifies; ///< this step modifies view (save before and after save differs)
 
+    /// record the modification of a single line. Call these *before* the
+    /// view data gets modified, except for AddInsertedLine().
+    void    AddInsertedLine(int index);
+    void    AddRemovedLine(int index, const viewdata& oldData);
+    void    AddReplacedLine(int index, const viewdata& oldData);
+    void    AddChangedLine(int index, const CString& oldLine);
+    void    AddChangedState(int index, DiffStates oldState);
+    void    AddChangedLineNumber(int index, int oldLineNumber);
+    void    AddChangedLineEnding(int index, EOL oldEnding);
+    void    AddChangedMarked(int index, bool oldMarked);
+
     void    AddViewLineFromView(CBaseView *pView, int nViewLine, bool bAddEmptyLine);
     void    Clear();
-    bool    IsEmpty() const { return difflines.empty() && linestates.empty() && linelines.empty() && linesEOL.empty() && markedlines.empty() && addedlines.empty() && removedlines.empty() && replacedlines.empty(); }
+    bool    IsEmpty() const { return m_ops.empty(); }
+
+    /// reverts the recorded change and returns the journal which restores it again
+    viewstate Revert(CViewData* pViewData) const;
+
+    /// memory used by the line pools, 0 if they have been written to a file
+    size_t  GetPayloadSize() const { return IsSpilled() ? 0 : m_nPayloadSize; }
+    bool    IsSpilled() const { return m_nSpillOffset >= 0; }
+    /// number of bytes Spill() writes
+    size_t  GetSpillSize() const;
+    /// location of the line pools in the spill file, if they have been written
+    LONGLONG GetSpillOffset() const { return m_nSpillOffset; }
+    size_t  GetSpilledSize() const { return IsSpilled() ? m_nPayloadSize : 0; }
+    /// writes the line pools to \a hFile at \a offset and releases them
+    bool    Spill(HANDLE hFile, LONGLONG offset);
+    /// reads the line pools back from \a hFile. The state is
+    /// unchanged if that fails.
+    bool    Reload(HANDLE hFile);
+
+private:
+    enum OpType : BYTE
+    {
+        OP_INSERT,          ///< lines have been inserted, no payload
+        OP_REMOVE,          ///< lines have been removed, payload in m_lines
+        OP_REPLACE,         ///< lines have been replaced, payload in m_lines
+        OP_LINE,            ///< line texts have been changed, payload in m_texts
+        OP_STATE,           ///< payload of this and the following ones in m_values
+        OP_LINENUMBER,
+        OP_EOL,
+        OP_MARKED,
+    };
+
+    struct Op
+    {
+        OpType  type;
+        int     index;      ///< first view line
+        int     count;      ///< number of lines
+        int     first;      ///< first entry of the payload in its pool
+    };
+
+    void    AddValue(OpType type, int index, int value);
+    bool    CanExtend(OpType type, int index) const;
+
+    std::vector<Op>         m_ops;
+    std::vector<viewdata>   m_lines;
+    std::vector<CString>    m_texts;
+    std::vector<int>        m_values;
+
+    size_t                  m_nPayloadSize;
+    LONGLONG                m_nSpillOffset;
 };
 
 /**
@@ -88,9 +152,18 @@ public:
     void MarkAllAsOriginalState() { MarkAsOriginalState(true, true, true); }
     void MarkAsOriginalState(bool Left, bool Right, bool Bottom);
 protected:
-    viewstate Do(const viewstate& state, CBaseView * pView, const POINT& pt);
+    viewstate Do(viewstate& state, CBaseView * pView, const POINT& pt);
     void UndoOne(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom);
     void RedoOne(CBaseView * pLeft, CBaseView * pRight, CBaseView * pBottom);
+    void LimitMemory();
+    void LimitMemory(std::list<allviewstate>& states, size_t& nSize);
+    /// reads the line pools of the last \a count steps back into memory
+    bool Reload(std::list<allviewstate>& states, size_t count);
+    bool Reload(viewstate& state);
+    /// space management within the spill file
+    LONGLONG AllocateSpillSpace(LONGLONG size);
+    void ReleaseSpillSpace(LONGLONG offset, LONGLONG size);
+    void ReleaseSpillSpace(std::list<allviewstate>& states);
     std::list<allviewstate> m_viewstates;
     std::list<POINT> m_caretpoints;
     std::list< std::list<int>::size_type > m_groups;
@@ -103,6 +176,15 @@ protected:
     std::list<POINT> m_redocaretpoints;
     std::list< std::list<int>::size_type > m_redogroups;
 
+    // line pools of older steps are written to this file
+    // once their size exceeds m_nMemoryLimit bytes (0: no limit).
+    // The space of reloaded or dropped steps gets reused, and
+    // the file is truncated when its end becomes unused.
+    size_t m_nMemoryLimit;
+    CAutoFile m_hSpillFile;
+    LONGLONG m_nSpillFileSize;
+    std::map<LONGLONG, LONGLONG> m_spillGaps;   ///< offset -> size of unused ranges
+
 private:
     CUndo();
     ~CUndo();
@@ -1,6 +1,6 @@
 // TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2007, 2009-2010, 2014 - TortoiseSVN
+// Copyright (C) 2007, 2009-2010, 2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -20,7 +20,12 @@
 #include "ViewData.h"
 
 CViewData::CViewData(void)
-    : m_nMarkedBlocks(0)
+    : m_nCount(0)
+    , m_nMarkedBlocks(0)
+    , m_nCachedBlock(-1)
+    , m_nCachedStart(0)
+    , m_nCachedEnd(0)
+    , m_readCache(NO_READ_CACHE)
 {
 }
 
@@ -42,7 +47,24 @@ void CViewData::AddData(const CString& sLine, DiffStates state, int linenumber,
 
 void CViewData::AddData(const viewdata& data)
 {
-    return m_data.push_back(data);
+    if (m_blocks.empty() || (m_blocks.back().lines.size() >= MAX_BLOCK_SIZE))
+    {
+        m_blocks.push_back(ViewDataBlock());
+        m_blocks.back().lines.reserve(MAX_BLOCK_SIZE);
+        m_blockSizes.push_back(0);
+        // the new tree node covers some of the preceding blocks as well
+        int node = (int)m_blockSizes.size();
+        int first = node - (node & -node);
+        for (int block = node - 1; block > first; block = (block & (block - 1)))
+            m_blockSizes[node - 1] += m_blockSizes[block - 1];
+    }
+
+    ViewDataBlock& block = m_blocks.back();
+    block.lines.push_back(data);
+    if (data.linenumber > block.maxLineNumber)
+        block.maxLineNumber = data.linenumber;
+    AddToBlockSize((int)m_blocks.size() - 1, 1);
+    ++m_nCount;
 }
 
 void CViewData::InsertData(int index, const CString& sLine, DiffStates state, int linenumber, EOL ending, HIDESTATE hide, int movedIndex)
@@ -59,13 +81,152 @@ void CViewData::InsertData(int index, const CString& sLine, DiffStates state, in
 
 void CViewData::InsertData(int index, const viewdata& data)
 {
-    m_data.insert(m_data.begin()+index, data);
+    if (index >= m_nCount)
+        return AddData(data);
+
+    LocateBlock(index);
+    int blockIndex = m_nCachedBlock;
+    ViewDataBlock& block = m_blocks[blockIndex];
+    block.lines.insert(block.lines.begin() + (index - m_nCachedStart), data);
+    if (data.linenumber > block.maxLineNumber)
+        block.maxLineNumber = data.linenumber;
+    ++m_nCount;
+
+    if (block.lines.size() <= MAX_BLOCK_SIZE)
+    {
+        AddToBlockSize(blockIndex, 1);
+        ++m_nCachedEnd;
+        InvalidateReadCache();
+        return;
+    }
+
+    // split the block in halves
+    ViewDataBlock upper;
+    upper.lines.reserve(MAX_BLOCK_SIZE);
+    upper.lines.assign(block.lines.begin() + MAX_BLOCK_SIZE / 2, block.lines.end());
+    upper.maxLineNumber = block.maxLineNumber;
+    block.lines.erase(block.lines.begin() + MAX_BLOCK_SIZE / 2, block.lines.end());
+    m_blocks.insert(m_blocks.begin() + blockIndex + 1, upper);
+
+    RebuildBlockSizes();
+}
+
+void CViewData::RemoveData(int index)
+{
+    LocateBlock(index);
+    int blockIndex = m_nCachedBlock;
+    ViewDataBlock& block = m_blocks[blockIndex];
+    block.lines.erase(block.lines.begin() + (index - m_nCachedStart));
+    --m_nCount;
+
+    // merge small blocks with their successor to keep the number of blocks low
+    if (block.lines.empty())
+    {
+        m_blocks.erase(m_blocks.begin() + blockIndex);
+    }
+    else if ((block.lines.size() < MAX_BLOCK_SIZE / 4) &&
+             (blockIndex + 1 < (int)m_blocks.size()) &&
+             (block.lines.size() + m_blocks[blockIndex + 1].lines.size() <= MAX_BLOCK_SIZE / 2))
+    {
+        ViewDataBlock& next = m_blocks[blockIndex + 1];
+        block.lines.insert(block.lines.end(), next.lines.begin(), next.lines.end());
+        block.maxLineNumber = std::max(block.maxLineNumber, next.maxLineNumber);
+        m_blocks.erase(m_blocks.begin() + blockIndex + 1);
+    }
+    else
+    {
+        AddToBlockSize(blockIndex, -1);
+        --m_nCachedEnd;
+        InvalidateReadCache();
+        return;
+    }
+
+    RebuildBlockSizes();
 }
 
 int CViewData::FindLineNumber(int number) const
 {
-    for(size_t i = 0; i < m_data.size(); ++i)
-        if (m_data[i].linenumber >= number)
-            return (int)i;
+    int start = 0;
+    for (size_t b = 0; b < m_blocks.size(); ++b)
+    {
+        const ViewDataBlock& block = m_blocks[b];
+        if (block.maxLineNumber >= number)
+        {
+            for (size_t i = 0; i < block.lines.size(); ++i)
+            {
+                if (block.lines[i].linenumber >= number)
+                    return start + (int)i;
+            }
+        }
+        start += (int)block.lines.size();
+    }
     return -1;
 }
+
+void CViewData::Clear()
+{
+    m_blocks.clear();
+    m_blockSizes.clear();
+    m_nCount = 0;
+    m_nMarkedBlocks = 0;
+    InvalidateCache();
+}
+
+int CViewData::FindBlock(int index, int& start) const
+{
+    // descend the Fenwick tree
+    int node = 0;
+    int remaining = index;
+    int nodeCount = (int)m_blockSizes.size();
+    int step = 1;
+    while (step * 2 <= nodeCount)
+        step *= 2;
+    for (; step > 0; step /= 2)
+    {
+        if ((node + step <= nodeCount) && (m_blockSizes[node + step - 1] <= remaining))
+        {
+            node += step;
+            remaining -= m_blockSizes[node - 1];
+        }
+    }
+    ASSERT(node < (int)m_blocks.size());
+    start = index - remaining;
+    return node;
+}
+
+void CViewData::LocateBlock(int index)
+{
+    // sequential access usually continues in the next block
+    int block = m_nCachedBlock + 1;
+    if ((index >= m_nCachedEnd) && (block < (int)m_blocks.size()) &&
+        (index < m_nCachedEnd + (int)m_blocks[block].lines.size()))
+    {
+        m_nCachedStart = m_nCachedEnd;
+    }
+    else
+    {
+        block = FindBlock(index, m_nCachedStart);
+    }
+    m_nCachedBlock = block;
+    m_nCachedEnd = m_nCachedStart + (int)m_blocks[block].lines.size();
+}
+
+void CViewData::AddToBlockSize(int block, int delta)
+{
+    for (int node = block + 1; node <= (int)m_blockSizes.size(); node += (node & -node))
+        m_blockSizes[node - 1] += delta;
+}
+
+void CViewData::RebuildBlockSizes()
+{
+    int nodeCount = (int)m_blocks.size();
+    m_blockSizes.assign(nodeCount, 0);
+    for (int node = 1; node <= nodeCount; ++node)
+    {
+        m_blockSizes[node - 1] += (int)m_blocks[node - 1].lines.size();
+        int parent = node + (node & -node);
+        if (parent <= nodeCount)
+            m_blockSizes[parent - 1] += m_blockSizes[node - 1];
+    }
+    InvalidateCache();
+}
@@ -1,6 +1,6 @@
 // TortoiseMerge - a Diff/Patch program
 
-// Copyright (C) 2007-2011, 2013-2014 - TortoiseSVN
+// Copyright (C) 2007-2011, 2013-2014, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -21,6 +21,7 @@
 #include "EOL.h"
 
 #include <vector>
+#include <atomic>
 
 enum HIDESTATE
 {
@@ -78,6 +79,17 @@ public:
 /**
  * \ingroup TortoiseMerge
  * Handles the view and diff data a TortoiseMerge view needs.
+ *
+ * The lines are stored in blocks of limited size. A Fenwick tree over the
+ * block sizes maps view indices to blocks, so that inserting and removing
+ * lines only needs to shift the lines of a single block instead of the
+ * whole view. Every block also keeps an upper bound of its line numbers
+ * which lets FindLineNumber() skip blocks without scanning their lines.
+ *
+ * Both the const and the non-const accessors remember the block they
+ * accessed last. The views may be read from several threads as long as
+ * nobody changes them, so the const accessors keep their own block and
+ * its start in a single atomic value.
  */
 class CViewData
 {
@@ -90,53 +102,113 @@ public:
     void            AddEmpty() {AddData(CString(), DIFFSTATE_EMPTY, -1, EOL_NOENDING, HIDESTATE_SHOWN, -1);}
     void            InsertData(int index, const CString& sLine, DiffStates state, int linenumber, EOL ending, HIDESTATE hide, int movedline);
     void            InsertData(int index, const viewdata& data);
-    void            RemoveData(int index) {m_data.erase(m_data.begin() + index);}
-
-    const viewdata& GetData(int index) const {return m_data[index];}
-    const CString&  GetLine(int index) const {return m_data[index].sLine;}
-    DiffStates      GetState(int index) const {return m_data[index].state;}
-    HIDESTATE       GetHideState(int index) const {return m_data[index].hidestate;}
-    int             GetLineNumber(int index) const {return m_data.size() ? m_data[index].linenumber : 0;}
-    int             GetMovedIndex(int index) const {return m_data.size() ? m_data[index].movedIndex: 0;}
-    bool            IsMoved(int index) const {return m_data.size() ? m_data[index].movedIndex >= 0 : false;}
-    bool            IsMovedFrom(int index) const {return m_data.size() ? m_data[index].movedFrom : true;}
+    void            RemoveData(int index);
+
+    const viewdata& GetData(int index) const {return Item(index);}
+    const CString&  GetLine(int index) const {return Item(index).sLine;}
+    DiffStates      GetState(int index) const {return Item(index).state;}
+    HIDESTATE       GetHideState(int index) const {return Item(index).hidestate;}
+    int             GetLineNumber(int index) const {return m_nCount ? Item(index).linenumber : 0;}
+    int             GetMovedIndex(int index) const {return m_nCount ? Item(index).movedIndex: 0;}
+    bool            IsMoved(int index) const {return m_nCount ? Item(index).movedIndex >= 0 : false;}
+    bool            IsMovedFrom(int index) const {return m_nCount ? Item(index).movedFrom : true;}
     int             FindLineNumber(int number) const;
-    EOL             GetLineEnding(int index) const {return m_data[index].ending;}
-    bool            GetMarked(int index) const {return m_data[index].marked;}
+    EOL             GetLineEnding(int index) const {return Item(index).ending;}
+    bool            GetMarked(int index) const {return Item(index).marked;}
 
-    int             GetCount() const {return (int)m_data.size();}
+    int             GetCount() const {return m_nCount;}
 
     void            SetData(int index, const viewdata& data)
     {
-        bool oldmarked = m_data[index].marked;
+        viewdata& item = Item(index);
+        bool oldmarked = item.marked;
         bool marked = data.marked;
         if (oldmarked && !marked && m_nMarkedBlocks > 0)
             m_nMarkedBlocks--;
         else if (!oldmarked && marked)
             m_nMarkedBlocks++;
-        m_data[index] = data;
+        item = data;
+        UpdateMaxLineNumber(data.linenumber);
     }
-    void            SetState(int index, DiffStates state) {m_data[index].state = state;}
-    void            SetLine(int index, const CString& sLine) {m_data[index].sLine = sLine;}
-    void            SetLineNumber(int index, int linenumber) {m_data[index].linenumber = linenumber;}
-    void            SetLineEnding(int index, EOL ending) {m_data[index].ending = ending;}
-    void            SetMovedIndex(int index, int movedIndex, bool movedFrom) {m_data[index].movedIndex = movedIndex; m_data[index].movedFrom = movedFrom;}
-    void            SetLineHideState(int index, HIDESTATE state) {m_data[index].hidestate = state;}
+    void            SetState(int index, DiffStates state) {Item(index).state = state;}
+    void            SetLine(int index, const CString& sLine) {Item(index).sLine = sLine;}
+    void            SetLineNumber(int index, int linenumber) {Item(index).linenumber = linenumber; UpdateMaxLineNumber(linenumber);}
+    void            SetLineEnding(int index, EOL ending) {Item(index).ending = ending;}
+    void            SetMovedIndex(int index, int movedIndex, bool movedFrom) {viewdata& item = Item(index); item.movedIndex = movedIndex; item.movedFrom = movedFrom;}
+    void            SetLineHideState(int index, HIDESTATE state) {Item(index).hidestate = state;}
     void            SetMarked(int index, bool marked)
     {
-        bool oldmarked = m_data[index].marked;
+        viewdata& item = Item(index);
+        bool oldmarked = item.marked;
         if (oldmarked && !marked && m_nMarkedBlocks > 0)
             m_nMarkedBlocks--;
         else if (!oldmarked && marked)
             m_nMarkedBlocks++;
-        m_data[index].marked = marked;
+        item.marked = marked;
     }
     bool            HasMarkedBlocks() { return m_nMarkedBlocks > 0; }
 
-    void            Clear() { m_data.clear(); m_nMarkedBlocks = 0; }
-    void            Reserve(int length) {m_data.reserve(length);}
+    void            Clear();
+    void            Reserve(int length) {m_blocks.reserve(length / MAX_BLOCK_SIZE + 1);}
 
 protected:
-    std::vector<viewdata>       m_data;
+    /// blocks get split when they grow beyond this size
+    enum { MAX_BLOCK_SIZE = 1024 };
+    /// block -1 at start 0
+    static const ULONGLONG NO_READ_CACHE = 0xffffffff00000000ULL;
+
+    struct ViewDataBlock
+    {
+        std::vector<viewdata>   lines;
+        /// no line in this block has a higher line number
+        int                     maxLineNumber;
+
+        ViewDataBlock() : maxLineNumber(-1) {}
+    };
+
+    const viewdata& Item(int index) const
+    {
+        ULONGLONG cached = m_readCache.load(std::memory_order_relaxed);
+        int block = (int)(cached >> 32);
+        int start = (int)(cached & 0xffffffff);
+        if ((block < 0) || (index < start) || (index >= start + (int)m_blocks[block].lines.size()))
+        {
+            block = FindBlock(index, start);
+            m_readCache.store(((ULONGLONG)block << 32) | (ULONG)start, std::memory_order_relaxed);
+        }
+        return m_blocks[block].lines[index - start];
+    }
+    viewdata&       Item(int index)
+    {
+        if ((index < m_nCachedStart) || (index >= m_nCachedEnd))
+            LocateBlock(index);
+        return m_blocks[m_nCachedBlock].lines[index - m_nCachedStart];
+    }
+
+    /// returns the block containing \a index and the view index of its first line
+    int             FindBlock(int index, int& start) const;
+    /// makes the block containing \a index the cached one
+    void            LocateBlock(int index);
+    /// raises the line number bound of the block that Item() returned last
+    void            UpdateMaxLineNumber(int linenumber) {if (linenumber > m_blocks[m_nCachedBlock].maxLineNumber) m_blocks[m_nCachedBlock].maxLineNumber = linenumber;}
+
+    /// Fenwick tree maintenance
+    void            AddToBlockSize(int block, int delta);
+    void            RebuildBlockSizes();
+    void            InvalidateCache() {m_nCachedBlock = -1; m_nCachedStart = 0; m_nCachedEnd = 0; InvalidateReadCache();}
+    void            InvalidateReadCache() {m_readCache.store(NO_READ_CACHE, std::memory_order_relaxed);}
+
+    std::vector<ViewDataBlock>  m_blocks;
+    std::vector<int>            m_blockSizes;   ///< Fenwick tree of the block sizes
+    int                         m_nCount;
     int                         m_nMarkedBlocks;
+
+    /// the block last accessed (-1 if none) and its view index range
+    int                         m_nCachedBlock;
+    int                         m_nCachedStart;
+    int                         m_nCachedEnd;
+
+    /// the block last read by the const accessors (upper 32 bits) and
+    /// the view index of its first line (lower 32 bits)
+    mutable std::atomic<ULONGLONG> m_readCache;
 };
\ No newline at end of file
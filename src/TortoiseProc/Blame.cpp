@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2014, 2016 - TortoiseSVN
+// Copyright (C) 2003-2014, 2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -24,6 +24,9 @@
 #include "registry.h"
 #include "UnicodeUtils.h"
 #include "TempFile.h"
+#include "BlameCache.h"
+#include "SVNInfo.h"
+#include "SVNHelpers.h"
 
 CBlame::CBlame()
     : SVN()
@@ -38,6 +41,7 @@ CBlame::CBlame()
     , m_bSetProgress(true)
     , m_bHasMerges(false)
     , m_bIncludeMerge(false)
+    , m_bCollectLines(false)
 {
 }
 CBlame::~CBlame()
@@ -122,56 +126,40 @@ BOOL CBlame::BlameCallback(LONG linenumber, bool /*localchange*/, svn_revnum_t r
         else
             return FALSE;
     }
-    else
+    else if (m_bCollectLines)
     {
-        if (m_saveFile.m_hFile != INVALID_HANDLE_VALUE)
-        {
-            m_saveFile.Write(&linenumber, sizeof(LONG));
-            m_saveFile.Write(&revision, sizeof(svn_revnum_t));
-
-            CStringA tempA = CUnicodeUtils::GetUTF8(author);
-            int length = tempA.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)tempA, length);
-
-            tempA = CUnicodeUtils::GetUTF8(date);
-            length = tempA.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)tempA, length);
-
-            m_saveFile.Write(&merged_revision, sizeof(svn_revnum_t));
-
-            tempA = CUnicodeUtils::GetUTF8(merged_author);
-            length = tempA.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)tempA, length);
+        SIncrementalLine entry;
+        entry.revision = revision;
+        entry.author = (LPCSTR)CUnicodeUtils::GetUTF8(author);
+        entry.date = (LPCSTR)CUnicodeUtils::GetUTF8(date);
+        entry.mergedRevision = merged_revision;
+        entry.mergedAuthor = (LPCSTR)CUnicodeUtils::GetUTF8(merged_author);
+        entry.mergedDate = (LPCSTR)CUnicodeUtils::GetUTF8(merged_date);
+        entry.mergedPath = (LPCSTR)CUnicodeUtils::GetUTF8(merged_path);
+        entry.line.assign((LPCSTR)line, line.GetLength());
+        m_incrementalLines.push_back(std::move(entry));
 
-            tempA = CUnicodeUtils::GetUTF8(merged_date);
-            length = tempA.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)tempA, length);
-
-            tempA = CUnicodeUtils::GetUTF8(merged_path);
-            length = tempA.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)tempA, length);
-
-            length = line.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)line, length);
-
-            length = log_msg.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)log_msg, length);
-
-            length = merged_log_msg.GetLength();
-            m_saveFile.Write(&length, sizeof(int));
-            m_saveFile.Write((LPCSTR)merged_log_msg, length);
-
-            return TRUE;
-        }
-        else
+        if ((revision > 0) && !log_msg.IsEmpty())
+            m_incrementalLogs.emplace(revision, std::string((LPCSTR)log_msg, log_msg.GetLength()));
+        if ((merged_revision > 0) && !merged_log_msg.IsEmpty())
+            m_incrementalLogs.emplace(merged_revision, std::string((LPCSTR)merged_log_msg, merged_log_msg.GetLength()));
+        return TRUE;
+    }
+    else
+    {
+        if (!m_blameFile.IsOpen())
             return FALSE;
+
+        return m_blameFile.AddLine(revision,
+                                   (LPCSTR)CUnicodeUtils::GetUTF8(author),
+                                   (LPCSTR)CUnicodeUtils::GetUTF8(date),
+                                   merged_revision,
+                                   (LPCSTR)CUnicodeUtils::GetUTF8(merged_author),
+                                   (LPCSTR)CUnicodeUtils::GetUTF8(merged_date),
+                                   (LPCSTR)CUnicodeUtils::GetUTF8(merged_path),
+                                   std::string_view((LPCSTR)line, line.GetLength()),
+                                   std::string_view((LPCSTR)log_msg, log_msg.GetLength()),
+                                   std::string_view((LPCSTR)merged_log_msg, merged_log_msg.GetLength()));
     }
 }
 
@@ -198,7 +186,12 @@ CString CBlame::BlameToTempFile(const CTSVNPath& path, const SVNRev& startrev, c
     temp = path.GetFileExtension();
     if (!temp.IsEmpty() && !extBlame)
         m_sSavePath += temp;
-    if (!m_saveFile.Open(m_sSavePath, (extBlame ? CFile::typeText : CFile::typeBinary) | CFile::modeReadWrite | CFile::modeCreate))
+    if (extBlame)
+    {
+        if (!m_saveFile.Open(m_sSavePath, CFile::typeText | CFile::modeReadWrite | CFile::modeCreate))
+            return L"";
+    }
+    else if (!m_blameFile.Open((LPCWSTR)m_sSavePath))
         return L"";
     CString headline;
     m_bNoLineNo = false;
@@ -228,17 +221,34 @@ CString CBlame::BlameToTempFile(const CTSVNPath& path, const SVNRev& startrev, c
     m_progressDlg.SetProgress(0, m_nHeadRev);
 
     m_bHasMerges = false;
-    BOOL bBlameSuccesful = this->Blame(path, startrev, endrev, pegrev, options, !!ignoremimetype, !!includemerge);
-    if (!bBlameSuccesful && !pegrev.IsValid())
+    BOOL bBlameSuccesful = FALSE;
+    bool bStoreInCache = false;
+    svn_revnum_t cacheRevision = -1;
+    std::unique_ptr<CBlameCache> cache;
+    if (!extBlame)
+        cache = GetBlameCache(path, startrev, endrev, pegrev, options, includemerge, cacheRevision);
+    if (cache)
+        bBlameSuccesful = BlameFromCache(*cache, cacheRevision, path, endrev, pegrev, options, ignoremimetype, includemerge, bStoreInCache);
+    if (!bBlameSuccesful)
     {
-        // retry with the end rev as peg rev
-        if (this->Blame(path, startrev, endrev, endrev, options, !!ignoremimetype, !!includemerge))
+        bBlameSuccesful = this->Blame(path, startrev, endrev, pegrev, options, !!ignoremimetype, !!includemerge);
+        if (!bBlameSuccesful && !pegrev.IsValid())
         {
-            bBlameSuccesful = TRUE;
-            pegrev = endrev;
+            // retry with the end rev as peg rev
+            if (this->Blame(path, startrev, endrev, endrev, options, !!ignoremimetype, !!includemerge))
+            {
+                bBlameSuccesful = TRUE;
+                pegrev = endrev;
+            }
         }
+        bStoreInCache = cache != nullptr;
     }
-    m_saveFile.Close();
+    if (extBlame)
+        m_saveFile.Close();
+    else
+        m_blameFile.Close(!!bBlameSuccesful);
+    if (bBlameSuccesful && bStoreInCache)
+        cache->Store(cacheRevision, m_sSavePath);
     if (!bBlameSuccesful)
     {
         DeleteFile(m_sSavePath);
@@ -251,6 +261,236 @@ CString CBlame::BlameToTempFile(const CTSVNPath& path, const SVNRev& startrev, c
 
     return m_sSavePath;
 }
+std::unique_ptr<CBlameCache> CBlame::GetBlameCache(const CTSVNPath& path, const SVNRev& startrev, const SVNRev& endrev, const SVNRev& pegrev,
+                                                  const CString& options, BOOL includemerge, svn_revnum_t& revision)
+{
+    // only blames of the whole history up to some committed revision get cached
+    if (!CBlameCache::IsEnabled() || !startrev.IsNumber() || ((LONG)startrev > 1) || endrev.IsWorking())
+        return nullptr;
+
+    // the same url@peg and end revision always resolve to the same entry,
+    // so only ask the repository the first time
+    CString request = GetBlameCacheRequest(path, endrev, pegrev);
+    CString uuid;
+    CString url;
+    if (!request.IsEmpty() && CBlameCache::FindRequest(request, uuid, url, revision))
+        return std::make_unique<CBlameCache>(uuid, url, options, !!includemerge);
+
+    // blaming any revision is the same as blaming the one the file was last changed in
+    SVNInfo info;
+    const SVNInfoData * infoData = info.GetFirstFileInfo(path, pegrev, endrev);
+    if ((infoData == nullptr) || (infoData->kind != svn_node_file) || infoData->reposUUID.IsEmpty())
+        return nullptr;
+
+    revision = infoData->lastchangedrev;
+    if (revision <= 0)
+        return nullptr;
+
+    if (!request.IsEmpty())
+        CBlameCache::StoreRequest(request, infoData->reposUUID, infoData->url, revision);
+
+    return std::make_unique<CBlameCache>(infoData->reposUUID, infoData->url, options, !!includemerge);
+}
+
+CString CBlame::GetBlameCacheRequest(const CTSVNPath& path, const SVNRev& endrev, const SVNRev& pegrev)
+{
+    // m_nHeadRev is the end revision as a number
+    if (!endrev.IsNumber() && !endrev.IsHead())
+        return CString();
+
+    CString url;
+    svn_revnum_t peg = -1;
+    if (pegrev.IsNumber())
+    {
+        url = path.IsUrl() ? path.GetSVNPathString() : GetURLFromPath(path);
+        peg = (LONG)pegrev;
+    }
+    else if (path.IsUrl())
+    {
+        // HEAD as peg is only fixed if it is the end revision, too
+        if ((pegrev.IsValid() && !pegrev.IsHead()) || !endrev.IsHead())
+            return CString();
+        url = path.GetSVNPathString();
+        peg = m_nHeadRev;
+    }
+    else if (!pegrev.IsValid() || pegrev.IsWorking() || pegrev.IsBase())
+    {
+        // the working copy item's base node, as long as it is unmodified in structure
+        SVNInfo info;
+        const SVNInfoData * infoData = info.GetFirstFileInfo(path, SVNRev(), SVNRev());
+        if ((infoData == nullptr) || (infoData->schedule != svn_wc_schedule_normal) || !infoData->copyfromurl.IsEmpty())
+            return CString();
+        url = infoData->url;
+        peg = (LONG)infoData->rev;
+    }
+
+    if (url.IsEmpty() || (peg <= 0) || (m_nHeadRev <= 0))
+        return CString();
+
+    CString request;
+    request.Format(L"%s@%ld:%ld", (LPCWSTR)url, peg, m_nHeadRev);
+    return request;
+}
+
+bool CBlame::BlameFromCache(const CBlameCache& cache, svn_revnum_t revision, const CTSVNPath& path, const SVNRev& endrev, const SVNRev& pegrev,
+                            const CString& options, BOOL ignoremimetype, BOOL includemerge, bool& bStore)
+{
+    bStore = false;
+    CString entry = cache.Find(revision);
+    if (!entry.IsEmpty())
+    {
+        m_blameFile.Close(false);
+        if (CopyFile(entry, m_sSavePath, FALSE))
+            return true;
+
+        m_blameFile.Open((LPCWSTR)m_sSavePath);
+        return false;
+    }
+
+    // blame only the revisions after the latest cached one
+    // and take the remaining lines from the cache
+
+    CString baseFile;
+    svn_revnum_t baseRevision = cache.FindBase(revision, baseFile);
+    if (baseRevision < 0)
+        return false;
+
+    m_incrementalLines.clear();
+    m_incrementalLogs.clear();
+    m_bCollectLines = true;
+    bool bSuccess = this->Blame(path, SVNRev(baseRevision), endrev, pegrev, options, !!ignoremimetype, !!includemerge)
+                 && MergeIncrementalBlame(baseFile, baseRevision, options);
+    m_bCollectLines = false;
+    m_incrementalLines.clear();
+    m_incrementalLogs.clear();
+
+    // the merge may have failed after writing some lines:
+    // start over with an empty file for the full blame
+    if (!bSuccess && m_blameFile.IsOpen())
+    {
+        m_blameFile.Close(false);
+        m_blameFile.Open((LPCWSTR)m_sSavePath);
+    }
+
+    bStore = bSuccess;
+    return bSuccess;
+}
+
+static svn_error_t * MapCommonLines(void * baton,
+                                    apr_off_t original_start, apr_off_t original_length,
+                                    apr_off_t modified_start, apr_off_t modified_length,
+                                    apr_off_t /*latest_start*/, apr_off_t /*latest_length*/)
+{
+    auto mapping = static_cast<std::vector<LONG>*>(baton);
+    for (apr_off_t i = 0; i < min(original_length, modified_length); ++i)
+        (*mapping)[(size_t)(modified_start + i)] = (LONG)(original_start + i);
+    return nullptr;
+}
+
+bool CBlame::MergeIncrementalBlame(const CString& baseFile, svn_revnum_t baseRevision, const CString& options)
+{
+    CBlameFileReader reader;
+    if (!reader.Open((LPCWSTR)baseFile))
+        return false;
+
+    std::vector<CBlameFile::SBlameLine> baseLines;
+    std::string baseText;
+    std::map<svn_revnum_t, DWORD> baseLogs;
+    const CBlameFile::SBlameLine* lines = nullptr;
+    size_t count = 0;
+    const char* text = nullptr;
+    size_t textSize = 0;
+    while (reader.NextLines(lines, count, text, textSize))
+    {
+        baseLines.insert(baseLines.end(), lines, lines + count);
+        baseText.append(text, textSize);
+    }
+    if (!reader.IsComplete())
+        return false;
+    for (const auto& logMessage : reader.TakeLogMessages())
+        baseLogs[logMessage.first] = logMessage.second;
+
+    // Lines not changed after the base revision are reported as either
+    // unknown or as from the base revision. They must be a subsequence
+    // of the base file's lines, so a diff maps them onto those.
+
+    std::vector<size_t> unchangedLines;
+    std::string unchangedText;
+    for (size_t i = 0; i < m_incrementalLines.size(); ++i)
+    {
+        const SIncrementalLine& line = m_incrementalLines[i];
+        if (!SVN_IS_VALID_REVNUM(line.revision) || (line.revision <= baseRevision))
+        {
+            unchangedLines.push_back(i);
+            unchangedText += CBlameFile::ToEditorText(line.line);
+            unchangedText += '\n';
+        }
+    }
+
+    SVNPool localpool(m_pool);
+    svn_diff_file_options_t * diffOptions = svn_diff_file_options_create(localpool);
+    apr_array_header_t * opts = svn_cstring_split(CUnicodeUtils::GetUTF8(options), " \t\n\r", TRUE, localpool);
+    svn_error_clear(svn_diff_file_options_parse(diffOptions, opts, localpool));
+
+    svn_string_t original = { baseText.c_str(), baseText.size() };
+    svn_string_t modified = { unchangedText.c_str(), unchangedText.size() };
+    svn_diff_output_fns_t outputFunctions = { MapCommonLines, nullptr, nullptr, nullptr, nullptr };
+
+    std::vector<LONG> mapping(unchangedLines.size(), -1);
+    svn_diff_t * diff = nullptr;
+    svn_error_t * error = svn_diff_mem_string_diff(&diff, &original, &modified, diffOptions, localpool);
+    if (error == nullptr)
+        error = svn_diff_output2(diff, &mapping, &outputFunctions, nullptr, nullptr);
+    if (error != nullptr)
+    {
+        svn_error_clear(error);
+        return false;
+    }
+
+    // the file's history differs from the cached one, e.g. after a replace
+    for (LONG baseLine : mapping)
+        if ((baseLine < 0) || ((size_t)baseLine >= baseLines.size()))
+            return false;
+
+    const auto& strings = reader.GetStrings();
+    auto getBaseLog = [&](svn_revnum_t rev) -> std::string_view
+    {
+        auto iter = baseLogs.find(rev);
+        return iter == baseLogs.end() ? std::string_view() : std::string_view(strings[iter->second]);
+    };
+    auto getNewLog = [this](svn_revnum_t rev) -> std::string_view
+    {
+        auto iter = m_incrementalLogs.find(rev);
+        return iter == m_incrementalLogs.end() ? std::string_view() : std::string_view(iter->second);
+    };
+
+    size_t nextUnchanged = 0;
+    for (size_t i = 0; i < m_incrementalLines.size(); ++i)
+    {
+        const SIncrementalLine& line = m_incrementalLines[i];
+        bool bWritten = false;
+        if ((nextUnchanged < unchangedLines.size()) && (unchangedLines[nextUnchanged] == i))
+        {
+            const CBlameFile::SBlameLine& base = baseLines[mapping[nextUnchanged++]];
+            bWritten = m_blameFile.AddLine(base.revision, strings[base.author], strings[base.date],
+                                           base.mergedRevision, strings[base.mergedAuthor], strings[base.mergedDate],
+                                           strings[base.mergedPath], line.line,
+                                           getBaseLog(base.revision), getBaseLog(base.mergedRevision));
+        }
+        else
+        {
+            bWritten = m_blameFile.AddLine(line.revision, line.author, line.date,
+                                           line.mergedRevision, line.mergedAuthor, line.mergedDate,
+                                           line.mergedPath, line.line,
+                                           getNewLog(line.revision), getNewLog(line.mergedRevision));
+        }
+        if (!bWritten)
+            return false;
+    }
+
+    return true;
+}
+
 BOOL CBlame::Notify(const CTSVNPath& /*path*/, const CTSVNPath& /*url*/, svn_wc_notify_action_t /*action*/,
                     svn_node_kind_t /*kind*/, const CString& /*mime_type*/,
                     svn_wc_notify_state_t /*content_state*/,
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2008, 2010-2013, 2016 - TortoiseSVN
+// Copyright (C) 2003-2008, 2010-2013, 2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -22,8 +22,10 @@
 #include "ProgressDlg.h"
 #include "SVNRev.h"
 #include "StdioFileT.h"
+#include "BlameFile.h"
 
 class CTSVNPath;
+class CBlameCache;
 
 /**
  * \ingroup TortoiseProc
@@ -55,6 +57,13 @@ public:
     void        SetAndClearProgressInfo(CProgressDlg * pProgressDlg, int infoline, bool bShowProgressBar = false) { SVN::SetAndClearProgressInfo(pProgressDlg, bShowProgressBar); m_bShowProgressBar = bShowProgressBar; m_nFormatLine = infoline; }
 
 private:
+    std::unique_ptr<CBlameCache> GetBlameCache(const CTSVNPath& path, const SVNRev& startrev, const SVNRev& endrev, const SVNRev& pegrev,
+                                               const CString& options, BOOL includemerge, svn_revnum_t& revision);
+    CString     GetBlameCacheRequest(const CTSVNPath& path, const SVNRev& endrev, const SVNRev& pegrev);
+    bool        BlameFromCache(const CBlameCache& cache, svn_revnum_t revision, const CTSVNPath& path, const SVNRev& endrev, const SVNRev& pegrev,
+                               const CString& options, BOOL ignoremimetype, BOOL includemerge, bool& bStore);
+    bool        MergeIncrementalBlame(const CString& baseFile, svn_revnum_t baseRevision, const CString& options);
+
     BOOL        BlameCallback(LONG linenumber, bool localchange, svn_revnum_t revision, const CString& author, const CString& date,
                                 svn_revnum_t merged_revision, const CString& merged_author, const CString& merged_date, const CString& merged_path,
                                 const CStringA& line, const CStringA& log_msg, const CStringA& merged_log_msg) override;
@@ -80,9 +89,27 @@ private:
     int         m_bSetProgress;         ///< whether to set the progress bar state
 
     CString     m_sSavePath;            ///< Where to save the blame data
-    CStdioFileT m_saveFile;             ///< The file object to write to
+    CStdioFileT m_saveFile;             ///< The file object to write the text blame to
+    CBlameFileWriter m_blameFile;       ///< The file object to write the TortoiseBlame data to
     CProgressDlg m_progressDlg;         ///< The progress dialog shown during operation
     LONG        m_lowestrev;
     LONG        m_highestrev;
     BOOL        extBlame;
+
+    /// a line reported by an incremental blame
+    struct SIncrementalLine
+    {
+        svn_revnum_t    revision;
+        std::string     author;
+        std::string     date;
+        svn_revnum_t    mergedRevision;
+        std::string     mergedAuthor;
+        std::string     mergedDate;
+        std::string     mergedPath;
+        std::string     line;
+    };
+
+    bool        m_bCollectLines;        ///< if true, lines are collected in m_incrementalLines instead of being written
+    std::vector<SIncrementalLine>       m_incrementalLines;
+    std::map<svn_revnum_t, std::string> m_incrementalLogs;
 };
@@ -0,0 +1,190 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "BlameCache.h"
+#include "SVN.h"
+#include "SVNHelpers.h"
+#include "PathUtils.h"
+#include "SmartHandle.h"
+#include "StringUtils.h"
+#include "registry.h"
+
+namespace
+{
+    // limits for the number of cached blame files
+    const size_t MAX_REVISIONS_PER_FILE = 4;
+    const size_t MAX_ENTRIES = 200;
+    const size_t MAX_REQUESTS = 1000;
+
+    const wchar_t ENTRY_EXTENSION[] = L".blame";
+    const wchar_t REQUEST_EXTENSION[] = L".request";
+}
+
+CBlameCache::CBlameCache(const CString& uuid, const CString& url, const CString& options, bool includeMerge)
+{
+    m_directory = GetDirectory();
+
+    CString key = uuid + L'\n' + url + L'\n' + options + L'\n' + (includeMerge ? L'1' : L'0');
+    SVNPool pool;
+    m_prefix = SVN::GetChecksumString(svn_checksum_md5, key, pool);
+}
+
+bool CBlameCache::IsEnabled()
+{
+    return !!(DWORD)CRegDWORD(L"Software\\TortoiseSVN\\BlameCache", TRUE);
+}
+
+CString CBlameCache::GetDirectory()
+{
+    return CPathUtils::GetLocalAppDataDirectory() + L"blamecache\\";
+}
+
+CString CBlameCache::GetRequestPath(const CString& request)
+{
+    SVNPool pool;
+    return GetDirectory() + SVN::GetChecksumString(svn_checksum_md5, request, pool) + REQUEST_EXTENSION;
+}
+
+bool CBlameCache::FindRequest(const CString& request, CString& uuid, CString& url, svn_revnum_t& revision)
+{
+    // format: request, uuid, url and revision, one per line
+    CString text;
+    if (!CStringUtils::ReadStringFromTextFile(GetRequestPath(request), text))
+        return false;
+
+    int pos = 0;
+    if (text.Tokenize(L"\n", pos) != request)
+        return false;
+    uuid = text.Tokenize(L"\n", pos);
+    url = text.Tokenize(L"\n", pos);
+    revision = _wtol(text.Tokenize(L"\n", pos));
+
+    return !uuid.IsEmpty() && !url.IsEmpty() && (revision > 0);
+}
+
+void CBlameCache::StoreRequest(const CString& request, const CString& uuid, const CString& url, svn_revnum_t revision)
+{
+    CString directory = GetDirectory();
+    if (!CPathUtils::MakeSureDirectoryPathExists(directory))
+        return;
+
+    CString text;
+    text.Format(L"%s\n%s\n%s\n%ld\n", (LPCWSTR)request, (LPCWSTR)uuid, (LPCWSTR)url, revision);
+    if (CStringUtils::WriteStringToTextFile((LPCWSTR)GetRequestPath(request), (LPCWSTR)text))
+        TrimFiles(directory, REQUEST_EXTENSION, MAX_REQUESTS);
+}
+
+CString CBlameCache::GetEntryPath(svn_revnum_t revision) const
+{
+    CString path;
+    path.Format(L"%s%s_%ld%s", (LPCWSTR)m_directory, (LPCWSTR)m_prefix, revision, ENTRY_EXTENSION);
+    return path;
+}
+
+std::map<svn_revnum_t, CString> CBlameCache::GetEntries() const
+{
+    std::map<svn_revnum_t, CString> result;
+
+    WIN32_FIND_DATA findData;
+    CAutoFindFile hFind = FindFirstFile(m_directory + m_prefix + L"_*" + ENTRY_EXTENSION, &findData);
+    if (!hFind)
+        return result;
+
+    do
+    {
+        const wchar_t* revision = findData.cFileName + m_prefix.GetLength() + 1;
+        result[_wtol(revision)] = m_directory + findData.cFileName;
+    } while (FindNextFile(hFind, &findData));
+
+    return result;
+}
+
+CString CBlameCache::Find(svn_revnum_t revision) const
+{
+    CString path = GetEntryPath(revision);
+    CAutoFile hFile = CreateFile(path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (!hFile)
+        return CString();
+
+    // mark the entry as recently used
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(hFile, nullptr, nullptr, &now);
+
+    return path;
+}
+
+svn_revnum_t CBlameCache::FindBase(svn_revnum_t revision, CString& path) const
+{
+    auto entries = GetEntries();
+    auto iter = entries.lower_bound(revision);
+    if (iter == entries.begin())
+        return -1;
+
+    --iter;
+    path = iter->second;
+    return iter->first;
+}
+
+void CBlameCache::Store(svn_revnum_t revision, const CString& blameFile) const
+{
+    if (!CPathUtils::MakeSureDirectoryPathExists(m_directory))
+        return;
+
+    CString path = GetEntryPath(revision);
+    if (!CopyFile(blameFile, path, FALSE))
+        return;
+
+    // blame files are written as temporary files
+    SetFileAttributes(path, FILE_ATTRIBUTE_NORMAL);
+
+    Trim();
+}
+
+void CBlameCache::Trim() const
+{
+    // remove the oldest revisions of this file
+
+    auto entries = GetEntries();
+    for (auto iter = entries.begin(); entries.size() > MAX_REVISIONS_PER_FILE; iter = entries.erase(iter))
+        DeleteFile(iter->second);
+
+    // remove the least recently used entries of all files
+
+    TrimFiles(m_directory, ENTRY_EXTENSION, MAX_ENTRIES);
+}
+
+void CBlameCache::TrimFiles(const CString& directory, LPCWSTR extension, size_t maxCount)
+{
+    std::multimap<ULONGLONG, CString> filesByTime;
+
+    WIN32_FIND_DATA findData;
+    CAutoFindFile hFind = FindFirstFile(directory + L"*" + extension, &findData);
+    if (!hFind)
+        return;
+
+    do
+    {
+        ULONGLONG time = ((ULONGLONG)findData.ftLastWriteTime.dwHighDateTime << 32) + findData.ftLastWriteTime.dwLowDateTime;
+        filesByTime.emplace(time, directory + findData.cFileName);
+    } while (FindNextFile(hFind, &findData));
+
+    for (auto iter = filesByTime.begin(); filesByTime.size() > maxCount; iter = filesByTime.erase(iter))
+        DeleteFile(iter->second);
+}
@@ -0,0 +1,79 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+/**
+ * \ingroup TortoiseProc
+ * Persistent cache of completed blame files (see CBlameFile).
+ *
+ * Entries are stored in the local app data folder, one file per blamed
+ * revision of a file. The entries of a file share a name prefix which is
+ * a hash of the repository UUID, the URL, the diff options and whether
+ * merge info has been included.
+ *
+ * Blaming any revision of a file gives the same result as blaming the
+ * revision in which it was last changed. Hence, callers should always
+ * use the last changed revision as the key.
+ *
+ * Only the latest few revisions are kept per file and only a limited
+ * number of entries overall. Least recently used entries get removed
+ * first.
+ *
+ * Finding that key requires a round trip to the repository. Requests
+ * which always resolve to the same key (i.e. url@peg up to a fixed end
+ * revision) are remembered separately, so that repeating them doesn't
+ * need the repository.
+ */
+class CBlameCache
+{
+public:
+    CBlameCache(const CString& uuid, const CString& url, const CString& options, bool includeMerge);
+
+    /// true, if caching blame results has not been disabled by the user
+    static bool IsEnabled();
+
+    /// returns the path of the entry for \a revision, or an empty string
+    CString Find(svn_revnum_t revision) const;
+
+    /**
+     * Returns the latest cached revision before \a revision and sets
+     * \a path to the entry's file. Returns -1 if there is none.
+     */
+    svn_revnum_t FindBase(svn_revnum_t revision, CString& path) const;
+
+    /// adds a copy of the complete blame file \a blameFile as entry for \a revision
+    void Store(svn_revnum_t revision, const CString& blameFile) const;
+
+    /// looks up the key \a request resolved to last time
+    static bool FindRequest(const CString& request, CString& uuid, CString& url, svn_revnum_t& revision);
+    /// remembers the key an immutable \a request resolved to
+    static void StoreRequest(const CString& request, const CString& uuid, const CString& url, svn_revnum_t revision);
+
+private:
+    static CString GetDirectory();
+    static CString GetRequestPath(const CString& request);
+    static void TrimFiles(const CString& directory, LPCWSTR extension, size_t maxCount);
+
+    CString GetEntryPath(svn_revnum_t revision) const;
+    std::map<svn_revnum_t, CString> GetEntries() const;
+    void Trim() const;
+
+    CString m_directory;
+    CString m_prefix;
+};
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2018 - TortoiseSVN
+// Copyright (C) 2003-2018, 2026 - TortoiseSVN
 // Copyright (C) 2019 - TortoiseGit
 
 // This program is free software; you can redistribute it and/or
@@ -282,10 +282,12 @@ BOOL CCopyDlg::OnInitDialog()
     EnableSaveRestore(L"CopyDlg");
 
     m_bSettingChanged = false;
-    if (!m_path.IsUrl())
+    if (!m_path.IsUrl() || m_CopyRev.IsNumber())
     {
         // start a thread to obtain the highest revision number of the working copy
-        // without blocking the dialog
+        // without blocking the dialog. For URLs, we can only find the externals
+        // of a fixed revision.
+        m_externalsRev = m_path.IsUrl() ? m_CopyRev : SVNRev(SVNRev::REV_WC);
         InterlockedExchange(&m_bThreadRunning, TRUE);
         if ((m_pThread = AfxBeginThread(FindRevThreadEntry, this, THREAD_PRIORITY_NORMAL, 0, CREATE_SUSPENDED)) == nullptr)
         {
@@ -313,7 +315,18 @@ UINT CCopyDlg::FindRevThreadEntry(LPVOID pVoid)
 UINT CCopyDlg::FindRevThread()
 {
     m_bmodified = false;
-    if (!m_bCancelled)
+    if (!m_bCancelled && m_path.IsUrl())
+    {
+        // the repository tree at a fixed revision: there is no
+        // working copy to find the revisions in, just the externals.
+        // Repeated copies of the same revision hit the externals cache.
+        m_maxrev = 0;
+        m_externals.clear();
+        m_externals.AddTree(m_path, m_externalsRev, false);
+        if (!m_bCancelled)
+            SendMessage(WM_TSVN_MAXREVFOUND);
+    }
+    else if (!m_bCancelled)
     {
         // find the external properties
         SVNStatus stats(&m_bCancelled);
@@ -331,18 +344,6 @@ UINT CCopyDlg::FindRevThread()
             {
                 if (s->repos_uuid && sUUID.empty())
                     sUUID = s->repos_uuid;
-                if (s->kind == svn_node_dir)
-                {
-                    // read the props of this dir and find out if it has svn:external props
-                    SVNProperties props(retPath, SVNRev::REV_WC, false, false);
-                    for (int i = 0; i < props.GetCount(); ++i)
-                    {
-                        if (props.GetItemName(i).compare(SVN_PROP_EXTERNALS) == 0)
-                        {
-                            m_externals.Add(retPath, props.GetItemValue(i), true);
-                        }
-                    }
-                }
                 if (s->changed_rev > m_maxrev)
                     m_maxrev = s->changed_rev;
                 if ( (s->node_status != svn_wc_status_none) &&
@@ -355,6 +356,9 @@ UINT CCopyDlg::FindRevThread()
                 s = stats.GetNextFileStatus(retPath);
             }
         }
+        // find the svn:externals properties of all folders at once
+        if (!m_bCancelled)
+            m_externals.AddTree(m_path, SVNRev::REV_WC, true, [this](size_t, size_t) { return !m_bCancelled; });
         // important note:
         // recursive externals can not be tagged, because the external
         // itself is not copied, and therefore there is no defined target
@@ -428,6 +432,10 @@ void CCopyDlg::OnOK()
         return;
     }
 
+    // the externals of an URL only apply to the revision they were read for
+    if (m_path.IsUrl() && !m_CopyRev.IsEqual(m_externalsRev))
+        m_externals.clear();
+
     CString combourl = m_URLCombo.GetWindowString();
     if (combourl.IsEmpty())
         combourl = m_URLCombo.GetString();
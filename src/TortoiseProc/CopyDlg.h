@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2013, 2015 - TortoiseSVN
+// Copyright (C) 2003-2013, 2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -126,6 +126,7 @@ private:
     bool            m_bCancelled;
     volatile LONG   m_bThreadRunning;
     SVNExternals    m_externals;
+    SVNRev          m_externalsRev;
     CLinkControl    m_CheckAll;
     CLinkControl    m_CheckNone;
 };
\ No newline at end of file
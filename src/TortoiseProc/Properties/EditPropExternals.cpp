@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2010-2015 - TortoiseSVN
+// Copyright (C) 2010-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -21,8 +21,6 @@
 #include "EditPropExternals.h"
 #include "EditPropExternalsValue.h"
 #include "SVN.h"
-#include "SVNLogHelper.h"
-#include "SVNInfo.h"
 #include "AppUtils.h"
 #include "ProgressDlg.h"
 #include "IconMenu.h"
@@ -314,44 +312,17 @@ void CEditPropExternals::OnBnClickedFindhead()
     CProgressDlg progDlg;
     progDlg.ShowModal(m_hWnd, TRUE);
     progDlg.SetTitle(IDS_EDITPROPS_PROG_FINDHEADTITLE);
-    progDlg.SetLine(1, CString(MAKEINTRESOURCE(IDS_EDITPROPS_PROG_FINDHEADROOTS)));
-    DWORD count = 0;
-    DWORD total = (DWORD)m_externals.size()*4;
-    SVN svn;
-    svn.SetPromptParentWindow(m_hWnd);
-    SVNInfo svnInfo;
-    svnInfo.SetPromptParentWindow(m_hWnd);
-    for (auto it = m_externals.begin(); it != m_externals.end(); ++it)
-    {
-        progDlg.SetProgress(count++, total);
-        if (progDlg.HasUserCancelled())
-            break;
-        if (it->root.IsEmpty())
-        {
-            CTSVNPath p = it->path;
-            p.AppendPathString(it->targetDir);
-            it->root = svn.GetRepositoryRoot(p);
-        }
-    }
-
     progDlg.SetLine(1, CString(MAKEINTRESOURCE(IDS_EDITPROPS_PROG_FINDHEADREVS)));
-    SVNLogHelper logHelper;
-    for (auto it = m_externals.begin(); it != m_externals.end(); ++it)
+
+    std::vector<size_t> indexes;
+    for (size_t i = 0; i < m_externals.size(); ++i)
+        indexes.push_back(i);
+
+    m_externals.FetchHeadRevisions(indexes, m_hWnd, [&progDlg](size_t done, size_t total)
     {
-        progDlg.SetProgress(count, total);
-        progDlg.SetLine(2, it->url, true);
-        if (progDlg.HasUserCancelled())
-            break;
-        count += 4;
-        if (!it->root.IsEmpty())
-        {
-            auto youngestRev = logHelper.GetYoungestRev(CTSVNPath(it->fullurl));
-            if (!youngestRev.IsValid())
-                it->headrev = svn.GetHEADRevision(CTSVNPath(it->fullurl), true);
-            else
-                it->headrev = youngestRev;
-        }
-    }
+        progDlg.SetProgress((DWORD)done, (DWORD)total);
+        return !progDlg.HasUserCancelled();
+    });
     progDlg.Stop();
     m_ExtList.Invalidate();
 }
@@ -406,42 +377,26 @@ void CEditPropExternals::OnContextMenu(CWnd* /*pWnd*/, CPoint point)
         {
         case CMD_FETCH_AND_ADJUST:
             {
-                SVN svn;
-                svn.SetPromptParentWindow(m_hWnd);
-                SVNInfo svnInfo;
-                svnInfo.SetPromptParentWindow(m_hWnd);
-                SVNLogHelper logHelper;
                 CProgressDlg progDlg;
                 progDlg.ShowModal(m_hWnd, TRUE);
                 progDlg.SetTitle(IDS_EDITPROPS_PROG_FINDHEADTITLE);
                 progDlg.SetLine(1, CString(MAKEINTRESOURCE(IDS_EDITPROPS_PROG_FINDHEADREVS)));
-                DWORD count = 0;
-                DWORD total = m_ExtList.GetSelectedCount();
+                std::vector<size_t> indexes;
                 POSITION p = m_ExtList.GetFirstSelectedItemPosition();
                 while (p)
                 {
                     int index = m_ExtList.GetNextSelectedItem(p);
-                    progDlg.SetProgress(count++, total);
                     if ((index >= 0)&&(index < (int)m_externals.size()))
                     {
-                        progDlg.SetLine(2, m_externals[index].url, true);
                         if (m_externals[index].headrev == SVN_INVALID_REVNUM)
-                        {
-                            if (m_externals[index].root.IsEmpty())
-                            {
-                                CTSVNPath path_ = m_externals[index].path;
-                                path_.AppendPathString(m_externals[index].targetDir);
-                                m_externals[index].root = svn.GetRepositoryRoot(path_);
-                            }
-                            auto fullurl = CTSVNPath(m_externals[index].fullurl);
-                            auto youngestRev = logHelper.GetYoungestRev(fullurl);
-                            if (!youngestRev.IsValid())
-                                m_externals[index].headrev = svn.GetHEADRevision(fullurl, true);
-                            else
-                                m_externals[index].headrev = youngestRev;
-                        }
+                            indexes.push_back(index);
                     }
                 }
+                m_externals.FetchHeadRevisions(indexes, m_hWnd, [&progDlg](size_t done, size_t total)
+                {
+                    progDlg.SetProgress((DWORD)done, (DWORD)total);
+                    return !progDlg.HasUserCancelled();
+                });
                 progDlg.Stop();
             }
             // intentional fall through
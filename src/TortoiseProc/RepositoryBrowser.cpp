@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2018 - TortoiseSVN
+// Copyright (C) 2003-2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -1423,26 +1423,26 @@ void CRepositoryBrowser::FetchChildren (HTREEITEM node)
         }
     }
 
-    int childfoldercount = 0;
     for (size_t i = 0, count = pTreeItem->children.size(); i < count; ++i)
     {
         const CItem& item = pTreeItem->children[i];
         if ((item.kind == svn_node_dir) && (!item.absolutepath.IsEmpty()))
         {
             pTreeItem->has_child_folders = true;
-            ++childfoldercount;
-            if (m_bFetchChildren)
-            {
-                m_lister.Enqueue(item.absolutepath
-                                 , item.is_external ? item.repository.peg_revision : SVNRev()
-                                 , item.repository
-                                 , !m_bSparseCheckoutMode && m_bShowExternals ? SVN_DIRENT_ALL : direntAllExceptHasProps
-                                 , item.has_props && !m_bSparseCheckoutMode && m_bShowExternals);
-                if (childfoldercount > 30)
-                    break;
-            }
+            break;
         }
     }
+
+    // speculatively list the sub-tree in the background,
+    // starting with the child folders
+
+    if (m_bFetchChildren && pTreeItem->has_child_folders)
+    {
+        m_lister.Prefetch(pTreeItem->children
+                          , !m_bSparseCheckoutMode && m_bShowExternals ? SVN_DIRENT_ALL : direntAllExceptHasProps
+                          , !m_bSparseCheckoutMode && m_bShowExternals);
+    }
+
     if ((pTreeItem->has_child_folders) || (m_bSparseCheckoutMode))
         AutoInsert(node, pTreeItem->children);
     // if there are no child folders, remove the '+' in front of the node
@@ -0,0 +1,362 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "RepositoryListCache.h"
+#include "RepositoryLister.h"
+#include "registry.h"
+#include "PathUtils.h"
+#include "SmartHandle.h"
+#include "UnicodeUtils.h"
+#include "SVNHelpers.h"
+#include "Containers/StringDictonary.h"
+#include "Streams/RootInStream.h"
+#include "Streams/RootOutStream.h"
+#include "Streams/CompositeInStream.h"
+#include "Streams/CompositeOutStream.h"
+#include "Streams/BLOBInStream.h"
+#include "Streams/BLOBOutStream.h"
+#include "Streams/PackedDWORDInStream.h"
+#include "Streams/PackedDWORDOutStream.h"
+#include "Streams/DiffIntegerInStream.h"
+#include "Streams/DiffIntegerOutStream.h"
+#include "Streams/PackedTime64InStream.h"
+#include "Streams/PackedTime64OutStream.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+namespace
+{
+    // limit for the number of cached listings
+    const size_t MAX_ENTRIES = 1000;
+
+    const wchar_t ENTRY_EXTENSION[] = L".list";
+
+    // path of the folder's entries within the repository
+
+    CString GetEntryPrefix (const CString& absolutePath)
+    {
+        return absolutePath.IsEmpty() || (absolutePath.Right (1) != L"/")
+            ? absolutePath + L"/"
+            : absolutePath;
+    }
+}
+
+// construction / destruction
+
+CRepositoryListCache::CRepositoryListCache
+    ( const CTSVNPath& url
+    , const SVNRev& revision
+    , const SVNRev& pegRevision
+    , apr_uint32_t dirent
+    , const SRepositoryInfo& repository)
+    : repository (repository)
+    , isHead (revision.IsHead() && pegRevision.IsHead())
+{
+    // other revision kinds may refer to different revisions over time
+
+    bool isFixed = revision.IsNumber() && pegRevision.IsNumber();
+    if (repository.uuid.IsEmpty() || !(isHead || isFixed))
+        return;
+
+    CString parameters;
+    parameters.Format ( L"%s\n%s\n%s\n%s\n%lu\n"
+                      , (LPCTSTR)repository.uuid
+                      , (LPCTSTR)url.GetSVNPathString()
+                      , (LPCTSTR)revision.ToString()
+                      , (LPCTSTR)pegRevision.ToString()
+                      , (unsigned long)dirent);
+
+    SVNPool pool;
+    directory = (LPCTSTR)(CPathUtils::GetLocalAppDataDirectory() + L"listcache\\");
+    fileName = directory
+             + (LPCTSTR)SVN::GetChecksumString (svn_checksum_md5, parameters, pool)
+             + ENTRY_EXTENSION;
+
+    key = CUnicodeUtils::StdGetUTF8 ((LPCTSTR)parameters);
+}
+
+CRepositoryListCache::~CRepositoryListCache(void)
+{
+}
+
+bool CRepositoryListCache::IsEnabled()
+{
+    return !!(DWORD)CRegDWORD (L"Software\\TortoiseSVN\\RepoBrowserListCache", TRUE);
+}
+
+bool CRepositoryListCache::IsCacheable() const
+{
+    return !fileName.empty();
+}
+
+bool CRepositoryListCache::NeedsValidation() const
+{
+    return isHead;
+}
+
+// cache access
+
+bool CRepositoryListCache::Load
+    ( std::deque<CItem>& items
+    , svn_revnum_t& createdRev) const
+{
+    if (fileName.empty())
+        return false;
+
+    // mark the entry as recently used
+
+    {
+        CAutoFile hFile = CreateFile ( fileName.c_str()
+                                     , FILE_WRITE_ATTRIBUTES
+                                     , FILE_SHARE_READ | FILE_SHARE_DELETE
+                                     , nullptr
+                                     , OPEN_EXISTING
+                                     , 0
+                                     , nullptr);
+        if (!hFile)
+            return false;
+
+        FILETIME now;
+        GetSystemTimeAsFileTime (&now);
+        SetFileTime (hFile, nullptr, nullptr, &now);
+    }
+
+    CStringDictionary strings;
+    std::vector<int> folder;
+    std::vector<DWORD> names;
+    std::vector<DWORD> kinds;
+    std::vector<DWORD> props;
+    std::vector<__time64_t> sizes;
+    std::vector<int> revisions;
+    std::vector<__time64_t> times;
+    std::vector<DWORD> authors;
+
+    try
+    {
+        CRootInStream stream (fileName);
+
+        // is this the entry for our listing?
+
+        CBLOBInStream* keyStream
+            = stream.GetSubStream<CBLOBInStream> (KEY_STREAM_ID);
+        if (   (keyStream->GetSize() != key.size())
+            || (memcmp (keyStream->GetData(), key.c_str(), key.size()) != 0))
+            return false;
+
+        IHierarchicalInStream* stringsStream
+            = stream.GetSubStream (STRINGS_STREAM_ID);
+        *stringsStream >> strings;
+
+        *stream.GetSubStream<CDiffIntegerInStream> (FOLDER_STREAM_ID)
+            >> folder;
+        *stream.GetSubStream<CPackedDWORDInStream> (NAMES_STREAM_ID)
+            >> names;
+        *stream.GetSubStream<CPackedDWORDInStream> (KINDS_STREAM_ID)
+            >> kinds;
+        *stream.GetSubStream<CPackedDWORDInStream> (PROPS_STREAM_ID)
+            >> props;
+        *stream.GetSubStream<CPackedTime64InStream> (SIZES_STREAM_ID)
+            >> sizes;
+        *stream.GetSubStream<CDiffIntegerInStream> (REVISIONS_STREAM_ID)
+            >> revisions;
+        *stream.GetSubStream<CPackedTime64InStream> (TIMES_STREAM_ID)
+            >> times;
+        *stream.GetSubStream<CPackedDWORDInStream> (AUTHORS_STREAM_ID)
+            >> authors;
+    }
+    catch (...)
+    {
+        // the file is probably corrupt -> just list the folder again
+
+        return false;
+    }
+
+    // validate the data before using it
+
+    size_t count = names.size();
+    if (   (folder.size() != 2)
+        || (folder[0] < 0)
+        || (static_cast<index_t>(folder[0]) >= strings.size())
+        || (kinds.size() != count)
+        || (props.size() != count)
+        || (sizes.size() != count)
+        || (revisions.size() != count)
+        || (times.size() != count)
+        || (authors.size() != count))
+        return false;
+
+    for (size_t i = 0; i < count; ++i)
+        if (   (names[i] >= strings.size())
+            || (authors[i] >= strings.size()))
+            return false;
+
+    createdRev = folder[1];
+
+    // CItems without lock info, just like SVN::List() would report them
+
+    CString prefix = repository.root
+                   + GetEntryPrefix (CUnicodeUtils::GetUnicode (strings[folder[0]]));
+
+    items.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        CString name = CUnicodeUtils::GetUnicode (strings[names[i]]);
+        items.push_back (CItem ( name
+                               , CString()
+                               , static_cast<svn_node_kind_t>(kinds[i])
+                               , sizes[i]
+                               , props[i] != 0
+                               , revisions[i]
+                               , times[i]
+                               , CUnicodeUtils::GetUnicode (strings[authors[i]])
+                               , CString()
+                               , CString()
+                               , CString()
+                               , false
+                               , 0
+                               , 0
+                               , prefix + name
+                               , repository));
+    }
+
+    return true;
+}
+
+void CRepositoryListCache::Save
+    ( const std::deque<CItem>& items
+    , svn_revnum_t createdRev
+    , const CString& absolutePath) const
+{
+    // HEAD entries cannot be validated without the last changed revision
+
+    if (fileName.empty() || (isHead && !SVN_IS_VALID_REVNUM (createdRev)))
+        return;
+
+    if (!CPathUtils::MakeSureDirectoryPathExists (directory.c_str()))
+        return;
+
+    CStringDictionary strings;
+    std::vector<int> folder;
+    std::vector<DWORD> names;
+    std::vector<DWORD> kinds;
+    std::vector<DWORD> props;
+    std::vector<__time64_t> sizes;
+    std::vector<int> revisions;
+    std::vector<__time64_t> times;
+    std::vector<DWORD> authors;
+
+    folder.push_back (static_cast<int>(strings.AutoInsert (CUnicodeUtils::GetUTF8 (absolutePath))));
+    folder.push_back (createdRev);
+
+    names.reserve (items.size());
+    kinds.reserve (items.size());
+    props.reserve (items.size());
+    sizes.reserve (items.size());
+    revisions.reserve (items.size());
+    times.reserve (items.size());
+    authors.reserve (items.size());
+
+    for ( std::deque<CItem>::const_iterator iter = items.begin(), end = items.end()
+        ; iter != end
+        ; ++iter)
+    {
+        names.push_back (strings.AutoInsert (CUnicodeUtils::GetUTF8 (iter->path)));
+        kinds.push_back (iter->kind);
+        props.push_back (iter->has_props ? 1 : 0);
+        sizes.push_back (iter->size);
+        revisions.push_back (iter->created_rev);
+        times.push_back (iter->time);
+        authors.push_back (strings.AutoInsert (CUnicodeUtils::GetUTF8 (iter->author)));
+    }
+
+    // write to a temp. file first to not disturb concurrent readers
+
+    std::wstring newFileName = fileName + L".new";
+    try
+    {
+        {
+            CRootOutStream stream (newFileName);
+
+            CBLOBOutStream* keyStream
+                = stream.OpenSubStream<CBLOBOutStream> (KEY_STREAM_ID);
+            keyStream->Add ( reinterpret_cast<const unsigned char*>(key.c_str())
+                           , key.size());
+
+            IHierarchicalOutStream* stringsStream
+                = stream.OpenSubStream<CCompositeOutStream> (STRINGS_STREAM_ID);
+            *stringsStream << strings;
+
+            *stream.OpenSubStream<CDiffIntegerOutStream> (FOLDER_STREAM_ID)
+                << folder;
+            *stream.OpenSubStream<CPackedDWORDOutStream> (NAMES_STREAM_ID)
+                << names;
+            *stream.OpenSubStream<CPackedDWORDOutStream> (KINDS_STREAM_ID)
+                << kinds;
+            *stream.OpenSubStream<CPackedDWORDOutStream> (PROPS_STREAM_ID)
+                << props;
+            *stream.OpenSubStream<CPackedTime64OutStream> (SIZES_STREAM_ID)
+                << sizes;
+            *stream.OpenSubStream<CDiffIntegerOutStream> (REVISIONS_STREAM_ID)
+                << revisions;
+            *stream.OpenSubStream<CPackedTime64OutStream> (TIMES_STREAM_ID)
+                << times;
+            *stream.OpenSubStream<CPackedDWORDOutStream> (AUTHORS_STREAM_ID)
+                << authors;
+        }
+
+        if (!MoveFileEx (newFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+            DeleteFile (newFileName.c_str());
+    }
+    catch (...)
+    {
+        // caching is optional
+
+        DeleteFile (newFileName.c_str());
+    }
+
+    Trim();
+}
+
+void CRepositoryListCache::Trim() const
+{
+    std::multimap<ULONGLONG, std::wstring> entriesByTime;
+
+    WIN32_FIND_DATA findData;
+    CAutoFindFile hFind = FindFirstFile ((directory + L"*" + ENTRY_EXTENSION).c_str(), &findData);
+    if (!hFind)
+        return;
+
+    do
+    {
+        ULONGLONG time = ((ULONGLONG)findData.ftLastWriteTime.dwHighDateTime << 32)
+                       + findData.ftLastWriteTime.dwLowDateTime;
+        entriesByTime.emplace (time, directory + findData.cFileName);
+    } while (FindNextFile (hFind, &findData));
+
+    for ( auto iter = entriesByTime.begin()
+        ; entriesByTime.size() > MAX_ENTRIES
+        ; iter = entriesByTime.erase (iter))
+    {
+        DeleteFile (iter->second.c_str());
+    }
+}
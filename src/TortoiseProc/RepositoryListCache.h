@@ -0,0 +1,120 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+class CTSVNPath;
+class SVNRev;
+class CItem;
+struct SRepositoryInfo;
+
+/**
+ * \ingroup TortoiseProc
+ * Persistent cache of the folder listings fetched by the CRepositoryLister.
+ *
+ * There is one entry per repository UUID, URL, revision, peg revision and
+ * set of requested dirent fields. Only listings of a fixed revision and of
+ * HEAD can be cached. Entries of fixed revisions never become invalid.
+ * Entries of HEAD store the revision in which the folder has been changed
+ * last. Since every change below a folder changes that revision as well,
+ * the entry remains valid as long as the folder's last changed revision
+ * is the same.
+ *
+ * Locks may change without a new revision and are not stored. Neither are
+ * externals, which get fetched by a separate query.
+ *
+ * The data uses the log cache stream format and lives in the local app
+ * data folder. Least recently used entries get removed once there are
+ * too many of them.
+ */
+class CRepositoryListCache
+{
+public:
+
+    /// construction / destruction
+
+    CRepositoryListCache ( const CTSVNPath& url
+                         , const SVNRev& revision
+                         , const SVNRev& pegRevision
+                         , apr_uint32_t dirent
+                         , const SRepositoryInfo& repository);
+    ~CRepositoryListCache(void);
+
+    /// true, if caching folder listings has not been disabled by the user
+
+    static bool IsEnabled();
+
+    /// false, if the listing cannot be cached (e.g. revision given as date)
+
+    bool IsCacheable() const;
+
+    /// true, if the entry must be checked against the folder's current
+    /// last changed revision before it can be used
+
+    bool NeedsValidation() const;
+
+    /// fill \a items with the cached listing. \a createdRev receives the
+    /// folder's last changed revision. Returns false, if there is no valid
+    /// entry.
+
+    bool Load (std::deque<CItem>& items, svn_revnum_t& createdRev) const;
+
+    /// replace the cache entry with \a items, i.e. the content of the
+    /// folder \a absolutePath as last changed in \a createdRev
+
+    void Save ( const std::deque<CItem>& items
+              , svn_revnum_t createdRev
+              , const CString& absolutePath) const;
+
+private:
+
+    /// sub-stream IDs
+
+    enum
+    {
+        KEY_STREAM_ID = 1,
+        STRINGS_STREAM_ID = 2,
+        FOLDER_STREAM_ID = 3,
+        NAMES_STREAM_ID = 4,
+        KINDS_STREAM_ID = 5,
+        PROPS_STREAM_ID = 6,
+        SIZES_STREAM_ID = 7,
+        REVISIONS_STREAM_ID = 8,
+        TIMES_STREAM_ID = 9,
+        AUTHORS_STREAM_ID = 10
+    };
+
+    /// remove the least recently used entries
+
+    void Trim() const;
+
+    const SRepositoryInfo& repository;
+
+    /// true, if the listing is for HEAD
+
+    bool isHead;
+
+    /// all listing parameters
+
+    std::string key;
+
+    /// empty, if the listing cannot be cached
+
+    std::wstring directory;
+    std::wstring fileName;
+};
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2009-2015, 2018 - TortoiseSVN
+// Copyright (C) 2009-2015, 2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -18,6 +18,7 @@
 //
 #include "stdafx.h"
 #include "RepositoryLister.h"
+#include "RepositoryListCache.h"
 #include "UnicodeUtils.h"
 #include "PathUtils.h"
 #include "resource.h"
@@ -121,6 +122,11 @@ BOOL CRepositoryLister::CListQuery::ReportList
 
     if (path_.IsEmpty())
     {
+        // needed to cache the result
+
+        folderPath = absolutepath;
+        folderCreatedRev = created_rev;
+
         // terminate with an error if this was actually a file
 
             return kind == svn_node_dir ? TRUE : FALSE;
@@ -160,19 +166,91 @@ BOOL CRepositoryLister::CListQuery::Cancel()
     return HasBeenTerminated();
 }
 
-// actual job code: just call \ref SVN::List
+// fill result from the on-disk cache, if there is a valid entry
+
+bool CRepositoryLister::CListQuery::ListFromCache
+    ( const CRepositoryListCache& cache
+    , bool fetchLocks)
+{
+    std::deque<CItem> items;
+    svn_revnum_t createdRev = SVN_INVALID_REVNUM;
+    if (!cache.Load (items, createdRev))
+        return false;
+
+    // HEAD listings remain valid until the folder gets changed
+
+    if (cache.NeedsValidation())
+    {
+        SVNInfo info (m_prompt.IsSilent());
+        const SVNInfoData* folderInfo
+            = info.GetFirstFileInfo (path, GetPegRevision(), GetRevision());
+
+        if (   (folderInfo == NULL)
+            || (folderInfo->kind != svn_node_dir)
+            || ((LONG)folderInfo->lastchangedrev != createdRev))
+            return false;
+    }
+
+    // locks are not cached but may change at any time
+
+    if (fetchLocks)
+    {
+        std::map<CString, SVNLock> locks;
+        if (!GetLocks (path, &locks, svn_depth_immediates))
+            return false;
+
+        for ( std::deque<CItem>::iterator iter = items.begin(), end = items.end()
+            ; iter != end
+            ; ++iter)
+        {
+            std::map<CString, SVNLock>::const_iterator lock
+                = locks.find (iter->absolutepath.Mid (repository.root.GetLength()));
+            if (lock == locks.end())
+                continue;
+
+            iter->locktoken = lock->second.token;
+            iter->lockowner = lock->second.owner;
+            iter->lockcomment = lock->second.comment;
+            iter->lock_creationdate = lock->second.creation_date * 1000000L;
+            iter->lock_expirationdate = lock->second.expiration_date * 1000000L;
+        }
+    }
+
+    if (HasBeenTerminated())
+        return false;
+
+    result.swap (items);
+    return true;
+}
+
+// actual job code: use the cached listing or call \ref SVN::List
 
 void CRepositoryLister::CListQuery::InternalExecute()
 {
     // TODO: let the svn API fetch the externals
     bool fetchLocks = !!(DWORD)fetchingLocksEnabled;
-    if (!List ( path
-               , GetRevision()
-               , GetPegRevision()
-               , svn_depth_immediates
-               , fetchLocks
-               , dirent
-               , false))
+
+    CRepositoryListCache cache (path, GetRevision(), GetPegRevision(), dirent, repository);
+    bool useCache = CRepositoryListCache::IsEnabled() && cache.IsCacheable();
+
+    bool succeeded = useCache && ListFromCache (cache, fetchLocks);
+    if (!succeeded)
+    {
+        succeeded = List ( path
+                         , GetRevision()
+                         , GetPegRevision()
+                         , svn_depth_immediates
+                         , fetchLocks
+                         , dirent
+                         , false);
+
+        // entries are keyed by the URL we asked for
+
+        if (succeeded && useCache && m_redirectedUrl.IsEmpty())
+            cache.Save (result, folderCreatedRev, folderPath);
+    }
+
+    if (!succeeded)
     {
         // something went wrong or query was cancelled
         // -> store error, clear results and terminate sub-queries
@@ -188,6 +266,11 @@ void CRepositoryLister::CListQuery::InternalExecute()
     }
     else
     {
+        // continue the prefetch walk with our sub-folders
+
+        if ((prefetcher != NULL) && !HasBeenTerminated())
+            prefetcher->PrefetchSubFolders (prefetchWalk, prefetchLevel + 1, dirent, result);
+
         // add results from the sub-query
         if (!m_redirectedUrl.IsEmpty())
             redirectedUrl = m_redirectedUrl.GetSVNPathString();
@@ -236,17 +319,41 @@ CRepositoryLister::CListQuery::CListQuery
     , apr_uint32_t dirent
     , bool includeExternals
     , bool runSilently
-    , async::CJobScheduler* scheduler)
+    , async::CJobScheduler* scheduler
+    , CRepositoryLister* prefetcher
+    , size_t prefetchWalk
+    , int prefetchLevel)
     : CQuery (path, pegRevision, dirent, repository)
     , SVN (runSilently)
     , externalsQuery
         (includeExternals
             ? new CExternalsQuery (path, pegRevision, repository, runSilently, scheduler)
             : NULL)
+    , folderCreatedRev (SVN_INVALID_REVNUM)
+    , prefetcher (prefetcher)
+    , prefetchWalk (prefetchWalk)
+    , prefetchLevel (prefetchLevel)
 {
     Schedule (false, scheduler);
 }
 
+// a new query for the same folder at the same stage of the prefetch walk
+
+CRepositoryLister::CListQuery* CRepositoryLister::CListQuery::Reschedule
+    (async::CJobScheduler* scheduler) const
+{
+    return new CListQuery ( path
+                          , pegRevision
+                          , repository
+                          , dirent
+                          , externalsQuery != NULL
+                          , true
+                          , scheduler
+                          , prefetcher
+                          , prefetchWalk
+                          , prefetchLevel);
+}
+
 // cancel the svn:externals sub query as well
 
 void CRepositoryLister::CListQuery::Terminate()
@@ -433,6 +540,139 @@ void CRepositoryLister::ClearDumpster()
     CompactDumpster();
 }
 
+// prefetch walk utilities
+
+void CRepositoryLister::PrefetchSubFolders
+    ( size_t walk
+    , int level
+    , apr_uint32_t dirent
+    , const std::deque<CItem>& items)
+{
+    async::CCriticalSectionLock lock (prefetchMutex);
+
+    // has the walk been cancelled or replaced in the meantime?
+
+    if ((walk != prefetchWalk) || (level > PREFETCH_LEVELS))
+        return;
+
+    // the job queue will process all folders of this level
+    // before any of the next level -> breadth-first.
+    // The direct sub-folders get listed along with the user's requests.
+
+    async::CJobScheduler* target = level == 1 ? &scheduler : &prefetchScheduler;
+
+    for ( std::deque<CItem>::const_iterator iter = items.begin(), end = items.end()
+        ; (iter != end) && (prefetchBudget > 0)
+        ; ++iter)
+    {
+        if ((iter->kind != svn_node_dir) || iter->absolutepath.IsEmpty())
+            continue;
+
+        // use the same parameters as the repository browser would
+
+        CTSVNPath escapedURL = EscapeUrl (iter->absolutepath);
+        SVNRev pegRev = iter->is_external
+                      ? iter->repository.peg_revision
+                      : SVNRev();
+
+        SPathAndRev key (escapedURL, pegRev, iter->repository.revision);
+        if (!prefetchVisited.insert (key).second)
+            continue;
+
+        --prefetchBudget;
+        prefetched[key] = new CListQuery ( escapedURL
+                                         , pegRev
+                                         , iter->repository
+                                         , dirent
+                                         , prefetchExternals && iter->has_props
+                                         , true
+                                         , target
+                                         , this
+                                         , walk
+                                         , level);
+    }
+}
+
+void CRepositoryLister::CancelPrefetching()
+{
+    async::CCriticalSectionLock lock (prefetchMutex);
+
+    // running queries will not continue the old walk
+
+    ++prefetchWalk;
+    prefetchVisited.clear();
+    prefetchBudget = 0;
+
+    // the queued ones are not needed anymore
+
+    for ( TQueries::iterator iter = prefetched.begin(), end = prefetched.end()
+        ; iter != end
+        ; ++iter)
+    {
+        if (iter->second->GetStatus() == async::IJob::waiting)
+            iter->second->Terminate();
+    }
+}
+
+void CRepositoryLister::AdoptPrefetched
+    ( CListQuery* query
+    , const SPathAndRev& key
+    , bool reschedule)
+{
+    // make the prefetched result available to \ref GetList().
+    // Never replace queries that we already know of.
+
+    if (query->HasBeenTerminated() || (queries.count (key) > 0))
+    {
+        query->Terminate();
+        dumpster.push_back (query);
+    }
+    else if (reschedule && (query->GetStatus() == async::IJob::waiting))
+    {
+        // don't wait for the low-priority queue to get to it
+
+        query->Terminate();
+        dumpster.push_back (query);
+        queries[key] = query->Reschedule (&scheduler);
+    }
+    else
+    {
+        queries[key] = query;
+    }
+}
+
+void CRepositoryLister::AdoptPrefetched (const SPathAndRev& key)
+{
+    async::CCriticalSectionLock lock (prefetchMutex);
+
+    TQueries::iterator iter = prefetched.find (key);
+    if (iter != prefetched.end())
+    {
+        AdoptPrefetched (iter->second, key, true);
+        prefetched.erase (iter);
+    }
+}
+
+void CRepositoryLister::AdoptPrefetched()
+{
+    async::CCriticalSectionLock lock (prefetchMutex);
+
+    for ( TQueries::iterator iter = prefetched.begin(), end = prefetched.end()
+        ; iter != end
+        ; ++iter)
+    {
+        AdoptPrefetched (iter->second, iter->first);
+    }
+
+    prefetched.clear();
+}
+
+void CRepositoryLister::StopPrefetching()
+{
+    CancelPrefetching();
+    AdoptPrefetched();
+}
+
 // parameter encoding utility
 
 CTSVNPath CRepositoryLister::EscapeUrl (const CString& url)
@@ -446,6 +686,10 @@ CTSVNPath CRepositoryLister::EscapeUrl (const CString& url)
 
 CRepositoryLister::CRepositoryLister()
     : scheduler (8, 0, true, false)
+    , prefetchWalk (0)
+    , prefetchBudget (0)
+    , prefetchExternals (false)
+    , prefetchScheduler (PREFETCH_THREADS, 0, false, true)
 {
 }
 
@@ -472,6 +716,8 @@ void CRepositoryLister::Enqueue
     async::CCriticalSectionLock lock (mutex);
 
     SPathAndRev key (escapedURL, pegRev, repository.revision);
+    AdoptPrefetched (key);
+
     auto iter = queries.find (key);
     if (iter != queries.end())
     {
@@ -541,6 +787,13 @@ void CRepositoryLister::Enqueue
             TQueries::iterator iterdel = queries.find (keydel);
             if ((iterdel != queries.end()) && (iterdel->second == query))
                 queries.erase (iterdel);
+
+            // first-level prefetch queries share our job queue
+
+            async::CCriticalSectionLock prefetchLock (prefetchMutex);
+            iterdel = prefetched.find (keydel);
+            if ((iterdel != prefetched.end()) && (iterdel->second == query))
+                prefetched.erase (iterdel);
         }
 
         // if the dumpster has not been empty before for some reason,
@@ -570,12 +823,46 @@ void CRepositoryLister::Enqueue
                                     , &scheduler);
 }
 
+// speculatively list the sub-tree below \ref items
+
+void CRepositoryLister::Prefetch
+    ( const std::deque<CItem>& items
+    , apr_uint32_t dirent
+    , bool includeExternals)
+{
+    async::CCriticalSectionLock lock (mutex);
+
+    StopPrefetching();
+
+    // start a new walk that skips all folders we already know of
+
+    size_t walk = 0;
+    {
+        async::CCriticalSectionLock prefetchLock (prefetchMutex);
+
+        walk = prefetchWalk;
+        prefetchBudget = PREFETCH_LIMIT;
+        prefetchExternals = includeExternals;
+
+        for ( TQueries::const_iterator iter = queries.begin(), end = queries.end()
+            ; iter != end
+            ; ++iter)
+        {
+            prefetchVisited.insert (iter->first);
+        }
+    }
+
+    PrefetchSubFolders (walk, 1, dirent, items);
+}
+
 // remove all unfinished entries from the job queue
 
 void CRepositoryLister::Cancel()
 {
     async::CCriticalSectionLock lock (mutex);
 
+    StopPrefetching();
+
     // move all unfinished queries to the dumpster
 
     for ( TQueries::iterator iter = queries.begin(); iter != queries.end(); )
@@ -604,12 +891,17 @@ void CRepositoryLister::WaitForJobsToFinish()
     scheduler.WaitForEmptyQueue();
 }
 
-// wait for all jobs to be finished
+// suspend job scheduling and cancel the prefetch walk
 
-std::unique_ptr<async::CSchedulerSuspension> CRepositoryLister::SuspendJobs()
+std::unique_ptr<CRepositoryLister::CJobSuspension> CRepositoryLister::SuspendJobs()
 {
-    return std::unique_ptr<async::CSchedulerSuspension>
-            (new async::CSchedulerSuspension (scheduler));
+    // don't wait for \ref mutex here. The prefetched queries
+    // will be cleaned up the next time we access \ref queries.
+
+    CancelPrefetching();
+
+    return std::unique_ptr<CJobSuspension>
+            (new CJobSuspension (scheduler, prefetchScheduler));
 }
 
 // don't return results from previous or still running requests
@@ -619,6 +911,8 @@ void CRepositoryLister::Refresh()
 {
     async::CCriticalSectionLock lock (mutex);
 
+    StopPrefetching();
+
     // move all revision-specific queries to the dumpster
 
     for ( TQueries::iterator iter = queries.begin()
@@ -643,6 +937,8 @@ void CRepositoryLister::Refresh (const SVNRev& revision)
 {
     async::CCriticalSectionLock lock (mutex);
 
+    StopPrefetching();
+
     // move all HEAD queries for a specific revision the dumpster
 
     for (TQueries::iterator iter = queries.begin(); iter != queries.end(); )
@@ -675,6 +971,8 @@ void CRepositoryLister::RefreshSubTree
 
     async::CCriticalSectionLock lock (mutex);
 
+    StopPrefetching();
+
     // move all HEAD queries for a specific revision the dumpster
 
     for (TQueries::iterator iter = queries.begin(); iter != queries.end(); )
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2009-2015 - TortoiseSVN
+// Copyright (C) 2009-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -27,6 +27,8 @@
 #include "JobScheduler.h"
 #include "SchedulerSuspension.h"
 
+class CRepositoryListCache;
+
 /**
  * \ingroup TortoiseProc
  * structure that contains all information necessary to access a repository.
@@ -269,6 +271,23 @@ private:
 
         std::deque<CItem> subPathExternals;
 
+        /// path within the repository and last changed revision
+        /// of the folder being listed as reported by SVN::List()
+
+        CString folderPath;
+        svn_revnum_t folderCreatedRev;
+
+        /// speculative queries only: the lister that runs the prefetch
+        /// walk, the walk they belong to and their level within it
+
+        CRepositoryLister* prefetcher;
+        size_t prefetchWalk;
+        int prefetchLevel;
+
+        /// fill result from the on-disk cache, if there is a valid entry
+
+        bool ListFromCache (const CRepositoryListCache& cache, bool fetchLocks);
+
         /// callback from the SVN::List() method which stores all the information
 
         virtual BOOL ReportList(const CString& path_, svn_node_kind_t kind,
@@ -303,12 +322,21 @@ private:
                    , apr_uint32_t dirent
                    , bool includeExternals
                    , bool runSilently
-                   , async::CJobScheduler* scheduler);
+                   , async::CJobScheduler* scheduler
+                   , CRepositoryLister* prefetcher = NULL
+                   , size_t prefetchWalk = 0
+                   , int prefetchLevel = 0);
 
         /// cancel the svn:externals sub query as well
 
         virtual void Terminate() override;
 
+        /// a new query with the same parameters and the same position
+        /// within the prefetch walk, scheduled on \ref scheduler.
+        /// Only used for speculative queries, i.e. it runs silently.
+
+        CListQuery* Reschedule (async::CJobScheduler* scheduler) const;
+
         /// access additional results
 
         const std::deque<CItem>& GetSubPathExternals();
@@ -370,11 +398,67 @@ private:
 
     async::CJobScheduler scheduler;
 
+    /// speculative prefetching of sub-trees: limits for a single walk.
+    /// The thread count is our per-server budget for the queries below
+    /// the first level.
+
+    enum
+    {
+        PREFETCH_LEVELS = 3,
+        PREFETCH_LIMIT = MAX_QUEUE_DEPTH,
+        PREFETCH_THREADS = 2
+    };
+
+    /// queries created by the prefetch walk that have not been moved
+    /// to \ref queries, yet. The walk runs in the background and must
+    /// not take \ref mutex, so it has its own.
+
+    TQueries prefetched;
+
+    /// the current prefetch walk, all folders that it already covers
+    /// and the number of queries it may still add
+
+    size_t prefetchWalk;
+    std::set<SPathAndRev> prefetchVisited;
+    size_t prefetchBudget;
+    bool prefetchExternals;
+
+    /// sync. access to all prefetch data.
+    /// Must not be acquired before \ref mutex.
+
+    async::CCriticalSection prefetchMutex;
+
+    /// the job queue to execute the speculative list requests below
+    /// the first level (breadth-first and separate from the \ref scheduler,
+    /// so they never delay requests for data that is actually needed).
+    /// The sub-folders of the current folder are the most likely ones
+    /// to be opened next, so they go to the \ref scheduler instead.
+
+    async::CJobScheduler prefetchScheduler;
+
     /// cleanup utilities
 
     void CompactDumpster();
     void ClearDumpster();
 
+    /// prefetch walk utilities.
+    /// \ref AdoptPrefetched moves prefetched queries to \ref queries
+    /// once they are being asked for or when the walk ends. Queries
+    /// that are being asked for but did not start, yet, are moved
+    /// to the \ref scheduler if \ref reschedule has been set.
+    /// It and \ref StopPrefetching must be called with \ref mutex
+    /// being held.
+
+    void PrefetchSubFolders ( size_t walk
+                            , int level
+                            , apr_uint32_t dirent
+                            , const std::deque<CItem>& items);
+    void CancelPrefetching();
+    void AdoptPrefetched (CListQuery* query, const SPathAndRev& key, bool reschedule = false);
+    void AdoptPrefetched (const SPathAndRev& key);
+    void AdoptPrefetched();
+    void StopPrefetching();
+
     /// parameter encoding utility
 
     static CTSVNPath EscapeUrl (const CString& url);
@@ -396,6 +480,28 @@ private:
 
 public:
 
+    /**
+     * \ingroup TortoiseProc
+     * RAII object that suspends all job scheduling for its lifetime.
+     */
+
+    class CJobSuspension
+    {
+    private:
+
+        async::CSchedulerSuspension listSuspension;
+        async::CSchedulerSuspension prefetchSuspension;
+
+    public:
+
+        CJobSuspension ( async::CJobScheduler& scheduler
+                       , async::CJobScheduler& prefetchScheduler)
+            : listSuspension (scheduler)
+            , prefetchSuspension (prefetchScheduler)
+        {
+        }
+    };
+
     /// simple construction
 
     CRepositoryLister();
@@ -419,18 +525,30 @@ public:
                  , bool includeExternals
                  , bool runSilently = true);
 
+    /// speculatively list the sub-folders of \ref items, then their
+    /// sub-folders etc. breadth-first up to \ref PREFETCH_LEVELS levels
+    /// deep. This replaces the previous prefetch walk. All queries run
+    /// silently. Except for the first level, they run with lower
+    /// priority than those from \ref Enqueue.
+
+    void Prefetch ( const std::deque<CItem>& items
+                  , apr_uint32_t dirent
+                  , bool includeExternals);
+
     /// remove all unfinished entries from the job queue
 
     void Cancel();
 
-    /// wait for all jobs to be finished
+    /// wait for all jobs to be finished (except for the prefetch walk)
 
     void WaitForJobsToFinish();
 
     /// return a RAII object that suspends job scheduling for its
-    /// lifetime (jobs already being processed will not be affected)
+    /// lifetime (jobs already being processed will not be affected).
+    /// The user is about to navigate elsewhere, so this also cancels
+    /// the prefetch walk.
 
-    std::unique_ptr<async::CSchedulerSuspension> SuspendJobs();
+    std::unique_ptr<CJobSuspension> SuspendJobs();
 
     /// don't return results from previous or still running requests
     /// the next time \ref GetList() gets called
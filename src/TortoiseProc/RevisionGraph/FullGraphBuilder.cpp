@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2008, 2014, 2016 - TortoiseSVN
+// Copyright (C) 2003-2008, 2014, 2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -23,6 +23,8 @@
 #include "SearchPathTree.h"
 #include "FullHistory.h"
 #include "FullGraph.h"
+#include "JobScheduler.h"
+#include "AsyncCall.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -50,6 +52,12 @@ void CFullGraphBuilder::Run()
          || !history.GetStartPath()->IsValid())
         return;
 
+    // extract the copy target info in parallel
+    // (the revision walk below depends on the search tree state
+    // of the previous revision and must be sequential)
+
+    CollectCopyTargets();
+
     // frequently used objects
 
     const CCachedLogInfo* cache = history.GetCache();
@@ -192,6 +200,85 @@ void CFullGraphBuilder::Run()
     }
 }
 
+void CFullGraphBuilder::CollectCopyTargets()
+{
+    // all revisions with copies, in ascending order
+
+    copyTargets.clear();
+    for ( SCopyInfo** iter = history.GetFirstCopyTo()
+        , **end = history.GetCopyToEnd()
+        ; iter != end
+        ; ++iter)
+    {
+        revision_t revision = (*iter)->toRevision;
+        if (copyTargets.empty() || (copyTargets.back().revision != revision))
+        {
+            copyTargets.push_back (SCopyTarget());
+            copyTargets.back().revision = revision;
+        }
+    }
+
+    // fill them, one chunk of revisions per job
+
+    enum {CHUNK_SIZE = 1024};
+
+    async::CJobScheduler jobs (1, async::CJobScheduler::GetHWThreadCount());
+    for (size_t i = 0, count = copyTargets.size(); i < count; i += CHUNK_SIZE)
+        new async::CAsyncCall ( this
+                              , &CFullGraphBuilder::AnalyzeCopyTargets
+                              , i
+                              , min (count, i + CHUNK_SIZE)
+                              , &jobs);
+
+    jobs.WaitForEmptyQueue();
+}
+
+void CFullGraphBuilder::AnalyzeCopyTargets (size_t first, size_t last)
+{
+    const CCachedLogInfo* cache = history.GetCache();
+    const CRevisionInfoContainer& logInfo = cache->GetLogInfo();
+    const CRevisionIndex& revisions = cache->GetRevisions();
+
+    for (size_t i = first; i < last; ++i)
+    {
+        SCopyTarget& target = copyTargets[i];
+        index_t index = revisions[target.revision];
+
+        target.hasDeletions
+            = (logInfo.GetSumChanges (index) & CRevisionInfoContainer::ACTION_DELETED) != 0;
+
+        for ( CRevisionInfoContainer::CChangesIterator
+              iter = logInfo.GetChangesBegin (index)
+            , end = logInfo.GetChangesEnd (index)
+            ; iter != end
+            ; ++iter)
+        {
+            if (iter->HasFromPath())
+                target.copySources.push_back
+                    (std::make_pair (iter->GetFromPathID(), iter->GetFromRevision()));
+
+            if (iter->GetAction() != CRevisionInfoContainer::ACTION_CHANGED)
+                target.structuralChanges.push_back
+                    (std::make_pair (iter->GetPathID(), iter->GetRawChange()));
+        }
+    }
+}
+
+const CFullGraphBuilder::SCopyTarget&
+CFullGraphBuilder::GetCopyTarget (revision_t revision) const
+{
+    auto iter = std::lower_bound ( copyTargets.begin()
+                                 , copyTargets.end()
+                                 , revision
+                                 , [](const SCopyTarget& lhs, revision_t rhs)
+                                   {
+                                       return lhs.revision < rhs;
+                                   });
+
+    assert ((iter != copyTargets.end()) && (iter->revision == revision));
+    return *iter;
+}
+
 void CFullGraphBuilder::AnalyzeReplacements ( revision_t revision
                                               , const CRevisionInfoContainer::CChangesIterator& first
                                               , const CRevisionInfoContainer::CChangesIterator& last
@@ -551,31 +638,27 @@ bool CFullGraphBuilder::IsLatestCopySource ( revision_t fromRevision
     // R /trunk/F/a  /trunk/branches/b/F/a  105
     // -> return r105
 
-    const CCachedLogInfo* cache = history.GetCache();
-    const CRevisionInfoContainer& logInfo = cache->GetLogInfo();
-    index_t index = cache->GetRevisions()[toRevision];
+    const std::vector<std::pair<index_t, revision_t> >& copySources
+        = GetCopyTarget (toRevision).copySources;
 
     // search it
 
-    for ( CRevisionInfoContainer::CChangesIterator
-          iter = logInfo.GetChangesBegin (index)
-        , end = logInfo.GetChangesEnd (index)
-        ; iter != end
-        ; ++iter)
+    for (size_t i = 0, count = copySources.size(); i < count; ++i)
     {
+        index_t copyFromPathID = copySources[i].first;
+
         // is this a copy of the current path?
 
-        if (   iter->HasFromPath()
-            && currentPath.IsSameOrChildOf (iter->GetFromPathID()))
+        if (currentPath.IsSameOrChildOf (copyFromPathID))
         {
             // a later change?
 
-            if (iter->GetFromRevision() > fromRevision)
+            if (copySources[i].second > fromRevision)
                 return false;
 
             // a closer sub-path?
 
-            if (iter->GetFromPathID() > fromPath.GetIndex())
+            if (copyFromPathID > fromPath.GetIndex())
                 return false;
         }
     }
@@ -595,29 +678,26 @@ bool CFullGraphBuilder::TargetPathExists ( revision_t revision
     // D /branches/b/a
     // -> /branches/b/a does not exist
 
-    const CCachedLogInfo* cache = history.GetCache();
-    const CRevisionInfoContainer& logInfo = cache->GetLogInfo();
-    index_t index = cache->GetRevisions()[revision];
+    const SCopyTarget& target = GetCopyTarget (revision);
 
     // short-cut: if there are no deletions, we should be fine
 
-    if (!(logInfo.GetSumChanges (index) & CRevisionInfoContainer::ACTION_DELETED))
+    if (!target.hasDeletions)
         return true;
 
-    // crawl changes and update this flag:
+    // crawl changes and update this flag
+    // (plain modifications don't affect it and have been filtered out)
 
     bool exists = false;
-    for ( CRevisionInfoContainer::CChangesIterator
-          iter = logInfo.GetChangesBegin (index)
-        , end = logInfo.GetChangesEnd (index)
-        ; iter != end
-        ; ++iter)
+    for (size_t i = 0, count = target.structuralChanges.size(); i < count; ++i)
     {
+        index_t changePathID = target.structuralChanges[i].first;
+
         // does this change affect the path?
 
-        if (path.IsSameOrChildOf (iter->GetPathID()))
+        if (path.IsSameOrChildOf (changePathID))
         {
-            switch (iter->GetRawChange())
+            switch (target.structuralChanges[i].second)
             {
             case CRevisionInfoContainer::ACTION_DELETED :
                 // deletion? -> does not exist
@@ -648,7 +728,7 @@ bool CFullGraphBuilder::TargetPathExists ( revision_t revision
             case CRevisionInfoContainer::ACTION_MOVEREPLACED:
                 // exact addition? -> does exist
 
-                if (iter->GetPathID() == path.GetIndex())
+                if (changePathID == path.GetIndex())
                     exists = true;
 
                 break;
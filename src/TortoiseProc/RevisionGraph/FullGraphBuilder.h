@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2008, 2014, 2016 - TortoiseSVN
+// Copyright (C) 2003-2008, 2014, 2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -35,6 +35,13 @@ class SCopyInfo;
 
 /**
  * \ingroup TortoiseProc
+ * Builds the full graph from the log cache and the copy relations
+ * found by CFullHistory.
+ *
+ * Only the extraction of the copy target changes runs in parallel.
+ * The revision walk that creates the graph nodes is sequential because
+ * every revision depends on the search tree left behind by the
+ * previous ones.
  */
 class CFullGraphBuilder
 {
@@ -47,6 +54,25 @@ public:
 
 private:
 
+    /// changes of a copy target revision, as far as relevant
+    /// for IsLatestCopySource() and TargetPathExists()
+
+    struct SCopyTarget
+    {
+        revision_t revision;
+        bool hasDeletions;
+
+        /// (from path, from revision) for all copies in that revision
+        std::vector<std::pair<index_t, revision_t> > copySources;
+
+        /// (path, raw change) for all but plain modifications
+        std::vector<std::pair<index_t, int> > structuralChanges;
+    };
+
+    void CollectCopyTargets();
+    void AnalyzeCopyTargets (size_t first, size_t last);
+    const SCopyTarget& GetCopyTarget (revision_t revision) const;
+
     void AnalyzeReplacements ( revision_t revision
                              , const CRevisionInfoContainer::CChangesIterator& first
                              , const CRevisionInfoContainer::CChangesIterator& last
@@ -76,4 +102,7 @@ private:
 
     const CFullHistory& history;
     CFullGraph& graph;
+
+    /// sorted by revision
+    std::vector<SCopyTarget> copyTargets;
 };
@@ -0,0 +1,295 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "FullGraphCache.h"
+#include "FullHistory.h"
+#include "FullGraph.h"
+#include "CachedLogInfo.h"
+#include "registry.h"
+#include "UnicodeUtils.h"
+#include "SVNHelpers.h"
+#include "Containers/StringDictonary.h"
+#include "Streams/RootInStream.h"
+#include "Streams/RootOutStream.h"
+#include "Streams/CompositeInStream.h"
+#include "Streams/CompositeOutStream.h"
+#include "Streams/BLOBInStream.h"
+#include "Streams/BLOBOutStream.h"
+#include "Streams/PackedDWORDInStream.h"
+#include "Streams/PackedDWORDOutStream.h"
+#include "Streams/DiffIntegerInStream.h"
+#include "Streams/DiffIntegerOutStream.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+// construction / destruction
+
+CFullGraphCache::CFullGraphCache (const CFullHistory& history, bool showWCInfo)
+    : history (history)
+{
+    // we can only cache data when the log cache is being used
+
+    const CCachedLogInfo* cache = history.GetCache();
+    if ((cache == NULL) || cache->GetFileName().empty())
+        return;
+
+    // everything the full graph depends on, except for the log data
+
+    CRegStdString trunkPattern (L"Software\\TortoiseSVN\\RevisionGraph\\TrunkPattern", L"trunk");
+    CRegStdString branchesPattern (L"Software\\TortoiseSVN\\RevisionGraph\\BranchPattern", L"branches");
+    CRegStdString tagsPattern (L"Software\\TortoiseSVN\\RevisionGraph\\TagsPattern", L"tags");
+
+    const CFullHistory::SWCInfo& wcInfo = history.GetWCInfo();
+
+    CString parameters;
+    parameters.Format ( L"%s\n%s\n%s\n%ld\n%d %ld %ld %ld %ld %d\n%s\n%s\n%s\n"
+                      , (LPCTSTR)history.GetRepositoryUUID()
+                      , (LPCTSTR)history.GetRepositoryRoot()
+                      , (LPCTSTR)history.GetRelativePath()
+                      , (long)history.GetPegRevision()
+                      , showWCInfo ? 1 : 0
+                      , (long)wcInfo.minAtRev
+                      , (long)wcInfo.maxAtRev
+                      , (long)wcInfo.minCommit
+                      , (long)wcInfo.maxCommit
+                      , wcInfo.modified ? 1 : 0
+                      , ((std::wstring)trunkPattern).c_str()
+                      , ((std::wstring)branchesPattern).c_str()
+                      , ((std::wstring)tagsPattern).c_str());
+
+    // one file per start path: a graph built for a different HEAD,
+    // peg revision or WC state simply replaces the previous entry
+
+    CString startPath;
+    startPath.Format ( L"%s\n%s\n%s\n"
+                     , (LPCTSTR)history.GetRepositoryUUID()
+                     , (LPCTSTR)history.GetRepositoryRoot()
+                     , (LPCTSTR)history.GetRelativePath());
+
+    SVNPool pool;
+    fileName = cache->GetFileName()
+             + L"."
+             + (LPCTSTR)SVN::GetChecksumString (svn_checksum_md5, startPath, pool)
+             + L".graph";
+
+    CString head;
+    head.Format (L"%ld", (long)history.GetHeadRevision());
+    key = CUnicodeUtils::StdGetUTF8 ((LPCTSTR)(parameters + head));
+}
+
+CFullGraphCache::~CFullGraphCache(void)
+{
+}
+
+// cache access
+
+bool CFullGraphCache::Load (CFullGraph& graph) const
+{
+    assert (graph.GetRoot() == NULL);
+
+    if (   fileName.empty()
+        || (GetFileAttributes (fileName.c_str()) == INVALID_FILE_ATTRIBUTES))
+        return false;
+
+    const CPathDictionary* dictionary
+        = &history.GetCache()->GetLogInfo().GetPaths();
+
+    std::vector<CDictionaryBasedTempPath> paths;
+    std::vector<DWORD> pathIDs;
+    std::vector<int> revisions;
+    std::vector<DWORD> classifications;
+    std::vector<DWORD> sources;
+
+    try
+    {
+        CRootInStream stream (fileName);
+
+        // is this the entry for our HEAD revision?
+
+        CBLOBInStream* keyStream
+            = stream.GetSubStream<CBLOBInStream> (KEY_STREAM_ID);
+        if (   (keyStream->GetSize() != key.size())
+            || (memcmp (keyStream->GetData(), key.c_str(), key.size()) != 0))
+            return false;
+
+        // resolve every path only once
+
+        CStringDictionary pathStrings;
+        IHierarchicalInStream* pathsStream
+            = stream.GetSubStream (PATHS_STREAM_ID);
+        *pathsStream >> pathStrings;
+
+        paths.reserve (pathStrings.size());
+        for (index_t i = 0, count = pathStrings.size(); i < count; ++i)
+            paths.push_back (CDictionaryBasedTempPath (dictionary, pathStrings[i]));
+
+        // node data
+
+        *stream.GetSubStream<CPackedDWORDInStream> (PATH_IDS_STREAM_ID)
+            >> pathIDs;
+        *stream.GetSubStream<CDiffIntegerInStream> (REVISIONS_STREAM_ID)
+            >> revisions;
+        *stream.GetSubStream<CPackedDWORDInStream> (CLASSIFICATIONS_STREAM_ID)
+            >> classifications;
+        *stream.GetSubStream<CPackedDWORDInStream> (SOURCES_STREAM_ID)
+            >> sources;
+    }
+    catch (...)
+    {
+        // the file is probably corrupt -> just rebuild the graph
+
+        return false;
+    }
+
+    // validate the data before touching the graph
+
+    size_t count = pathIDs.size();
+    if (   (count == 0)
+        || (revisions.size() != count)
+        || (classifications.size() != count)
+        || (sources.size() != count))
+        return false;
+
+    for (size_t i = 0; i < count; ++i)
+        if (   (pathIDs[i] >= paths.size())
+            || (sources[i] > i)
+            || ((sources[i] == 0) != (i == 0)))
+            return false;
+
+    // replay the node creation
+
+    std::vector<CFullGraphNode*> nodes;
+    nodes.reserve (count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        CFullGraphNode* source = i == 0 ? NULL : nodes[i - sources[i]];
+        nodes.push_back (graph.Add ( paths[pathIDs[i]]
+                                   , revisions[i]
+                                   , classifications[i]
+                                   , source));
+    }
+
+    return true;
+}
+
+void CFullGraphCache::Save (const CFullGraph& graph) const
+{
+    if (fileName.empty() || (graph.GetRoot() == NULL))
+        return;
+
+    // Flatten the graph such that replaying CFullGraph::Add() in the
+    // same order restores all links: chains get extended at their end
+    // while copy targets get prepended to their source's target list.
+    // Sources are stored as distance to the node's own index.
+
+    CStringDictionary paths;
+    std::vector<DWORD> pathIDs;
+    std::vector<int> revisions;
+    std::vector<DWORD> classifications;
+    std::vector<DWORD> sources;
+
+    pathIDs.reserve (graph.GetNodeCount());
+    revisions.reserve (graph.GetNodeCount());
+    classifications.reserve (graph.GetNodeCount());
+    sources.reserve (graph.GetNodeCount());
+
+    // (first node of a chain, index of its copy source + 1)
+
+    typedef std::pair<const CFullGraphNode*, size_t> TChain;
+    std::vector<TChain> chains;
+    chains.push_back (TChain (graph.GetRoot(), 0));
+
+    while (!chains.empty())
+    {
+        const CFullGraphNode* node = chains.back().first;
+        size_t source = chains.back().second;
+        chains.pop_back();
+
+        for (; node != NULL; node = node->GetNext())
+        {
+            // CFullGraph::Add() decides upon the link type
+            // by looking at the classification
+
+            bool isCopyTarget = node->GetClassification()
+                                    .Is (CNodeClassification::IS_COPY_TARGET);
+            if (isCopyTarget != (node->GetCopySource() != NULL))
+                return;
+
+            size_t index = pathIDs.size();
+
+            pathIDs.push_back (paths.AutoInsert (node->GetPath().GetPath().c_str()));
+            revisions.push_back (node->GetRevision());
+            classifications.push_back (node->GetClassification().GetFlags());
+            sources.push_back (source == 0 ? 0 : static_cast<DWORD>(index + 1 - source));
+
+            source = index + 1;
+
+            // being a stack, the last target will be added first
+
+            for ( const CFullGraphNode::CCopyTarget* target = node->GetFirstCopyTarget()
+                ; target != NULL
+                ; target = target->next())
+            {
+                chains.push_back (TChain (target->value(), source));
+            }
+        }
+    }
+
+    // write to a temp. file first to not disturb concurrent readers
+
+    std::wstring newFileName = fileName + L".new";
+    try
+    {
+        {
+            CRootOutStream stream (newFileName);
+
+            CBLOBOutStream* keyStream
+                = stream.OpenSubStream<CBLOBOutStream> (KEY_STREAM_ID);
+            keyStream->Add ( reinterpret_cast<const unsigned char*>(key.c_str())
+                           , key.size());
+
+            IHierarchicalOutStream* pathsStream
+                = stream.OpenSubStream<CCompositeOutStream> (PATHS_STREAM_ID);
+            *pathsStream << paths;
+
+            *stream.OpenSubStream<CPackedDWORDOutStream> (PATH_IDS_STREAM_ID)
+                << pathIDs;
+            *stream.OpenSubStream<CDiffIntegerOutStream> (REVISIONS_STREAM_ID)
+                << revisions;
+            *stream.OpenSubStream<CPackedDWORDOutStream> (CLASSIFICATIONS_STREAM_ID)
+                << classifications;
+            *stream.OpenSubStream<CPackedDWORDOutStream> (SOURCES_STREAM_ID)
+                << sources;
+        }
+
+        if (!MoveFileEx (newFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+            DeleteFile (newFileName.c_str());
+    }
+    catch (...)
+    {
+        // caching is optional
+
+        DeleteFile (newFileName.c_str());
+    }
+}
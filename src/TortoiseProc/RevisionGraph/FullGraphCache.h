@@ -0,0 +1,86 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+class CFullHistory;
+class CFullGraph;
+
+/**
+ * \ingroup TortoiseProc
+ * Stores finalized full graphs next to the repository's log cache file
+ * such that showing the same graph again does not need to run the
+ * CFullGraphBuilder and CFullGraphFinalizer.
+ *
+ * There is one file per start path. It holds the graph for the latest
+ * HEAD revision, peg revision and set of options that the full graph
+ * depends on (WC info and path classification patterns). An entry is
+ * only valid if all of these match and gets replaced once the graph has
+ * been rebuilt for other parameters. The files are removed along with
+ * the log cache (see CLogCachePool::DropCache()).
+ *
+ * New revisions are not appended to a cached graph. The builder's search
+ * tree state is not persisted, and the finalizer rewrites nodes that
+ * later revisions affect. So once HEAD has moved, the graph is built from
+ * scratch and the entry gets replaced.
+ *
+ * The data uses the log cache stream format. Paths are stored as strings
+ * and get resolved against the current path dictionary upon loading.
+ */
+class CFullGraphCache
+{
+public:
+
+    /// construction / destruction
+
+    CFullGraphCache (const CFullHistory& history, bool showWCInfo);
+    ~CFullGraphCache(void);
+
+    /// fill the empty \a graph with the cached data.
+    /// Returns false, if there is no valid entry.
+
+    bool Load (CFullGraph& graph) const;
+
+    /// replace the cache entry with \a graph
+
+    void Save (const CFullGraph& graph) const;
+
+private:
+
+    /// sub-stream IDs
+
+    enum
+    {
+        KEY_STREAM_ID = 1,
+        PATHS_STREAM_ID = 2,
+        PATH_IDS_STREAM_ID = 3,
+        REVISIONS_STREAM_ID = 4,
+        CLASSIFICATIONS_STREAM_ID = 5,
+        SOURCES_STREAM_ID = 6
+    };
+
+    const CFullHistory& history;
+
+    /// all graph parameters, including the HEAD revision
+
+    std::string key;
+
+    /// empty, if the log cache is not used
+
+    std::wstring fileName;
+};
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2015 - TortoiseSVN
+// Copyright (C) 2003-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -496,21 +496,16 @@ inline bool AscendingToRevision (const SCopyInfo* lhs, const SCopyInfo* rhs)
     return lhs->toRevision < rhs->toRevision;
 }
 
-void CFullHistory::BuildForwardCopies()
+void CFullHistory::CollectCopies ( revision_t first
+                                 , revision_t last
+                                 , std::vector<SCopyInfo>& copies) const
 {
-    // iterate through all revisions and fill copyToRelation:
-    // for every copy-from info found, add an entry
-
     const CRevisionIndex& revisions = cache->GetRevisions();
     const CRevisionInfoContainer& revisionInfo = cache->GetLogInfo();
 
-    // for all revisions ...
+    // for all revisions in [first, last) ...
 
-    copiesContainer.reserve (revisions.GetLastRevision());
-    for ( revision_t revision = revisions.GetFirstRevision()
-        , last = revisions.GetLastRevision()
-        ; revision < last
-        ; ++revision)
+    for (revision_t revision = first; revision < last; ++revision)
     {
         // ... in the cache ...
 
@@ -532,18 +527,74 @@ void CFullHistory::BuildForwardCopies()
                 {
                     // ... add it to the list
 
-                    SCopyInfo* copyInfo = SCopyInfo::Create (copyInfoPool);
+                    copies.push_back (SCopyInfo());
+                    SCopyInfo& copyInfo = copies.back();
 
-                    copyInfo->fromRevision = iter->GetFromRevision();
-                    copyInfo->fromPathIndex = iter->GetFromPathID();
-                    copyInfo->toRevision = revision;
-                    copyInfo->toPathIndex = iter->GetPathID();
-
-                    copiesContainer.push_back (copyInfo);
+                    copyInfo.fromRevision = iter->GetFromRevision();
+                    copyInfo.fromPathIndex = iter->GetFromPathID();
+                    copyInfo.toRevision = revision;
+                    copyInfo.toPathIndex = iter->GetPathID();
                 }
             }
         }
     }
+}
+
+void CFullHistory::BuildForwardCopies()
+{
+    // iterate through all revisions and fill copyToRelation:
+    // for every copy-from info found, add an entry
+
+    const CRevisionIndex& revisions = cache->GetRevisions();
+    const revision_t first = revisions.GetFirstRevision();
+    const revision_t last = revisions.GetLastRevision();
+
+    // scan the revisions in parallel, one chunk per job
+    // (the log cache is not modified anymore at this point).
+    // We are running in cpuLoadScheduler ourselves, hence the extra
+    // thread to guarantee progress even if the shared pool is empty.
+
+    enum {CHUNK_SIZE = 0x10000};
+
+    std::vector<std::vector<SCopyInfo>> chunks
+        ((last > first ? last - first : 0) / CHUNK_SIZE + 1);
+
+    {
+        async::CJobScheduler jobs (1, async::CJobScheduler::GetHWThreadCount());
+        for (size_t i = 0, count = chunks.size(); i < count; ++i)
+        {
+            revision_t chunkFirst = first + static_cast<revision_t>(i * CHUNK_SIZE);
+            revision_t chunkLast = min (last, chunkFirst + CHUNK_SIZE);
+            std::vector<SCopyInfo>* copies = &chunks[i];
+
+            new CAsyncCall ( [this, chunkFirst, chunkLast, copies]()
+                             {
+                                 CollectCopies (chunkFirst, chunkLast, *copies);
+                             }
+                           , &jobs);
+        }
+
+        jobs.WaitForEmptyQueue();
+    }
+
+    // merge the results in revision order
+    // (the pool is not thread-safe, so allocate only here)
+
+    copiesContainer.reserve (revisions.GetLastRevision());
+    for (size_t i = 0, count = chunks.size(); i < count; ++i)
+    {
+        for (const SCopyInfo& copy : chunks[i])
+        {
+            SCopyInfo* copyInfo = SCopyInfo::Create (copyInfoPool);
+
+            copyInfo->fromRevision = copy.fromRevision;
+            copyInfo->fromPathIndex = copy.fromPathIndex;
+            copyInfo->toRevision = copy.toRevision;
+            copyInfo->toPathIndex = copy.toPathIndex;
+
+            copiesContainer.push_back (copyInfo);
+        }
+    }
 
     // sort container by source revision and path
 
@@ -563,8 +614,19 @@ void CFullHistory::BuildForwardCopies()
         memcpy (copyToRelation, &copiesContainer.front(), bytesToCopy);
         memcpy (copyFromRelation, &copiesContainer.front(), bytesToCopy);
 
+        // the two sort orders are independent of each other
+
+        async::CJobScheduler jobs (1, 0);
+        new CAsyncCall ( [this]()
+                         {
+                             std::sort ( copyFromRelation
+                                       , copyFromRelationEnd
+                                       , &AscendingFromRevision);
+                         }
+                       , &jobs);
+
         std::sort (copyToRelation, copyToRelationEnd, &AscendingToRevision);
-        std::sort (copyFromRelation, copyFromRelationEnd, &AscendingFromRevision);
+        jobs.WaitForEmptyQueue();
     }
 }
 
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2008-2010, 2011-2013, 2015 - TortoiseSVN
+// Copyright (C) 2008-2010, 2011-2013, 2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -143,6 +143,7 @@ public:
 
     SCopyInfo**                 GetFirstCopyFrom() const {return copyFromRelation;}
     SCopyInfo**                 GetFirstCopyTo() const {return copyToRelation;}
+    SCopyInfo**                 GetCopyToEnd() const {return copyToRelationEnd;}
     void                        GetCopyFromRange (SCopyInfo**& first, SCopyInfo**& last, revision_t revision) const;
     void                        GetCopyToRange (SCopyInfo**& first, SCopyInfo**& last, revision_t revision) const;
 
@@ -207,6 +208,9 @@ private:
     void                        QueryWCRevision (bool doQuery, CString path);
     void                        AnalyzeRevisionData();
     void                        BuildForwardCopies();
+    void                        CollectCopies ( revision_t first
+                                              , revision_t last
+                                              , std::vector<SCopyInfo>& copies) const;
 
     /// implement ILogReceiver
 
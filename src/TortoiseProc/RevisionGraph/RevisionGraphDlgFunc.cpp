@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2011, 2013-2015, 2018 - TortoiseSVN
+// Copyright (C) 2003-2011, 2013-2015, 2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -28,6 +28,7 @@
 #include "CachedLogInfo.h"
 #include "RevisionGraph/IRevisionGraphLayout.h"
 #include "RevisionGraph/FullGraphBuilder.h"
+#include "RevisionGraph/FullGraphCache.h"
 #include "RevisionGraph/FullGraphFinalizer.h"
 #include "RevisionGraph/VisibleGraphBuilder.h"
 #include "RevisionGraph/StandardLayout.h"
@@ -229,11 +230,22 @@ bool CRevisionGraphWnd::FetchRevisionData
     {
         std::unique_ptr<CFullGraph> newFullGraph (new CFullGraph());
 
-        CFullGraphBuilder builder (*newFullHistory, *newFullGraph);
-        builder.Run();
+        // re-use the graph from the last time, if HEAD did not change
+
+        CFullGraphCache graphCache ( *newFullHistory
+                                   , showWCRev || showWCModification);
+        if (!graphCache.Load (*newFullGraph))
+        {
+            newFullGraph.reset (new CFullGraph());
 
-        CFullGraphFinalizer finalizer (*newFullHistory, *newFullGraph);
-        finalizer.Run();
+            CFullGraphBuilder builder (*newFullHistory, *newFullGraph);
+            builder.Run();
+
+            CFullGraphFinalizer finalizer (*newFullHistory, *newFullGraph);
+            finalizer.Run();
+
+            graphCache.Save (*newFullGraph);
+        }
 
         m_state.SetQueryResult ( newFullHistory
                                , newFullGraph
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2018 - TortoiseSVN
+// Copyright (C) 2003-2018, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -45,6 +45,7 @@
 #include "TaskbarUUID.h"
 #include "CreateProcessHelper.h"
 #include "SVNConfig.h"
+#include "SVNRASessionPool.h"
 #include "AnimationManager.h"
 #include <random>
 
@@ -84,6 +85,9 @@ CTortoiseProcApp::CTortoiseProcApp() : hWndExplorer(NULL), m_GlobalPool(NULL)
 
 CTortoiseProcApp::~CTortoiseProcApp()
 {
+    // close the pooled connections while apr and SSL are still up
+    SVNRASessionPool::Instance().Clear();
+
     // global application exit cleanup (after all SSL activity is shutdown)
     // we have to clean up SSL ourselves, since serf doesn't do that (can't do it)
     // because those cleanup functions work globally per process.
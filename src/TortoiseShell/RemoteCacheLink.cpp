@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2015, 2017 - TortoiseSVN
+// Copyright (C) 2003-2015, 2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -25,6 +25,7 @@
 #include "CreateProcessHelper.h"
 
 CRemoteCacheLink::CRemoteCacheLink(void)
+    : m_statusTableOpen(false)
 {
     SecureZeroMemory(&m_dummyStatus, sizeof(m_dummyStatus));
     SecureZeroMemory(&m_Overlapped, sizeof(m_Overlapped));
@@ -96,8 +97,13 @@ bool CRemoteCacheLink::EnsurePipeOpen()
 {
     AutoLocker lock(m_critSec);
 
+    const bool wasOpen = m_hPipe;
     if (InternalEnsurePipeOpen (m_hPipe, GetCachePipeName(), true))
     {
+        // the cache sets up the status table before it creates the pipe
+        if (!wasOpen)
+            EnsureStatusTableOpen();
+
         // create an unnamed (=local) manual reset event for use in the overlapped structure
         if (m_hEvent)
             return true;
@@ -113,6 +119,37 @@ bool CRemoteCacheLink::EnsurePipeOpen()
     return false;
 }
 
+void CRemoteCacheLink::EnsureStatusTableOpen()
+{
+    if (m_statusTableOpen.load(std::memory_order_acquire))
+        return;
+
+    m_hStatusTable = OpenFileMapping(FILE_MAP_READ, FALSE, GetCacheStatusTableName());
+    if (!m_hStatusTable)
+        return;
+
+    m_statusTableView = MapViewOfFile(m_hStatusTable, FILE_MAP_READ, 0, 0, 0);
+    if (!m_statusTableView || !m_statusTable.Attach(m_statusTableView))
+    {
+        CTraceToOutputDebugString::Instance()(__FUNCTION__ ": status table not available\n");
+        m_statusTableView.CloseHandle();
+        m_hStatusTable.CloseHandle();
+        return;
+    }
+
+    // optional: without it, the cache just can't tell which paths we look at
+    m_hAskedKeys = OpenFileMapping(FILE_MAP_WRITE, FALSE, GetCacheAskedKeysName());
+    if (m_hAskedKeys)
+    {
+        m_askedKeysView = MapViewOfFile(m_hAskedKeys, FILE_MAP_WRITE, 0, 0, 0);
+        if (m_askedKeysView)
+            m_askedKeys.Attach(m_askedKeysView);
+    }
+
+    // publish the table only after it has been fully set up
+    m_statusTableOpen.store(true, std::memory_order_release);
+}
+
 bool CRemoteCacheLink::EnsureCommandPipeOpen()
 {
     return InternalEnsurePipeOpen (m_hCommandPipe, GetCacheCommandPipeName(), false);
@@ -150,6 +187,27 @@ void CRemoteCacheLink::CloseCommandPipe()
 
 bool CRemoteCacheLink::GetStatusFromRemoteCache(const CTSVNPath& Path, TSVNCacheResponse* pReturnedStatus, bool bRecursive)
 {
+    TSVNCacheRequest request;
+    request.flags = TSVNCACHE_FLAGS_NONOTIFICATIONS;
+    if(bRecursive)
+    {
+        request.flags |= TSVNCACHE_FLAGS_RECUSIVE_STATUS;
+    }
+    wcsncpy_s(request.path, Path.GetWinPath(), MAX_PATH - 1);
+
+    // Most of the time, the cache has already answered that question
+    // and published the response. Looking it up doesn't need any lock.
+    if (m_statusTableOpen.load(std::memory_order_acquire))
+    {
+        const CCacheStatusTable::Key key = CCacheStatusTable::GetKey(request.path, request.flags);
+        if (m_statusTable.Lookup(key, GetTickCount64(), *pReturnedStatus))
+        {
+            // the cache prefers crawling what the shell currently shows
+            m_askedKeys.Push(key.hash);
+            return true;
+        }
+    }
+
     if(!EnsurePipeOpen())
     {
         // We've failed to open the pipe - try and start the cache
@@ -185,13 +243,6 @@ bool CRemoteCacheLink::GetStatusFromRemoteCache(const CTSVNPath& Path, TSVNCache
     AutoLocker lock(m_critSec);
 
     DWORD nBytesRead;
-    TSVNCacheRequest request;
-    request.flags = TSVNCACHE_FLAGS_NONOTIFICATIONS;
-    if(bRecursive)
-    {
-        request.flags |= TSVNCACHE_FLAGS_RECUSIVE_STATUS;
-    }
-    wcsncpy_s(request.path, Path.GetWinPath(), MAX_PATH - 1);
     SecureZeroMemory(&m_Overlapped, sizeof(OVERLAPPED));
     m_Overlapped.hEvent = m_hEvent;
     // Do the transaction in overlapped mode.
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2011, 2014, 2017 - TortoiseSVN
+// Copyright (C) 2003-2011, 2014, 2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -18,8 +18,9 @@
 //
 #pragma once
 #include "SmartHandle.h"
+#include "../TSVNCache/CacheInterface.h"
+#include <atomic>
 
-struct TSVNCacheResponse;
 class CTSVNPath;
 
 /**
@@ -45,6 +46,8 @@ private:
     bool EnsureCommandPipeOpen();
     void CloseCommandPipe();
 
+    void EnsureStatusTableOpen();
+
     DWORD GetProcessIntegrityLevel() const;
     bool RunTsvnCacheProcess();
     CString GetTsvnCachePath() const;
@@ -56,6 +59,17 @@ private:
 
     CAutoFile m_hCommandPipe;
 
+    /// read-only view of the responses the cache shares with all clients.
+    /// Once open, it stays valid until we're destroyed.
+    CAutoGeneralHandle m_hStatusTable;
+    CAutoViewOfFile m_statusTableView;
+    CCacheStatusTable m_statusTable;
+    std::atomic<bool> m_statusTableOpen;
+
+    /// tells the cache which table entries we used (optional)
+    CAutoGeneralHandle m_hAskedKeys;
+    CAutoViewOfFile m_askedKeysView;
+    CCacheAskedKeys m_askedKeys;
 
     CComAutoCriticalSection m_critSec;
     svn_client_status_t m_dummyStatus;
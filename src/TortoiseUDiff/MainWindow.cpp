@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2018 - TortoiseSVN
+// Copyright (C) 2003-2018, 2026 - TortoiseSVN
 // Copyright (C) 2012-2016, 2018-2019 - TortoiseGit
 
 // This program is free software; you can redistribute it and/or
@@ -28,10 +28,16 @@
 #include "registry.h"
 #include "DPIAware.h"
 #include "LoadIconEx.h"
+#include "SmartHandle.h"
 #include <VersionHelpers.h>
 
 const UINT TaskBarButtonCreated = RegisterWindowMessage(L"TaskbarButtonCreated");
 
+// size of the file views which get passed to the editor, a multiple of the allocation granularity
+static const ULONGLONG LOAD_CHUNK_SIZE = 16 * 1024 * 1024;
+// the styles only depend on the first few chars of a line
+static const Sci_Position MAX_STYLED_LINE_LENGTH = 400;
+
 CMainWindow::CMainWindow(HINSTANCE hInst, const WNDCLASSEX* wcx /* = nullptr*/)
     : CWindow(hInst, wcx)
     , m_bShowFindBar(false)
@@ -133,6 +139,13 @@ LRESULT CALLBACK CMainWindow::WinMsgHandler(HWND hwnd, UINT uMsg, WPARAM wParam,
             }
         }
         break;
+    case WM_NOTIFY:
+        {
+            SCNotification * pSCN = reinterpret_cast<SCNotification *>(lParam);
+            if ((pSCN->nmhdr.hwndFrom == m_hWndEdit) && (pSCN->nmhdr.code == SCN_STYLENEEDED))
+                StyleLines(SendEditor(SCI_GETENDSTYLED), pSCN->position);
+        }
+        break;
     case WM_GETMINMAXINFO:
         {
             MINMAXINFO * mmi = (MINMAXINFO*)lParam;
@@ -292,6 +305,18 @@ LRESULT CMainWindow::DoCommand(int id)
         else
             PostQuitMessage(0);
         break;
+    case ID_VIEW_NEXTFILE:
+        GoToIndexLine(CPatchIndex::GetNext(m_patchIndex.GetFileLines(), GetCurrentLine()));
+        break;
+    case ID_VIEW_PREVFILE:
+        GoToIndexLine(CPatchIndex::GetPrevious(m_patchIndex.GetFileLines(), GetCurrentLine()));
+        break;
+    case ID_VIEW_NEXTHUNK:
+        GoToIndexLine(CPatchIndex::GetNext(m_patchIndex.GetHunkLines(), GetCurrentLine()));
+        break;
+    case ID_VIEW_PREVHUNK:
+        GoToIndexLine(CPatchIndex::GetPrevious(m_patchIndex.GetHunkLines(), GetCurrentLine()));
+        break;
     case ID_FILE_SETTINGS:
         {
             tstring svnCmd = L" /command:settings /page:20";
@@ -647,6 +672,8 @@ bool CMainWindow::Initialize()
     SendEditor(SCI_SETWHITESPACESIZE, 2);
     SendEditor(SCI_SETWHITESPACEFORE, true, ::GetSysColor(COLOR_3DSHADOW));
     SendEditor(SCI_STYLESETVISIBLE, STYLE_CONTROLCHAR, TRUE);
+    // nobody listens to SCN_MODIFIED, don't send it for every loaded chunk
+    SendEditor(SCI_SETMODEVENTMASK, 0);
 
     return true;
 }
@@ -654,16 +681,16 @@ bool CMainWindow::Initialize()
 bool CMainWindow::LoadFile(HANDLE hFile)
 {
     InitEditor();
-    char data[4096] = { 0 };
+    const DWORD bufferSize = 64 * 1024;
+    auto data = std::make_unique<char[]>(bufferSize);
     DWORD dwRead = 0;
 
-    BOOL bRet = ReadFile(hFile, data, sizeof(data), &dwRead, nullptr);
-    bool bUTF8 = IsUTF8(data, dwRead);
+    BOOL bRet = ReadFile(hFile, data.get(), bufferSize, &dwRead, nullptr);
+    bool bUTF8 = IsUTF8(data.get(), min(dwRead, 4096));
     while ((dwRead > 0) && (bRet))
     {
-        SendEditor(SCI_ADDTEXT, dwRead,
-            reinterpret_cast<LPARAM>(static_cast<char *>(data)));
-        bRet = ReadFile(hFile, data, sizeof(data), &dwRead, nullptr);
+        AddText(data.get(), dwRead);
+        bRet = ReadFile(hFile, data.get(), bufferSize, &dwRead, nullptr);
     }
     SetupWindow(bUTF8);
     return true;
@@ -672,27 +699,91 @@ bool CMainWindow::LoadFile(HANDLE hFile)
 bool CMainWindow::LoadFile(LPCTSTR filename)
 {
     InitEditor();
-    FILE* fp = nullptr;
-    _wfopen_s(&fp, filename, L"rb");
-    if (!fp)
+    CAutoFile hFile = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (!hFile)
+        return false;
+    LARGE_INTEGER fileSize = { 0 };
+    if (!GetFileSizeEx(hFile, &fileSize))
         return false;
 
-    //SetTitle();
-    char data[4096] = { 0 };
-    size_t lenFile = fread(data, 1, sizeof(data), fp);
-    bool bUTF8 = IsUTF8(data, lenFile);
-    while (lenFile > 0)
+    // map the file in views of a few MB instead of copying it through a small
+    // buffer, the memory for the whole text is allocated in the editor up front
+    bool bUTF8 = true;
+    if (fileSize.QuadPart > 0)
     {
-        SendEditor(SCI_ADDTEXT, lenFile,
-            reinterpret_cast<LPARAM>(static_cast<char *>(data)));
-        lenFile = fread(data, 1, sizeof(data), fp);
+        CAutoGeneralHandle hMapping = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!hMapping)
+            return false;
+        SendEditor(SCI_ALLOCATE, (WPARAM)fileSize.QuadPart);
+        for (ULONGLONG offset = 0; offset < (ULONGLONG)fileSize.QuadPart; offset += LOAD_CHUNK_SIZE)
+        {
+            size_t size = (size_t)min(LOAD_CHUNK_SIZE, (ULONGLONG)fileSize.QuadPart - offset);
+            char * pData = static_cast<char *>(MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)offset, size));
+            if (!pData)
+                return false;
+            if (offset == 0)
+                bUTF8 = IsUTF8(pData, min(size, 4096));
+            AddText(pData, size);
+            UnmapViewOfFile(pData);
+        }
     }
-    fclose(fp);
     SetupWindow(bUTF8);
     m_filename = filename;
     return true;
 }
 
+void CMainWindow::AddText(const char* data, size_t length)
+{
+    SendEditor(SCI_APPENDTEXT, length, reinterpret_cast<LPARAM>(data));
+    m_patchIndex.AddData(data, length);
+}
+
+void CMainWindow::StyleLines(Sci_Position startPos, Sci_Position endPos)
+{
+    Sci_Position line = SendEditor(SCI_LINEFROMPOSITION, startPos);
+    Sci_Position lastLine = SendEditor(SCI_LINEFROMPOSITION, endPos);
+    Sci_Position lineStart = SendEditor(SCI_POSITIONFROMLINE, line);
+    SendEditor(SCI_STARTSTYLING, lineStart, 0);
+    char text[MAX_STYLED_LINE_LENGTH + 1];
+    for (; line <= lastLine; ++line)
+    {
+        // the styles include the line ends
+        Sci_Position nextLineStart = SendEditor(SCI_POSITIONFROMLINE, line + 1);
+        if (nextLineStart < lineStart)
+            break;
+        Sci_TextRange range;
+        range.chrg.cpMin = (Sci_PositionCR)lineStart;
+        range.chrg.cpMax = (Sci_PositionCR)min(nextLineStart, lineStart + MAX_STYLED_LINE_LENGTH);
+        range.lpstrText = text;
+        SendEditor(SCI_GETTEXTRANGE, 0, reinterpret_cast<LPARAM>(&range));
+        SendEditor(SCI_SETSTYLING, nextLineStart - lineStart, CPatchIndex::GetLineStyle(text));
+        lineStart = nextLineStart;
+    }
+}
+
+int CMainWindow::GetCurrentLine()
+{
+    return (int)SendEditor(SCI_LINEFROMPOSITION, SendEditor(SCI_GETCURRENTPOS));
+}
+
+void CMainWindow::GoToIndexLine(int line)
+{
+    if (line < 0)
+    {
+        FLASHWINFO fwi;
+        fwi.cbSize = sizeof(FLASHWINFO);
+        fwi.uCount = 3;
+        fwi.dwTimeout = 100;
+        fwi.dwFlags = FLASHW_ALL;
+        fwi.hwnd = m_hwnd;
+        FlashWindowEx(&fwi);
+        return;
+    }
+    SendEditor(SCI_GOTOLINE, line);
+    SendEditor(SCI_SETFIRSTVISIBLELINE, line);
+}
+
 void CMainWindow::InitEditor()
 {
     SendEditor(SCI_SETREADONLY, FALSE);
@@ -701,6 +792,7 @@ void CMainWindow::InitEditor()
     SendEditor(SCI_SETSAVEPOINT);
     SendEditor(SCI_CANCEL);
     SendEditor(SCI_SETUNDOCOLLECTION, 0);
+    m_patchIndex.Clear();
 }
 
 void CMainWindow::SetupWindow(bool bUTF8)
@@ -743,9 +835,8 @@ void CMainWindow::SetupWindow(bool bUTF8)
                   CRegStdDWORD(L"Software\\TortoiseSVN\\UDiffBackRemovedColor", UDIFF_COLORBACKREMOVED));
     }
 
-    SendEditor(SCI_SETLEXER, SCLEX_DIFF);
-    SendEditor(SCI_SETKEYWORDS, 0, (LPARAM)"revision");
-    SendEditor(SCI_COLOURISE, 0, -1);
+    // the lines are styled when they get visible, see StyleLines()
+    SendEditor(SCI_SETLEXER, SCLEX_CONTAINER);
     ::ShowWindow(m_hWndEdit, SW_SHOW);
 }
 
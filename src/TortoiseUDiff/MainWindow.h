@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2007, 2009-2013 - TortoiseSVN
+// Copyright (C) 2007, 2009-2013, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -23,6 +23,7 @@
 #include "registry.h"
 #include "resource.h"
 #include "FindBar.h"
+#include "PatchIndex.h"
 #include <string>
 #include <stdio.h>
 
@@ -64,6 +65,13 @@ private:
     bool                IsUTF8(LPVOID pBuffer, size_t cb);
     void                InitEditor();
     void                SetupWindow(bool bUTF8);
+    /// appends a chunk of the patch to the editor and the index
+    void                AddText(const char* data, size_t length);
+    /// styles the lines between the two positions, see SCN_STYLENEEDED
+    void                StyleLines(Sci_Position startPos, Sci_Position endPos);
+    /// scrolls \a line to the top and moves the caret there, -1 if there is no such line
+    void                GoToIndexLine(int line);
+    int                 GetCurrentLine();
 
 private:
     LRESULT             m_directFunction;
@@ -76,6 +84,7 @@ private:
     bool                m_bMatchCase;
     std::wstring        m_findtext;
     std::wstring        m_filename;
+    CPatchIndex         m_patchIndex;
 
     void loadOrSaveFile( bool doLoad, const std::wstring& filename = L"" );
 };
\ No newline at end of file
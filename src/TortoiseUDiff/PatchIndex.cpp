@@ -0,0 +1,253 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "PatchIndex.h"
+#include "SciLexer.h"
+#include <algorithm>
+
+static bool StartsWith(const char* line, size_t length, const char* prefix)
+{
+    size_t prefixLength = strlen(prefix);
+    return (length >= prefixLength) && (strncmp(line, prefix, prefixLength) == 0);
+}
+
+static bool ParseRange(const char*& pos, const char* end, char sign, int& count)
+{
+    if ((pos >= end) || (*pos != sign))
+        return false;
+    ++pos;
+    if ((pos >= end) || !isdigit((unsigned char)*pos))
+        return false;
+    while ((pos < end) && isdigit((unsigned char)*pos))
+        ++pos;
+
+    // the line count is optional and defaults to 1
+    count = 1;
+    if ((pos < end) && (*pos == ','))
+    {
+        ++pos;
+        if ((pos >= end) || !isdigit((unsigned char)*pos))
+            return false;
+        count = 0;
+        while ((pos < end) && isdigit((unsigned char)*pos))
+        {
+            if (count > 100000000)
+                return false;
+            count = count * 10 + (*pos - '0');
+            ++pos;
+        }
+    }
+    return true;
+}
+
+CPatchIndex::CPatchIndex()
+{
+    Clear();
+}
+
+CPatchIndex::~CPatchIndex(void)
+{
+}
+
+void CPatchIndex::Clear()
+{
+    m_fileLines.clear();
+    m_hunkLines.clear();
+    m_line = 0;
+    m_bAfterCR = false;
+    m_prefixLength = 0;
+    m_header = HEADER_NONE;
+    m_oldLines = 0;
+    m_newLines = 0;
+}
+
+void CPatchIndex::AddData(const char* data, size_t length)
+{
+    const char* end = data + length;
+    while (data < end)
+    {
+        if (m_bAfterCR)
+        {
+            m_bAfterCR = false;
+            if (*data == '\n')
+            {
+                ++data;
+                continue;
+            }
+        }
+
+        const char* lineEnd = data;
+        while ((lineEnd < end) && (*lineEnd != '\r') && (*lineEnd != '\n'))
+            ++lineEnd;
+
+        size_t count = std::min<size_t>(lineEnd - data, MAX_PREFIX - m_prefixLength);
+        memcpy(m_prefix + m_prefixLength, data, count);
+        m_prefixLength += count;
+        if (lineEnd == end)
+            break;      // the line continues in the next chunk
+
+        ParseLine(m_prefix, m_prefixLength);
+        ++m_line;
+        m_prefixLength = 0;
+        m_bAfterCR = (*lineEnd == '\r');
+        data = lineEnd + 1;
+    }
+}
+
+int CPatchIndex::GetNext(const std::vector<int>& lines, int line)
+{
+    auto it = std::upper_bound(lines.begin(), lines.end(), line);
+    return it == lines.end() ? -1 : *it;
+}
+
+int CPatchIndex::GetPrevious(const std::vector<int>& lines, int line)
+{
+    auto it = std::lower_bound(lines.begin(), lines.end(), line);
+    return it == lines.begin() ? -1 : *(--it);
+}
+
+void CPatchIndex::ParseLine(const char* line, size_t length)
+{
+    if ((m_oldLines > 0) || (m_newLines > 0))
+    {
+        // lines of a hunk may look like headers, e.g. a removed "-- " line
+        switch (length ? line[0] : ' ')
+        {
+        case ' ':
+            --m_oldLines;
+            --m_newLines;
+            return;
+        case '-':
+            --m_oldLines;
+            return;
+        case '+':
+            --m_newLines;
+            return;
+        case '\\':
+            return;
+        default:
+            // the hunk is shorter than its header says
+            m_oldLines = 0;
+            m_newLines = 0;
+            break;
+        }
+    }
+
+    int oldLines = 0;
+    int newLines = 0;
+    if (ParseHunkHeader(line, length, oldLines, newLines))
+    {
+        m_hunkLines.push_back(m_line);
+        m_header = HEADER_NONE;
+        m_oldLines = oldLines;
+        m_newLines = newLines;
+    }
+    else if (StartsWith(line, length, "Index: "))
+    {
+        m_fileLines.push_back(m_line);
+        m_header = HEADER_INDEX;
+    }
+    else if (StartsWith(line, length, "diff "))
+    {
+        // "svn diff --git" writes both headers
+        if (m_header != HEADER_INDEX)
+            m_fileLines.push_back(m_line);
+        m_header = HEADER_DIFF;
+    }
+    else if (StartsWith(line, length, "--- ") && (m_header == HEADER_NONE))
+    {
+        m_fileLines.push_back(m_line);
+        m_header = HEADER_PLAIN;
+    }
+}
+
+bool CPatchIndex::ParseHunkHeader(const char* line, size_t length, int& oldLines, int& newLines)
+{
+    // "@@ -1,2 +1,3 @@" for the contents, "## -1,2 +1,3 ##" for properties
+    if ((length < 4) || (line[0] != line[1]) || ((line[0] != '@') && (line[0] != '#')) || (line[2] != ' '))
+        return false;
+
+    const char* pos = line + 3;
+    const char* end = line + length;
+    if (!ParseRange(pos, end, '-', oldLines))
+        return false;
+    if ((pos >= end) || (*pos != ' '))
+        return false;
+    ++pos;
+    return ParseRange(pos, end, '+', newLines);
+}
+
+int CPatchIndex::GetLineStyle(const char* line)
+{
+    // same rules as ColouriseDiffLine() in LexDiff.cxx
+    if (strncmp(line, "diff ", 5) == 0)
+        return SCE_DIFF_COMMAND;
+    if (strncmp(line, "Index: ", 7) == 0)
+        return SCE_DIFF_COMMAND;
+    if ((strncmp(line, "---", 3) == 0) && (line[3] != '-'))
+    {
+        // in a context diff, --- appears in both the header and the position markers
+        if ((line[3] == ' ') && atoi(line + 4) && !strchr(line, '/'))
+            return SCE_DIFF_POSITION;
+        if ((line[3] == '\r') || (line[3] == '\n'))
+            return SCE_DIFF_POSITION;
+        if (line[3] == ' ')
+            return SCE_DIFF_HEADER;
+        return SCE_DIFF_DELETED;
+    }
+    if (strncmp(line, "+++ ", 4) == 0)
+    {
+        if (atoi(line + 4) && !strchr(line, '/'))
+            return SCE_DIFF_POSITION;
+        return SCE_DIFF_HEADER;
+    }
+    if (strncmp(line, "====", 4) == 0)
+        return SCE_DIFF_HEADER;
+    if (strncmp(line, "***", 3) == 0)
+    {
+        if ((line[3] == ' ') && atoi(line + 4) && !strchr(line, '/'))
+            return SCE_DIFF_POSITION;
+        if (line[3] == '*')
+            return SCE_DIFF_POSITION;
+        return SCE_DIFF_HEADER;
+    }
+    if (strncmp(line, "? ", 2) == 0)
+        return SCE_DIFF_HEADER;
+    if (line[0] == '@')
+        return SCE_DIFF_POSITION;
+    if ((line[0] >= '0') && (line[0] <= '9'))
+        return SCE_DIFF_POSITION;
+    if (strncmp(line, "++", 2) == 0)
+        return SCE_DIFF_PATCH_ADD;
+    if (strncmp(line, "+-", 2) == 0)
+        return SCE_DIFF_PATCH_DELETE;
+    if (strncmp(line, "-+", 2) == 0)
+        return SCE_DIFF_REMOVED_PATCH_ADD;
+    if (strncmp(line, "--", 2) == 0)
+        return SCE_DIFF_REMOVED_PATCH_DELETE;
+    if ((line[0] == '-') || (line[0] == '<'))
+        return SCE_DIFF_DELETED;
+    if ((line[0] == '+') || (line[0] == '>'))
+        return SCE_DIFF_ADDED;
+    if (line[0] == '!')
+        return SCE_DIFF_CHANGED;
+    if (line[0] != ' ')
+        return SCE_DIFF_COMMENT;
+    return SCE_DIFF_DEFAULT;
+}
@@ -0,0 +1,84 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+#include <vector>
+
+/**
+ * \ingroup TortoiseUDiff
+ * Line numbers of the files and hunks of a patch.
+ *
+ * The patch is parsed while it gets loaded, in chunks which may end in the
+ * middle of a line. Lines end with CR, LF or CRLF, the same as in Scintilla,
+ * so the line numbers can be used with the editor directly.
+ */
+class CPatchIndex
+{
+public:
+    CPatchIndex();
+    ~CPatchIndex(void);
+
+    void                    Clear();
+    /// parses the next part of the patch
+    void                    AddData(const char* data, size_t length);
+
+    /// lines where the diff of a file starts ("Index: ", "diff ", "--- ")
+    const std::vector<int>& GetFileLines() const { return m_fileLines; }
+    /// lines of the hunk headers ("@@ ", "## ")
+    const std::vector<int>& GetHunkLines() const { return m_hunkLines; }
+
+    /// returns the first line in \a lines after \a line, -1 if there is none
+    static int              GetNext(const std::vector<int>& lines, int line);
+    /// returns the last line in \a lines before \a line, -1 if there is none
+    static int              GetPrevious(const std::vector<int>& lines, int line);
+
+    /**
+     * Returns the SCE_DIFF_* style of a line, the same as the diff lexer of
+     * Scintilla would use. \a line must be null terminated.
+     */
+    static int              GetLineStyle(const char* line);
+
+private:
+    enum HeaderType
+    {
+        HEADER_NONE,
+        HEADER_INDEX,
+        HEADER_DIFF,
+        HEADER_PLAIN
+    };
+
+    enum
+    {
+        MAX_PREFIX = 64     ///< only the start of the lines is needed for parsing
+    };
+
+    void                    ParseLine(const char* line, size_t length);
+    static bool             ParseHunkHeader(const char* line, size_t length, int& oldLines, int& newLines);
+
+    std::vector<int>        m_fileLines;
+    std::vector<int>        m_hunkLines;
+
+    int                     m_line;
+    bool                    m_bAfterCR;         ///< a LF right after this is part of the same line end
+    char                    m_prefix[MAX_PREFIX];
+    size_t                  m_prefixLength;
+
+    HeaderType              m_header;           ///< file header which has not been followed by a hunk yet
+    int                     m_oldLines;         ///< remaining lines of the current hunk
+    int                     m_newLines;
+};
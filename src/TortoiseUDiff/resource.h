@@ -30,6 +30,10 @@
 #define IDM_FINDNEXT                    32789
 #define IDM_FINDPREV                    32790
 #define IDM_FINDEXIT                    32793
+#define ID_VIEW_NEXTFILE                32794
+#define ID_VIEW_PREVFILE                32795
+#define ID_VIEW_NEXTHUNK                32796
+#define ID_VIEW_PREVHUNK                32797
 #define IDC_STATIC                      -1
 
 // Next default values for new objects
@@ -38,7 +42,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NO_MFC                     1
 #define _APS_NEXT_RESOURCE_VALUE        133
-#define _APS_NEXT_COMMAND_VALUE         32785
+#define _APS_NEXT_COMMAND_VALUE         32798
 #define _APS_NEXT_CONTROL_VALUE         1000
 #define _APS_NEXT_SYMED_VALUE           110
 #endif
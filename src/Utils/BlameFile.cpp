@@ -0,0 +1,464 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#include "stdafx.h"
+#include "BlameFile.h"
+#include <algorithm>
+
+const char CBlameFile::MAGIC[8] = { 'T', 'S', 'V', 'N', 'B', 'L', 'M', '2' };
+
+namespace
+{
+    // the first chunk is small to allow for an early display
+    const size_t FIRST_CHUNK_LINES = 1000;
+    const size_t CHUNK_LINES = 16 * 1024;
+
+    // sanity limit for chunk sizes
+    const DWORD MAX_CHUNK_SIZE = 256 * 1024 * 1024;
+
+    template<class T>
+    void Append(std::string& target, const T& value)
+    {
+        target.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template<class T>
+    T Read(const char* source)
+    {
+        T result;
+        memcpy(&result, source, sizeof(result));
+        return result;
+    }
+
+    // returns true, if the text contains valid UTF-8 multi-byte sequences
+    // and no invalid ones
+    bool IsUTF8(const unsigned char* text, size_t length)
+    {
+        bool bUTF8 = false;
+        for (const unsigned char* end = text + length; text < end; ++text)
+        {
+            int trailing = 0;
+            if ((*text == 0xC0) || (*text == 0xC1) || (*text >= 0xF5))
+                return false;
+            else if ((*text & 0xE0) == 0xC0)
+                trailing = 1;
+            else if ((*text & 0xF0) == 0xE0)
+                trailing = 2;
+            else if ((*text & 0xF8) == 0xF0)
+                trailing = 3;
+            else if (*text >= 0x80)
+                return false;
+
+            if (trailing)
+                bUTF8 = true;
+            for (; trailing > 0; --trailing)
+            {
+                if (++text == end)
+                    return bUTF8;
+                if ((*text & 0xC0) != 0x80)
+                    return false;
+            }
+        }
+
+        return bUTF8;
+    }
+}
+
+std::string CBlameFile::ToEditorText(std::string_view line)
+{
+    // we display the line up to the first zero char only
+    line = line.substr(0, line.find('\0'));
+
+    // in case we find an UTF8 BOM at the beginning of the line, we remove it
+    if ((line.size() >= 3) && ((unsigned char)line[0] == 0xEF) && ((unsigned char)line[1] == 0xBB) && ((unsigned char)line[2] == 0xBF))
+        line.remove_prefix(3);
+    if ((line.size() >= 3) && ((unsigned char)line[0] == 0xBB) && ((unsigned char)line[1] == 0xEF) && ((unsigned char)line[2] == 0xBF))
+        line.remove_prefix(3);
+
+    bool isAscii = std::none_of(line.begin(), line.end(), [](char c) { return (unsigned char)c >= 0x80; });
+    if (isAscii || IsUTF8((const unsigned char*)line.data(), line.size()))
+        return std::string(line);
+
+    // not UTF-8: treat as ANSI
+    int wideLength = MultiByteToWideChar(CP_ACP, 0, line.data(), (int)line.size(), nullptr, 0);
+    if (wideLength == 0)
+        return std::string(line);
+
+    std::wstring wide(wideLength, L'\0');
+    MultiByteToWideChar(CP_ACP, 0, line.data(), (int)line.size(), &wide[0], wideLength);
+
+    int utf8Length = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), wideLength, nullptr, 0, nullptr, nullptr);
+    if (utf8Length == 0)
+        return std::string(line);
+
+    std::string result(utf8Length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), wideLength, &result[0], utf8Length, nullptr, nullptr);
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CBlameFileWriter::CBlameFileWriter()
+    : m_pendingStringCount(0)
+    , m_pendingLogCount(0)
+    , m_linesPerChunk(FIRST_CHUNK_LINES)
+{
+}
+
+CBlameFileWriter::~CBlameFileWriter()
+{
+    if (IsOpen())
+        Close(false);
+}
+
+bool CBlameFileWriter::Open(const std::wstring& path)
+{
+    // allow readers to process the file while we are still writing
+    m_file = CreateFile(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                        nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, nullptr);
+    if (!m_file)
+        return false;
+
+    m_stringIDs.clear();
+    m_stringIDs[std::string()] = 0;
+    m_loggedRevisions.clear();
+    m_linesPerChunk = FIRST_CHUNK_LINES;
+
+    DWORD written = 0;
+    return WriteFile(m_file, CBlameFile::MAGIC, sizeof(CBlameFile::MAGIC), &written, nullptr)
+        && (written == sizeof(CBlameFile::MAGIC));
+}
+
+DWORD CBlameFileWriter::AddString(std::string_view text)
+{
+    auto iter = m_stringIDs.find(std::string(text));
+    if (iter != m_stringIDs.end())
+        return iter->second;
+
+    DWORD id = (DWORD)m_stringIDs.size();
+    m_stringIDs.emplace(std::string(text), id);
+
+    Append(m_pendingStrings, (DWORD)text.size());
+    m_pendingStrings.append(text.data(), text.size());
+    ++m_pendingStringCount;
+
+    return id;
+}
+
+void CBlameFileWriter::AddLogMessage(LONG revision, std::string_view logMessage)
+{
+    if ((revision <= 0) || logMessage.empty())
+        return;
+    if (!m_loggedRevisions.insert(revision).second)
+        return;
+
+    Append(m_pendingLogs, revision);
+    Append(m_pendingLogs, AddString(logMessage));
+    ++m_pendingLogCount;
+}
+
+bool CBlameFileWriter::AddLine(LONG revision, std::string_view author, std::string_view date,
+                               LONG mergedRevision, std::string_view mergedAuthor, std::string_view mergedDate,
+                               std::string_view mergedPath, std::string_view line,
+                               std::string_view logMessage, std::string_view mergedLogMessage)
+{
+    if (!IsOpen())
+        return false;
+
+    CBlameFile::SBlameLine entry;
+    entry.revision = revision;
+    entry.mergedRevision = mergedRevision;
+    entry.author = AddString(author);
+    entry.date = AddString(date);
+    entry.mergedAuthor = AddString(mergedAuthor);
+    entry.mergedDate = AddString(mergedDate);
+    entry.mergedPath = AddString(mergedPath);
+    m_pendingLines.push_back(entry);
+
+    AddLogMessage(revision, logMessage);
+    AddLogMessage(mergedRevision, mergedLogMessage);
+
+    m_pendingText += CBlameFile::ToEditorText(line);
+    m_pendingText += '\n';
+
+    if (m_pendingLines.size() < m_linesPerChunk)
+        return true;
+
+    m_linesPerChunk = CHUNK_LINES;
+    return Flush();
+}
+
+bool CBlameFileWriter::WriteChunk(DWORD type, DWORD count, const std::string& payload)
+{
+    DWORD header[3] = { type, (DWORD)(payload.size() + sizeof(count)), count };
+    DWORD written = 0;
+    if (!WriteFile(m_file, header, sizeof(header), &written, nullptr) || (written != sizeof(header)))
+        return false;
+
+    return WriteFile(m_file, payload.data(), (DWORD)payload.size(), &written, nullptr)
+        && (written == payload.size());
+}
+
+bool CBlameFileWriter::Flush()
+{
+    // strings must be written before the chunks that reference them
+
+    bool result = true;
+    if (m_pendingStringCount)
+        result = WriteChunk(CBlameFile::CHUNK_STRINGS, m_pendingStringCount, m_pendingStrings);
+    if (m_pendingLogCount)
+        result = result && WriteChunk(CBlameFile::CHUNK_LOGS, m_pendingLogCount, m_pendingLogs);
+    if (!m_pendingLines.empty())
+    {
+        std::string payload;
+        payload.reserve(m_pendingLines.size() * sizeof(CBlameFile::SBlameLine) + sizeof(DWORD) + m_pendingText.size());
+        payload.append(reinterpret_cast<const char*>(m_pendingLines.data()), m_pendingLines.size() * sizeof(CBlameFile::SBlameLine));
+        Append(payload, (DWORD)m_pendingText.size());
+        payload += m_pendingText;
+
+        result = result && WriteChunk(CBlameFile::CHUNK_LINES, (DWORD)m_pendingLines.size(), payload);
+    }
+
+    m_pendingStrings.clear();
+    m_pendingStringCount = 0;
+    m_pendingLogs.clear();
+    m_pendingLogCount = 0;
+    m_pendingLines.clear();
+    m_pendingText.clear();
+
+    return result;
+}
+
+bool CBlameFileWriter::Close(bool complete)
+{
+    if (!IsOpen())
+        return false;
+
+    bool result = Flush();
+    if (complete)
+        result = result && WriteChunk(CBlameFile::CHUNK_END, 0, std::string());
+
+    m_file.CloseHandle();
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+CBlameFileReader::CBlameFileReader()
+    : m_data(nullptr)
+    , m_mappedSize(0)
+    , m_offset(0)
+    , m_complete(false)
+    , m_failed(false)
+{
+}
+
+CBlameFileReader::~CBlameFileReader()
+{
+    UnMap();
+}
+
+void CBlameFileReader::UnMap()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    m_data = nullptr;
+    m_mappedSize = 0;
+    m_mapping.CloseHandle();
+}
+
+bool CBlameFileReader::Open(const std::wstring& path)
+{
+    UnMap();
+    m_file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (!m_file)
+        return false;
+
+    m_path = path;
+    m_offset = 0;
+    m_complete = false;
+    m_failed = false;
+    m_strings.assign(1, std::string());
+    m_logMessages.clear();
+
+    if (!EnsureAvailable(sizeof(CBlameFile::MAGIC)) || (memcmp(m_data, CBlameFile::MAGIC, sizeof(CBlameFile::MAGIC)) != 0))
+        return false;
+
+    m_offset = sizeof(CBlameFile::MAGIC);
+    return true;
+}
+
+bool CBlameFileReader::EnsureAvailable(size_t size)
+{
+    if (m_offset + size <= m_mappedSize)
+        return true;
+
+    // the file may have grown in the meantime
+
+    LARGE_INTEGER fileSize = { 0 };
+    if (!GetFileSizeEx(m_file, &fileSize) || ((size_t)fileSize.QuadPart < m_offset + size))
+        return false;
+
+    UnMap();
+    m_mapping = CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+        return false;
+
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr)
+    {
+        UnMap();
+        return false;
+    }
+
+    m_mappedSize = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+bool CBlameFileReader::NextLines(const CBlameFile::SBlameLine*& lines, size_t& count, const char*& text, size_t& textSize)
+{
+    while (!m_complete && !m_failed)
+    {
+        const size_t headerSize = 2 * sizeof(DWORD);
+        if (!EnsureAvailable(headerSize))
+            return false;
+
+        DWORD type = Read<DWORD>(m_data + m_offset);
+        DWORD size = Read<DWORD>(m_data + m_offset + sizeof(DWORD));
+        if ((size > MAX_CHUNK_SIZE) || ((type != CBlameFile::CHUNK_END) && (size < sizeof(DWORD))))
+        {
+            m_failed = true;
+            return false;
+        }
+        if (!EnsureAvailable(headerSize + size))
+            return false;
+
+        const char* payload = m_data + m_offset + headerSize;
+        const char* end = payload + size;
+        m_offset += headerSize + size;
+
+        switch (type)
+        {
+        case CBlameFile::CHUNK_END:
+            m_complete = true;
+            break;
+
+        case CBlameFile::CHUNK_STRINGS:
+            {
+                DWORD stringCount = Read<DWORD>(payload);
+                payload += sizeof(DWORD);
+                for (DWORD i = 0; i < stringCount; ++i)
+                {
+                    if ((size_t)(end - payload) < sizeof(DWORD))
+                    {
+                        m_failed = true;
+                        return false;
+                    }
+                    DWORD length = Read<DWORD>(payload);
+                    payload += sizeof(DWORD);
+                    if (length > (DWORD)(end - payload))
+                    {
+                        m_failed = true;
+                        return false;
+                    }
+                    m_strings.emplace_back(payload, length);
+                    payload += length;
+                }
+            }
+            break;
+
+        case CBlameFile::CHUNK_LOGS:
+            {
+                DWORD logCount = Read<DWORD>(payload);
+                payload += sizeof(DWORD);
+                if (logCount > (DWORD)(end - payload) / (sizeof(LONG) + sizeof(DWORD)))
+                {
+                    m_failed = true;
+                    return false;
+                }
+                for (DWORD i = 0; i < logCount; ++i, payload += sizeof(LONG) + sizeof(DWORD))
+                {
+                    DWORD id = Read<DWORD>(payload + sizeof(LONG));
+                    if (id < m_strings.size())
+                        m_logMessages.emplace_back(Read<LONG>(payload), id);
+                }
+            }
+            break;
+
+        case CBlameFile::CHUNK_LINES:
+            {
+                DWORD lineCount = Read<DWORD>(payload);
+                payload += sizeof(DWORD);
+                if (   ((size_t)(end - payload) < sizeof(DWORD))
+                    || (lineCount > (DWORD)(end - payload - sizeof(DWORD)) / sizeof(CBlameFile::SBlameLine)))
+                {
+                    m_failed = true;
+                    return false;
+                }
+
+                lines = reinterpret_cast<const CBlameFile::SBlameLine*>(payload);
+                count = lineCount;
+                payload += lineCount * sizeof(CBlameFile::SBlameLine);
+
+                textSize = Read<DWORD>(payload);
+                text = payload + sizeof(DWORD);
+                if (textSize > (size_t)(end - text))
+                {
+                    m_failed = true;
+                    return false;
+                }
+
+                // reject dangling string references
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const CBlameFile::SBlameLine& line = lines[i];
+                    DWORD maxID = max(max(line.author, line.date), max(max(line.mergedAuthor, line.mergedDate), line.mergedPath));
+                    if (maxID >= m_strings.size())
+                    {
+                        m_failed = true;
+                        return false;
+                    }
+                }
+            }
+            return true;
+
+        default:
+            // unknown chunk type -> skip
+            break;
+        }
+    }
+
+    return false;
+}
+
+bool CBlameFileReader::IsWriterActive() const
+{
+    // the writer does not share write access, so we can't
+    // deny it ourselves unless it has closed the file
+    CAutoFile file = CreateFile(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, 0, nullptr);
+    return !file && (GetLastError() == ERROR_SHARING_VIOLATION);
+}
+
+std::vector<std::pair<LONG, DWORD>> CBlameFileReader::TakeLogMessages()
+{
+    std::vector<std::pair<LONG, DWORD>> result;
+    result.swap(m_logMessages);
+    return result;
+}
@@ -0,0 +1,182 @@
+// TortoiseSVN - a Windows shell extension for easy version control
+
+// Copyright (C) 2026 - TortoiseSVN
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+#pragma once
+
+#include "SmartHandle.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+/**
+ * \ingroup Utils
+ * The chunked blame file format written by CBlame and read by TortoiseBlame.
+ *
+ * \code
+ * file    := "TSVNBLM2" chunk*
+ * chunk   := type (DWORD) size (DWORD) count (DWORD) data
+ *            (size covers count and data)
+ *
+ * STRINGS := { length (DWORD) UTF-8 bytes }*count
+ * LINES   := SBlameLine*count textsize (DWORD) text
+ * LOGS    := { revision (LONG) string ID (DWORD) }*count
+ * END     := (no data, count is 0)
+ * \endcode
+ *
+ * Authors, dates, paths and log messages are stored only once in the
+ * string table and referenced by ID from the line records. ID 0 is
+ * the empty string, the first string ever written gets ID 1 etc.
+ * A string is always written before the first chunk that references it.
+ *
+ * The text of a LINES chunk contains all its lines, converted to UTF-8
+ * and terminated by '\n', i.e. ready to be appended to the editor.
+ *
+ * Every revision's log message is written only once.
+ *
+ * The END chunk marks the file as complete. Until it has been written,
+ * readers must expect further chunks to arrive. Unknown chunk types
+ * must be skipped.
+ */
+class CBlameFile
+{
+public:
+    enum
+    {
+        CHUNK_STRINGS   = 1,
+        CHUNK_LINES     = 2,
+        CHUNK_LOGS      = 3,
+        CHUNK_END       = 4,
+    };
+
+    static const char MAGIC[8];
+
+#pragma pack(push, 1)
+    struct SBlameLine
+    {
+        LONG    revision;
+        LONG    mergedRevision;
+        DWORD   author;
+        DWORD   date;
+        DWORD   mergedAuthor;
+        DWORD   mergedDate;
+        DWORD   mergedPath;
+    };
+#pragma pack(pop)
+
+    /**
+     * Strips BOMs from \a line and converts it to UTF-8 if it is not
+     * valid UTF-8 already (assuming the ANSI code page in that case).
+     */
+    static std::string ToEditorText(std::string_view line);
+};
+
+/**
+ * \ingroup Utils
+ * Writes a blame file. Lines are collected and written in chunks,
+ * the first one being rather small so that readers can start
+ * displaying early.
+ */
+class CBlameFileWriter
+{
+public:
+    CBlameFileWriter();
+    ~CBlameFileWriter();
+
+    bool Open(const std::wstring& path);
+    bool IsOpen() const { return m_file.IsValid(); }
+
+    bool AddLine(LONG revision, std::string_view author, std::string_view date,
+                 LONG mergedRevision, std::string_view mergedAuthor, std::string_view mergedDate,
+                 std::string_view mergedPath, std::string_view line,
+                 std::string_view logMessage, std::string_view mergedLogMessage);
+
+    /// writes all pending data. Marks the file as complete if \a complete is set.
+    bool Close(bool complete);
+
+private:
+    DWORD AddString(std::string_view text);
+    void AddLogMessage(LONG revision, std::string_view logMessage);
+    bool Flush();
+    bool WriteChunk(DWORD type, DWORD count, const std::string& payload);
+
+    CAutoFile                               m_file;
+
+    std::unordered_map<std::string, DWORD>  m_stringIDs;
+    std::set<LONG>                          m_loggedRevisions;
+
+    std::string                             m_pendingStrings;
+    DWORD                                   m_pendingStringCount;
+    std::string                             m_pendingLogs;
+    DWORD                                   m_pendingLogCount;
+    std::vector<CBlameFile::SBlameLine>     m_pendingLines;
+    std::string                             m_pendingText;
+    size_t                                  m_linesPerChunk;
+};
+
+/**
+ * \ingroup Utils
+ * Maps a blame file into memory and parses it chunk by chunk.
+ * The file may still be growing while being read.
+ */
+class CBlameFileReader
+{
+public:
+    CBlameFileReader();
+    ~CBlameFileReader();
+
+    /// returns false, if the file cannot be opened or has the wrong format
+    bool Open(const std::wstring& path);
+
+    /**
+     * Advances to the next chunk of lines. Returns false if no complete
+     * chunk of lines is available (yet). The returned pointers remain
+     * valid until the next call.
+     */
+    bool NextLines(const CBlameFile::SBlameLine*& lines, size_t& count, const char*& text, size_t& textSize);
+
+    /// true, if the END chunk has been read
+    bool IsComplete() const { return m_complete; }
+    /// true, if the data could not be parsed
+    bool HasFailed() const { return m_failed; }
+    /// true, if the file is still open for writing, e.g. by CBlameFileWriter
+    bool IsWriterActive() const;
+
+    /// the UTF-8 string table read so far
+    const std::vector<std::string>& GetStrings() const { return m_strings; }
+    /// (revision, string ID) pairs of the log messages read since the last call
+    std::vector<std::pair<LONG, DWORD>> TakeLogMessages();
+
+private:
+    bool EnsureAvailable(size_t size);
+    void UnMap();
+
+    std::wstring            m_path;
+    CAutoFile               m_file;
+    CAutoGeneralHandle      m_mapping;
+    const char*             m_data;
+    size_t                  m_mappedSize;
+    size_t                  m_offset;
+
+    bool                    m_complete;
+    bool                    m_failed;
+
+    std::vector<std::string>            m_strings;
+    std::vector<std::pair<LONG, DWORD>> m_logMessages;
+};
@@ -1,6 +1,6 @@
 ﻿// TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2015, 2017 - TortoiseSVN
+// Copyright (C) 2003-2015, 2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -51,6 +51,9 @@ CPicture::CPicture()
     , bIsIcon(false)
     , bIsTiff(false)
     , m_nSize(0)
+    , m_HorizontalResolution(0.0f)
+    , m_VerticalResolution(0.0f)
+    , bPixelsReleased(false)
     , m_ColorDepth(0)
     , hGlobal(NULL)
     , gdiplusToken(NULL)
@@ -95,6 +98,9 @@ void CPicture::FreePictureData()
     pBitmap = nullptr;
     delete[] pBitmapBuffer;
     pBitmapBuffer = nullptr;
+    m_HorizontalResolution = 0.0f;
+    m_VerticalResolution = 0.0f;
+    bPixelsReleased = false;
 }
 
 // Util function to ease loading of FreeImage library
@@ -481,6 +487,11 @@ bool CPicture::Load(tstring sFilePathName)
     }
 
     m_ColorDepth = GetColorDepth();
+    if (pBitmap)
+    {
+        m_HorizontalResolution = pBitmap->GetHorizontalResolution();
+        m_VerticalResolution = pBitmap->GetVerticalResolution();
+    }
 
     return(bResult);
 }
@@ -685,9 +696,42 @@ UINT CPicture::GetColorDepth() const
     return 0;
 }
 
+bool CPicture::GetPixels(int left, int top, int width, int height, UINT* pixels, int stride)
+{
+    if ((pBitmap == NULL) || (bIsIcon && lpIcons))
+        return false;
+
+    // let GDI+ convert the pixels right into the buffer of the caller
+    BitmapData data;
+    data.Width = width;
+    data.Height = height;
+    data.Stride = stride * (int)sizeof(UINT);
+    data.PixelFormat = PixelFormat32bppPARGB;
+    data.Scan0 = pixels;
+    data.Reserved = 0;
+    Rect rect(left, top, width, height);
+    if (pBitmap->LockBits(&rect, ImageLockModeRead | ImageLockModeUserInputBuf, PixelFormat32bppPARGB, &data) != Ok)
+        return false;
+    pBitmap->UnlockBits(&data);
+    return true;
+}
+
+bool CPicture::ReleasePixels()
+{
+    if ((pBitmap == NULL) || (bIsIcon && lpIcons) || (GetNumberOfDimensions() > 1) || (GetNumberOfFrames(0) > 1))
+        return false;
+
+    delete pBitmap;
+    pBitmap = nullptr;
+    delete[] pBitmapBuffer;
+    pBitmapBuffer = nullptr;
+    bPixelsReleased = true;
+    return true;
+}
+
 UINT CPicture::GetNumberOfFrames(int dimension)
 {
-    if (bIsIcon && lpIcons)
+    if ((bIsIcon && lpIcons) || bPixelsReleased)
     {
         return 1;
     }
@@ -711,6 +755,8 @@ UINT CPicture::GetNumberOfDimensions()
         LPICONDIR lpIconDir = (LPICONDIR)lpIcons;
         return lpIconDir->idCount;
     }
+    if (bPixelsReleased)
+        return 1;
     return pBitmap ? pBitmap->GetFrameDimensionsCount() : 0;
 }
 
@@ -763,6 +809,8 @@ long CPicture::SetActiveFrame(UINT frame)
     free(pPropertyItem);
     m_Height = GetHeight();
     m_Width = GetWidth();
+    m_HorizontalResolution = pBitmap->GetHorizontalResolution();
+    m_VerticalResolution = pBitmap->GetVerticalResolution();
     return delay;
 }
 
@@ -773,6 +821,8 @@ UINT CPicture::GetHeight() const
         LPICONDIR lpIconDir = (LPICONDIR)lpIcons;
         return lpIconDir->idEntries[nCurrentIcon].bHeight == 0 ? 256 : lpIconDir->idEntries[nCurrentIcon].bHeight;
     }
+    if (bPixelsReleased)
+        return (UINT)m_Height;
     return pBitmap ? pBitmap->GetHeight() : 0;
 }
 
@@ -783,6 +833,8 @@ UINT CPicture::GetWidth() const
         LPICONDIR lpIconDir = (LPICONDIR)lpIcons;
         return lpIconDir->idEntries[nCurrentIcon].bWidth == 0 ? 256 : lpIconDir->idEntries[nCurrentIcon].bWidth;
     }
+    if (bPixelsReleased)
+        return (UINT)m_Width;
     return pBitmap ? pBitmap->GetWidth() : 0;
 }
 
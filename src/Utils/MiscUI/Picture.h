@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2007, 2009, 2012-2015, 2017 - TortoiseSVN
+// Copyright (C) 2003-2007, 2009, 2012-2015, 2017, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -97,12 +97,12 @@ public:
      * Return the horizontal resolutions in dpi of the loaded picture.
      * \remark this only works if gdi+ is installed.
      */
-    float GetHorizontalResolution() {return pBitmap ? pBitmap->GetHorizontalResolution() : 0.0f;}
+    float GetHorizontalResolution() const {return m_HorizontalResolution;}
     /**
      * Return the vertical resolution in dpi of the loaded picture.
      * \remark this only works if gdi+ is installed.
      */
-    float GetVerticalResolution() {return pBitmap ? pBitmap->GetVerticalResolution() : 0.0f;}
+    float GetVerticalResolution() const {return m_VerticalResolution;}
     /**
      * Returns the picture height in pixels.
      * \remark this only works if gdi+ is installed.
@@ -123,6 +123,19 @@ public:
      * \remark this only works if gdi+ is installed.
      */
     UINT GetColorDepth() const;
+    /**
+     * Copies a part of the picture as premultiplied 32 bit ARGB pixels.
+     * \param stride the distance between two rows of \a pixels, in pixels
+     * \remark this only works for pictures loaded with gdi+, not for icons.
+     */
+    bool GetPixels(int left, int top, int width, int height, UINT* pixels, int stride);
+    /**
+     * Frees the decoded pixels once the caller has its own copy of them.
+     * The size, resolution and color depth are still available, but the
+     * picture can't be drawn or read anymore.
+     * \return false if the picture isn't a single gdi+ image
+     */
+    bool ReleasePixels();
 
     /**
      * Sets the interpolation used for drawing the image.
@@ -199,6 +212,9 @@ private:
     BYTE *              lpIcons;
     HICON *             hIcons;
     DWORD               m_nSize;
+    float               m_HorizontalResolution;
+    float               m_VerticalResolution;
+    bool                bPixelsReleased;
 
     #pragma pack(push, r1, 2)   // n = 16, pushed to stack
 
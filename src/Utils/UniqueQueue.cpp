@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2010 - TortoiseSVN
+// Copyright (C) 2010, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -18,6 +18,7 @@
 //
 #include "stdafx.h"
 #include "UniqueQueue.h"
+#include <string_view>
 
 
 #if defined(_DEBUG)
@@ -25,9 +26,17 @@
 static class UniqueQueueTests
 {
 public:
+    struct CStringHash
+    {
+        size_t operator()(const CString& s) const
+        {
+            return std::hash<std::wstring_view>()(std::wstring_view(s, s.GetLength()));
+        }
+    };
+
     UniqueQueueTests()
     {
-        UniqueQueue<CString> myQueue;
+        UniqueQueue<CString, CStringHash> myQueue;
 
         myQueue.Push(CString(L"one"));
         ATLASSERT(myQueue.size() == 1);
@@ -47,6 +56,20 @@ public:
         ATLASSERT(myQueue.Pop().Compare(L"two") == 0);
         ATLASSERT(myQueue.Pop().Compare(L"one") == 0);
         ATLASSERT(myQueue.Pop().Compare(L"three") == 0);
+        ATLASSERT(myQueue.size() == 0);
+        ATLASSERT(myQueue.Pop().IsEmpty());
+
+        // re-pushing the last entry and erasing entries in the middle
+        myQueue.Push(CString(L"one"));
+        myQueue.Push(CString(L"two"));
+        myQueue.Push(CString(L"three"));
+        myQueue.Push(CString(L"three"));
+        ATLASSERT(myQueue.size() == 3);
+        myQueue.erase(CString(L"two"));
+        ATLASSERT(myQueue.size() == 2);
+        myQueue.Push(CString(L"one"));
+        ATLASSERT(myQueue.Pop().Compare(L"three") == 0);
+        ATLASSERT(myQueue.Pop().Compare(L"one") == 0);
     }
 } UniqueQueueTestsObject;
 
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2010-2012, 2014-2015 - TortoiseSVN
+// Copyright (C) 2010-2012, 2014-2015, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -18,143 +18,149 @@
 //
 #pragma once
 
+#include <unordered_map>
+
 /**
  * \ingroup Utils
  * Implements a queue like container which avoids storing duplicates.
  * If an entry is added that's already in the queue, it gets moved to
  * the end of the queue.
  *
+ * The entries are stored in a hash map whose elements are linked into
+ * a doubly-linked list, i.e. all operations take constant time. \a Hash
+ * and \a KeyEqual must be consistent with each other.
+ *
  * \code
- * UniqueQueue<CString> myQueue;
- * myQueue.Push(CString(L"one"));
- * myQueue.Push(CString(L"two"));
- * myQueue.Push(CString(L"one"));  // "one" already exists, so moved to the end of the queue
- * myQueue.Push(CString(L"three"));
- * myQueue.Push(CString(L"three"));
+ * UniqueQueue<std::wstring> myQueue;
+ * myQueue.Push(L"one");
+ * myQueue.Push(L"two");
+ * myQueue.Push(L"one");  // "one" already exists, so moved to the end of the queue
+ * myQueue.Push(L"three");
+ * myQueue.Push(L"three");
  *
- * ATLASSERT(myQueue.Pop().Compare(L"two") == 0);   // because "one" got moved
- * ATLASSERT(myQueue.Pop().Compare(L"one") == 0);
- * ATLASSERT(myQueue.Pop().Compare(L"three") == 0);
+ * ATLASSERT(myQueue.Pop() == L"two");   // because "one" got moved
+ * ATLASSERT(myQueue.Pop() == L"one");
+ * ATLASSERT(myQueue.Pop() == L"three");
  * \endcode
  */
-template <class T>
+template <class T, class Hash = std::hash<T>, class KeyEqual = std::equal_to<T>>
 class UniqueQueue
 {
 public:
     UniqueQueue();
     ~UniqueQueue();
+    // the links point into the map
+    UniqueQueue(const UniqueQueue&) = delete;
+    UniqueQueue& operator=(const UniqueQueue&) = delete;
 
     size_t          Push(T value);
     T               Pop();
     size_t          erase(T value);
-    size_t          size() const { return m_Queue.size(); }
+    size_t          size() const { return m_QueueTMap.size(); }
+    bool            contains(const T& value) const { return m_QueueTMap.find(value) != m_QueueTMap.end(); }
 private:
-    struct UniqueQueueStruct
+    struct Links
     {
-        T           value;
-        size_t      priority;
+        std::pair<const T, Links>*  prev;
+        std::pair<const T, Links>*  next;
     };
-    std::map<T, size_t>             m_QueueTMap;
-    std::deque<UniqueQueueStruct>   m_Queue;
-    size_t                          m_highestValue;
+    typedef std::pair<const T, Links> Entry;
+
+    void            Append(Entry* entry);
+    void            Unlink(Entry* entry);
+
+    // element addresses remain stable when the map gets rehashed
+    std::unordered_map<T, Links, Hash, KeyEqual>    m_QueueTMap;
+    Entry*                                          m_first;
+    Entry*                                          m_last;
 };
 
-template <class T>
-UniqueQueue<T>::UniqueQueue()
-    : m_highestValue(0)
+template <class T, class Hash, class KeyEqual>
+UniqueQueue<T, Hash, KeyEqual>::UniqueQueue()
+    : m_first(nullptr)
+    , m_last(nullptr)
 {
 }
 
-template <class T>
-UniqueQueue<T>::~UniqueQueue()
+template <class T, class Hash, class KeyEqual>
+UniqueQueue<T, Hash, KeyEqual>::~UniqueQueue()
 {
 
 }
 
-template <class T>
-size_t UniqueQueue<T>::Push( T value )
+template <class T, class Hash, class KeyEqual>
+size_t UniqueQueue<T, Hash, KeyEqual>::Push( T value )
 {
-    std::map<T, size_t>::iterator it = m_QueueTMap.find(value);
-    if (it != m_QueueTMap.end())
+    auto result = m_QueueTMap.emplace(std::move(value), Links{ nullptr, nullptr });
+    Entry* entry = &*result.first;
+    if (!result.second)
     {
         // value is already in the queue: we don't allow duplicates
         // so just move the existing value to the end of the queue
-        for (std::deque<UniqueQueueStruct>::iterator qIt = m_Queue.begin(); qIt != m_Queue.end(); ++qIt)
-        {
-            if (qIt->priority == it->second)
-            {
-                m_Queue.erase(qIt);
-                break;
-            }
-        }
-        it->second = m_highestValue;
-        UniqueQueueStruct s;
-        s.priority = m_highestValue++;
-        s.value = it->first;
-        m_Queue.push_back(s);
-    }
-    else
-    {
-        m_QueueTMap.insert(it, std::map<T, size_t>::value_type(value, m_highestValue));
-        UniqueQueueStruct s;
-        s.priority = m_highestValue++;
-        s.value = value;
-        m_Queue.push_back(s);
-        if (m_highestValue == 0)
-        {
-            // overflow of priority value
-            // recreate the whole queue from scratch
-            std::map<T, size_t> tempQueue = m_QueueTMap;
-            m_QueueTMap.clear();
-            m_Queue.clear();
-
-            for (std::map<T, size_t>::const_iterator tempIt = tempQueue.begin(); tempIt != tempQueue.end(); ++tempIt)
-            {
-                m_QueueTMap.insert(m_QueueTMap.end(), std::map<T, size_t>::value_type(tempIt->first, m_highestValue));
-                UniqueQueueStruct s2;
-                s2.priority = m_highestValue++;
-                s2.value = tempIt->first;
-                m_Queue.push_back(s2);
-            }
-        }
+        if (entry == m_last)
+            return m_QueueTMap.size();
+
+        Unlink(entry);
     }
 
-    return m_Queue.size();
+    Append(entry);
+
+    return m_QueueTMap.size();
 }
 
-template <class T>
-T UniqueQueue<T>::Pop()
+template <class T, class Hash, class KeyEqual>
+T UniqueQueue<T, Hash, KeyEqual>::Pop()
 {
-    if (m_Queue.empty())
+    if (m_first == nullptr)
         return T();
 
-    T value = m_Queue.front().value;
-    m_Queue.pop_front();
-    m_QueueTMap.erase(value);
+    Entry* entry = m_first;
+    Unlink(entry);
 
-    if (m_Queue.empty())
-        m_highestValue = 0;
+    T value = entry->first;
+    m_QueueTMap.erase(value);
 
     return value;
 }
 
-template <class T>
-size_t UniqueQueue<T>::erase( T value )
+template <class T, class Hash, class KeyEqual>
+size_t UniqueQueue<T, Hash, KeyEqual>::erase( T value )
 {
-    std::map<T, size_t>::iterator it = m_QueueTMap.find(value);
+    auto it = m_QueueTMap.find(value);
     if (it != m_QueueTMap.end())
     {
-        for (std::deque<UniqueQueueStruct>::iterator qIt = m_Queue.begin(); qIt != m_Queue.end(); ++qIt)
-        {
-            if (qIt->priority == it->second)
-            {
-                m_Queue.erase(qIt);
-                break;
-            }
-        }
+        Unlink(&*it);
         m_QueueTMap.erase(it);
     }
 
     return m_QueueTMap.size();
 }
 
+template <class T, class Hash, class KeyEqual>
+void UniqueQueue<T, Hash, KeyEqual>::Append( Entry* entry )
+{
+    entry->second.prev = m_last;
+    entry->second.next = nullptr;
+    if (m_last)
+        m_last->second.next = entry;
+    else
+        m_first = entry;
+    m_last = entry;
+}
+
+template <class T, class Hash, class KeyEqual>
+void UniqueQueue<T, Hash, KeyEqual>::Unlink( Entry* entry )
+{
+    if (entry->second.prev)
+        entry->second.prev->second.next = entry->second.next;
+    else
+        m_first = entry->second.next;
+
+    if (entry->second.next)
+        entry->second.next->second.prev = entry->second.prev;
+    else
+        m_last = entry->second.prev;
+
+    entry->second.prev = nullptr;
+    entry->second.next = nullptr;
+}
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2006, 2009, 2013-2016 - TortoiseSVN
+// Copyright (C) 2003-2006, 2009, 2013-2016, 2026 - TortoiseSVN
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -20,6 +20,10 @@
 #include "Cache.h"
 #include "DirFileEnum.h"
 #include "CacheInterface.h"
+#include "WCDbReader.h"
+#include "SVNHelpers.h"
+#include "SVNAdminDir.h"
+#include "svn_dso.h"
 #include <WinInet.h>
 #include "cachedlg.h"
 
@@ -52,6 +56,7 @@ BEGIN_MESSAGE_MAP(CCacheDlg, CDialog)
     //}}AFX_MSG_MAP
     ON_BN_CLICKED(IDOK, OnBnClickedOk)
     ON_BN_CLICKED(IDC_WATCHTESTBUTTON, OnBnClickedWatchtestbutton)
+    ON_BN_CLICKED(IDC_WCDBBENCHBUTTON, OnBnClickedWcdbbenchbutton)
 END_MESSAGE_MAP()
 
 
@@ -468,6 +473,93 @@ UINT CCacheDlg::WatchTestThread()
     return 0;
 }
 
+void CCacheDlg::OnBnClickedWcdbbenchbutton()
+{
+    UpdateData();
+    AfxBeginThread(WCDbBenchThreadEntry, this);
+}
+
+UINT CCacheDlg::WCDbBenchThreadEntry(LPVOID pVoid)
+{
+    return ((CCacheDlg*)pVoid)->WCDbBenchThread();
+}
+
+static svn_error_t * BenchStatusCallback(void * /*baton*/, const char * /*path*/, const svn_client_status_t * /*status*/, apr_pool_t * /*pool*/)
+{
+    return SVN_NO_ERROR;
+}
+
+// Compares the time the cache needs to get the status of every folder of
+// the working copy at m_sRootPath: directly from wc.db vs. svn_client_status().
+// Folders the wc.db reader can't handle are counted, the cache falls back
+// to svn_client_status() for those.
+UINT CCacheDlg::WCDbBenchThread()
+{
+    apr_initialize();
+    svn_dso_initialize2();
+    g_SVNAdminDir.Init();
+    {
+        CTSVNPath wcRoot(m_sRootPath);
+        std::vector<CTSVNPath> folders(1, wcRoot);
+        CDirFileEnum direnum(m_sRootPath);
+        CString filepath;
+        bool bIsDir = false;
+        while (direnum.NextFile(filepath, &bIsDir))
+        {
+            if (bIsDir && !g_SVNAdminDir.IsAdminDirPath(filepath))
+                folders.push_back(CTSVNPath(filepath));
+        }
+
+        CTime starttime = CTime::GetCurrentTime();
+        GetDlgItem(IDC_STARTTIME)->SetWindowText(starttime.Format(_T("%H:%M:%S")));
+
+        SVNHelper svnHelp;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        LONGLONG wcDbTicks = 0;
+        LONGLONG statusTicks = 0;
+        int fallbacks = 0;
+
+        CString sNumber;
+        for (size_t i = 0; i < folders.size(); ++i)
+        {
+            GetDlgItem(IDC_FILEPATH)->SetWindowText(folders[i].GetWinPath());
+
+            LARGE_INTEGER start, end;
+            QueryPerformanceCounter(&start);
+            std::vector<CWCDbReader::Node> nodes;
+            if (!CWCDbReader::GetDirectoryStatus(wcRoot, folders[i], nodes))
+                ++fallbacks;
+            QueryPerformanceCounter(&end);
+            wcDbTicks += end.QuadPart - start.QuadPart;
+
+            SVNPool pool(svnHelp.Pool());
+            svn_opt_revision_t revision;
+            revision.kind = svn_opt_revision_unspecified;
+            QueryPerformanceCounter(&start);
+            svn_client_ctx_t * ctx = svnHelp.ClientContext(pool);
+            svn_error_clear(svn_client_status6(NULL, ctx, folders[i].GetSVNApiPath(pool), &revision,
+                                               svn_depth_immediates, TRUE, FALSE, TRUE, TRUE, FALSE, TRUE,
+                                               NULL, BenchStatusCallback, NULL, pool));
+            QueryPerformanceCounter(&end);
+            statusTicks += end.QuadPart - start.QuadPart;
+
+            sNumber.Format(_T("%d / %d folders, %d not read from wc.db"), (int)i + 1, (int)folders.size(), fallbacks);
+            GetDlgItem(IDC_DONE)->SetWindowText(sNumber);
+        }
+
+        CTime endtime = CTime::GetCurrentTime();
+        CString sEndText;
+        sEndText.Format(_T("%s  - wc.db: %I64d ms, svn_client_status: %I64d ms"), (LPCTSTR)endtime.Format(_T("%H:%M:%S")),
+                        wcDbTicks * 1000 / frequency.QuadPart, statusTicks * 1000 / frequency.QuadPart);
+        GetDlgItem(IDC_ENDTIME)->SetWindowText(sEndText);
+    }
+    g_SVNAdminDir.Close();
+    apr_terminate();
+
+    return 0;
+}
+
 void CCacheDlg::TouchFile(const CString& path)
 {
     SetFileAttributes(path, FILE_ATTRIBUTE_NORMAL);
@@ -1,6 +1,6 @@
 // TortoiseSVN - a Windows shell extension for easy version control
 
-// Copyright (C) 2003-2006 - Stefan Kueng
+// Copyright (C) 2003-2006, 2026 - Stefan Kueng
 
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -64,5 +64,9 @@ protected:
 
     static UINT WatchTestThreadEntry(LPVOID pVoid);
     UINT WatchTestThread();
+
+    afx_msg void OnBnClickedWcdbbenchbutton();
+    static UINT WCDbBenchThreadEntry(LPVOID pVoid);
+    UINT WCDbBenchThread();
 public:
 };
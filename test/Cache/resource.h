@@ -12,6 +12,7 @@
 #define IDC_ROOTPATH                    1004
 #define IDC_BUTTON1                     1005
 #define IDC_WATCHTESTBUTTON             1005
+#define IDC_WCDBBENCHBUTTON             1006
 
 // Next default values for new objects
 //
@@ -19,7 +20,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        129
 #define _APS_NEXT_COMMAND_VALUE         32771
-#define _APS_NEXT_CONTROL_VALUE         1006
+#define _APS_NEXT_CONTROL_VALUE         1007
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif